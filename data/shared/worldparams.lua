@@ -7,6 +7,7 @@ caveNoiseLacunarity = 0.1
 caveNoiseFrequency = 0.02
 caveNoiseGain = 0.1
 caveDensityThreshold = 0.80
+caveNoiseSampleStep = 1
 mountainNoiseOctaves = 2
 mountainNoiseLacunarity = 0.3
 mountainNoiseFrequency = 0.00075
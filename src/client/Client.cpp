@@ -20,6 +20,7 @@
 #include "network/EntityRemoveHandler.h"
 #include "network/EntitySpawnHandler.h"
 #include "network/EntityUpdateHandler.h"
+#include "network/WorldSnapshotHandler.h"
 #include "network/UserSpawnHandler.h"
 #include "network/UserInfoHandler.h"
 #include "network/VarUpdateHandler.h"
@@ -61,6 +62,15 @@ frontend::ClientEntityPtr Client::getEntity(frontend::ClientEntityId id) const {
 	return _worldRenderer.entityMgr().getEntity(id);
 }
 
+void Client::snapshotReceived(uint32_t sequence, network::SnapshotEntities& entities) {
+	_lastSnapshot = sequence;
+	_snapshots.put(sequence, entities);
+	// a lost ack is no problem - the next one acknowledges a newer snapshot
+	_snapshotAckFbb.Clear();
+	_messageSender->sendClientMessage(_snapshotAckFbb, network::ClientMsgType::SnapshotAck,
+			network::CreateSnapshotAck(_snapshotAckFbb, sequence).Union(), 0u, network::ChannelSnapshot);
+}
+
 frontend::ClientEntityId Client::id() const {
 	if (!_player) {
 		return -1;
@@ -165,6 +175,7 @@ core::AppState Client::onInit() {
 	regHandler(network::ServerMsgType::EntitySpawn, EntitySpawnHandler);
 	regHandler(network::ServerMsgType::EntityRemove, EntityRemoveHandler);
 	regHandler(network::ServerMsgType::EntityUpdate, EntityUpdateHandler);
+	regHandler(network::ServerMsgType::WorldSnapshot, WorldSnapshotHandler);
 	regHandler(network::ServerMsgType::UserSpawn, UserSpawnHandler);
 	regHandler(network::ServerMsgType::AuthFailed, AuthFailedHandler);
 	regHandler(network::ServerMsgType::StartCooldown, StartCooldownHandler);
@@ -229,6 +240,8 @@ core::AppState Client::onInit() {
 		Log::error("Failed to initialize world manager");
 		return core::AppState::InitFailure;
 	}
+	// the chunk downloads and the decompression are done off the mesh extraction thread
+	_worldMgr->volumeData()->initAsyncPaging(2);
 
 	if (!_floorResolver.init(_worldMgr)) {
 		Log::error("Failed to initialize floor resolver");
@@ -284,6 +297,7 @@ void Client::beforeUI() {
 			return _floorResolver.findWalkableFloor(pos, maxWalkHeight);
 		});
 		_action.update(_nowSeconds, _player);
+		_clientPager->prefetch(glm::ivec3(_player->position()), _worldMgr->volumeData()->chunkSideLength());
 		const double speed = _player->attrib().current(attrib::Type::SPEED);
 		_camera.update(_player->position(), _nowSeconds, _deltaFrameSeconds, speed);
 		_worldRenderer.extractMeshes(camera);
@@ -332,6 +346,8 @@ core::AppState Client::onCleanup() {
 	Log::info("shutting down the world renderer");
 	_worldRenderer.shutdown();
 	Log::info("shutting down the world");
+	// wakes up the page-ins that wait for their download
+	_clientPager->shutdown();
 	_worldMgr->shutdown();
 	_floorResolver.shutdown();
 	_player = frontend::ClientEntityPtr();
@@ -424,6 +440,8 @@ bool Client::connect(uint16_t port, const core::String& hostname) {
 	}
 
 	peer->data = this;
+	_snapshots.reset();
+	_lastSnapshot = 0u;
 	Log::info("Connecting to server %s:%i", hostname.c_str(), port);
 	return true;
 }
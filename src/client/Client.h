@@ -20,6 +20,7 @@
 #include "network/ClientNetwork.h"
 #include "network/ClientMessageSender.h"
 #include "network/NetworkEvents.h"
+#include "network/Snapshot.h"
 #include "ui/nuklear/LUAUIApp.h"
 #include "animation/AnimationCache.h"
 #include "video/Camera.h"
@@ -41,6 +42,9 @@ protected:
 	flatbuffers::FlatBufferBuilder _moveFbb;
 	frontend::PlayerMovement _movement;
 	flatbuffers::FlatBufferBuilder _actionFbb;
+	flatbuffers::FlatBufferBuilder _snapshotAckFbb;
+	network::SnapshotHistory _snapshots;
+	uint32_t _lastSnapshot = 0u;
 	frontend::PlayerAction _action;
 	client::CooldownHandler _cooldownHandler;
 	network::MoveDirection _lastMoveMask = network::MoveDirection::NONE;
@@ -107,8 +111,26 @@ public:
 	void entitySpawn(frontend::ClientEntityId id, network::EntityType type, float orientation, const glm::vec3& pos, animation::Animation animation);
 	void entityRemove(frontend::ClientEntityId id);
 	frontend::ClientEntityPtr getEntity(frontend::ClientEntityId id) const;
+
+	/**
+	 * @brief The received world snapshots that the server might use as baseline
+	 */
+	const network::SnapshotHistory& snapshots() const;
+	uint32_t lastSnapshot() const;
+	/**
+	 * @brief Stores the decoded snapshot and acknowledges it
+	 */
+	void snapshotReceived(uint32_t sequence, network::SnapshotEntities& entities);
 };
 
+inline const network::SnapshotHistory& Client::snapshots() const {
+	return _snapshots;
+}
+
+inline uint32_t Client::lastSnapshot() const {
+	return _lastSnapshot;
+}
+
 inline client::CooldownHandler& Client::cooldownHandler() {
 	return _cooldownHandler;
 }
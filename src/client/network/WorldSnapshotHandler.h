@@ -0,0 +1,47 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "IClientProtocolHandler.h"
+#include "network/Snapshot.h"
+
+/**
+ * Updates the @c frontend::ClientEntity instances with the state of the delta encoded world snapshot
+ * and acknowledges the snapshot to let the server use it as baseline for the following snapshots.
+ *
+ * @sa network::decodeSnapshot()
+ */
+CLIENTPROTOHANDLERIMPL(WorldSnapshot) {
+	const uint32_t sequence = message->sequence();
+	// the snapshots are sent unreliable - they might arrive out of order
+	if (sequence <= client->lastSnapshot()) {
+		return;
+	}
+	const uint32_t baselineSequence = message->baseline();
+	const network::SnapshotEntities* baseline = nullptr;
+	if (baselineSequence != 0u) {
+		baseline = client->snapshots().get(baselineSequence);
+		if (baseline == nullptr) {
+			Log::debug("Baseline %u for snapshot %u is not known anymore", baselineSequence, sequence);
+			return;
+		}
+	}
+	network::SnapshotEntities entities;
+	const flatbuffers::Vector<uint8_t>* data = message->entities();
+	if (!network::decodeSnapshot(baseline, data->data(), data->size(), entities)) {
+		Log::warn("Received invalid snapshot %u", sequence);
+		return;
+	}
+	for (const network::SnapshotEntity& e : entities) {
+		const frontend::ClientEntityPtr& entity = client->getEntity(e.id);
+		if (!entity) {
+			continue;
+		}
+		entity->setPosition(network::dequantizePosition(e.pos));
+		entity->setOrientation(network::dequantizeRotation(e.rotation));
+		entity->setAnimation(e.animation, true);
+	}
+	client->snapshotReceived(sequence, entities);
+}
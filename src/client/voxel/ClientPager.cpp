@@ -4,84 +4,449 @@
 
 #include "ClientPager.h"
 #include "core/App.h"
+#include "core/ByteStream.h"
+#include "core/Common.h"
+#include "core/GameConfig.h"
+#include "core/Log.h"
+#include "core/StringUtil.h"
+#include "core/TimeProvider.h"
+#include "core/concurrent/Concurrency.h"
 #include "core/io/Filesystem.h"
 #include "http/ResponseParser.h"
 #include "http/HttpMimeType.h"
+#include "http/Url.h"
+#include "voxel/Constants.h"
 #include "voxel/Region.h"
+#include <algorithm>
+#include <stdlib.h>
 
 namespace client {
 
+namespace {
+
+inline int floorDiv(int value, int divisor) {
+	return (value >= 0 ? value : value - divisor + 1) / divisor;
+}
+
+}
+
+ClientPager::~ClientPager() {
+	shutdown();
+}
+
 bool ClientPager::init(const core::String& baseUrl) {
+	_prefetchRadius = core::Var::get(cfg::ClientChunkPrefetchRadius, "1");
 	if (baseUrl.empty()) {
 		return true;
 	}
-	if (!_httpClient.setBaseUrl(baseUrl)) {
+	const http::Url url(baseUrl);
+	if (!url.valid()) {
 		Log::warn("Invalid client pager url");
-	} else {
-		Log::info("Updated client pager url to '%s'", baseUrl.c_str());
+		return true;
 	}
+	Log::info("Updated client pager url to '%s'", baseUrl.c_str());
 
+	core::ScopedLock<core::Lock> lock(_lock);
+	_batchUrl = baseUrl + "s";
+	_batchUrlDirty = true;
+	if (!_downloader.joinable()) {
+		_stop = false;
+		_downloader = std::thread(&ClientPager::downloadLoop, this);
+	}
 	return true;
 }
 
+void ClientPager::shutdown() {
+	{
+		core::ScopedLock<core::Lock> lock(_lock);
+		_stop = true;
+		_queueCondition.notify_all();
+		_downloadedCondition.notify_all();
+	}
+	if (_downloader.joinable()) {
+		_downloader.join();
+	}
+	core::ScopedLock<core::Lock> lock(_lock);
+	reset();
+	_requested.clear();
+}
+
 void ClientPager::setSeed(unsigned int seed) {
+	core::ScopedLock<core::Lock> lock(_lock);
+	if (_seed != seed) {
+		reset();
+	}
 	_seed = seed;
 	Log::info("set seed: %u", _seed);
 }
 
 void ClientPager::setMapId(int mapId) {
+	core::ScopedLock<core::Lock> lock(_lock);
+	if (_mapId != mapId) {
+		reset();
+	}
 	_mapId = mapId;
 	Log::info("set mapid: %u", _mapId);
 }
 
+void ClientPager::reset() {
+	for (const QueuedChunk& queued : _queue) {
+		_requested.erase(queued.pos);
+	}
+	_queue.clear();
+	for (const RetryChunk& retry : _retry) {
+		_requested.erase(retry.pos);
+	}
+	_retry.clear();
+	_attempts.clear();
+	_downloaded.clear();
+	_available.clear();
+	_prefetched = false;
+	// the page-ins that wait for a queued chunk fail
+	_downloadedCondition.notify_all();
+}
+
+void ClientPager::requeueRetries(uint64_t nowMillis) {
+	while (!_retry.empty() && _retry.front().dueMillis <= nowMillis) {
+		// a page-in might wait for it - and it was close enough to be downloaded before
+		_queue.push_back(QueuedChunk{_retry.front().pos, PriorityPageIn});
+		std::push_heap(_queue.begin(), _queue.end());
+		_retry.pop_front();
+	}
+}
+
+void ClientPager::enqueue(const glm::ivec3& pos, int priority) {
+	if (_requested.insert(pos).second) {
+		_queue.push_back(QueuedChunk{pos, priority});
+		std::push_heap(_queue.begin(), _queue.end());
+		_queueCondition.notify_one();
+		return;
+	}
+	// a prefetched chunk that is still queued is needed now
+	for (QueuedChunk& queued : _queue) {
+		if (queued.pos == pos) {
+			if (priority < queued.priority) {
+				queued.priority = priority;
+				std::make_heap(_queue.begin(), _queue.end());
+			}
+			return;
+		}
+	}
+}
+
+void ClientPager::prefetch(const glm::ivec3& pos, uint16_t chunkSideLength) {
+	core_trace_scoped(ClientPagerPrefetch);
+	const int side = chunkSideLength;
+	const glm::ivec3 center(floorDiv(pos.x, side) * side, 0, floorDiv(pos.z, side) * side);
+	const int radius = _prefetchRadius ? core_max(0, _prefetchRadius->intVal()) : 0;
+
+	std::vector<QueuedChunk> candidates;
+	unsigned int seed;
+	{
+		core::ScopedLock<core::Lock> lock(_lock);
+		if (_stop || _batchUrl.empty()) {
+			return;
+		}
+		if (_prefetched && _prefetchCenter == center) {
+			return;
+		}
+		_prefetched = true;
+		_prefetchCenter = center;
+		_chunkSideLength = chunkSideLength;
+		seed = _seed;
+
+		// the chunks that were queued for the old position are queued again with new priorities
+		auto queueEnd = std::partition(_queue.begin(), _queue.end(), [] (const QueuedChunk& queued) {
+			return queued.priority == PriorityPageIn;
+		});
+		for (auto i = queueEnd; i != _queue.end(); ++i) {
+			_requested.erase(i->pos);
+		}
+		_queue.erase(queueEnd, _queue.end());
+		std::make_heap(_queue.begin(), _queue.end());
+
+		// the downloaded chunks that are out of range are paged in from disk
+		const int maxDistance = (radius + 1) * side;
+		for (auto i = _downloaded.begin(); i != _downloaded.end();) {
+			const glm::ivec3& delta = i->first - center;
+			if (std::abs(delta.x) > maxDistance || std::abs(delta.z) > maxDistance) {
+				i = _downloaded.erase(i);
+			} else {
+				++i;
+			}
+		}
+
+		for (int dz = -radius; dz <= radius; ++dz) {
+			for (int dx = -radius; dx <= radius; ++dx) {
+				for (int y = 0; y <= voxel::MAX_HEIGHT; y += side) {
+					const glm::ivec3 chunkOrigin(center.x + dx * side, y, center.z + dz * side);
+					if (_available.find(chunkOrigin) != _available.end()) {
+						continue;
+					}
+					if (_requested.find(chunkOrigin) != _requested.end()) {
+						continue;
+					}
+					candidates.push_back(QueuedChunk{chunkOrigin, dx * dx + dz * dz});
+				}
+			}
+		}
+	}
+	if (candidates.empty()) {
+		return;
+	}
+
+	// don't download the chunks again that are already stored on disk
+	std::vector<glm::ivec3> stored;
+	for (auto i = candidates.begin(); i != candidates.end();) {
+		const glm::ivec3 chunkPos(i->pos.x / side, i->pos.y / side, i->pos.z / side);
+		if (_chunkPersister.exists(chunkPos, seed)) {
+			stored.push_back(i->pos);
+			i = candidates.erase(i);
+		} else {
+			++i;
+		}
+	}
+
+	core::ScopedLock<core::Lock> lock(_lock);
+	if (_seed != seed) {
+		return;
+	}
+	_available.insert(stored.begin(), stored.end());
+	for (const QueuedChunk& candidate : candidates) {
+		enqueue(candidate.pos, candidate.priority);
+	}
+	Log::debug("Prefetch %i chunks around %i:%i:%i", (int)candidates.size(), center.x, center.y, center.z);
+}
+
+bool ClientPager::sendBatch(const Batch& batch, int mapId) {
+	core::String positions;
+	for (const glm::ivec3& pos : batch) {
+		if (!positions.empty()) {
+			positions += ",";
+		}
+		positions += core::string::format("%i,%i,%i", pos.x, pos.y, pos.z);
+	}
+	return _connection.sendGet("?mapid=%i&positions=%s", mapId, positions.c_str());
+}
+
+void ClientPager::receiveBatch(const Batch& batch, unsigned int seed, uint16_t chunkSideLength) {
+	core_trace_scoped(ClientPagerReceiveBatch);
+	const http::ResponseParser& response = _connection.receive();
+	if (!response.valid() || response.status != http::HttpStatus::Ok) {
+		Log::error("Failed to download %i chunks for seed %u", (int)batch.size(), seed);
+		if (response.isHeaderValue(http::header::CONTENT_TYPE, http::mimetype::TEXT_PLAIN)) {
+			const core::String s(response.content, response.contentLength);
+			Log::error("%s", s.c_str());
+		}
+		failed(batch);
+		return;
+	}
+	const char *contentType;
+	if (!response.headers.get(http::header::CONTENT_TYPE, contentType)) {
+		Log::error("No content type set in chunks response");
+		failed(batch);
+		return;
+	}
+	if (SDL_strcmp(contentType, http::mimetype::APPLICATION_CHUNKS)) {
+		Log::error("Unexpected content type: %s for chunks", contentType);
+		failed(batch);
+		return;
+	}
+
+	core::ByteStream stream(response.contentLength);
+	stream.append((const uint8_t*)response.content, response.contentLength);
+	std::vector<std::pair<glm::ivec3, ChunkData>> chunks;
+	chunks.reserve(batch.size());
+	std::vector<glm::ivec3> missing;
+	while (stream.getSize() >= 4 * sizeof(int32_t)) {
+		glm::ivec3 pos;
+		pos.x = stream.readInt();
+		pos.y = stream.readInt();
+		pos.z = stream.readInt();
+		const int32_t size = stream.readInt();
+		if (size < 0 || (size_t)size > stream.getSize()) {
+			Log::error("Invalid chunk size %i in chunks response", size);
+			break;
+		}
+		if (size == 0) {
+			Log::debug("Chunk for position %i:%i:%i and seed %u is not yet available", pos.x, pos.y, pos.z, seed);
+			missing.push_back(pos);
+			continue;
+		}
+		const ChunkData& data = std::make_shared<const std::vector<uint8_t>>(stream.getBuffer(), stream.getBuffer() + size);
+		stream.skip(size);
+		// the chunks that are not paged in right now are paged in from disk later
+		const glm::ivec3 chunkPos(pos.x / chunkSideLength, pos.y / chunkSideLength, pos.z / chunkSideLength);
+		if (!_chunkPersister.write(chunkPos, seed, data->data(), data->size())) {
+			Log::error("Failed to save the downloaded chunk for position %i:%i:%i and seed %u", pos.x, pos.y, pos.z, seed);
+		}
+		chunks.emplace_back(pos, data);
+	}
+
+	core::ScopedLock<core::Lock> lock(_lock);
+	PositionSet retried;
+	if (_seed == seed) {
+		for (const auto& e : chunks) {
+			_downloaded[e.first] = e.second;
+			_available.insert(e.first);
+			_attempts.erase(e.first);
+		}
+		const uint64_t dueMillis = core::TimeProvider::systemMillis() + RetryDelayMillis;
+		for (const glm::ivec3& pos : missing) {
+			if (++_attempts[pos] >= MaxAttempts) {
+				Log::error("Failed to download the chunk for position %i:%i:%i and seed %u", pos.x, pos.y, pos.z, seed);
+				_attempts.erase(pos);
+				continue;
+			}
+			_retry.push_back(RetryChunk{pos, dueMillis});
+			retried.insert(pos);
+		}
+	}
+	for (const glm::ivec3& pos : batch) {
+		if (retried.find(pos) == retried.end()) {
+			_requested.erase(pos);
+		}
+	}
+	_downloadedCondition.notify_all();
+}
+
+void ClientPager::failed(const Batch& batch) {
+	core::ScopedLock<core::Lock> lock(_lock);
+	for (const glm::ivec3& pos : batch) {
+		_requested.erase(pos);
+	}
+	_downloadedCondition.notify_all();
+}
+
+void ClientPager::downloadLoop() {
+	core::setThreadName("ChunkDownload");
+	struct InFlight {
+		Batch batch;
+		unsigned int seed;
+		uint16_t chunkSideLength;
+	};
+	std::deque<InFlight> inFlight;
+	for (;;) {
+		std::vector<Batch> batches;
+		int mapId;
+		unsigned int seed;
+		uint16_t chunkSideLength;
+		{
+			core::ScopedLock<core::Lock> lock(_lock);
+			requeueRetries(core::TimeProvider::systemMillis());
+			while (inFlight.empty() && _queue.empty() && !_stop) {
+				if (_retry.empty()) {
+					_queueCondition.wait(_lock);
+					continue;
+				}
+				const uint64_t now = core::TimeProvider::systemMillis();
+				if (_retry.front().dueMillis > now) {
+					_queueCondition.waitTimeout(_lock, (uint32_t)(_retry.front().dueMillis - now));
+				}
+				requeueRetries(core::TimeProvider::systemMillis());
+			}
+			if (_stop) {
+				break;
+			}
+			// the responses for the old url must be received first
+			if (_batchUrlDirty && inFlight.empty()) {
+				_connection.setBaseUrl(_batchUrl);
+				_batchUrlDirty = false;
+			}
+			mapId = _mapId;
+			seed = _seed;
+			chunkSideLength = _chunkSideLength;
+			while (!_batchUrlDirty && !_queue.empty() && inFlight.size() + batches.size() < MaxRequestsInFlight) {
+				Batch batch;
+				while (!_queue.empty() && batch.size() < BatchSize) {
+					std::pop_heap(_queue.begin(), _queue.end());
+					batch.push_back(_queue.back().pos);
+					_queue.pop_back();
+				}
+				batches.emplace_back(std::move(batch));
+			}
+		}
+		for (Batch& batch : batches) {
+			if (!sendBatch(batch, mapId)) {
+				// the connection is closed - the responses of the pending requests are lost, too
+				for (const InFlight& f : inFlight) {
+					failed(f.batch);
+				}
+				inFlight.clear();
+				failed(batch);
+				continue;
+			}
+			inFlight.push_back(InFlight{std::move(batch), seed, chunkSideLength});
+		}
+		if (inFlight.empty()) {
+			continue;
+		}
+		const InFlight& f = inFlight.front();
+		receiveBatch(f.batch, f.seed, f.chunkSideLength);
+		inFlight.pop_front();
+		if ((size_t)_connection.pending() < inFlight.size()) {
+			// the connection was closed
+			for (const InFlight& lost : inFlight) {
+				failed(lost.batch);
+			}
+			inFlight.clear();
+		}
+	}
+	for (const InFlight& f : inFlight) {
+		failed(f.batch);
+	}
+	_connection.disconnect();
+}
+
 bool ClientPager::pageIn(voxel::PagedVolume::PagerContext& pctx) {
+	core_trace_scoped(ClientPagerPageIn);
 	if (pctx.region.getLowerY() < 0) {
 		return false;
 	}
-	if (!_chunkPersister.load(pctx.chunk, _seed)) {
-		const int x = pctx.region.getLowerX();
-		const int y = pctx.region.getLowerY();
-		const int z = pctx.region.getLowerZ();
-		const http::ResponseParser& response = _httpClient.get("?x=%i&y=%i&z=%i&mapid=%i", x, y, z, _mapId);
-		if (response.status != http::HttpStatus::Ok) {
-			Log::error("Failed to download the chunk for position %i:%i:%i and seed %u on map %i",
-					x, y, z, _seed, _mapId);
-			if (response.isHeaderValue(http::header::CONTENT_TYPE, http::mimetype::TEXT_PLAIN)) {
-				const core::String s(response.content, response.contentLength);
-				Log::error("%s", s.c_str());
-			}
-			return false;
+	const glm::ivec3& pos = pctx.region.getLowerCorner();
+	ChunkData data;
+	unsigned int seed;
+	int mapId;
+	{
+		core::ScopedLock<core::Lock> lock(_lock);
+		seed = _seed;
+		mapId = _mapId;
+		_chunkSideLength = pctx.region.getWidthInVoxels();
+		auto i = _downloaded.find(pos);
+		if (i != _downloaded.end()) {
+			data = i->second;
+			_downloaded.erase(i);
 		}
-		const size_t length = response.contentLength;
-		const char* data = response.content;
-		const char *contentType;
-		if (!response.headers.get(http::header::CONTENT_TYPE, contentType)) {
-			Log::error("No content type set in chunk response for position %i:%i:%i and seed %u on map %i",
-					x, y, z, _seed, _mapId);
+	}
+	if (!data) {
+		if (_chunkPersister.load(pctx.chunk, seed)) {
 			return false;
 		}
-		if (SDL_strcmp(contentType, "application/chunk")) {
-			Log::error("Unexpected content type: %s for chunk at position %i:%i:%i and seed %u on map %i",
-					contentType, x, y, z, _seed, _mapId);
+		core::ScopedLock<core::Lock> lock(_lock);
+		if (_stop || _batchUrl.empty()) {
+			Log::error("Can't download the chunk for position %i:%i:%i and seed %u on map %i",
+					pos.x, pos.y, pos.z, seed, mapId);
 			return false;
 		}
-		if (!_chunkPersister.loadCompressed(pctx.chunk, (const uint8_t*)data, length)) {
-			Log::error("Failed to uncompress the chunk for position %i:%i:%i and seed %u on map %i",
-					x, y, z, _seed, _mapId);
-			return false;
+		// the download might have finished after the lookup above
+		if (_downloaded.find(pos) == _downloaded.end()) {
+			enqueue(pos, PriorityPageIn);
+			_downloadedCondition.wait(_lock, [&] () {
+				return _stop || _requested.find(pos) == _requested.end();
+			});
 		}
-		if (!_chunkPersister.save(pctx.chunk, _seed)) {
-			Log::error("Failed to save the downloaded chunk for position %i:%i:%i and seed %u on map %i",
-					x, y, z, _seed, _mapId);
+		auto i = _downloaded.find(pos);
+		if (i == _downloaded.end()) {
+			Log::error("Failed to download the chunk for position %i:%i:%i and seed %u on map %i",
+					pos.x, pos.y, pos.z, seed, mapId);
 			return false;
 		}
+		data = i->second;
+		_downloaded.erase(i);
 	}
-	if (!_chunkPersister.load(pctx.chunk, _seed)) {
-		const int x = pctx.region.getLowerX();
-		const int y = pctx.region.getLowerY();
-		const int z = pctx.region.getLowerZ();
-		Log::error("Failed to load the world for position %i:%i:%i and seed %u on map %i",
-				x, y, z, _seed, _mapId);
+	if (!_chunkPersister.loadCompressed(pctx.chunk, data->data(), data->size())) {
+		Log::error("Failed to uncompress the chunk for position %i:%i:%i and seed %u on map %i",
+				pos.x, pos.y, pos.z, seed, mapId);
 	}
 	return false;
 }
@@ -7,19 +7,154 @@
 #include "voxelworld/FilePersister.h"
 #include "voxel/PagedVolume.h"
 #include "network/ClientMessageSender.h"
-#include "http/HttpClient.h"
+#include "http/HttpConnection.h"
 #include "core/SharedPtr.h"
+#include "core/Var.h"
+#include "core/Trace.h"
+#include "core/concurrent/Lock.h"
+#include "core/concurrent/ConditionVariable.h"
+#include <deque>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <glm/vec3.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
 
 namespace client {
 
+/**
+ * @brief Pages in the chunks that are downloaded from the server.
+ *
+ * The downloads are done by an own thread that pipelines several batch requests (see the @c /chunks
+ * route of the server) on one keep-alive connection. The chunks around the player are downloaded
+ * before they are needed (see prefetch()) - the closest chunks first. Page-ins of chunks that are not
+ * yet downloaded are put in front of the queue and wait for their download.
+ *
+ * The server answers chunks that it didn't generate yet with an empty entry - these chunks are requested
+ * again after a short delay.
+ *
+ * The page-ins can be executed by several paging threads at once - they decompress the downloaded
+ * chunks, the downloader thread only stores the compressed data on disk.
+ */
 class ClientPager : public voxel::PagedVolume::Pager {
 private:
-	http::HttpClient _httpClient;
+	using ChunkData = std::shared_ptr<const std::vector<uint8_t>>;
+	using PositionSet = std::unordered_set<glm::ivec3, std::hash<glm::ivec3>>;
+	// the chunks in one batch request
+	using Batch = std::vector<glm::ivec3>;
+
+	struct QueuedChunk {
+		// the world position of the chunk origin
+		glm::ivec3 pos;
+		// lower values are downloaded first
+		int priority;
+
+		inline bool operator<(const QueuedChunk& other) const {
+			return priority > other.priority;
+		}
+	};
+
+	/**
+	 * @brief The max amount of chunks per batch request
+	 */
+	static constexpr size_t BatchSize = 8u;
+	/**
+	 * @brief The max amount of batch requests that are sent before their response was received
+	 */
+	static constexpr size_t MaxRequestsInFlight = 4u;
+	/**
+	 * @brief The priority of chunks that a page-in is waiting for
+	 */
+	static constexpr int PriorityPageIn = -1;
+	/**
+	 * @brief The chunks that the server is still generating are requested again after this delay
+	 */
+	static constexpr uint32_t RetryDelayMillis = 100u;
+	/**
+	 * @brief The download of a chunk fails if the server didn't have it after this many requests
+	 */
+	static constexpr int MaxAttempts = 50;
+
+	struct RetryChunk {
+		glm::ivec3 pos;
+		uint64_t dueMillis;
+	};
+
+	core_trace_mutex(core::Lock, _lock, "ClientPager");
+	// wakes up the downloader if chunks were queued
+	core::ConditionVariable _queueCondition;
+	// wakes up the page-ins that are waiting for their download
+	core::ConditionVariable _downloadedCondition;
+	// priority queue (heap) of the chunks that should get downloaded
+	std::vector<QueuedChunk> _queue;
+	// queued or in flight
+	PositionSet _requested;
+	// downloaded but not yet paged in
+	std::unordered_map<glm::ivec3, ChunkData, std::hash<glm::ivec3>> _downloaded;
+	// downloaded or found on disk - these chunks are not prefetched again
+	PositionSet _available;
+	// the chunks that the server is still generating - they stay requested and are queued again once due
+	std::deque<RetryChunk> _retry;
+	// the amount of requests that were answered without the chunk
+	std::unordered_map<glm::ivec3, int, std::hash<glm::ivec3>> _attempts;
+	glm::ivec3 _prefetchCenter {0};
+	bool _prefetched = false;
+	core::String _batchUrl;
+	bool _batchUrlDirty = false;
 	unsigned int _seed = 0u;
 	int _mapId = -1;
+	uint16_t _chunkSideLength = 0u;
+	bool _stop = true;
+
+	// only used by the downloader thread
+	http::HttpConnection _connection;
+	std::thread _downloader;
+	core::VarPtr _prefetchRadius;
 	voxelworld::FilePersister _chunkPersister;
+
+	/**
+	 * @note The caller must hold the lock
+	 */
+	void enqueue(const glm::ivec3& pos, int priority);
+	/**
+	 * @brief Drops the queued chunks and the downloaded chunks that are not paged in yet
+	 * @note The caller must hold the lock
+	 */
+	void reset();
+	/**
+	 * @brief Moves the due chunks of the retry list back into the queue
+	 * @note The caller must hold the lock
+	 */
+	void requeueRetries(uint64_t nowMillis);
+
+	void downloadLoop();
+	bool sendBatch(const Batch& batch, int mapId);
+	/**
+	 * @brief Stores the chunks of the batch response and wakes up the page-ins that are waiting for them
+	 */
+	void receiveBatch(const Batch& batch, unsigned int seed, uint16_t chunkSideLength);
+	/**
+	 * @brief Gives up the download of the given chunks - the page-ins that wait for them fail
+	 */
+	void failed(const Batch& batch);
 public:
+	~ClientPager();
+
+	/**
+	 * @param[in] baseUrl The url of the @c /chunk route of the server. The batch route is expected at the same
+	 * location (@c /chunks)
+	 */
 	bool init(const core::String& baseUrl);
+	void shutdown();
+
+	/**
+	 * @brief Queues the download of the chunks around the given world position. Should be called with the
+	 * player position whenever the player moves.
+	 */
+	void prefetch(const glm::ivec3& pos, uint16_t chunkSideLength);
 
 	bool pageIn(voxel::PagedVolume::PagerContext& ctx) override;
 	void pageOut(voxel::PagedVolume::Chunk* chunk) override;
@@ -124,13 +124,24 @@ static int luaAI_nodetostring(lua_State* s) {
 static int luaAI_createnode(lua_State* s) {
 	LUAAIRegistry* r = luaAI_toregistry(s);
 	const core::String type = luaL_checkstring(s, -1);
-	const LUATreeNodeFactoryPtr& factory = std::make_shared<LuaNodeFactory>(s, type);
-	const bool inserted = r->registerNodeFactory(type, *factory);
-	if (!inserted) {
-		return luaL_error(s, "tree node %s is already registered", type.c_str());
+	LuaNodeFactory* factory;
+	if (r->statePool().isMainState(s)) {
+		const LUATreeNodeFactoryPtr& factoryPtr = std::make_shared<LuaNodeFactory>(&r->statePool(), type);
+		const bool inserted = r->registerNodeFactory(type, *factoryPtr);
+		if (!inserted) {
+			return luaL_error(s, "tree node %s is already registered", type.c_str());
+		}
+		r->addTreeNodeFactory(type, factoryPtr);
+		factory = factoryPtr.get();
+	} else {
+		// the state of another thread - the factory was registered by the main state
+		factory = r->treeNodeFactory(type);
+		if (factory == nullptr) {
+			return luaL_error(s, "tree node %s is not registered", type.c_str());
+		}
 	}
 
-	luaAI_newuserdata<LuaNodeFactory*>(s, factory.get());
+	luaAI_newuserdata<LuaNodeFactory*>(s, factory);
 	const luaL_Reg nodes[] = {
 		{"execute", luaAI_nodeemptyexecute},
 		{"__tostring", luaAI_nodetostring},
@@ -138,7 +149,6 @@ static int luaAI_createnode(lua_State* s) {
 		{nullptr, nullptr}
 	};
 	luaAI_setupmetatable(s, type, nodes, "node");
-	r->addTreeNodeFactory(type, factory);
 	return 1;
 }
 
@@ -165,13 +175,23 @@ static int luaAI_conditiontostring(lua_State* s) {
 static int luaAI_createcondition(lua_State* s) {
 	LUAAIRegistry* r = luaAI_toregistry(s);
 	const core::String type = luaL_checkstring(s, -1);
-	const LUAConditionFactoryPtr& factory = std::make_shared<LuaConditionFactory>(s, type);
-	const bool inserted = r->registerConditionFactory(type, *factory);
-	if (!inserted) {
-		return luaL_error(s, "condition %s is already registered", type.c_str());
+	LuaConditionFactory* factory;
+	if (r->statePool().isMainState(s)) {
+		const LUAConditionFactoryPtr& factoryPtr = std::make_shared<LuaConditionFactory>(&r->statePool(), type);
+		const bool inserted = r->registerConditionFactory(type, *factoryPtr);
+		if (!inserted) {
+			return luaL_error(s, "condition %s is already registered", type.c_str());
+		}
+		r->addConditionFactory(type, factoryPtr);
+		factory = factoryPtr.get();
+	} else {
+		factory = r->conditionFactory(type);
+		if (factory == nullptr) {
+			return luaL_error(s, "condition %s is not registered", type.c_str());
+		}
 	}
 
-	luaAI_newuserdata<LuaConditionFactory*>(s, factory.get());
+	luaAI_newuserdata<LuaConditionFactory*>(s, factory);
 	const luaL_Reg nodes[] = {
 		{"evaluate", luaAI_conditionemptyevaluate},
 		{"__tostring", luaAI_conditiontostring},
@@ -179,7 +199,6 @@ static int luaAI_createcondition(lua_State* s) {
 		{nullptr, nullptr}
 	};
 	luaAI_setupmetatable(s, type, nodes, "condition");
-	r->addConditionFactory(type, factory);
 	return 1;
 }
 
@@ -202,13 +221,23 @@ static int luaAI_filtertostring(lua_State* s) {
 static int luaAI_createfilter(lua_State* s) {
 	LUAAIRegistry* r = luaAI_toregistry(s);
 	const core::String type = luaL_checkstring(s, -1);
-	const LUAFilterFactoryPtr& factory = std::make_shared<LuaFilterFactory>(s, type);
-	const bool inserted = r->registerFilterFactory(type, *factory);
-	if (!inserted) {
-		return luaL_error(s, "filter %s is already registered", type.c_str());
+	LuaFilterFactory* factory;
+	if (r->statePool().isMainState(s)) {
+		const LUAFilterFactoryPtr& factoryPtr = std::make_shared<LuaFilterFactory>(&r->statePool(), type);
+		const bool inserted = r->registerFilterFactory(type, *factoryPtr);
+		if (!inserted) {
+			return luaL_error(s, "filter %s is already registered", type.c_str());
+		}
+		r->addFilterFactory(type, factoryPtr);
+		factory = factoryPtr.get();
+	} else {
+		factory = r->filterFactory(type);
+		if (factory == nullptr) {
+			return luaL_error(s, "filter %s is not registered", type.c_str());
+		}
 	}
 
-	luaAI_newuserdata<LuaFilterFactory*>(s, factory.get());
+	luaAI_newuserdata<LuaFilterFactory*>(s, factory);
 	const luaL_Reg nodes[] = {
 		{"filter", luaAI_filteremptyfilter},
 		{"__tostring", luaAI_filtertostring},
@@ -216,7 +245,6 @@ static int luaAI_createfilter(lua_State* s) {
 		{nullptr, nullptr}
 	};
 	luaAI_setupmetatable(s, type, nodes, "filter");
-	r->addFilterFactory(type, factory);
 	return 1;
 }
 
@@ -234,13 +262,23 @@ static int luaAI_steeringtostring(lua_State* s) {
 static int luaAI_createsteering(lua_State* s) {
 	LUAAIRegistry* r = luaAI_toregistry(s);
 	const core::String type = luaL_checkstring(s, -1);
-	const LUASteeringFactoryPtr& factory = std::make_shared<LuaSteeringFactory>(s, type);
-	const bool inserted = r->registerSteeringFactory(type, *factory);
-	if (!inserted) {
-		return luaL_error(s, "steering %s is already registered", type.c_str());
+	LuaSteeringFactory* factory;
+	if (r->statePool().isMainState(s)) {
+		const LUASteeringFactoryPtr& factoryPtr = std::make_shared<LuaSteeringFactory>(&r->statePool(), type);
+		const bool inserted = r->registerSteeringFactory(type, *factoryPtr);
+		if (!inserted) {
+			return luaL_error(s, "steering %s is already registered", type.c_str());
+		}
+		r->addSteeringFactory(type, factoryPtr);
+		factory = factoryPtr.get();
+	} else {
+		factory = r->steeringFactory(type);
+		if (factory == nullptr) {
+			return luaL_error(s, "steering %s is not registered", type.c_str());
+		}
 	}
 
-	luaAI_newuserdata<LuaSteeringFactory*>(s, factory.get());
+	luaAI_newuserdata<LuaSteeringFactory*>(s, factory);
 	const luaL_Reg nodes[] = {
 		{"filter", luaAI_steeringemptyexecute},
 		{"__tostring", luaAI_steeringtostring},
@@ -248,7 +286,6 @@ static int luaAI_createsteering(lua_State* s) {
 		{nullptr, nullptr}
 	};
 	luaAI_setupmetatable(s, type, nodes, "steering");
-	r->addSteeringFactory(type, factory);
 	return 1;
 }
 
@@ -256,18 +293,16 @@ LUAAIRegistry::LUAAIRegistry() {
 	init();
 }
 
-lua_State* LUAAIRegistry::getLuaState() {
-	return _s;
-}
-
 int LUAAIRegistry::pushAIMetatable() {
-	ai_assert(_s != nullptr, "LUA state is not yet initialized");
-	return luaL_getmetatable(_s, luaAI_metaai());
+	lua_State* s = _states.mainState();
+	ai_assert(s != nullptr, "LUA state is not yet initialized");
+	return luaL_getmetatable(s, luaAI_metaai());
 }
 
 int LUAAIRegistry::pushCharacterMetatable() {
-	ai_assert(_s != nullptr, "LUA state is not yet initialized");
-	return luaL_getmetatable(_s, luaAI_metacharacter());
+	lua_State* s = _states.mainState();
+	ai_assert(s != nullptr, "LUA state is not yet initialized");
+	return luaL_getmetatable(s, luaAI_metacharacter());
 }
 
 static const luaL_Reg registryFuncs[] = {
@@ -278,39 +313,41 @@ static const luaL_Reg registryFuncs[] = {
 	{nullptr, nullptr}
 };
 
-bool LUAAIRegistry::init() {
-	if (_s != nullptr) {
-		return true;
-	}
-	_s = luaL_newstate();
-	lua::clua_registertrace(_s);
+bool LUAAIRegistry::initState(lua_State* s) {
+	lua::clua_registertrace(s);
 
-	lua_atpanic(_s, [] (lua_State* L) {
+	lua_atpanic(s, [] (lua_State* L) {
 		ai_log_error("Lua panic. Error message: %s", (lua_isnil(L, -1) ? "" : lua_tostring(L, -1)));
 		return 0;
 	});
-	lua_gc(_s, LUA_GCSTOP, 0);
-	luaL_openlibs(_s);
+	lua_gc(s, LUA_GCSTOP, 0);
+	luaL_openlibs(s);
 
-	luaAI_registerfuncs(_s, registryFuncs, "META_REGISTRY");
-	lua_setglobal(_s, "REGISTRY");
+	luaAI_registerfuncs(s, registryFuncs, "META_REGISTRY");
+	lua_setglobal(s, "REGISTRY");
 
 	// TODO: random
 
-	luaAI_globalpointer(_s, this, luaAI_metaregistry());
-	luaAI_registerAll(_s);
+	luaAI_globalpointer(s, this, luaAI_metaregistry());
+	luaAI_registerAll(s);
 
 	const char* script = ""
 		"UNKNOWN, CANNOTEXECUTE, RUNNING, FINISHED, FAILED, EXCEPTION = 0, 1, 2, 3, 4, 5\n";
 
-	if (luaL_loadbufferx(_s, script, SDL_strlen(script), "", nullptr) || lua_pcall(_s, 0, 0, 0)) {
-		ai_log_error("%s", lua_tostring(_s, -1));
-		lua_pop(_s, 1);
+	if (luaL_loadbufferx(s, script, SDL_strlen(script), "", nullptr) || lua_pcall(s, 0, 0, 0)) {
+		ai_log_error("%s", lua_tostring(s, -1));
+		lua_pop(s, 1);
 		return false;
 	}
 	return true;
 }
 
+bool LUAAIRegistry::init() {
+	return _states.init([this] (lua_State* s) {
+		return initState(s);
+	});
+}
+
 void LUAAIRegistry::shutdown() {
 	{
 		core::ScopedLock scopedLock(_lock);
@@ -319,10 +356,7 @@ void LUAAIRegistry::shutdown() {
 		_filterFactories.clear();
 		_steeringFactories.clear();
 	}
-	if (_s != nullptr) {
-		lua_close(_s);
-		_s = nullptr;
-	}
+	_states.shutdown();
 }
 
 LUAAIRegistry::~LUAAIRegistry() {
@@ -330,16 +364,7 @@ LUAAIRegistry::~LUAAIRegistry() {
 }
 
 bool LUAAIRegistry::evaluate(const char* luaBuffer, size_t size) {
-	if (_s == nullptr) {
-		ai_log_error("LUA state is not yet initialized");
-		return false;
-	}
-	if (luaL_loadbufferx(_s, luaBuffer, size, "", nullptr) || lua_pcall(_s, 0, 0, 0)) {
-		ai_log_error("%s", lua_tostring(_s, -1));
-		lua_pop(_s, 1);
-		return false;
-	}
-	return true;
+	return _states.evaluate(luaBuffer, size);
 }
 
 void LUAAIRegistry::addTreeNodeFactory(const core::String& type, const LUATreeNodeFactoryPtr& factory) {
@@ -362,4 +387,33 @@ void LUAAIRegistry::addSteeringFactory(const core::String& type, const LUASteeri
 	_steeringFactories.emplace(type, factory);
 }
 
+template<class FACTORY, class MAP>
+static FACTORY* luaAI_findfactory(const MAP& factories, const core::String& type) {
+	auto i = factories.find(type);
+	if (i == factories.end()) {
+		return nullptr;
+	}
+	return i->second.get();
+}
+
+LuaNodeFactory* LUAAIRegistry::treeNodeFactory(const core::String& type) const {
+	core::ScopedLock scopedLock(_lock);
+	return luaAI_findfactory<LuaNodeFactory>(_treeNodeFactories, type);
+}
+
+LuaConditionFactory* LUAAIRegistry::conditionFactory(const core::String& type) const {
+	core::ScopedLock scopedLock(_lock);
+	return luaAI_findfactory<LuaConditionFactory>(_conditionFactories, type);
+}
+
+LuaFilterFactory* LUAAIRegistry::filterFactory(const core::String& type) const {
+	core::ScopedLock scopedLock(_lock);
+	return luaAI_findfactory<LuaFilterFactory>(_filterFactories, type);
+}
+
+LuaSteeringFactory* LUAAIRegistry::steeringFactory(const core::String& type) const {
+	core::ScopedLock scopedLock(_lock);
+	return luaAI_findfactory<LuaSteeringFactory>(_steeringFactories, type);
+}
+
 }
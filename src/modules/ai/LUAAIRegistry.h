@@ -7,6 +7,7 @@
 #include "AIRegistry.h"
 #include "common/Thread.h"
 #include "core/concurrent/Lock.h"
+#include "LUAStatePool.h"
 #include "tree/LUATreeNode.h"
 #include "conditions/LUACondition.h"
 #include "filter/LUAFilter.h"
@@ -82,16 +83,27 @@ typedef std::map<core::String, LUASteeringFactoryPtr> SteeringFactoryMap;
  * @par AI metatable
  * There is a metatable that you can modify by calling @ai{LUAAIRegistry::pushAIMetatable()}.
  * This metatable is applied to all @ai{AI} pointers that are forwarded to the lua functions.
+ *
+ * @par Threads
+ * Every thread that executes the lua nodes, conditions, filters or steerings gets its own lua state
+ * (see @ai{LUAStatePool}). The states are set up by initState() and the scripts that were given to
+ * evaluate().
  */
 class LUAAIRegistry : public AIRegistry {
 protected:
-	lua_State* _s = nullptr;
+	LUAStatePool _states;
 
 	core_trace_mutex(core::Lock, _lock, "LUAAIRegistry");
 	TreeNodeFactoryMap _treeNodeFactories;
 	ConditionFactoryMap _conditionFactories;
 	FilterFactoryMap _filterFactories;
 	SteeringFactoryMap _steeringFactories;
+
+	/**
+	 * @brief Registers the lua functions and globals in a new lua state. This is done for the main
+	 * state in init() and for the state of every thread that is executing lua code.
+	 */
+	bool initState(lua_State* s);
 public:
 	LUAAIRegistry();
 
@@ -100,16 +112,25 @@ public:
 	void addFilterFactory(const core::String& type, const LUAFilterFactoryPtr& factory);
 	void addSteeringFactory(const core::String& type, const LUASteeringFactoryPtr& factory);
 
+	LuaNodeFactory* treeNodeFactory(const core::String& type) const;
+	LuaConditionFactory* conditionFactory(const core::String& type) const;
+	LuaFilterFactory* filterFactory(const core::String& type) const;
+	LuaSteeringFactory* steeringFactory(const core::String& type) const;
+
 	/**
-	 * @brief Access to the lua state.
+	 * @brief Access to the main lua state.
 	 * @see pushAIMetatable()
 	 */
 	lua_State* getLuaState();
 
+	LUAStatePool& statePool();
+
 	/**
-	 * @brief Pushes the AI metatable onto the stack. This allows anyone to modify it
+	 * @brief Pushes the AI metatable of the main state onto the stack. This allows anyone to modify it
 	 * to provide own functions and data that is applied to the @c ai parameters of the
 	 * lua functions.
+	 * @note The states of the other threads don't see these modifications - use lua scripts given to
+	 * evaluate() for modifications that should be visible to all threads
 	 * @note lua_ctxai() can be used in your lua c callbacks to get access to the
 	 * @ai{AI} pointer: @code const AI* ai = lua_ctxai(s, 1); @endcode
 	 */
@@ -139,11 +160,20 @@ public:
 
 	/**
 	 * @brief Load your lua scripts into the lua state of the registry.
-	 * This can be called multiple times to e.g. load multiple files.
+	 * This can be called multiple times to e.g. load multiple files. The states of the other threads
+	 * are evaluating the script before they execute any lua code again.
 	 * @return @c true if the lua script was loaded, @c false otherwise
 	 * @note you have to call init() before
 	 */
 	bool evaluate(const char* luaBuffer, size_t size);
 };
 
+inline lua_State* LUAAIRegistry::getLuaState() {
+	return _states.mainState();
+}
+
+inline LUAStatePool& LUAAIRegistry::statePool() {
+	return _states;
+}
+
 }
@@ -0,0 +1,212 @@
+/**
+ * @file
+ * @ingroup LUA
+ */
+
+#include "LUAStatePool.h"
+#include "common/Log.h"
+
+namespace ai {
+
+static std::atomic<uint32_t> _poolIds { 1u };
+
+LUAStatePool::~LUAStatePool() {
+	shutdown();
+}
+
+bool LUAStatePool::init(const StateInitializer& initializer) {
+	if (_main.s != nullptr) {
+		return true;
+	}
+	_initializer = initializer;
+	_mainThread = std::this_thread::get_id();
+	_main.s = createState();
+	if (_main.s == nullptr) {
+		return false;
+	}
+	_id = _poolIds++;
+	return true;
+}
+
+void LUAStatePool::shutdown() {
+	core::ScopedLock lock(_lock);
+	for (auto& e : _states) {
+		destroy(*e.second);
+		delete e.second;
+	}
+	_states.clear();
+	destroy(_main);
+	_scripts.clear();
+	_scriptCount = 0u;
+	_callbacks.clear();
+	_id = 0u;
+}
+
+lua_State* LUAStatePool::createState() const {
+	lua_State* s = luaL_newstate();
+	if (!_initializer(s)) {
+		lua_close(s);
+		return nullptr;
+	}
+	return s;
+}
+
+void LUAStatePool::destroy(State& state) const {
+	if (state.s != nullptr) {
+		lua_close(state.s);
+	}
+	state = State();
+}
+
+bool LUAStatePool::isMainState(lua_State* s) const {
+	if (_main.s == nullptr) {
+		return false;
+	}
+	lua_rawgeti(s, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+	const lua_State* mainThread = lua_tothread(s, -1);
+	lua_pop(s, 1);
+	return mainThread == _main.s;
+}
+
+LUAStatePool::State* LUAStatePool::state() {
+	static thread_local uint32_t cachedPoolId = 0u;
+	static thread_local State* cachedState = nullptr;
+	State* state;
+	if (_id != 0u && cachedPoolId == _id) {
+		state = cachedState;
+	} else if (_id == 0u || std::this_thread::get_id() == _mainThread) {
+		state = &_main;
+	} else {
+		const std::thread::id threadId = std::this_thread::get_id();
+		core::ScopedLock lock(_lock);
+		auto i = _states.find(threadId);
+		if (i != _states.end()) {
+			state = i->second;
+		} else {
+			state = new State();
+			state->s = createState();
+			if (state->s == nullptr) {
+				ai_log_error("Failed to create the lua state for a new thread");
+			}
+			_states.emplace(threadId, state);
+		}
+		cachedPoolId = _id;
+		cachedState = state;
+	}
+	if (state->s != nullptr && state->scripts < _scriptCount.load(std::memory_order_acquire)) {
+		catchUp(*state);
+	}
+	return state;
+}
+
+void LUAStatePool::catchUp(State& state) {
+	std::vector<core::String> scripts;
+	{
+		core::ScopedLock lock(_lock);
+		scripts.assign(_scripts.begin() + state.scripts, _scripts.end());
+	}
+	for (const core::String& script : scripts) {
+		evaluate(state.s, script.c_str(), script.size());
+	}
+	state.scripts += scripts.size();
+	// the scripts might have assigned other functions
+	releaseFunctionRefs(state);
+}
+
+bool LUAStatePool::evaluate(lua_State* s, const char* luaBuffer, size_t size) {
+	if (luaL_loadbufferx(s, luaBuffer, size, "", nullptr) || lua_pcall(s, 0, 0, 0)) {
+		ai_log_error("%s", lua_tostring(s, -1));
+		lua_pop(s, 1);
+		return false;
+	}
+	return true;
+}
+
+bool LUAStatePool::evaluate(const char* luaBuffer, size_t size) {
+	if (_main.s == nullptr) {
+		ai_log_error("LUA state is not yet initialized");
+		return false;
+	}
+	if (!evaluate(_main.s, luaBuffer, size)) {
+		return false;
+	}
+	releaseFunctionRefs(_main);
+	core::ScopedLock lock(_lock);
+	_scripts.emplace_back(luaBuffer, size);
+	++_main.scripts;
+	_scriptCount.store(_scripts.size(), std::memory_order_release);
+	return true;
+}
+
+void LUAStatePool::releaseFunctionRefs(State& state) const {
+	for (int& ref : state.functionRefs) {
+		luaL_unref(state.s, LUA_REGISTRYINDEX, ref);
+		ref = LUA_NOREF;
+	}
+}
+
+int LUAStatePool::registerCallback(const core::String& registryKey, const char* function) {
+	core::ScopedLock lock(_lock);
+	_callbacks.push_back(Callback{registryKey, function});
+	return (int)_callbacks.size() - 1;
+}
+
+bool LUAStatePool::resolve(State& state, int callbackId) {
+	Callback callback;
+	{
+		core::ScopedLock lock(_lock);
+		if (callbackId < 0 || callbackId >= (int)_callbacks.size()) {
+			ai_log_error("LUA: invalid callback id %i", callbackId);
+			return false;
+		}
+		callback = _callbacks[callbackId];
+	}
+	lua_State* s = state.s;
+	int& selfRef = state.selfRefs[callbackId];
+	if (selfRef == LUA_NOREF) {
+		lua_getfield(s, LUA_REGISTRYINDEX, callback.registryKey.c_str());
+		if (lua_isnil(s, -1)) {
+			ai_log_error("LUA: could not find lua userdata for %s", callback.registryKey.c_str());
+			lua_pop(s, 1);
+			return false;
+		}
+		selfRef = luaL_ref(s, LUA_REGISTRYINDEX);
+	}
+	lua_rawgeti(s, LUA_REGISTRYINDEX, selfRef);
+	if (!lua_getmetatable(s, -1)) {
+		ai_log_error("LUA: userdata for %s doesn't have a metatable assigned", callback.registryKey.c_str());
+		lua_pop(s, 1);
+		return false;
+	}
+	lua_getfield(s, -1, callback.function.c_str());
+	if (!lua_isfunction(s, -1)) {
+		ai_log_error("LUA: metatable for %s doesn't have the %s() function assigned",
+				callback.registryKey.c_str(), callback.function.c_str());
+		lua_pop(s, 3);
+		return false;
+	}
+	state.functionRefs[callbackId] = luaL_ref(s, LUA_REGISTRYINDEX);
+	// pop the metatable and the userdata
+	lua_pop(s, 2);
+	return true;
+}
+
+lua_State* LUAStatePool::pushCallback(int callbackId) {
+	State* state = this->state();
+	lua_State* s = state->s;
+	if (s == nullptr || callbackId < 0) {
+		return nullptr;
+	}
+	if ((size_t)callbackId >= state->functionRefs.size()) {
+		state->selfRefs.resize(callbackId + 1, LUA_NOREF);
+		state->functionRefs.resize(callbackId + 1, LUA_NOREF);
+	}
+	if (state->functionRefs[callbackId] == LUA_NOREF && !resolve(*state, callbackId)) {
+		return nullptr;
+	}
+	lua_rawgeti(s, LUA_REGISTRYINDEX, state->functionRefs[callbackId]);
+	lua_rawgeti(s, LUA_REGISTRYINDEX, state->selfRefs[callbackId]);
+	return s;
+}
+
+}
@@ -0,0 +1,125 @@
+/**
+ * @file
+ * @ingroup LUA
+ */
+#pragma once
+
+#include "commonlua/LUA.h"
+#include "core/String.h"
+#include "core/Trace.h"
+#include "core/concurrent/Lock.h"
+#include <functional>
+#include <unordered_map>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <stdint.h>
+
+namespace ai {
+
+/**
+ * @brief The lua states of the @ai{LUAAIRegistry} - one state for every thread that executes lua
+ * tree nodes, conditions, filters or steerings.
+ *
+ * The thread that called init() is using the main state. Every other thread gets its own state
+ * on first use. This state is set up by the @c StateInitializer and all the scripts that were
+ * evaluated in the main state are evaluated again.
+ *
+ * The userdata and the lua function of a callback (see registerCallback()) are looked up once per
+ * state and are kept in registry slots afterwards.
+ */
+class LUAStatePool {
+public:
+	/**
+	 * @brief Called for every new lua state before the scripts are evaluated
+	 */
+	using StateInitializer = std::function<bool(lua_State*)>;
+private:
+	struct State {
+		lua_State* s = nullptr;
+		// the amount of scripts that were evaluated in this state
+		size_t scripts = 0u;
+		// registry references of the userdata and the function of the callbacks (indexed by the callback id)
+		std::vector<int> selfRefs;
+		std::vector<int> functionRefs;
+	};
+	struct Callback {
+		core::String registryKey;
+		core::String function;
+	};
+	// identifies the states in the thread local cache - a new id is assigned in every init()
+	uint32_t _id = 0u;
+	StateInitializer _initializer;
+	State _main;
+	std::thread::id _mainThread;
+
+	core_trace_mutex(core::Lock, _lock, "LUAStatePool");
+	std::unordered_map<std::thread::id, State*> _states;
+	std::vector<core::String> _scripts;
+	std::atomic<size_t> _scriptCount { 0u };
+	std::vector<Callback> _callbacks;
+
+	State* state();
+	lua_State* createState() const;
+	void catchUp(State& state);
+	bool resolve(State& state, int callbackId);
+	void releaseFunctionRefs(State& state) const;
+	void destroy(State& state) const;
+	static bool evaluate(lua_State* s, const char* luaBuffer, size_t size);
+public:
+	~LUAStatePool();
+
+	/**
+	 * @brief Creates the main state for the calling thread
+	 */
+	bool init(const StateInitializer& initializer);
+	/**
+	 * @brief Closes all lua states
+	 * @note Make sure that no other thread is executing lua code anymore
+	 */
+	void shutdown();
+
+	/**
+	 * @return The state of the thread that called init()
+	 */
+	lua_State* mainState() const;
+	/**
+	 * @return The state of the calling thread
+	 */
+	lua_State* luaState();
+	/**
+	 * @return @c true if the given state (or coroutine) belongs to the main state
+	 */
+	bool isMainState(lua_State* s) const;
+
+	/**
+	 * @brief Evaluates the script in the main state. The states of the other threads evaluate it
+	 * the next time they are used.
+	 */
+	bool evaluate(const char* luaBuffer, size_t size);
+
+	/**
+	 * @param[in] registryKey The key of the userdata in the lua registry
+	 * @param[in] function The name of the function in the metatable of the userdata
+	 * @return The id of the callback that is given to pushCallback()
+	 */
+	int registerCallback(const core::String& registryKey, const char* function);
+
+	/**
+	 * @brief Pushes the function and the userdata (as first parameter) of the callback onto the
+	 * stack of the state of the calling thread
+	 * @return The state of the calling thread - or @c nullptr if the callback couldn't get resolved.
+	 * Nothing was pushed onto the stack in this case.
+	 */
+	lua_State* pushCallback(int callbackId);
+};
+
+inline lua_State* LUAStatePool::mainState() const {
+	return _main.s;
+}
+
+inline lua_State* LUAStatePool::luaState() {
+	return state()->s;
+}
+
+}
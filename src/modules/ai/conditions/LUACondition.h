@@ -7,6 +7,7 @@
 
 #include "ICondition.h"
 #include "../LUAFunctions.h"
+#include "../LUAStatePool.h"
 
 namespace ai {
 
@@ -15,81 +16,66 @@ namespace ai {
  */
 class LUACondition : public ICondition {
 protected:
-	lua_State* _s;
+	LUAStatePool* _states;
+	// the evaluate() function of the condition userdata
+	int _callbackId;
 
 	bool evaluateLUA(const AIPtr& entity) {
-		// get userdata of the condition
-		const core::String name = "__meta_condition_" + _name;
-		lua_getfield(_s, LUA_REGISTRYINDEX, name.c_str());
-#if AI_LUA_SANTITY > 0
-		if (lua_isnil(_s, -1)) {
-			ai_log_error("LUA condition: could not find lua userdata for %s", _name.c_str());
-			return false;
-		}
-#endif
-		// get metatable
-		lua_getmetatable(_s, -1);
-#if AI_LUA_SANTITY > 0
-		if (!lua_istable(_s, -1)) {
-			ai_log_error("LUA condition: userdata for %s doesn't have a metatable assigned", _name.c_str());
+		// push the evaluate() method and self onto the stack of the lua state of this thread
+		lua_State* s = _states->pushCallback(_callbackId);
+		if (s == nullptr) {
+			ai_log_error("LUA condition: could not resolve the evaluate() function of %s", _name.c_str());
 			return false;
 		}
-#endif
-		// get evaluate() method
-		lua_getfield(_s, -1, "evaluate");
-		if (!lua_isfunction(_s, -1)) {
-			ai_log_error("LUA condition: metatable for %s doesn't have the evaluate() function assigned", _name.c_str());
-			return false;
-		}
-
-		// push self onto the stack
-		lua_getfield(_s, LUA_REGISTRYINDEX, name.c_str());
 
 		// first parameter is ai
-		if (luaAI_pushai(_s, entity) == 0) {
+		if (luaAI_pushai(s, entity) == 0) {
+			lua_pop(s, lua_gettop(s));
 			return false;
 		}
 
 #if AI_LUA_SANTITY > 0
-		if (!lua_isfunction(_s, -3)) {
+		if (!lua_isfunction(s, -3)) {
 			ai_log_error("LUA condition: expected to find a function on stack -3");
 			return false;
 		}
-		if (!lua_isuserdata(_s, -2)) {
+		if (!lua_isuserdata(s, -2)) {
 			ai_log_error("LUA condition: expected to find the userdata on -2");
 			return false;
 		}
-		if (!lua_isuserdata(_s, -1)) {
+		if (!lua_isuserdata(s, -1)) {
 			ai_log_error("LUA condition: second parameter should be the ai");
 			return false;
 		}
 #endif
-		const int error = lua_pcall(_s, 2, 1, 0);
+		const int error = lua_pcall(s, 2, 1, 0);
 		if (error) {
-			ai_log_error("LUA condition script: %s", lua_isstring(_s, -1) ? lua_tostring(_s, -1) : "Unknown Error");
+			ai_log_error("LUA condition script: %s", lua_isstring(s, -1) ? lua_tostring(s, -1) : "Unknown Error");
 			// reset stack
-			lua_pop(_s, lua_gettop(_s));
+			lua_pop(s, lua_gettop(s));
 			return false;
 		}
-		const int state = lua_toboolean(_s, -1);
+		const int state = lua_toboolean(s, -1);
 		if (state != 0 && state != 1) {
 			ai_log_error("LUA condition: illegal evaluate() value returned: %i", state);
 			return false;
 		}
 
 		// reset stack
-		lua_pop(_s, lua_gettop(_s));
+		lua_pop(s, lua_gettop(s));
 		return state == 1;
 	}
 
 public:
 	class LUAConditionFactory : public IConditionFactory {
 	private:
-		lua_State* _s;
+		LUAStatePool* _states;
 		core::String _type;
+		int _callbackId;
 	public:
-		LUAConditionFactory(lua_State* s, const core::String& typeStr) :
-				_s(s), _type(typeStr) {
+		LUAConditionFactory(LUAStatePool* states, const core::String& typeStr) :
+				_states(states), _type(typeStr) {
+			_callbackId = _states->registerCallback("__meta_condition_" + _type, "evaluate");
 		}
 
 		inline const core::String& type() const {
@@ -97,12 +83,12 @@ public:
 		}
 
 		ConditionPtr create(const ConditionFactoryContext* ctx) const override {
-			return std::make_shared<LUACondition>(_type, ctx->parameters, _s);
+			return std::make_shared<LUACondition>(_type, ctx->parameters, _states, _callbackId);
 		}
 	};
 
-	LUACondition(const core::String& name, const core::String& parameters, lua_State* s) :
-			ICondition(name, parameters), _s(s) {
+	LUACondition(const core::String& name, const core::String& parameters, LUAStatePool* states, int callbackId) :
+			ICondition(name, parameters), _states(states), _callbackId(callbackId) {
 	}
 
 	~LUACondition() {
@@ -7,6 +7,7 @@
 
 #include "IFilter.h"
 #include "../LUAFunctions.h"
+#include "../LUAStatePool.h"
 
 namespace ai {
 
@@ -15,71 +16,56 @@ namespace ai {
  */
 class LUAFilter : public IFilter {
 protected:
-	lua_State* _s;
+	LUAStatePool* _states;
+	// the filter() function of the filter userdata
+	int _callbackId;
 
 	void filterLUA(const AIPtr& entity) {
-		// get userdata of the filter
-		const core::String name = "__meta_filter_" + _name;
-		lua_getfield(_s, LUA_REGISTRYINDEX, name.c_str());
-#if AI_LUA_SANTITY > 0
-		if (lua_isnil(_s, -1)) {
-			ai_log_error("LUA filter: could not find lua userdata for %s", _name.c_str());
-			return;
-		}
-#endif
-		// get metatable
-		lua_getmetatable(_s, -1);
-#if AI_LUA_SANTITY > 0
-		if (!lua_istable(_s, -1)) {
-			ai_log_error("LUA filter: userdata for %s doesn't have a metatable assigned", _name.c_str());
+		// push the filter() method and self onto the stack of the lua state of this thread
+		lua_State* s = _states->pushCallback(_callbackId);
+		if (s == nullptr) {
+			ai_log_error("LUA filter: could not resolve the filter() function of %s", _name.c_str());
 			return;
 		}
-#endif
-		// get filter() method
-		lua_getfield(_s, -1, "filter");
-		if (!lua_isfunction(_s, -1)) {
-			ai_log_error("LUA filter: metatable for %s doesn't have the filter() function assigned", _name.c_str());
-			return;
-		}
-
-		// push self onto the stack
-		lua_getfield(_s, LUA_REGISTRYINDEX, name.c_str());
 
 		// first parameter is ai
-		if (luaAI_pushai(_s, entity) == 0) {
+		if (luaAI_pushai(s, entity) == 0) {
+			lua_pop(s, lua_gettop(s));
 			return;
 		}
 #if AI_LUA_SANTITY > 0
-		if (!lua_isfunction(_s, -3)) {
+		if (!lua_isfunction(s, -3)) {
 			ai_log_error("LUA filter: expected to find a function on stack -3");
 			return;
 		}
-		if (!lua_isuserdata(_s, -2)) {
+		if (!lua_isuserdata(s, -2)) {
 			ai_log_error("LUA filter: expected to find the userdata on -2");
 			return;
 		}
-		if (!lua_isuserdata(_s, -1)) {
+		if (!lua_isuserdata(s, -1)) {
 			ai_log_error("LUA filter: second parameter should be the ai");
 			return;
 		}
 #endif
-		const int error = lua_pcall(_s, 2, 0, 0);
+		const int error = lua_pcall(s, 2, 0, 0);
 		if (error) {
-			ai_log_error("LUA filter script: %s", lua_isstring(_s, -1) ? lua_tostring(_s, -1) : "Unknown Error");
+			ai_log_error("LUA filter script: %s", lua_isstring(s, -1) ? lua_tostring(s, -1) : "Unknown Error");
 		}
 
 		// reset stack
-		lua_pop(_s, lua_gettop(_s));
+		lua_pop(s, lua_gettop(s));
 	}
 
 public:
 	class LUAFilterFactory : public IFilterFactory {
 	private:
-		lua_State* _s;
+		LUAStatePool* _states;
 		core::String _type;
+		int _callbackId;
 	public:
-		LUAFilterFactory(lua_State* s, const core::String& typeStr) :
-				_s(s), _type(typeStr) {
+		LUAFilterFactory(LUAStatePool* states, const core::String& typeStr) :
+				_states(states), _type(typeStr) {
+			_callbackId = _states->registerCallback("__meta_filter_" + _type, "filter");
 		}
 
 		inline const core::String& type() const {
@@ -87,12 +73,12 @@ public:
 		}
 
 		FilterPtr create(const FilterFactoryContext* ctx) const override {
-			return std::make_shared<LUAFilter>(_type, ctx->parameters, _s);
+			return std::make_shared<LUAFilter>(_type, ctx->parameters, _states, _callbackId);
 		}
 	};
 
-	LUAFilter(const core::String& name, const core::String& parameters, lua_State* s) :
-			IFilter(name, parameters), _s(s) {
+	LUAFilter(const core::String& name, const core::String& parameters, LUAStatePool* states, int callbackId) :
+			IFilter(name, parameters), _states(states), _callbackId(callbackId) {
 	}
 
 	~LUAFilter() {
@@ -6,6 +6,7 @@
 
 #include "Steering.h"
 #include "commonlua/LUA.h"
+#include "../LUAStatePool.h"
 
 namespace ai {
 namespace movement {
@@ -15,7 +16,9 @@ namespace movement {
  */
 class LUASteering : public ISteering {
 protected:
-	mutable lua_State* _s;
+	LUAStatePool* _states;
+	// the execute() function of the steering userdata
+	int _callbackId;
 	core::String _type;
 
 	MoveVector executeLUA(const AIPtr& entity, float speed) const;
@@ -23,11 +26,13 @@ protected:
 public:
 	class LUASteeringFactory : public ISteeringFactory {
 	private:
-		lua_State* _s;
+		LUAStatePool* _states;
 		core::String _type;
+		int _callbackId;
 	public:
-		LUASteeringFactory(lua_State* s, const core::String& typeStr) :
-				_s(s), _type(typeStr) {
+		LUASteeringFactory(LUAStatePool* states, const core::String& typeStr) :
+				_states(states), _type(typeStr) {
+			_callbackId = _states->registerCallback("__meta_steering_" + _type, "execute");
 		}
 
 		inline const core::String& type() const {
@@ -35,11 +40,11 @@ public:
 		}
 
 		SteeringPtr create(const SteeringFactoryContext* ctx) const override {
-			return std::make_shared<LUASteering>(_s, _type);
+			return std::make_shared<LUASteering>(_states, _callbackId, _type);
 		}
 	};
 
-	LUASteering(lua_State* s, const core::String& type);
+	LUASteering(LUAStatePool* states, int callbackId, const core::String& type);
 
 	~LUASteering() {
 	}
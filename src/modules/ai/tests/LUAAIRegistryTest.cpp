@@ -7,6 +7,9 @@
 #include "core/io/Filesystem.h"
 #include <fstream>
 #include <streambuf>
+#include <thread>
+#include <vector>
+#include <atomic>
 
 class LUAAIRegistryTest: public TestSuite {
 protected:
@@ -153,3 +156,32 @@ TEST_F(LUAAIRegistryTest, testFilter_100) {
 TEST_F(LUAAIRegistryTest, testSteeringEmpty) {
 	testSteering("LuaSteeringTest");
 }
+
+TEST_F(LUAAIRegistryTest, testLuaNodeMultipleThreads) {
+	const ai::TreeNodeFactoryContext ctx = ai::TreeNodeFactoryContext("TreeNodeName", "", ai::True::get());
+	const ai::TreeNodePtr& node = _registry.createNode("LuaTest2", ctx);
+	ASSERT_TRUE((bool)node);
+	const ai::ConditionPtr& condition = _registry.createCondition("LuaTestTrue", ctxCondition);
+	ASSERT_TRUE((bool)condition);
+	const int threads = 4;
+	std::atomic_int failures(0);
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; ++t) {
+		workers.emplace_back([&] () {
+			const ai::AIPtr& ai = std::make_shared<ai::AI>(node);
+			ai->setCharacter(_chr);
+			for (int i = 0; i < 100; ++i) {
+				if (node->execute(ai, 1L) != ai::TreeNodeStatus::RUNNING) {
+					++failures;
+				}
+				if (!condition->evaluate(ai)) {
+					++failures;
+				}
+			}
+		});
+	}
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	EXPECT_EQ(0, failures) << "Every thread should execute the lua node in its own lua state";
+}
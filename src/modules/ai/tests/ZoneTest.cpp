@@ -4,6 +4,7 @@
 
 #include "TestShared.h"
 #include "tree/PrioritySelector.h"
+#include <atomic>
 
 class ZoneTest: public TestSuite {
 };
@@ -47,3 +48,47 @@ TEST_F(ZoneTest, testMassAdd1000000) {
 	zone.update(0l);
 	ASSERT_EQ(n, (int)zone.size());
 }
+
+TEST_F(ZoneTest, testRemoveKeepsLookup) {
+	ai::Zone zone("test1");
+	ai::TreeNodePtr root = std::make_shared<ai::PrioritySelector>("test", "", ai::True::get());
+	std::vector<ai::AIPtr> ais;
+	for (int i = 0; i < 5; ++i) {
+		ai::ICharacterPtr character = std::make_shared<TestEntity>(i);
+		ai::AIPtr ai = std::make_shared<ai::AI>(root);
+		ai->setCharacter(character);
+		ais.push_back(ai);
+		ASSERT_TRUE(zone.addAI(ai));
+	}
+	zone.update(1);
+	ASSERT_TRUE(zone.removeAI(ais[1]));
+	ASSERT_TRUE(zone.destroyAI(3));
+	zone.update(1);
+	ASSERT_EQ(3, (int)zone.size());
+	EXPECT_FALSE(zone.getAI(1));
+	EXPECT_FALSE(zone.getAI(3));
+	EXPECT_EQ(ais[0], zone.getAI(0));
+	EXPECT_EQ(ais[2], zone.getAI(2));
+	EXPECT_EQ(ais[4], zone.getAI(4));
+}
+
+TEST_F(ZoneTest, testExecuteParallelGrainSize) {
+	ai::Zone zone("test1", 2, 7);
+	ai::TreeNodePtr root = std::make_shared<ai::PrioritySelector>("test", "", ai::True::get());
+	const int n = 100;
+	for (int i = 0; i < n; ++i) {
+		ai::ICharacterPtr character = std::make_shared<TestEntity>(i);
+		ai::AIPtr ai = std::make_shared<ai::AI>(root);
+		ai->setCharacter(character);
+		ASSERT_TRUE(zone.addAI(ai));
+	}
+	zone.update(1);
+	std::atomic_int count { 0 };
+	std::atomic_int64_t ids { 0 };
+	zone.executeParallel([&] (const ai::AIPtr& ai) {
+		++count;
+		ids += ai->getId();
+	});
+	EXPECT_EQ(n, count);
+	EXPECT_EQ(n * (n - 1) / 2, ids);
+}
@@ -6,6 +6,7 @@
 
 #include "tree/TreeNode.h"
 #include "../LUAFunctions.h"
+#include "../LUAStatePool.h"
 #include "common/Common.h"
 
 namespace ai {
@@ -15,87 +16,72 @@ namespace ai {
  */
 class LUATreeNode : public TreeNode {
 protected:
-	lua_State* _s;
+	LUAStatePool* _states;
+	// the execute() function of the node userdata
+	int _callbackId;
 
 	TreeNodeStatus runLUA(const AIPtr& entity, int64_t deltaMillis) {
-		// get userdata of the behaviour tree node
-		const core::String name = "__meta_node_" + _type;
-		lua_getfield(_s, LUA_REGISTRYINDEX, name.c_str());
-#if AI_LUA_SANTITY > 0
-		if (lua_isnil(_s, -1)) {
-			ai_log_error("LUA node: could not find lua userdata for %s", name.c_str());
-			return TreeNodeStatus::EXCEPTION;
-		}
-#endif
-		// get metatable
-		lua_getmetatable(_s, -1);
-#if AI_LUA_SANTITY > 0
-		if (!lua_istable(_s, -1)) {
-			ai_log_error("LUA node: userdata for %s doesn't have a metatable assigned", name.c_str());
+		// push the execute() method and self onto the stack of the lua state of this thread
+		lua_State* s = _states->pushCallback(_callbackId);
+		if (s == nullptr) {
+			ai_log_error("LUA node: could not resolve the execute() function of %s", _type.c_str());
 			return TreeNodeStatus::EXCEPTION;
 		}
-#endif
-		// get execute() method
-		lua_getfield(_s, -1, "execute");
-		if (!lua_isfunction(_s, -1)) {
-			ai_log_error("LUA node: metatable for %s doesn't have the execute() function assigned", name.c_str());
-			return TreeNodeStatus::EXCEPTION;
-		}
-
-		// push self onto the stack
-		lua_getfield(_s, LUA_REGISTRYINDEX, name.c_str());
 
 		// first parameter is ai
-		if (luaAI_pushai(_s, entity) == 0) {
+		if (luaAI_pushai(s, entity) == 0) {
+			lua_pop(s, lua_gettop(s));
 			return TreeNodeStatus::EXCEPTION;
 		}
 
 		// second parameter is dt
-		lua_pushinteger(_s, deltaMillis);
+		lua_pushinteger(s, deltaMillis);
 
 #if AI_LUA_SANTITY > 0
-		if (!lua_isfunction(_s, -4)) {
+		if (!lua_isfunction(s, -4)) {
 			ai_log_error("LUA node: expected to find a function on stack -4");
 			return TreeNodeStatus::EXCEPTION;
 		}
-		if (!lua_isuserdata(_s, -3)) {
+		if (!lua_isuserdata(s, -3)) {
 			ai_log_error("LUA node: expected to find the userdata on -3");
 			return TreeNodeStatus::EXCEPTION;
 		}
-		if (!lua_isuserdata(_s, -2)) {
+		if (!lua_isuserdata(s, -2)) {
 			ai_log_error("LUA node: second parameter should be the ai");
 			return TreeNodeStatus::EXCEPTION;
 		}
-		if (!lua_isinteger(_s, -1)) {
+		if (!lua_isinteger(s, -1)) {
 			ai_log_error("LUA node: first parameter should be the delta millis");
 			return TreeNodeStatus::EXCEPTION;
 		}
 #endif
-		const int error = lua_pcall(_s, 3, 1, 0);
+		const int error = lua_pcall(s, 3, 1, 0);
 		if (error) {
-			ai_log_error("LUA node script: %s", lua_isstring(_s, -1) ? lua_tostring(_s, -1) : "Unknown Error");
+			ai_log_error("LUA node script: %s", lua_isstring(s, -1) ? lua_tostring(s, -1) : "Unknown Error");
 			// reset stack
-			lua_pop(_s, lua_gettop(_s));
+			lua_pop(s, lua_gettop(s));
 			return TreeNodeStatus::EXCEPTION;
 		}
-		const lua_Integer execstate = luaL_checkinteger(_s, -1);
+		const lua_Integer execstate = luaL_checkinteger(s, -1);
 		if (execstate < 0 || execstate >= (lua_Integer)TreeNodeStatus::MAX_TREENODESTATUS) {
 			ai_log_error("LUA node: illegal tree node status returned: " LUA_INTEGER_FMT, execstate);
 		}
 
 		// reset stack
-		lua_pop(_s, lua_gettop(_s));
+		lua_pop(s, lua_gettop(s));
 		return (TreeNodeStatus)execstate;
 	}
 
 public:
 	class LUATreeNodeFactory : public ITreeNodeFactory {
 	private:
-		lua_State* _s;
+		LUAStatePool* _states;
 		core::String _type;
+		int _callbackId;
 	public:
-		LUATreeNodeFactory(lua_State* s, const core::String& typeStr) :
-				_s(s), _type(typeStr) {
+		LUATreeNodeFactory(LUAStatePool* states, const core::String& typeStr) :
+				_states(states), _type(typeStr) {
+			_callbackId = _states->registerCallback("__meta_node_" + _type, "execute");
 		}
 
 		inline const core::String& type() const {
@@ -103,12 +89,12 @@ public:
 		}
 
 		TreeNodePtr create(const TreeNodeFactoryContext* ctx) const override {
-			return std::make_shared<LUATreeNode>(ctx->name, ctx->parameters, ctx->condition, _s, _type);
+			return std::make_shared<LUATreeNode>(ctx->name, ctx->parameters, ctx->condition, _states, _callbackId, _type);
 		}
 	};
 
-	LUATreeNode(const core::String& name, const core::String& parameters, const ConditionPtr& condition, lua_State* s, const core::String& type) :
-			TreeNode(name, parameters, condition), _s(s) {
+	LUATreeNode(const core::String& name, const core::String& parameters, const ConditionPtr& condition, LUAStatePool* states, int callbackId, const core::String& type) :
+			TreeNode(name, parameters, condition), _states(states), _callbackId(callbackId) {
 		_type = type;
 	}
 
@@ -4,17 +4,17 @@
 
 #include "Zone.h"
 #include "core/Trace.h"
+#include "core/TimeProvider.h"
 
 namespace ai {
 
 AIPtr Zone::getAI(CharacterId id) const {
 	core::ScopedLock scopedLock(_lock);
-	auto i = _ais.find(id);
-	if (i == _ais.end()) {
+	auto i = _aiIndices.find(id);
+	if (i == _aiIndices.end()) {
 		return AIPtr();
 	}
-	const AIPtr& ai = i->second;
-	return ai;
+	return _ais[i->second];
 }
 
 std::size_t Zone::size() const {
@@ -27,35 +27,50 @@ bool Zone::doAddAI(const AIPtr& ai) {
 		return false;
 	}
 	const CharacterId& id = ai->getCharacter()->getId();
-	if (_ais.find(id) != _ais.end()) {
+	if (!_aiIndices.insert(std::make_pair(id, _ais.size())).second) {
 		return false;
 	}
-	_ais.insert(std::make_pair(id, ai));
+	_ais.push_back(ai);
 	ai->setZone(this);
 	return true;
 }
 
+void Zone::removeAt(size_t index) {
+	// fill the gap with the last entry to keep the list contiguous
+	const size_t last = _ais.size() - 1;
+	if (index != last) {
+		_ais[index] = std::move(_ais[last]);
+		_aiIndices[_ais[index]->getCharacter()->getId()] = index;
+	}
+	_ais.pop_back();
+}
+
 bool Zone::doRemoveAI(const AIPtr& ai) {
 	if (!ai) {
 		return false;
 	}
 	const CharacterId& id = ai->getCharacter()->getId();
-	AIMapIter i = _ais.find(id);
-	if (i == _ais.end()) {
+	auto i = _aiIndices.find(id);
+	if (i == _aiIndices.end()) {
 		return false;
 	}
-	i->second->setZone(nullptr);
-	_groupManager.removeFromAllGroups(i->second);
-	_ais.erase(i);
+	const size_t index = i->second;
+	_aiIndices.erase(i);
+	const AIPtr& existing = _ais[index];
+	existing->setZone(nullptr);
+	_groupManager.removeFromAllGroups(existing);
+	removeAt(index);
 	return true;
 }
 
 bool Zone::doDestroyAI(const CharacterId& id) {
-	AIMapIter i = _ais.find(id);
-	if (i == _ais.end()) {
+	auto i = _aiIndices.find(id);
+	if (i == _aiIndices.end()) {
 		return false;
 	}
-	_ais.erase(i);
+	const size_t index = i->second;
+	_aiIndices.erase(i);
+	removeAt(index);
 	return true;
 }
 
@@ -85,6 +100,7 @@ bool Zone::removeAI(const AIPtr& ai) {
 
 void Zone::update(int64_t dt) {
 	core_trace_scoped(ZoneUpdate);
+	const uint64_t start = core::TimeProvider::highResTime();
 	{
 		AIScheduleList scheduledRemove;
 		AIScheduleList scheduledAdd;
@@ -117,8 +133,10 @@ void Zone::update(int64_t dt) {
 		ai->update(dt, _debug);
 		ai->getBehaviour()->execute(ai, dt);
 	};
-	executeParallel(func);
+	// the list is only modified in this method - so we don't need a copy here
+	parallelFor(_ais, func);
 	_groupManager.update(dt);
+	_updateMicros = (core::TimeProvider::highResTime() - start) * 1000000u / core::TimeProvider::highResTimeResolution();
 }
 
 }
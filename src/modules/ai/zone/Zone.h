@@ -23,6 +23,7 @@
 #include <unordered_map>
 #include <vector>
 #include <memory>
+#include <algorithm>
 
 namespace ai {
 
@@ -40,15 +41,20 @@ typedef std::shared_ptr<AI> AIPtr;
  */
 class Zone {
 public:
-	typedef std::unordered_map<CharacterId, AIPtr> AIMap;
+	typedef std::vector<AIPtr> AIList;
+	typedef std::unordered_map<CharacterId, size_t> AIIndexMap;
 	typedef std::vector<AIPtr> AIScheduleList;
 	typedef std::vector<CharacterId> CharacterIdList;
-	typedef AIMap::const_iterator AIMapConstIter;
-	typedef AIMap::iterator AIMapIter;
+	/**
+	 * @brief The amount of @c AI instances that are updated in one task of the thread pool
+	 */
+	static constexpr int DefaultGrainSize = 64;
 
 protected:
 	const core::String _name;
-	AIMap _ais;
+	// contiguous - the index of the ai in this list is stored in _aiIndices
+	AIList _ais;
+	AIIndexMap _aiIndices;
 	AIScheduleList _scheduledAdd;
 	AIScheduleList _scheduledRemove;
 	CharacterIdList _scheduledDestroy;
@@ -57,6 +63,32 @@ protected:
 	core_trace_mutex(core::Lock, _scheduleLock, "AIScheduleZone");
 	ai::GroupMgr _groupManager;
 	mutable core::ThreadPool _threadPool;
+	int _grainSize;
+	uint64_t _updateMicros = 0u;
+
+	/**
+	 * @brief Splits the given list into batches of @c _grainSize instances and executes the batches
+	 * in the thread pool. We are waiting for the execution of this.
+	 */
+	template<typename Func>
+	void parallelFor(const AIList& ais, Func& func) const {
+		core_trace_scoped(ZoneParallelFor);
+		const int n = (int)ais.size();
+		const int grainSize = std::max(1, _grainSize);
+		core::TaskGroup group;
+		for (int begin = 0; begin < n; begin += grainSize) {
+			const int end = std::min(n, begin + grainSize);
+			_threadPool.schedule(group, [&ais, &func, begin, end] () {
+				for (int i = begin; i < end; ++i) {
+					func(ais[i]);
+				}
+			});
+		}
+		// only the threads of the zone are executing the ai - the calling thread doesn't help here
+		_threadPool.wait(group, false);
+	}
+
+	void removeAt(size_t index);
 
 	/**
 	 * @brief called in the zone update to add new @c AI instances.
@@ -79,8 +111,8 @@ protected:
 	bool doDestroyAI(const CharacterId& id);
 
 public:
-	Zone(const core::String& name, int threadCount = 1) :
-			_name(name), _debug(false), _threadPool(threadCount) {
+	Zone(const core::String& name, int threadCount = 1, int grainSize = DefaultGrainSize) :
+			_name(name), _debug(false), _threadPool(threadCount), _grainSize(grainSize) {
 		_threadPool.init();
 	}
 
@@ -95,6 +127,18 @@ public:
 	 */
 	void update(int64_t dt);
 
+	/**
+	 * @return The time in microseconds the last @c update() call took
+	 */
+	uint64_t lastUpdateMicros() const;
+
+	/**
+	 * @brief The amount of @c AI instances that are updated in one task of the thread pool
+	 */
+	void setGrainSize(int grainSize);
+	int grainSize() const;
+	int threads() const;
+
 	/**
 	 * @brief If you need to add new @code AI entities to a zone from within the @code AI tick (e.g. spawning via behaviour
 	 * tree) - then you need to schedule the spawn. Otherwise you will end up in a deadlock
@@ -253,17 +297,10 @@ public:
 	template<typename Func>
 	void executeParallel(Func& func) {
 		core_trace_scoped(ZoneExecuteParallel);
-		std::vector<std::future<void> > results;
 		_lock.lock();
-		AIMap copy(_ais);
+		const AIList copy(_ais);
 		_lock.unlock();
-		for (auto i = copy.begin(); i != copy.end(); ++i) {
-			const AIPtr& ai = i->second;
-			results.emplace_back(executeAsync(ai, func));
-		}
-		for (auto & result: results) {
-			result.wait();
-		}
+		parallelFor(copy, func);
 	}
 
 	/**
@@ -276,17 +313,10 @@ public:
 	template<typename Func>
 	void executeParallel(const Func& func) const {
 		core_trace_scoped(ZoneExecuteParallel);
-		std::vector<std::future<void> > results;
 		_lock.lock();
-		AIMap copy(_ais);
+		const AIList copy(_ais);
 		_lock.unlock();
-		for (auto i = copy.begin(); i != copy.end(); ++i) {
-			const AIPtr& ai = i->second;
-			results.emplace_back(executeAsync(ai, func));
-		}
-		for (auto & result: results) {
-			result.wait();
-		}
+		parallelFor(copy, func);
 	}
 
 	/**
@@ -299,10 +329,9 @@ public:
 	void execute(const Func& func) const {
 		core_trace_scoped(ZoneExecute);
 		_lock.lock();
-		AIMap copy(_ais);
+		const AIList copy(_ais);
 		_lock.unlock();
-		for (auto i = copy.begin(); i != copy.end(); ++i) {
-			const AIPtr& ai = i->second;
+		for (const AIPtr& ai : copy) {
 			func(ai);
 		}
 	}
@@ -317,10 +346,9 @@ public:
 	void execute(Func& func) {
 		core_trace_scoped(ZoneExecute);
 		_lock.lock();
-		AIMap copy(_ais);
+		const AIList copy(_ais);
 		_lock.unlock();
-		for (auto i = copy.begin(); i != copy.end(); ++i) {
-			const AIPtr& ai = i->second;
+		for (const AIPtr& ai : copy) {
 			func(ai);
 		}
 	}
@@ -336,6 +364,22 @@ inline bool Zone::isDebug () const {
 	return _debug;
 }
 
+inline uint64_t Zone::lastUpdateMicros() const {
+	return _updateMicros;
+}
+
+inline void Zone::setGrainSize(int grainSize) {
+	_grainSize = grainSize;
+}
+
+inline int Zone::grainSize() const {
+	return _grainSize;
+}
+
+inline int Zone::threads() const {
+	return (int)_threadPool.size();
+}
+
 inline const core::String& Zone::getName() const {
 	return _name;
 }
@@ -2,6 +2,7 @@
 
 #include <memory>
 #include "entity/EntityId.h"
+#include <vector>
 #include "core/SharedPtr.h"
 
 namespace voxelworld {
@@ -86,6 +87,10 @@ typedef std::shared_ptr<AILoader> AILoaderPtr;
 
 class Entity;
 typedef std::shared_ptr<Entity> EntityPtr;
+/**
+ * @brief List of entities - sorted by their id if not stated otherwise
+ */
+typedef std::vector<EntityPtr> EntityList;
 
 class User;
 typedef std::shared_ptr<User> UserPtr;
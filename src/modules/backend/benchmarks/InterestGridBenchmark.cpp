@@ -0,0 +1,152 @@
+/**
+ * @file
+ */
+
+#include "core/benchmark/AbstractBenchmark.h"
+#include "core/collection/Set.h"
+#include "backend/world/InterestGrid.h"
+#include "math/QuadTree.h"
+#include "math/Rect.h"
+#include <unordered_set>
+#include <random>
+
+namespace {
+
+constexpr int Npcs = 10000;
+constexpr int Users = 500;
+constexpr float WorldSize = 4096.0f;
+constexpr float NpcViewDistance = 50.0f;
+constexpr float UserViewDistance = 500.0f;
+// every tick this fraction of the npcs is wandering around - all users are moving
+constexpr int MovingNpcsPercent = 10;
+
+struct BenchEntity {
+	backend::EntityId id;
+	glm::vec3 pos;
+	float viewDistance;
+	std::unordered_set<backend::EntityId> visible;
+};
+
+}
+
+class InterestGridBenchmark : public core::AbstractBenchmark {
+protected:
+	std::vector<BenchEntity> _entities;
+	std::mt19937 _rnd { 4711 };
+
+	bool onInitApp() override {
+		_rnd.seed(4711);
+		std::uniform_real_distribution<float> dist(0.0f, WorldSize);
+		_entities.clear();
+		_entities.resize(Npcs + Users);
+		for (int i = 0; i < Npcs + Users; ++i) {
+			BenchEntity& e = _entities[i];
+			e.id = i + 1;
+			e.pos = glm::vec3(dist(_rnd), 0.0f, dist(_rnd));
+			e.viewDistance = i < Npcs ? NpcViewDistance : UserViewDistance;
+		}
+		return true;
+	}
+
+	bool moves(int index, int tick) const {
+		return index >= Npcs || (index + tick) % 100 < MovingNpcsPercent;
+	}
+
+	void move(BenchEntity& e) {
+		std::uniform_real_distribution<float> step(-1.0f, 1.0f);
+		e.pos.x = glm::clamp(e.pos.x + step(_rnd), 0.0f, WorldSize);
+		e.pos.z = glm::clamp(e.pos.z + step(_rnd), 0.0f, WorldSize);
+	}
+};
+
+struct QuadTreeNode {
+	BenchEntity* entity;
+
+	math::RectFloat getRect() const {
+		return math::RectFloat(entity->pos.x - 0.5f, entity->pos.z - 0.5f, entity->pos.x + 0.5f, entity->pos.z + 0.5f);
+	}
+
+	bool operator==(const QuadTreeNode& rhs) const {
+		return rhs.entity == entity;
+	}
+};
+
+/**
+ * @brief The way the visible sets were calculated before - a full quad tree query per entity and tick and
+ * hash set operations on the results
+ */
+BENCHMARK_DEFINE_F(InterestGridBenchmark, QuadTreeFullQuery) (benchmark::State& state) {
+	math::QuadTree<QuadTreeNode, float> quadTree(math::RectFloat::getMaxRect(), 100.0f);
+	for (BenchEntity& e : _entities) {
+		quadTree.insert(QuadTreeNode { &e });
+	}
+	int tick = 0;
+	for (auto _ : state) {
+		for (int i = 0; i < (int)_entities.size(); ++i) {
+			if (moves(i, tick)) {
+				BenchEntity& e = _entities[i];
+				quadTree.remove(QuadTreeNode { &e });
+				move(e);
+				quadTree.insert(QuadTreeNode { &e });
+			}
+		}
+		size_t changes = 0u;
+		for (BenchEntity& e : _entities) {
+			const math::RectFloat rect(e.pos.x - e.viewDistance, e.pos.z - e.viewDistance, e.pos.x + e.viewDistance, e.pos.z + e.viewDistance);
+			math::QuadTree<QuadTreeNode, float>::Contents contents;
+			quadTree.query(rect, contents);
+			std::unordered_set<backend::EntityId> set;
+			set.reserve(contents.size());
+			for (const QuadTreeNode& node : contents) {
+				set.insert(node.entity->id);
+			}
+			set.erase(e.id);
+			const auto& stillVisible = core::setIntersection(set, e.visible);
+			const auto& remove = core::setDifference(e.visible, stillVisible);
+			const auto& add = core::setDifference(set, stillVisible);
+			e.visible = core::setUnion(stillVisible, add);
+			changes += add.size() + remove.size();
+		}
+		benchmark::DoNotOptimize(changes);
+		++tick;
+	}
+}
+
+BENCHMARK_DEFINE_F(InterestGridBenchmark, InterestGrid) (benchmark::State& state) {
+	backend::InterestGrid grid((float)state.range(0));
+	for (const BenchEntity& e : _entities) {
+		grid.add(e.id, e.pos);
+	}
+	backend::EntityIds entered;
+	backend::EntityIds left;
+	auto isVisible = [] (const glm::vec3&) {
+		return true;
+	};
+	int tick = 0;
+	for (auto _ : state) {
+		for (int i = 0; i < (int)_entities.size(); ++i) {
+			if (moves(i, tick)) {
+				BenchEntity& e = _entities[i];
+				move(e);
+				grid.move(e.id, e.pos);
+			}
+		}
+		size_t changes = 0u;
+		for (const BenchEntity& e : _entities) {
+			backend::InterestGrid::View view;
+			view.pos = e.pos;
+			view.distance = e.viewDistance;
+			if (grid.updateView(e.id, view, isVisible, entered, left)) {
+				changes += entered.size() + left.size();
+			}
+		}
+		grid.update();
+		benchmark::DoNotOptimize(changes);
+		++tick;
+	}
+}
+
+BENCHMARK_REGISTER_F(InterestGridBenchmark, QuadTreeFullQuery)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(InterestGridBenchmark, InterestGrid)->Arg(32)->Arg(64)->Arg(128)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
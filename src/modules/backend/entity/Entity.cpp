@@ -3,7 +3,6 @@
  */
 
 #include "Entity.h"
-#include "core/collection/Set.h"
 #include "core/ArrayLength.h"
 #include "core/Assert.h"
 #include "core/Log.h"
@@ -16,6 +15,7 @@
 #include "network/ProtocolEnum.h"
 #include "attrib/ContainerProvider.h"
 #include <glm/trigonometric.hpp>
+#include <algorithm>
 
 namespace backend {
 
@@ -32,14 +32,14 @@ Entity::Entity(EntityId id,
 Entity::~Entity() {
 }
 
-void Entity::visibleAdd(const EntitySet& entities) {
+void Entity::visibleAdd(const EntityList& entities) {
 	for (const EntityPtr& e : entities) {
 		Log::trace("entity %i is visible for %i", (int)e->id(), (int)id());
 		sendEntitySpawn(e);
 	}
 }
 
-void Entity::visibleRemove(const EntitySet& entities) {
+void Entity::visibleRemove(const EntityList& entities) {
 	for (const EntityPtr& e : entities) {
 		Log::trace("entity %i is no longer visible for %i", (int)e->id(), (int)id());
 		sendEntityRemove(e);
@@ -60,7 +60,7 @@ bool Entity::attack(EntityId victimId) {
 
 void Entity::sendToVisible(flatbuffers::FlatBufferBuilder& fbb, network::ServerMsgType type,
 		flatbuffers::Offset<void> data, bool sendToSelf, uint32_t flags) const {
-	const EntitySet& visible = visibleCopy();
+	const EntityList& visible = visibleCopy();
 	std::vector<ENetPeer*> peers;
 	peers.reserve(visible.size() + 1);
 	if (sendToSelf) {
@@ -169,36 +169,69 @@ bool Entity::update(long dt) {
 	return true;
 }
 
-void Entity::updateVisible(const EntitySet& set) {
+void Entity::updateVisible(const EntityList& entered, const EntityIds& left) {
 	core_trace_scoped(UpdateVisible);
+	EntityList removed;
+	removed.reserve(left.size());
 	_visibleLock.lockWrite();
-	const auto& stillVisible = core::setIntersection(set, _visible);
-	const EntitySet& remove = core::setDifference(stillVisible, _visible);
-	const EntitySet& add = core::setDifference(set, stillVisible);
-	_visible = core::setUnion(stillVisible, add);
-	_visibleLock.unlockWrite();
-
-	for (const auto& e : _visible) {
-		sendEntityUpdate(e);
+	// all lists are sorted by the entity id - merge them
+	_visibleScratch.clear();
+	_visibleScratch.reserve(_visible.size() + entered.size());
+	size_t e = 0u;
+	size_t l = 0u;
+	for (const EntityPtr& v : _visible) {
+		const EntityId visibleId = v->id();
+		while (e < entered.size() && entered[e]->id() < visibleId) {
+			_visibleScratch.push_back(entered[e++]);
+		}
+		while (l < left.size() && left[l] < visibleId) {
+			++l;
+		}
+		if (l < left.size() && left[l] == visibleId) {
+			removed.push_back(v);
+			++l;
+			continue;
+		}
+		_visibleScratch.push_back(v);
 	}
+	while (e < entered.size()) {
+		_visibleScratch.push_back(entered[e++]);
+	}
+	_visible.swap(_visibleScratch);
+	_visibleScratch.clear();
+	_visibleLock.unlockWrite();
 
-	if (!add.empty()) {
-		visibleAdd(add);
+	if (!entered.empty()) {
+		visibleAdd(entered);
 	}
-	if (!remove.empty()) {
-		visibleRemove(remove);
+	if (!removed.empty()) {
+		visibleRemove(removed);
 	}
 }
 
-void Entity::sendEntityUpdate(const EntityPtr& entity) const {
-	if (_peer == nullptr) {
-		return;
+void Entity::updateVisible(EntityList set) {
+	auto byId = [] (const EntityPtr& a, const EntityPtr& b) {
+		return a->id() < b->id();
+	};
+	std::sort(set.begin(), set.end(), byId);
+	EntityList entered;
+	EntityIds left;
+	{
+		core::ScopedReadLock lock(_visibleLock);
+		size_t v = 0u;
+		size_t c = 0u;
+		while (v < _visible.size() || c < set.size()) {
+			if (c == set.size() || (v < _visible.size() && byId(_visible[v], set[c]))) {
+				left.push_back(_visible[v++]->id());
+			} else if (v == _visible.size() || byId(set[c], _visible[v])) {
+				entered.push_back(set[c++]);
+			} else {
+				++v;
+				++c;
+			}
+		}
 	}
-	const glm::vec3& _pos = entity->pos();
-	const network::Vec3 pos { _pos.x, _pos.y, _pos.z };
-	_entityUpdateFBB.Clear();
-	_messageSender->sendServerMessage(_peer, _entityUpdateFBB, network::ServerMsgType::EntityUpdate,
-			network::CreateEntityUpdate(_entityUpdateFBB, entity->id(), &pos, entity->orientation(), entity->animation()).Union());
+	updateVisible(entered, left);
 }
 
 void Entity::sendEntitySpawn(const EntityPtr& entity) const {
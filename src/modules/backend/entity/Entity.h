@@ -13,29 +13,30 @@
 #include "ServerMessages_generated.h"
 #include "network/IProtocolHandler.h"
 #include "core/Trace.h"
+#include "EntityId.h"
 
 #include <unordered_set>
 #include <memory>
+#include <vector>
 
 namespace backend {
 
-typedef std::unordered_set<EntityPtr> EntitySet;
-
 /**
  * @brief Every actor in the world is an entity
  *
- * Entities are updated via @c network::ServerMsgType::EntityUpdate
- * message for the clients that are seeing the entity
+ * The clients that are seeing the entity get its state via the per tick
+ * @c network::ServerMsgType::WorldSnapshot message
  *
- * @sa EntityUpdateHandler
+ * @sa UserSnapshotMgr
  */
 class Entity : public std::enable_shared_from_this<Entity> {
 private:
 	core::ReadWriteLock _visibleLock {"Entity"};
-	EntitySet _visible;
+	// sorted by the entity id
+	EntityList _visible;
+	EntityList _visibleScratch;
 	// they are stored as members to reduce memory allocations
 	mutable flatbuffers::FlatBufferBuilder _attribUpdateFBB;
-	mutable flatbuffers::FlatBufferBuilder _entityUpdateFBB;
 	mutable flatbuffers::FlatBufferBuilder _entitySpawnFBB;
 	mutable flatbuffers::FlatBufferBuilder _entityRemoveFBB;
 
@@ -62,14 +63,13 @@ protected:
 	/**
 	 * @brief Called with the set of entities that just get visible for this entity
 	 */
-	void visibleAdd(const EntitySet& entities);
+	void visibleAdd(const EntityList& entities);
 	/**
 	 * @brief Called with the set of entities that just get invisible for this entity
 	 */
-	void visibleRemove(const EntitySet& entities);
+	void visibleRemove(const EntityList& entities);
 
 	void broadcastAttribUpdate();
-	void sendEntityUpdate(const EntityPtr& entity) const;
 	void sendEntitySpawn(const EntityPtr& entity) const;
 	void sendEntityRemove(const EntityPtr& entity) const;
 
@@ -144,18 +144,31 @@ public:
 	 * @brief Creates a copy of the currently visible objects. If you don't need a copy, use the @c Entity::visibleVisible method.
 	 * @note This is thread safe
 	 */
-	inline EntitySet visibleCopy() const {
+	inline EntityList visibleCopy() const {
 		core::ScopedReadLock lock(_visibleLock);
-		return EntitySet(_visible);
+		return EntityList(_visible);
 	}
 
+	/**
+	 * @brief This will inform the entity about the entities that got visible or invisible.
+	 * @param[in] entered The entities that got visible - sorted by their id
+	 * @param[in] left The ids of the entities that are no longer visible - sorted
+	 * @note This is thread safe
+	 * @sa InterestGrid
+	 */
+	void updateVisible(const EntityList& entered, const EntityIds& left);
 	/**
 	 * @brief This will inform the entity about all the other entities that it can see.
-	 * @param[in] set The entities that are currently visible
-	 * @note All entities have the same view range - see @c Entity::regionRect
+	 * @param[in] set The entities that are currently visible - in any order
 	 * @note This is thread safe
 	 */
-	void updateVisible(const EntitySet& set);
+	void updateVisible(EntityList set);
+
+	/**
+	 * @brief Called once per tick after the visible entities were updated - the state of
+	 * the visible entities should be sent here
+	 */
+	virtual void sendSnapshot() {}
 
 	/**
 	 * @brief The tick of the entity
@@ -6,11 +6,16 @@
 
 #include <stdint.h>
 #include <inttypes.h>
+#include <vector>
 
 namespace backend {
 
 #define PRIEntId "%" PRId64
 typedef int64_t EntityId;
 constexpr EntityId EntityIdNone = (EntityId)0;
+/**
+ * @brief Sorted list of entity ids
+ */
+typedef std::vector<EntityId> EntityIds;
 
 }
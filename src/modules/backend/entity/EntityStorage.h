@@ -8,6 +8,8 @@
 #include "ai/common/CharacterId.h"
 #include "core/EventBus.h"
 #include "backend/eventbus/Event.h"
+#include "core/Trace.h"
+#include "core/concurrent/Lock.h"
 #include <functional>
 #include <unordered_map>
 
@@ -17,6 +19,8 @@ namespace backend {
  * @brief Manages the Entity instances of the backend.
  *
  * This includes calling the Entity::update() method as well as performing the visibility calculations.
+ *
+ * @note This is thread safe - the visitors are called with the lock held and must not modify the storage.
  */
 class EntityStorage : public core::IEventBusHandler<EntityDeleteEvent>{
 private:
@@ -29,6 +33,8 @@ private:
 	Npcs _npcs;
 
 	core::EventBusPtr _eventBus;
+	// the maps are ticking in parallel and might add entities at the same time
+	core_trace_mutex(core::Lock, _lock, "EntityStorage");
 public:
 	EntityStorage(const core::EventBusPtr& eventBus);
 	virtual ~EntityStorage();
@@ -29,7 +29,8 @@ User::User(ENetPeer* peer, EntityId id,
 		_cooldownMgr(this, timeProvider, cooldownProvider, dbHandler, persistenceMgr),
 		_attribMgr(id, _attribs, dbHandler, persistenceMgr),
 		_logoutMgr(_cooldownMgr),
-		_movementMgr(this) {
+		_movementMgr(this),
+		_snapshotMgr(this) {
 	setPeer(peer);
 	_entityType = network::EntityType::PLAYER;
 }
@@ -44,6 +45,7 @@ void User::init() {
 	_attribMgr.init();
 	_logoutMgr.init();
 	_movementMgr.init();
+	_snapshotMgr.init();
 }
 
 void User::sendVars() const {
@@ -74,6 +76,7 @@ void User::shutdown() {
 	_attribMgr.shutdown();
 	_logoutMgr.shutdown();
 	_movementMgr.shutdown();
+	_snapshotMgr.shutdown();
 }
 
 ENetPeer* User::setPeer(ENetPeer* peer) {
@@ -82,6 +85,8 @@ ENetPeer* User::setPeer(ENetPeer* peer) {
 	if (_peer) {
 		_peer->data = this;
 	}
+	// the new connection doesn't know about any snapshot
+	_snapshotMgr.reset();
 	return old;
 }
 
@@ -139,13 +144,18 @@ void User::broadcastUserSpawn() const {
 	sendToVisible(fbb, network::ServerMsgType::UserSpawn, network::CreateUserSpawn(fbb, id(), fbb.CreateString(_name.c_str(), _name.size()), &pos).Union(), true);
 }
 
-bool User::sendMessage(flatbuffers::FlatBufferBuilder& fbb, network::ServerMsgType type, flatbuffers::Offset<void> msg) const {
+bool User::sendMessage(flatbuffers::FlatBufferBuilder& fbb, network::ServerMsgType type, flatbuffers::Offset<void> msg,
+		uint32_t flags, int channel) const {
 	if (_peer == nullptr) {
 		return false;
 	}
-	_messageSender->sendServerMessage(_peer, fbb, type, msg);
+	_messageSender->sendServerMessage(_peer, fbb, type, msg, flags, channel);
 	return true;
 }
 
+void User::sendSnapshot() {
+	_snapshotMgr.update();
+}
+
 
 }
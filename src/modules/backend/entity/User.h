@@ -12,6 +12,7 @@
 #include "user/UserCooldownMgr.h"
 #include "user/UserLogoutMgr.h"
 #include "user/UserMovementMgr.h"
+#include "user/UserSnapshotMgr.h"
 #include "persistence/DBHandler.h"
 #include "stock/StockDataProvider.h"
 
@@ -32,6 +33,7 @@ private:
 	UserAttribMgr _attribMgr;
 	UserLogoutMgr _logoutMgr;
 	UserMovementMgr _movementMgr;
+	UserSnapshotMgr _snapshotMgr;
 
 public:
 	User(ENetPeer* peer,
@@ -72,6 +74,7 @@ public:
 	void userinfo(const char *key, const char* value);
 
 	bool update(long dt) override;
+	void sendSnapshot() override;
 
 	void init() override;
 	void shutdown() override;
@@ -81,7 +84,8 @@ public:
 	 */
 	ENetPeer* setPeer(ENetPeer* peer);
 
-	bool sendMessage(flatbuffers::FlatBufferBuilder& fbb, network::ServerMsgType type, flatbuffers::Offset<void> msg) const;
+	bool sendMessage(flatbuffers::FlatBufferBuilder& fbb, network::ServerMsgType type, flatbuffers::Offset<void> msg,
+			uint32_t flags = ENET_PACKET_FLAG_RELIABLE, int channel = network::ChannelReliable) const;
 
 	/**
 	 * @brief Informs the user that the login was successful
@@ -104,6 +108,9 @@ public:
 
 	UserMovementMgr& movementMgr();
 	const UserMovementMgr& movementMgr() const;
+
+	UserSnapshotMgr& snapshotMgr();
+	const UserSnapshotMgr& snapshotMgr() const;
 };
 
 inline UserLogoutMgr& User::logoutMgr() {
@@ -122,6 +129,14 @@ inline const UserMovementMgr& User::movementMgr() const {
 	return _movementMgr;
 }
 
+inline UserSnapshotMgr& User::snapshotMgr() {
+	return _snapshotMgr;
+}
+
+inline const UserSnapshotMgr& User::snapshotMgr() const {
+	return _snapshotMgr;
+}
+
 inline UserCooldownMgr& User::cooldownMgr() {
 	return _cooldownMgr;
 }
@@ -36,9 +36,10 @@ void UserMovementMgr::update(long dt) {
 
 	if (_sendUpdate || _movement.animation() != oldAnimation || !glm::all(glm::epsilonEqual(oldPos, newPos, glm::epsilon<float>()))) {
 		const network::Vec3 netPos { newPos.x, newPos.y, newPos.z };
-		_user->sendToVisible(_entityUpdateFBB,
+		// the other users get the new state with their next world snapshot
+		_user->sendMessage(_entityUpdateFBB,
 				network::ServerMsgType::EntityUpdate,
-				network::CreateEntityUpdate(_entityUpdateFBB, _user->id(), &netPos, orientation, _movement.animation()).Union(), true, 0u);
+				network::CreateEntityUpdate(_entityUpdateFBB, _user->id(), &netPos, orientation, _movement.animation()).Union(), 0u);
 		_sendUpdate = false;
 	}
 
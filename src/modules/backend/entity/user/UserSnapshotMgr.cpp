@@ -0,0 +1,71 @@
+/**
+ * @file
+ */
+
+#include "UserSnapshotMgr.h"
+#include "backend/entity/User.h"
+#include "network/Network.h"
+#include "core/Trace.h"
+#include <algorithm>
+
+namespace backend {
+
+UserSnapshotMgr::UserSnapshotMgr(User* user) : _user(user) {
+}
+
+void UserSnapshotMgr::update() {
+	core_trace_scoped(UserSnapshotMgrUpdate);
+	if (_user->peer() == nullptr) {
+		return;
+	}
+	_entities.clear();
+	_user->visitVisible([this] (const EntityPtr& e) {
+		network::SnapshotEntity entity;
+		entity.id = e->id();
+		entity.pos = network::quantizePosition(e->pos());
+		entity.rotation = network::quantizeRotation(e->orientation());
+		entity.animation = e->animation();
+		_entities.push_back(entity);
+	});
+	std::sort(_entities.begin(), _entities.end(), [] (const network::SnapshotEntity& a, const network::SnapshotEntity& b) {
+		return a.id < b.id;
+	});
+
+	// if the acknowledged snapshot is too old, the full state is sent
+	const network::SnapshotEntities* baseline = _history.get(_acknowledged);
+	const uint32_t baselineSequence = baseline != nullptr ? _acknowledged : 0u;
+	if (network::encodeSnapshot(baseline, _entities, _buffer) == 0) {
+		return;
+	}
+	const uint32_t sequence = ++_sequence;
+	_fbb.Clear();
+	auto entities = _fbb.CreateVector(_buffer);
+	// don't let enet send the fragments of big snapshots reliable
+	_user->sendMessage(_fbb, network::ServerMsgType::WorldSnapshot,
+			network::CreateWorldSnapshot(_fbb, sequence, baselineSequence, entities).Union(),
+			ENET_PACKET_FLAG_UNRELIABLE_FRAGMENT, network::ChannelSnapshot);
+	_history.put(sequence, _entities);
+}
+
+void UserSnapshotMgr::acknowledge(uint32_t sequence) {
+	if (sequence <= _acknowledged || sequence > _sequence) {
+		return;
+	}
+	_acknowledged = sequence;
+}
+
+void UserSnapshotMgr::reset() {
+	_history.reset();
+	_acknowledged = 0u;
+}
+
+bool UserSnapshotMgr::init() {
+	reset();
+	return true;
+}
+
+void UserSnapshotMgr::shutdown() {
+	reset();
+}
+
+}
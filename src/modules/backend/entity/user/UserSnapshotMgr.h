@@ -0,0 +1,54 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/IComponent.h"
+#include "network/Snapshot.h"
+#include "ServerMessages_generated.h"
+#include <vector>
+
+namespace backend {
+
+class User;
+
+/**
+ * @brief Sends the state of the visible entities as one @c network::WorldSnapshot per tick
+ *
+ * The snapshot is delta encoded against the last snapshot the client acknowledged and only contains
+ * the entities that changed since then.
+ *
+ * @sa network::encodeSnapshot()
+ */
+class UserSnapshotMgr : public core::IComponent {
+private:
+	User* _user;
+	network::SnapshotHistory _history;
+	uint32_t _sequence = 0u;
+	uint32_t _acknowledged = 0u;
+	// they are stored as members to reduce memory allocations
+	network::SnapshotEntities _entities;
+	std::vector<uint8_t> _buffer;
+	flatbuffers::FlatBufferBuilder _fbb;
+public:
+	UserSnapshotMgr(User* user);
+
+	/**
+	 * @brief Sends the changed state of the visible entities
+	 */
+	void update();
+	/**
+	 * @brief The client received the snapshot with the given sequence number
+	 */
+	void acknowledge(uint32_t sequence);
+	/**
+	 * @brief Forget about the sent snapshots - e.g. the client reconnected
+	 */
+	void reset();
+
+	bool init() override;
+	void shutdown() override;
+};
+
+}
@@ -9,6 +9,7 @@
 #include "core/Var.h"
 #include "core/Log.h"
 #include "core/App.h"
+#include "core/concurrent/ThreadPool.h"
 #include "core/io/Filesystem.h"
 #include "core/Password.h"
 #include "cooldown/CooldownProvider.h"
@@ -26,6 +27,7 @@
 #include "backend/network/TriggerActionHandler.h"
 #include "backend/network/VarUpdateHandler.h"
 #include "backend/network/MoveHandler.h"
+#include "backend/network/SnapshotAckHandler.h"
 #include "persistence/PersistenceMgr.h"
 #include "backend/world/World.h"
 #include "core/command/CommandHandler.h"
@@ -221,7 +223,7 @@ bool ServerLoop::init() {
 	}
 
 	const int httpPort = core::Var::getSafe(cfg::ServerHttpPort)->intVal();
-	if (!_httpServer->init(httpPort)) {
+	if (!_httpServer->init(_loop, httpPort)) {
 		Log::error("Failed to initialize the HTTP server on port %i", httpPort);
 		return false;
 	}
@@ -309,6 +311,7 @@ bool ServerLoop::init() {
 	regHandler(network::ClientMsgType::TriggerAction, TriggerActionHandler);
 	regHandler(network::ClientMsgType::Move, MoveHandler);
 	regHandler(network::ClientMsgType::VarUpdate, VarUpdateHandler);
+	regHandler(network::ClientMsgType::SnapshotAck, SnapshotAckHandler);
 
 	Log::info("Init material");
 	if (!voxel::initDefaultMaterialColors()) {
@@ -338,9 +341,10 @@ bool ServerLoop::init() {
 		const ServerLoop* loop = (const ServerLoop*)handle->data;
 		const long dt = handle->repeat;
 		const persistence::PersistenceMgrPtr& persistenceMgr = loop->_persistenceMgr;
-		core::App::getInstance()->threadPool().enqueue([=] () {
+		// don't delay the latency critical tasks
+		core::App::getInstance()->threadPool().schedule([=] () {
 			persistenceMgr->update(dt);
-		});
+		}, core::TaskPriority::Low);
 	}, 10000);
 
 	_idleTimer = new uv_idle_t;
@@ -367,7 +371,7 @@ bool ServerLoop::init() {
 	const core::VarPtr& port = core::Var::getSafe(cfg::ServerPort);
 	const core::VarPtr& host = core::Var::getSafe(cfg::ServerHost);
 	const core::VarPtr& maxclients = core::Var::getSafe(cfg::ServerMaxClients);
-	if (!_network->bind(port->intVal(), host->strVal(), maxclients->intVal(), 2)) {
+	if (!_network->bind(port->intVal(), host->strVal(), maxclients->intVal(), network::MaxChannels)) {
 		Log::error("Failed to bind the server socket on %s:%i", host->strVal().c_str(), port->intVal());
 		return false;
 	}
@@ -415,10 +419,10 @@ void ServerLoop::shutdown() {
 
 void ServerLoop::update() {
 	core_trace_scoped(ServerLoop);
-	// not everything is ticked in here directly, a lot is handled by libuv timers
+	// not everything is ticked in here directly, a lot is handled by libuv timers - the http server
+	// is also running in this loop
 	uv_run(_loop, UV_RUN_NOWAIT);
 	_network->update();
-	_httpServer->update();
 	_eventBus->update(200);
 
 	replicateVars();
@@ -0,0 +1,21 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "network/Network.h"
+#include "IUserProtocolHandler.h"
+
+namespace backend {
+
+/**
+ * The client received a world snapshot - the following snapshots are delta encoded against it
+ *
+ * @sa UserSnapshotMgr
+ */
+USERPROTOHANDLERIMPL(SnapshotAck) {
+	user->snapshotMgr().acknowledge(message->sequence());
+}
+
+}
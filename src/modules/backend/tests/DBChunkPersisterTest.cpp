@@ -0,0 +1,145 @@
+/**
+ * @file
+ */
+
+#include "core/tests/AbstractTest.h"
+#include "backend/world/DBChunkPersister.h"
+#include "persistence/tests/Mocks.h"
+#include "core/GameConfig.h"
+#include "core/Var.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace backend {
+
+class DBChunkPersisterTest: public core::AbstractTest {
+protected:
+	class TestDBChunkPersister: public DBChunkPersister {
+	public:
+		using DBChunkPersister::DBChunkPersister;
+
+		// all queued chunks are compressed and waiting for the writer
+		bool compressed(size_t amount) {
+			core::ScopedLock<core::Lock> lock(_lock);
+			if (_compressed.size() != amount) {
+				return false;
+			}
+			for (const auto& e : _pending) {
+				if (!e.second.data) {
+					return false;
+				}
+			}
+			return true;
+		}
+	};
+	class Pager: public voxel::PagedVolume::Pager {
+	public:
+		bool pageIn(voxel::PagedVolume::PagerContext& ctx) override {
+			return false;
+		}
+		void pageOut(voxel::PagedVolume::Chunk* chunk) override {
+		}
+	};
+	Pager _pager;
+	const unsigned int _seed = 1u;
+	std::shared_ptr<persistence::DBHandlerMock> _dbHandler;
+	// the amount of statements that were executed
+	std::atomic_int _statements { 0 };
+	// blocks the writer in the first statement until the test released it
+	std::atomic_bool _released { false };
+
+	voxel::PagedVolume::ChunkPtr createChunk(const glm::ivec3& pos, voxel::VoxelType type) {
+		voxel::PagedVolume::ChunkPtr chunk = core::make_shared<voxel::PagedVolume::Chunk>(pos, 64, &_pager);
+		chunk->setUniform(voxel::createVoxel(type, 1));
+		return chunk;
+	}
+
+	void waitForStatements(int amount) {
+		while (_statements.load() < amount) {
+			std::this_thread::yield();
+		}
+	}
+
+public:
+	void SetUp() override {
+		core::AbstractTest::SetUp();
+		core::Var::get(cfg::ServerChunkPersistThreads, "1")->setVal(1);
+		core::Var::get(cfg::ServerChunkPersistQueue, "1024")->setVal(1024);
+		_dbHandler = persistence::createDbHandlerMock();
+		EXPECT_CALL(*_dbHandler, connection()).WillRepeatedly(testing::Invoke([this] () -> persistence::Connection* {
+			++_statements;
+			// don't block forever if the test failed before it released the writer
+			const auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+			while (!_released.load() && std::chrono::steady_clock::now() < timeout) {
+				std::this_thread::yield();
+			}
+			return nullptr;
+		}));
+	}
+
+	void TearDown() override {
+		_released = true;
+		_dbHandler.reset();
+		core::AbstractTest::TearDown();
+	}
+};
+
+TEST_F(DBChunkPersisterTest, testLoadQueuedChunk) {
+	DBChunkPersister persister(_dbHandler, 1);
+	ASSERT_TRUE(persister.init());
+	const glm::ivec3 pos(1, 0, 2);
+	ASSERT_TRUE(persister.save(createChunk(pos, voxel::VoxelType::Water), _seed));
+	// the writer is blocked - the chunk must be loaded from the queue
+	voxel::PagedVolume::ChunkPtr loaded = core::make_shared<voxel::PagedVolume::Chunk>(pos, 64, &_pager);
+	ASSERT_TRUE(persister.load(loaded, _seed)) << "Could not load the queued chunk";
+	ASSERT_TRUE(loaded->isUniform());
+	EXPECT_EQ(voxel::VoxelType::Water, loaded->voxel(1, 2, 3).getMaterial());
+	_released = true;
+	persister.flush();
+	persister.shutdown();
+}
+
+TEST_F(DBChunkPersisterTest, testQueueDoesNotKeepChunk) {
+	DBChunkPersister persister(_dbHandler, 1);
+	ASSERT_TRUE(persister.init());
+	const glm::ivec3 pos(1, 0, 2);
+	voxel::PagedVolume::ChunkPtr chunk = createChunk(pos, voxel::VoxelType::Water);
+	ASSERT_TRUE(persister.save(chunk, _seed));
+	// modifications after the save are not written
+	chunk->setUniform(voxel::createVoxel(voxel::VoxelType::Sand, 1));
+	chunk = voxel::PagedVolume::ChunkPtr();
+	voxel::PagedVolume::ChunkPtr loaded = core::make_shared<voxel::PagedVolume::Chunk>(pos, 64, &_pager);
+	ASSERT_TRUE(persister.load(loaded, _seed));
+	EXPECT_EQ(voxel::VoxelType::Water, loaded->voxel(1, 2, 3).getMaterial());
+	_released = true;
+	persister.flush();
+	persister.shutdown();
+}
+
+TEST_F(DBChunkPersisterTest, testCoalesceQueuedSaves) {
+	TestDBChunkPersister persister(_dbHandler, 1);
+	ASSERT_TRUE(persister.init());
+	ASSERT_TRUE(persister.save(createChunk(glm::ivec3(0, 0, 0), voxel::VoxelType::Grass), _seed));
+	waitForStatements(1);
+	// queued while the writer is blocked - only the last save of a chunk is written
+	const glm::ivec3 pos(1, 0, 0);
+	ASSERT_TRUE(persister.save(createChunk(pos, voxel::VoxelType::Water), _seed));
+	ASSERT_TRUE(persister.save(createChunk(glm::ivec3(2, 0, 0), voxel::VoxelType::Water), _seed));
+	ASSERT_TRUE(persister.save(createChunk(pos, voxel::VoxelType::Sand), _seed));
+	core::ByteStream data;
+	ASSERT_TRUE(persister.load(pos.x, pos.y, pos.z, 1, _seed, data));
+	voxel::PagedVolume::ChunkPtr loaded = core::make_shared<voxel::PagedVolume::Chunk>(pos, 64, &_pager);
+	ASSERT_TRUE(persister.loadCompressed(loaded, data.getBuffer(), data.getSize()));
+	EXPECT_EQ(voxel::VoxelType::Sand, loaded->voxel(0, 0, 0).getMaterial());
+	while (!persister.compressed(2u)) {
+		std::this_thread::yield();
+	}
+	_released = true;
+	persister.flush();
+	// the two chunks of the second batch are written with one statement
+	EXPECT_EQ(2, _statements.load());
+	persister.shutdown();
+}
+
+}
@@ -67,6 +67,7 @@ protected:
 	io::FilesystemPtr filesystem;
 	core::TimeProviderPtr timeProvider;
 	persistence::PersistenceMgrPtr persistenceMgr;
+	voxelformat::VolumeCachePtr volumeCache;
 	MapProviderPtr mapProvider;
 	MapPtr map;
 
@@ -89,7 +90,7 @@ protected:
 		cooldownProvider = std::make_shared<cooldown::CooldownProvider>();
 		filesystem = _testApp->filesystem();
 		eventBus = _testApp->eventBus();
-		voxelformat::VolumeCachePtr volumeCache = std::make_shared<voxelformat::VolumeCache>();
+		volumeCache = std::make_shared<voxelformat::VolumeCache>();
 		http::HttpServerPtr httpServer = std::make_shared<http::HttpServer>(_testApp->metric());
 		timeProvider = _testApp->timeProvider();
 		persistenceMgr = persistence::createPersistenceMgrMock();
@@ -103,6 +104,12 @@ protected:
 		ASSERT_TRUE(mapProvider->init()) << "Failed to initialize the map provider";
 		map = mapProvider->map(1);
 	}
+
+	void TearDown() override {
+		// the world pager prefetches the tree volumes
+		volumeCache->shutdown();
+		Super::TearDown();
+	}
 };
 
 }
@@ -0,0 +1,89 @@
+/**
+ * @file
+ */
+
+#include "core/tests/AbstractTest.h"
+#include "backend/world/InterestGrid.h"
+
+namespace backend {
+
+class InterestGridTest : public core::AbstractTest {
+protected:
+	InterestGrid _grid { 16.0f };
+	EntityIds _entered;
+	EntityIds _left;
+
+	InterestGrid::View view(const glm::vec3& pos, float distance = 20.0f) const {
+		InterestGrid::View v;
+		v.pos = pos;
+		v.distance = distance;
+		return v;
+	}
+
+	bool update(EntityId id, const InterestGrid::View& v) {
+		return _grid.updateView(id, v, [] (const glm::vec3&) { return true; }, _entered, _left);
+	}
+};
+
+TEST_F(InterestGridTest, testEnterAndLeave) {
+	ASSERT_TRUE(_grid.add(1, glm::vec3(0.0f)));
+	ASSERT_TRUE(_grid.add(2, glm::vec3(10.0f, 0.0f, 10.0f)));
+	ASSERT_TRUE(_grid.add(3, glm::vec3(100.0f, 0.0f, 100.0f)));
+	ASSERT_FALSE(_grid.add(3, glm::vec3(0.0f)));
+
+	ASSERT_TRUE(update(1, view(glm::vec3(0.0f))));
+	EXPECT_EQ(EntityIds{2}, _entered);
+	EXPECT_TRUE(_left.empty());
+
+	_grid.move(3, glm::vec3(-5.0f, 0.0f, 5.0f));
+	ASSERT_TRUE(update(1, view(glm::vec3(0.0f))));
+	EXPECT_EQ(EntityIds{3}, _entered);
+
+	_grid.move(2, glm::vec3(50.0f, 0.0f, 0.0f));
+	ASSERT_TRUE(update(1, view(glm::vec3(0.0f))));
+	EXPECT_EQ(EntityIds{2}, _left);
+	EXPECT_TRUE(_entered.empty());
+
+	ASSERT_TRUE(_grid.remove(3));
+	ASSERT_TRUE(update(1, view(glm::vec3(0.0f))));
+	EXPECT_EQ(EntityIds{3}, _left);
+	EXPECT_TRUE(_grid.visible(1)->empty());
+}
+
+TEST_F(InterestGridTest, testUnchangedViewIsSkipped) {
+	_grid.add(1, glm::vec3(0.0f));
+	_grid.add(2, glm::vec3(5.0f, 0.0f, 5.0f));
+	_grid.add(3, glm::vec3(500.0f, 0.0f, 500.0f));
+	ASSERT_TRUE(update(1, view(glm::vec3(0.0f))));
+	int calls = 0;
+	auto countingVisible = [&] (const glm::vec3&) {
+		++calls;
+		return true;
+	};
+	EXPECT_FALSE(_grid.updateView(1, view(glm::vec3(0.0f)), countingVisible, _entered, _left));
+	// a change outside of the view range doesn't trigger a new calculation
+	_grid.move(3, glm::vec3(510.0f, 0.0f, 500.0f));
+	EXPECT_FALSE(_grid.updateView(1, view(glm::vec3(0.0f)), countingVisible, _entered, _left));
+	EXPECT_EQ(0, calls);
+	// a changed view does - even if the set stays the same
+	EXPECT_FALSE(_grid.updateView(1, view(glm::vec3(1.0f, 0.0f, 0.0f)), countingVisible, _entered, _left));
+	EXPECT_EQ(1, calls);
+}
+
+TEST_F(InterestGridTest, testEmptyCellsAreRemoved) {
+	_grid.add(1, glm::vec3(0.0f));
+	_grid.add(2, glm::vec3(100.0f, 0.0f, 0.0f));
+	update(1, view(glm::vec3(0.0f)));
+	update(2, view(glm::vec3(100.0f, 0.0f, 0.0f)));
+	EXPECT_EQ(2u, _grid.cells());
+	_grid.move(2, glm::vec3(200.0f, 0.0f, 0.0f));
+	_grid.update();
+	// entity 1 didn't see the change yet
+	EXPECT_EQ(3u, _grid.cells());
+	update(1, view(glm::vec3(0.0f)));
+	update(2, view(glm::vec3(200.0f, 0.0f, 0.0f)));
+	_grid.update();
+	EXPECT_EQ(2u, _grid.cells());
+}
+
+}
@@ -55,6 +55,11 @@ public:
 		_dbHandler = persistence::createDbHandlerMock();
 		testing::Mock::AllowLeak(_persistenceMgr.get());
 	}
+
+	void TearDown() override {
+		_volumeCache->shutdown();
+		core::AbstractTest::TearDown();
+	}
 };
 
 #define create(name) \
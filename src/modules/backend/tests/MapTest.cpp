@@ -50,6 +50,11 @@ public:
 		_dbHandler = persistence::createDbHandlerMock();
 		testing::Mock::AllowLeak(_persistenceMgr.get());
 	}
+
+	void TearDown() override {
+		_volumeCache->shutdown();
+		core::AbstractTest::TearDown();
+	}
 };
 
 #define create(name, id) \
@@ -17,6 +17,10 @@
 #include "voxelformat/VolumeCache.h"
 #include "persistence/tests/Mocks.h"
 #include "core/io/Filesystem.h"
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
 
 namespace backend {
 
@@ -60,6 +64,34 @@ public:
 				_entityStorage, _messageSender, _loader, _containerProvider, _cooldownProvider,
 				_persistenceMgr, _volumeCache, _httpServer, chunkPersisterFactory, dbHandler);
 	}
+
+	void TearDown() override {
+		_volumeCache->shutdown();
+		core::AbstractTest::TearDown();
+	}
+};
+
+/**
+ * @brief Records the threads that tick the maps. Every tick waits (with a timeout) until a second
+ * thread joined - a serial update would only ever see the calling thread.
+ */
+class ThreadRecordingWorld : public World {
+private:
+	std::mutex _mutex;
+	std::condition_variable _condition;
+public:
+	using World::World;
+	std::set<std::thread::id> threads;
+
+	void updateMap(Map* map, long dt) override {
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			threads.insert(std::this_thread::get_id());
+			_condition.notify_all();
+			_condition.wait_for(lock, std::chrono::seconds(5), [this] () { return threads.size() >= 2u; });
+		}
+		World::updateMap(map, dt);
+	}
 };
 
 #define create(name) \
@@ -78,6 +110,23 @@ TEST_F(WorldTest, testUpdate) {
 	world.shutdown();
 }
 
+TEST_F(WorldTest, testUpdateParallel) {
+	const core::VarPtr& maps = core::Var::get(cfg::ServerMaps, "1");
+	const core::VarPtr& mapThreads = core::Var::get(cfg::ServerMapThreads, "0");
+	maps->setVal(3);
+	mapThreads->setVal(2);
+	ThreadRecordingWorld world(_mapProvider, _aiRegistry, _testApp->eventBus(), _testApp->filesystem());
+	ASSERT_TRUE(world.init());
+	EXPECT_EQ(3u, _mapProvider->worldMaps().size());
+	world.update(0ul);
+	world.update(0ul);
+	world.shutdown();
+	EXPECT_EQ(2u, world.threads.size()) << "The maps were not ticked on the pool threads";
+	EXPECT_EQ(1u, world.threads.count(std::this_thread::get_id()));
+	maps->setVal(1);
+	mapThreads->setVal(0);
+}
+
 #undef create
 
 }
@@ -6,89 +6,432 @@
 #include "BackendModels.h"
 #include "voxel/PagedVolume.h"
 #include "voxel/Region.h"
+#include "core/concurrent/ThreadPool.h"
+#include "core/concurrent/Concurrency.h"
+#include "core/GameConfig.h"
+#include "core/Var.h"
+#include "core/Log.h"
 
 namespace backend {
 
+size_t DBChunkPersister::ChunkKeyHash::operator()(const ChunkKey& key) const {
+	return ((size_t)key.x * 73856093u) ^ ((size_t)key.y * 19349663u) ^ ((size_t)key.z * 83492791u) ^ (size_t)key.seed;
+}
+
 DBChunkPersister::DBChunkPersister(const persistence::DBHandlerPtr &dbHandler, MapId mapId) :
 		_dbHandler(dbHandler), _mapId(mapId) {
 }
 
+DBChunkPersister::~DBChunkPersister() {
+	shutdown();
+}
+
 bool DBChunkPersister::init() {
 	if (!_dbHandler->createTable(db::ChunkModel())) {
 		return false;
 	}
+	const int threads = core::Var::get(cfg::ServerChunkPersistThreads, "1")->intVal();
+	_maxPending = (size_t)core_max(1, core::Var::get(cfg::ServerChunkPersistQueue, "1024")->intVal());
+	_maxCached = (size_t)core_max(0, core::Var::get(cfg::ServerChunkCache, "256")->intVal());
+	if (threads <= 0 || _compressPool != nullptr) {
+		return true;
+	}
+	_stop = false;
+	_compressPool = new core::ThreadPool(threads, "ChunkPersist");
+	_compressPool->init();
+	_writer = std::thread(&DBChunkPersister::writeLoop, this);
 	return true;
 }
 
+void DBChunkPersister::shutdown() {
+	if (_compressPool == nullptr) {
+		return;
+	}
+	// compress the queued chunks - they are written by the writer before it stops
+	_compressPool->shutdown(true);
+	{
+		core::ScopedLock<core::Lock> lock(_lock);
+		_stop = true;
+		_compressedCondition.notify_all();
+	}
+	_writer.join();
+	core::ScopedLock<core::Lock> lock(_lock);
+	delete _compressPool;
+	_compressPool = nullptr;
+	_writtenCondition.notify_all();
+}
+
+void DBChunkPersister::flush() {
+	core::ScopedLock<core::Lock> lock(_lock);
+	_writtenCondition.wait(_lock, [this] () {
+		return _pending.empty() || _stop;
+	});
+}
+
+DBChunkPersister::ChunkKey DBChunkPersister::key(const voxel::PagedVolume::ChunkPtr& chunk, unsigned int seed) const {
+	const glm::ivec3& chunkPos = chunk->chunkPos();
+	return ChunkKey{chunkPos.x, chunkPos.y, chunkPos.z, seed};
+}
+
+db::ChunkModel DBChunkPersister::model(const ChunkKey& key, const core::ByteStream& data) const {
+	db::ChunkModel model;
+	model.setMapid(_mapId);
+	model.setX(key.x);
+	model.setY(key.y);
+	model.setZ(key.z);
+	model.setSeed(key.seed);
+	model.setData(persistence::Blob((uint8_t*)data.getBuffer(), data.getSize()));
+	return model;
+}
+
 void DBChunkPersister::erase(const voxel::Region& region, unsigned int seed) {
+	const ChunkKey k{region.getLowerX(), region.getLowerY(), region.getLowerZ(), seed};
+	core::ScopedLock<core::Lock> writeLock(_writeLock);
+	{
+		core::ScopedLock<core::Lock> lock(_lock);
+		if (_pending.erase(k) > 0u) {
+			_writtenCondition.notify_all();
+		}
+		uncache(k);
+		++_generation;
+	}
 	db::ChunkModel model;
 	model.setMapid(_mapId);
-	model.setX(region.getLowerX());
-	model.setY(region.getLowerY());
-	model.setZ(region.getLowerZ());
+	model.setX(k.x);
+	model.setY(k.y);
+	model.setZ(k.z);
 	model.setSeed(seed);
 	_dbHandler->deleteModel(model);
 }
 
 bool DBChunkPersister::truncate(unsigned int seed) {
+	core::ScopedLock<core::Lock> writeLock(_writeLock);
+	{
+		core::ScopedLock<core::Lock> lock(_lock);
+		for (auto i = _pending.begin(); i != _pending.end();) {
+			if (i->first.seed == seed) {
+				i = _pending.erase(i);
+			} else {
+				++i;
+			}
+		}
+		_writtenCondition.notify_all();
+		for (auto i = _cache.begin(); i != _cache.end();) {
+			if (i->first.seed == seed) {
+				_lru.erase(i->second.lru);
+				i = _cache.erase(i);
+			} else {
+				++i;
+			}
+		}
+		++_generation;
+	}
 	db::ChunkModel model;
 	model.setMapid(_mapId);
 	model.setSeed(seed);
 	return _dbHandler->truncate(model);
 }
 
-persistence::Blob DBChunkPersister::load(int x, int y, int z, MapId mapId, unsigned int seed) const {
+DBChunkPersister::CompressedData DBChunkPersister::pendingData(const ChunkKey& key) {
+	Snapshot snapshot;
+	{
+		core::ScopedLock<core::Lock> lock(_lock);
+		auto i = _pending.find(key);
+		if (i == _pending.end()) {
+			return CompressedData();
+		}
+		if (i->second.data) {
+			return i->second.data;
+		}
+		snapshot = i->second.snapshot;
+	}
+	// not yet compressed by the workers
+	std::shared_ptr<core::ByteStream> data = std::make_shared<core::ByteStream>();
+	if (!saveCompressed(*snapshot, *data)) {
+		return CompressedData();
+	}
+	return data;
+}
+
+DBChunkPersister::CompressedData DBChunkPersister::cached(const ChunkKey& key) {
+	auto i = _cache.find(key);
+	if (i == _cache.end()) {
+		return CompressedData();
+	}
+	_lru.splice(_lru.begin(), _lru, i->second.lru);
+	return i->second.data;
+}
+
+void DBChunkPersister::cache(const ChunkKey& key, const CompressedData& data) {
+	if (_maxCached == 0u) {
+		return;
+	}
+	auto i = _cache.find(key);
+	if (i != _cache.end()) {
+		i->second.data = data;
+		_lru.splice(_lru.begin(), _lru, i->second.lru);
+		return;
+	}
+	_lru.push_front(key);
+	_cache.emplace(key, CachedChunk{data, _lru.begin()});
+	while (_cache.size() > _maxCached) {
+		_cache.erase(_lru.back());
+		_lru.pop_back();
+	}
+}
+
+void DBChunkPersister::uncache(const ChunkKey& key) {
+	auto i = _cache.find(key);
+	if (i == _cache.end()) {
+		return;
+	}
+	_lru.erase(i->second.lru);
+	_cache.erase(i);
+}
+
+DBChunkPersister::CompressedData DBChunkPersister::select(const ChunkKey& key, MapId mapId) const {
 	db::ChunkModel model;
 	model.setMapid(mapId);
-	model.setX(x);
-	model.setY(y);
-	model.setZ(z);
-	model.setSeed(seed);
+	model.setX(key.x);
+	model.setY(key.y);
+	model.setZ(key.z);
+	model.setSeed(key.seed);
 	if (!_dbHandler->select(model, persistence::DBConditionOne())) {
 		Log::warn("Failed to load the model");
 	}
-	return model.data();
+	persistence::Blob blob = model.data();
+	if (blob.length <= 0) {
+		blob.release();
+		return CompressedData();
+	}
+	std::shared_ptr<core::ByteStream> data = std::make_shared<core::ByteStream>(blob.length);
+	data->append(blob.data, blob.length);
+	blob.release();
+	return data;
+}
+
+DBChunkPersister::CompressedData DBChunkPersister::compressedData(int x, int y, int z, unsigned int seed) {
+	core_trace_scoped(DBChunkPersisterCompressedData);
+	const ChunkKey k{x, y, z, seed};
+	CompressedData data = pendingData(k);
+	if (data) {
+		return data;
+	}
+	uint32_t generation;
+	{
+		core::ScopedLock<core::Lock> lock(_lock);
+		data = cached(k);
+		if (data) {
+			return data;
+		}
+		generation = _generation;
+	}
+	data = select(k, _mapId);
+	if (data) {
+		core::ScopedLock<core::Lock> lock(_lock);
+		// don't cache the chunk if it was written or erased in the meantime
+		if (generation == _generation) {
+			cache(k, data);
+		}
+	}
+	return data;
+}
+
+bool DBChunkPersister::load(int x, int y, int z, MapId mapId, unsigned int seed, core::ByteStream& out) {
+	const CompressedData& data = mapId == _mapId ? compressedData(x, y, z, seed) : select(ChunkKey{x, y, z, seed}, mapId);
+	if (!data) {
+		return false;
+	}
+	out.append(data->getBuffer(), data->getSize());
+	return true;
 }
 
 bool DBChunkPersister::load(const voxel::PagedVolume::ChunkPtr& chunk, unsigned int seed) {
 	core_trace_scoped(DBChunkPersisterLoad);
 	const glm::ivec3& region = chunk->chunkPos();
-	persistence::Blob blob = load(region.x, region.y, region.z, _mapId, seed);
-	if (blob.length <= 0) {
+	core::ByteStream data;
+	if (!load(region.x, region.y, region.z, _mapId, seed, data)) {
 		Log::debug("No chunk found in database");
-		blob.release();
 		return false;
 	}
-	if (!loadCompressed(chunk, blob.data, blob.length)) {
+	if (!loadCompressed(chunk, data.getBuffer(), data.getSize())) {
 		Log::warn("Failed to uncompress the model");
-		blob.release();
 		return false;
 	}
-	blob.release();
 	return true;
 }
 
-// TODO: this must be done async
+bool DBChunkPersister::saveNow(const ChunkKey& k, const ChunkSnapshot& snapshot) {
+	std::shared_ptr<core::ByteStream> out = std::make_shared<core::ByteStream>();
+	if (!saveCompressed(snapshot, *out)) {
+		return false;
+	}
+	Log::debug("Store compressed chunk with size %i", (int)out->getSize());
+	core::ScopedLock<core::Lock> writeLock(_writeLock);
+	const bool success = _dbHandler->insert(model(k, *out));
+	core::ScopedLock<core::Lock> lock(_lock);
+	++_generation;
+	if (success) {
+		cache(k, out);
+	} else {
+		uncache(k);
+	}
+	return success;
+}
+
 bool DBChunkPersister::save(const voxel::PagedVolume::ChunkPtr& chunk, unsigned int seed) {
 	core_trace_scoped(DBChunkPersisterSave);
-	core::ByteStream out;
-	if (!saveCompressed(chunk, out)) {
-		return false;
+	const ChunkKey k = key(chunk, seed);
+	// the chunk might get modified or destroyed before the workers compress it
+	const Snapshot snapshot = std::make_shared<const ChunkSnapshot>(*chunk.get());
+	{
+		core::ScopedLock<core::Lock> lock(_lock);
+		if (!_stop && _compressPool != nullptr) {
+			if (_pending.find(k) == _pending.end() && _pending.size() >= _maxPending) {
+				core_trace_scoped(DBChunkPersisterBackPressure);
+				_writtenCondition.wait(_lock, [this] () {
+					return _pending.size() < _maxPending || _stop;
+				});
+			}
+			if (!_stop) {
+				PendingChunk& pending = _pending[k];
+				pending.snapshot = snapshot;
+				pending.data.reset();
+				++pending.version;
+				if (pending.compressing) {
+					// the worker picks up the new chunk
+					return true;
+				}
+				pending.compressing = true;
+				if (_compressPool->schedule([this, k] () { compress(k); })) {
+					return true;
+				}
+				_pending.erase(k);
+			}
+		}
 	}
+	return saveNow(k, *snapshot);
+}
 
-	persistence::Blob data;
-	data.data = (uint8_t*)out.getBuffer();
-	data.length = out.getSize();
-	Log::info("Store compressed chunk with size %i", (int)data.length);
-	db::ChunkModel model;
-	model.setMapid(_mapId);
-	const glm::ivec3& chunkPos = chunk->chunkPos();
-	model.setX(chunkPos.x);
-	model.setY(chunkPos.y);
-	model.setZ(chunkPos.z);
-	model.setSeed(seed);
-	model.setData(data);
-	return _dbHandler->insert(model);
+void DBChunkPersister::compress(const ChunkKey& key) {
+	core_trace_scoped(DBChunkPersisterCompress);
+	core::ScopedLock<core::Lock> lock(_lock);
+	for (;;) {
+		auto i = _pending.find(key);
+		if (i == _pending.end()) {
+			return;
+		}
+		const Snapshot snapshot = i->second.snapshot;
+		const uint32_t version = i->second.version;
+		if (!snapshot) {
+			i->second.compressing = false;
+			return;
+		}
+		std::shared_ptr<core::ByteStream> data = std::make_shared<core::ByteStream>();
+		_lock.unlock();
+		const bool success = saveCompressed(*snapshot, *data);
+		_lock.lock();
+		i = _pending.find(key);
+		if (i == _pending.end()) {
+			return;
+		}
+		PendingChunk& pending = i->second;
+		if (pending.version != version) {
+			// saved again while we were compressing
+			continue;
+		}
+		pending.compressing = false;
+		if (!success) {
+			Log::error("Failed to compress chunk %i:%i:%i", key.x, key.y, key.z);
+			_pending.erase(i);
+			_writtenCondition.notify_all();
+			return;
+		}
+		pending.snapshot = Snapshot();
+		pending.data = data;
+		if (!pending.queued) {
+			pending.queued = true;
+			_compressed.push_back(key);
+		}
+		_compressedCondition.notify_one();
+		return;
+	}
+}
+
+void DBChunkPersister::writeLoop() {
+	core::setThreadName("ChunkWriter");
+	std::vector<WriteEntry> batch;
+	batch.reserve(BatchSize);
+	for (;;) {
+		{
+			core::ScopedLock<core::Lock> lock(_lock);
+			_compressedCondition.wait(_lock, [this] () {
+				return !_compressed.empty() || _stop;
+			});
+		}
+		core::ScopedLock<core::Lock> writeLock(_writeLock);
+		{
+			core::ScopedLock<core::Lock> lock(_lock);
+			if (_compressed.empty()) {
+				if (_stop) {
+					// all compressed chunks are written
+					_writtenCondition.notify_all();
+					return;
+				}
+				continue;
+			}
+			const size_t n = core_min(BatchSize, _compressed.size());
+			for (size_t i = 0u; i < n; ++i) {
+				const ChunkKey& k = _compressed[i];
+				auto iter = _pending.find(k);
+				if (iter == _pending.end()) {
+					continue;
+				}
+				PendingChunk& pending = iter->second;
+				pending.queued = false;
+				if (!pending.data) {
+					// saved again - queued again once it's compressed
+					continue;
+				}
+				batch.push_back(WriteEntry{k, pending.data, pending.version});
+			}
+			_compressed.erase(_compressed.begin(), _compressed.begin() + n);
+		}
+		writeBatch(batch);
+		batch.clear();
+	}
+}
+
+void DBChunkPersister::writeBatch(std::vector<WriteEntry>& batch) {
+	if (batch.empty()) {
+		return;
+	}
+	core_trace_scoped(DBChunkPersisterWriteBatch);
+	std::vector<db::ChunkModel> models;
+	models.reserve(batch.size());
+	for (const WriteEntry& e : batch) {
+		models.push_back(model(e.key, *e.data));
+	}
+	Log::debug("Store %i compressed chunks", (int)models.size());
+	const bool success = _dbHandler->insert(models);
+	if (!success) {
+		// the chunks are generated again the next time they are paged in
+		Log::error("Failed to store %i chunks of map %i", (int)models.size(), (int)_mapId);
+	}
+	core::ScopedLock<core::Lock> lock(_lock);
+	++_generation;
+	for (const WriteEntry& e : batch) {
+		if (success) {
+			cache(e.key, e.data);
+		} else {
+			uncache(e.key);
+		}
+		auto i = _pending.find(e.key);
+		if (i != _pending.end() && i->second.version == e.version) {
+			_pending.erase(i);
+		}
+	}
+	_writtenCondition.notify_all();
 }
 
 }
@@ -9,21 +9,149 @@
 #include "persistence/Blob.h"
 #include "voxel/PagedVolume.h"
 #include "voxel/Region.h"
+#include "core/ByteStream.h"
+#include "core/concurrent/Lock.h"
+#include "core/concurrent/ConditionVariable.h"
+#include "core/Trace.h"
+#include "BackendModels.h"
 #include "MapId.h"
+#include <unordered_map>
+#include <list>
+#include <vector>
+#include <thread>
+#include <memory>
+
+namespace core {
+class ThreadPool;
+}
 
 namespace backend {
 
+/**
+ * @brief Stores the chunks of a map in the database
+ *
+ * The chunks are written behind: save() only queues a copy of the voxels. The copies are compressed on
+ * worker threads (@c sv_chunkpersistthreads) and a writer thread stores them in batches of up to
+ * @c BatchSize chunks with one multi row upsert. Saving a chunk again before it was written
+ * replaces the queued chunk. If more than @c sv_chunkpersistqueue chunks are queued, save()
+ * blocks until the writer caught up.
+ *
+ * Loading a chunk checks the queue before the database is queried. The most recently loaded or
+ * written compressed chunks are kept in a cache (@c sv_chunkcache) for the chunk downloads.
+ */
 class DBChunkPersister : public voxelworld::ChunkPersister {
+public:
+	/**
+	 * @brief The max amount of chunks that are written with one statement
+	 */
+	static constexpr size_t BatchSize = 64u;
+	using CompressedData = std::shared_ptr<const core::ByteStream>;
 protected:
+	struct ChunkKey {
+		int x;
+		int y;
+		int z;
+		unsigned int seed;
+
+		inline bool operator==(const ChunkKey& other) const {
+			return x == other.x && y == other.y && z == other.z && seed == other.seed;
+		}
+	};
+	struct ChunkKeyHash {
+		size_t operator()(const ChunkKey& key) const;
+	};
+	using Snapshot = std::shared_ptr<const ChunkSnapshot>;
+	struct PendingChunk {
+		// a copy of the voxels - the queue doesn't keep the chunk alive. Reset once the chunk was compressed.
+		Snapshot snapshot;
+		CompressedData data;
+		// incremented whenever the chunk is saved again - a written version doesn't remove a newer one
+		uint32_t version = 0u;
+		bool compressing = false;
+		bool queued = false;
+	};
+	struct WriteEntry {
+		ChunkKey key;
+		CompressedData data;
+		uint32_t version;
+	};
+	struct CachedChunk {
+		CompressedData data;
+		std::list<ChunkKey>::iterator lru;
+	};
+
 	persistence::DBHandlerPtr _dbHandler;
 	const MapId _mapId;
+	size_t _maxPending = 1024u;
+
+	core::ThreadPool* _compressPool = nullptr;
+	std::thread _writer;
+	core_trace_mutex(core::Lock, _lock, "DBChunkPersister");
+	// notifies the writer about compressed chunks
+	core::ConditionVariable _compressedCondition;
+	// notifies the threads that are waiting for queued chunks to get written
+	core::ConditionVariable _writtenCondition;
+	std::unordered_map<ChunkKey, PendingChunk, ChunkKeyHash> _pending;
+	// the keys of the compressed chunks in the order they should get written
+	std::vector<ChunkKey> _compressed;
+	bool _stop = false;
+	// serializes the batch writes with erase() to not bring back erased chunks
+	core_trace_mutex(core::Lock, _writeLock, "DBChunkPersisterWrite");
+	// the keys of the cached chunks - the most recently used chunk is at the front
+	std::list<ChunkKey> _lru;
+	std::unordered_map<ChunkKey, CachedChunk, ChunkKeyHash> _cache;
+	size_t _maxCached = 256u;
+	// incremented whenever the database is modified - a chunk that was selected before isn't cached
+	uint32_t _generation = 0u;
+
+	ChunkKey key(const voxel::PagedVolume::ChunkPtr& chunk, unsigned int seed) const;
+	db::ChunkModel model(const ChunkKey& key, const core::ByteStream& data) const;
+	bool saveNow(const ChunkKey& key, const ChunkSnapshot& snapshot);
+	void compress(const ChunkKey& key);
+	/**
+	 * @return The compressed data of the queued chunk or an empty pointer if the chunk isn't queued
+	 */
+	CompressedData pendingData(const ChunkKey& key);
+	CompressedData select(const ChunkKey& key, MapId mapId) const;
+	/**
+	 * @note The caller must hold @c _lock for the cache functions
+	 */
+	CompressedData cached(const ChunkKey& key);
+	void cache(const ChunkKey& key, const CompressedData& data);
+	void uncache(const ChunkKey& key);
+	void writeLoop();
+	void writeBatch(std::vector<WriteEntry>& batch);
 public:
 	DBChunkPersister(const persistence::DBHandlerPtr& dbHandler, MapId mapId);
-	virtual ~DBChunkPersister() {}
+	virtual ~DBChunkPersister();
 
+	/**
+	 * @note Reads the @c sv_chunkpersistthreads, @c sv_chunkpersistqueue and @c sv_chunkcache cvars - if no threads
+	 * are configured, the chunks are written synchronously in save()
+	 */
 	bool init() override;
+	/**
+	 * @brief Writes all queued chunks and stops the threads
+	 */
+	void shutdown() override;
 
-	persistence::Blob load(int x, int y, int z, MapId mapId, unsigned int seed) const;
+	/**
+	 * @brief Blocks until all queued chunks were written
+	 */
+	void flush();
+
+	/**
+	 * @brief The compressed chunk data from the write queue, the cache or the database
+	 * @note The data is shared with the cache and must not be modified
+	 * @return An empty pointer if the chunk wasn't found
+	 */
+	CompressedData compressedData(int x, int y, int z, unsigned int seed);
+	/**
+	 * @brief Loads the compressed chunk data - from the write queue, the cache or from the database
+	 * @param[out] out The compressed chunk data is appended here
+	 * @return @c false if the chunk wasn't found
+	 */
+	bool load(int x, int y, int z, MapId mapId, unsigned int seed, core::ByteStream& out);
 	/**
 	 * @brief Removes all persisted chunks from the database for the given parameters
 	 */
@@ -0,0 +1,130 @@
+/**
+ * @file
+ */
+
+#include "InterestGrid.h"
+#include "core/Trace.h"
+#include <glm/common.hpp>
+
+namespace backend {
+
+InterestGrid::InterestGrid(float cellSize) :
+		_cellSize(glm::max(cellSize, 1.0f)) {
+}
+
+glm::ivec2 InterestGrid::cellPos(const glm::vec3& pos) const {
+	return glm::ivec2(glm::floor(pos.x / _cellSize), glm::floor(pos.z / _cellSize));
+}
+
+void InterestGrid::insertIntoCell(EntityId id, Record& record, const glm::vec3& pos) {
+	record.cell = cellPos(pos);
+	Cell& cell = _cells[record.cell];
+	record.index = (uint32_t)cell.entries.size();
+	cell.entries.push_back(CellEntry{id, pos});
+	cell.version = ++_version;
+}
+
+void InterestGrid::removeFromCell(const Record& record) {
+	auto i = _cells.find(record.cell);
+	if (i == _cells.end()) {
+		return;
+	}
+	Cell& cell = i->second;
+	// swap with the last entry to keep the entries packed
+	if (record.index + 1u != (uint32_t)cell.entries.size()) {
+		const CellEntry& last = cell.entries.back();
+		_records[last.id].index = record.index;
+		cell.entries[record.index] = last;
+	}
+	cell.entries.pop_back();
+	cell.version = ++_version;
+	if (cell.entries.empty()) {
+		_emptyCells.push_back(record.cell);
+	}
+}
+
+bool InterestGrid::changedSince(const glm::ivec2& mins, const glm::ivec2& maxs, uint64_t version) const {
+	for (int z = mins.y; z <= maxs.y; ++z) {
+		for (int x = mins.x; x <= maxs.x; ++x) {
+			auto i = _cells.find(glm::ivec2(x, z));
+			if (i != _cells.end() && i->second.version > version) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool InterestGrid::add(EntityId id, const glm::vec3& pos) {
+	auto i = _records.emplace(id, Record());
+	if (!i.second) {
+		return false;
+	}
+	insertIntoCell(id, i.first->second, pos);
+	return true;
+}
+
+bool InterestGrid::remove(EntityId id) {
+	auto i = _records.find(id);
+	if (i == _records.end()) {
+		return false;
+	}
+	removeFromCell(i->second);
+	_records.erase(i);
+	return true;
+}
+
+void InterestGrid::move(EntityId id, const glm::vec3& pos) {
+	auto i = _records.find(id);
+	if (i == _records.end()) {
+		return;
+	}
+	Record& record = i->second;
+	const glm::ivec2& newCell = cellPos(pos);
+	if (newCell == record.cell) {
+		Cell& cell = _cells[record.cell];
+		CellEntry& entry = cell.entries[record.index];
+		if (entry.pos != pos) {
+			entry.pos = pos;
+			cell.version = ++_version;
+		}
+		return;
+	}
+	removeFromCell(record);
+	insertIntoCell(id, record, pos);
+}
+
+void InterestGrid::update() {
+	core_trace_scoped(InterestGridUpdate);
+	if (_emptyCells.empty()) {
+		return;
+	}
+	// a cell can only be removed if every entity has seen that it got empty
+	uint64_t minEvaluated = _version;
+	for (const auto& e : _records) {
+		minEvaluated = glm::min(minEvaluated, e.second.evaluated);
+	}
+	size_t n = 0u;
+	for (const glm::ivec2& pos : _emptyCells) {
+		auto i = _cells.find(pos);
+		if (i == _cells.end() || !i->second.entries.empty()) {
+			continue;
+		}
+		if (i->second.version <= minEvaluated) {
+			_cells.erase(i);
+			continue;
+		}
+		_emptyCells[n++] = pos;
+	}
+	_emptyCells.resize(n);
+}
+
+const EntityIds* InterestGrid::visible(EntityId id) const {
+	auto i = _records.find(id);
+	if (i == _records.end()) {
+		return nullptr;
+	}
+	return &i->second.visible;
+}
+
+}
@@ -0,0 +1,197 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "backend/entity/EntityId.h"
+#include "core/GLM.h"
+#include <glm/gtx/hash.hpp>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+namespace backend {
+
+/**
+ * @brief Uniform spatial hash grid on the x/z plane that keeps track of the entities of a map and
+ * calculates the entities that are visible for each of them.
+ *
+ * Every change of a cell (an entity entered, left or moved inside of the cell) bumps the version of
+ * the cell. The visible entities of an entity are only calculated again if the view of the entity
+ * changed or one of the cells in its view range got a newer version since the last calculation.
+ * The visible entities are stored as sorted entity ids - the entered and left entities are found by
+ * merging the old and the new list.
+ */
+class InterestGrid {
+public:
+	/**
+	 * @brief The state of an entity that has an influence on the entities it can see
+	 */
+	struct View {
+		glm::vec3 pos { 0.0f };
+		float orientation = 0.0f;
+		float distance = 0.0f;
+		float fieldOfView = 0.0f;
+
+		inline bool operator==(const View& other) const {
+			return pos == other.pos && orientation == other.orientation && distance == other.distance
+					&& fieldOfView == other.fieldOfView;
+		}
+	};
+
+private:
+	struct CellEntry {
+		EntityId id;
+		glm::vec3 pos;
+	};
+
+	struct Cell {
+		std::vector<CellEntry> entries;
+		uint64_t version = 0u;
+	};
+
+	struct Record {
+		glm::ivec2 cell;
+		uint32_t index;
+		View view;
+		// 0 means that the visible entities were never calculated
+		uint64_t evaluated = 0u;
+		EntityIds visible;
+	};
+
+	const float _cellSize;
+	uint64_t _version = 0u;
+	std::unordered_map<glm::ivec2, Cell> _cells;
+	std::unordered_map<EntityId, Record> _records;
+	// cells that got empty - they are removed as soon as every record has seen the change
+	std::vector<glm::ivec2> _emptyCells;
+	EntityIds _candidates;
+
+	glm::ivec2 cellPos(const glm::vec3& pos) const;
+	void insertIntoCell(EntityId id, Record& record, const glm::vec3& pos);
+	void removeFromCell(const Record& record);
+	bool changedSince(const glm::ivec2& mins, const glm::ivec2& maxs, uint64_t version) const;
+
+public:
+	/**
+	 * @param[in] cellSize The side length of the cells in world units. This should be in the range of
+	 * the most common view distance.
+	 */
+	explicit InterestGrid(float cellSize = 64.0f);
+
+	/**
+	 * @return @c false if the entity is already known
+	 */
+	bool add(EntityId id, const glm::vec3& pos);
+	/**
+	 * @return @c false if the entity isn't known
+	 */
+	bool remove(EntityId id);
+	/**
+	 * @brief Updates the position of the given entity - only bumps the cell version if the position changed
+	 */
+	void move(EntityId id, const glm::vec3& pos);
+
+	/**
+	 * @brief Calculates the visible entities of the given entity if anything in its view range changed.
+	 *
+	 * @param[in] isVisible Functor that gets the position of a candidate in the view range and returns
+	 * whether the entity can see it.
+	 * @param[out] entered The ids of the entities that got visible - sorted
+	 * @param[out] left The ids of the entities that are no longer visible - sorted
+	 * @return @c true if the visible entities changed
+	 */
+	template<typename Func>
+	bool updateView(EntityId id, const View& view, Func&& isVisible, EntityIds& entered, EntityIds& left);
+
+	/**
+	 * @brief Removes empty cells - should be called once per tick
+	 */
+	void update();
+
+	/**
+	 * @return The sorted ids of the visible entities from the last calculation or @c nullptr
+	 * if the entity isn't known
+	 */
+	const EntityIds* visible(EntityId id) const;
+
+	size_t size() const;
+	size_t cells() const;
+	float cellSize() const;
+};
+
+inline size_t InterestGrid::size() const {
+	return _records.size();
+}
+
+inline size_t InterestGrid::cells() const {
+	return _cells.size();
+}
+
+inline float InterestGrid::cellSize() const {
+	return _cellSize;
+}
+
+template<typename Func>
+bool InterestGrid::updateView(EntityId id, const View& view, Func&& isVisible, EntityIds& entered, EntityIds& left) {
+	entered.clear();
+	left.clear();
+	auto recordIter = _records.find(id);
+	if (recordIter == _records.end()) {
+		return false;
+	}
+	Record& record = recordIter->second;
+	const glm::vec3 mins3(view.pos.x - view.distance, 0.0f, view.pos.z - view.distance);
+	const glm::vec3 maxs3(view.pos.x + view.distance, 0.0f, view.pos.z + view.distance);
+	const glm::ivec2& mins = cellPos(mins3);
+	const glm::ivec2& maxs = cellPos(maxs3);
+	const bool changed = record.evaluated == 0u || !(record.view == view) || changedSince(mins, maxs, record.evaluated);
+	// nothing changed that is relevant for this entity up to this version
+	record.evaluated = _version;
+	if (!changed) {
+		return false;
+	}
+	record.view = view;
+
+	_candidates.clear();
+	for (int z = mins.y; z <= maxs.y; ++z) {
+		for (int x = mins.x; x <= maxs.x; ++x) {
+			auto cellIter = _cells.find(glm::ivec2(x, z));
+			if (cellIter == _cells.end()) {
+				continue;
+			}
+			for (const CellEntry& entry : cellIter->second.entries) {
+				if (entry.id == id) {
+					continue;
+				}
+				if (glm::abs(entry.pos.x - view.pos.x) > view.distance || glm::abs(entry.pos.z - view.pos.z) > view.distance) {
+					continue;
+				}
+				if (!isVisible(entry.pos)) {
+					continue;
+				}
+				_candidates.push_back(entry.id);
+			}
+		}
+	}
+	std::sort(_candidates.begin(), _candidates.end());
+
+	const EntityIds& before = record.visible;
+	size_t b = 0u;
+	size_t c = 0u;
+	while (b < before.size() || c < _candidates.size()) {
+		if (c == _candidates.size() || (b < before.size() && before[b] < _candidates[c])) {
+			left.push_back(before[b++]);
+		} else if (b == before.size() || _candidates[c] < before[b]) {
+			entered.push_back(_candidates[c++]);
+		} else {
+			++b;
+			++c;
+		}
+	}
+	record.visible.swap(_candidates);
+	return !entered.empty() || !left.empty();
+}
+
+}
@@ -9,7 +9,7 @@
 #include "core/EventBus.h"
 #include "core/App.h"
 #include "core/Trace.h"
-#include "math/QuadTree.h"
+#include "core/TimeProvider.h"
 #include "core/io/Filesystem.h"
 #include "backend/entity/Npc.h"
 #include "backend/entity/User.h"
@@ -22,14 +22,6 @@
 
 namespace backend {
 
-math::RectFloat Map::QuadTreeNode::getRect() const {
-	return entity->rect();
-}
-
-bool Map::QuadTreeNode::operator==(const QuadTreeNode& rhs) const {
-	return rhs.entity == entity;
-}
-
 Map::Map(MapId mapId,
 		const core::EventBusPtr& eventBus,
 		const core::TimeProviderPtr& timeProvider,
@@ -45,7 +37,7 @@ Map::Map(MapId mapId,
 		_mapId(mapId), _mapIdStr(core::string::toString(mapId)),
 		_eventBus(eventBus), _filesystem(filesystem), _persistenceMgr(persistenceMgr),
 		_volumeCache(volumeCache), _attackMgr(this),
-		_quadTree(math::RectFloat::getMaxRect(), 100.0f), _chunkPersister(chunkPersister) {
+		_chunkPersister(chunkPersister) {
 	_poiProvider = std::make_shared<poi::PoiProvider>(timeProvider);
 	_spawnMgr = std::make_shared<backend::SpawnMgr>(this, filesystem, entityStorage, messageSender,
 			timeProvider, loader, containerProvider, cooldownProvider);
@@ -64,29 +56,54 @@ bool Map::updateEntity(const EntityPtr& entity, long dt) {
 	if (!entity->update(dt)) {
 		return false;
 	}
-	const math::RectFloat& rect = entity->viewRect();
-	// TODO: maybe move into the entity instance to reduce memory allocations.
-	math::QuadTree<QuadTreeNode, float>::Contents contents;
-	_quadTree.query(rect, contents);
-	EntitySet set;
-	set.reserve(contents.size());
-	for (const QuadTreeNode& node : contents) {
-		// TODO: check the distance - the rect might contain more than the circle would...
-		if (entity->inFrustum(node.entity)) {
-			set.insert(node.entity);
+	_interestGrid.move(entity->id(), entity->pos());
+	return true;
+}
+
+EntityPtr Map::entity(EntityId id) const {
+	auto u = _users.find(id);
+	if (u != _users.end()) {
+		return u->second;
+	}
+	auto n = _npcs.find(id);
+	if (n != _npcs.end()) {
+		return n->second;
+	}
+	return EntityPtr();
+}
+
+void Map::updateVisible(const EntityPtr& entity) {
+	core_trace_scoped(UpdateVisible);
+	InterestGrid::View view;
+	view.pos = entity->pos();
+	view.orientation = entity->orientation();
+	view.distance = (float)entity->current(attrib::Type::VIEWDISTANCE);
+	view.fieldOfView = (float)entity->current(attrib::Type::FIELDOFVIEW);
+	auto isVisible = [&] (const glm::vec3& pos) {
+		return entity->inFrustum(pos);
+	};
+	if (!_interestGrid.updateView(entity->id(), view, isVisible, _entered, _left)) {
+		return;
+	}
+	_enteredEntities.clear();
+	for (EntityId id : _entered) {
+		const EntityPtr& e = this->entity(id);
+		if (e) {
+			_enteredEntities.push_back(e);
 		}
 	}
-	set.erase(entity);
-	entity->updateVisible(set);
-	return true;
+	entity->updateVisible(_enteredEntities, _left);
 }
 
 void Map::update(long dt) {
 	core_trace_scoped(MapUpdate);
 	Log::trace("tick map %i", (int)_mapId);
+	const uint64_t startTime = core::TimeProvider::highResTime();
 	_spawnMgr->update(dt);
 	_zone->update(dt);
+	_eventBus->enqueue<metric::MetricEvent>(metric::timing("ai.zone.tick", (uint32_t)(_zone->lastUpdateMicros() / 1000u), {{"map", _mapIdStr}}));
 	_attackMgr.update(dt);
+	updateVolumeMetrics(dt);
 
 	for (auto i = _users.begin(); i != _users.end();) {
 		UserPtr user = i->second;
@@ -95,9 +112,9 @@ void Map::update(long dt) {
 			continue;
 		}
 		Log::debug("remove user " PRIEntId, user->id());
-		_quadTree.remove(QuadTreeNode { user });
+		_interestGrid.remove(user->id());
 		i = _users.erase(i);
-		_eventBus->enqueue(std::make_shared<EntityDeleteEvent>(user->id(), user->entityType()));
+		_eventBus->enqueue<EntityDeleteEvent>(user->id(), user->entityType());
 	}
 	for (auto i = _npcs.begin(); i != _npcs.end();) {
 		NpcPtr npc = i->second;
@@ -106,10 +123,63 @@ void Map::update(long dt) {
 			continue;
 		}
 		Log::debug("remove npc " PRIEntId, npc->id());
-		_quadTree.remove(QuadTreeNode { npc });
+		_interestGrid.remove(npc->id());
 		i = _npcs.erase(i);
 		_zone->removeAI(npc->ai());
-		_eventBus->enqueue(std::make_shared<EntityDeleteEvent>(npc->id(), npc->entityType()));
+		_eventBus->enqueue<EntityDeleteEvent>(npc->id(), npc->entityType());
+	}
+
+	// all entities are at their new position now - only the entities with changes in their
+	// view range need a new visible set
+	{
+		core_trace_scoped(MapUpdateVisible);
+		for (const auto& e : _users) {
+			updateVisible(e.second);
+		}
+		for (const auto& e : _npcs) {
+			updateVisible(e.second);
+		}
+		_interestGrid.update();
+	}
+	for (const auto& e : _users) {
+		e.second->sendSnapshot();
+	}
+	updateTickMetrics(startTime, dt);
+}
+
+void Map::updateTickMetrics(uint64_t startTime, long dt) {
+	const uint64_t micros = (core::TimeProvider::highResTime() - startTime) * 1000000u / core::TimeProvider::highResTimeResolution();
+	const metric::TagMap tags {{"map", _mapIdStr}};
+	_eventBus->enqueue<metric::MetricEvent>(metric::timing("map.tick", (uint32_t)(micros / 1000u), tags));
+	// the tick took longer than the tick interval - the map can't keep up
+	if (dt > 0l && micros > (uint64_t)dt * 1000u) {
+		_eventBus->enqueue<metric::MetricEvent>(metric::count("map.tick.overrun", 1, tags));
+	}
+}
+
+void Map::updateVolumeMetrics(long dt) {
+	_volumeMetricsDelta += dt;
+	if (_volumeMetricsDelta < 10000l) {
+		return;
+	}
+	_volumeMetricsDelta = 0l;
+	const voxel::PagedVolume::Statistics& stats = _voxelWorldMgr->volumeData()->statistics();
+	const int hits = (int)(stats.hits - _volumeHits);
+	const int misses = (int)(stats.misses - _volumeMisses);
+	const int evictions = (int)(stats.evictions - _volumeEvictions);
+	_volumeHits = stats.hits;
+	_volumeMisses = stats.misses;
+	_volumeEvictions = stats.evictions;
+	const metric::TagMap tags {{"map", _mapIdStr}};
+	_eventBus->enqueue<metric::MetricEvent>(metric::count("voxel.chunk.hit", hits, tags));
+	_eventBus->enqueue<metric::MetricEvent>(metric::count("voxel.chunk.miss", misses, tags));
+	_eventBus->enqueue<metric::MetricEvent>(metric::count("voxel.chunk.evicted", evictions, tags));
+	_eventBus->enqueue<metric::MetricEvent>(metric::gauge("voxel.chunk.count", stats.chunks, tags));
+	_eventBus->enqueue<metric::MetricEvent>(metric::gauge("voxel.chunk.compressed", stats.compressed, tags));
+	_eventBus->enqueue<metric::MetricEvent>(metric::gauge("voxel.chunk.memory.kb", (uint32_t)(stats.memoryUsage / 1024u), tags));
+	if (hits + misses > 0) {
+		const uint32_t hitRate = (uint32_t)(100 * (int64_t)hits / (hits + misses));
+		_eventBus->enqueue<metric::MetricEvent>(metric::gauge("voxel.chunk.hitrate", hitRate, tags));
 	}
 }
 
@@ -137,9 +207,13 @@ bool Map::init() {
 	_pager->init(_voxelWorldMgr->volumeData(), worldParamData, biomesData);
 	_pager->setSeed(seed->uintVal());
 	_pager->setNoiseOffset(glm::zero<glm::vec2>());
+	// one thread - the page-ins of the map are serialized and the http routes don't have to wait for them
+	_voxelWorldMgr->volumeData()->initAsyncPaging(1u);
 
 	_voxelWorldMgr->setSeed(seed->uintVal());
-	_zone = new ai::Zone(core::string::format("Zone %i", _mapId));
+	const int aiThreads = core::Var::get(cfg::ServerAIThreads, "1")->intVal();
+	const int aiGrainSize = core::Var::get(cfg::ServerAIGrainSize, "64")->intVal();
+	_zone = new ai::Zone(core::string::format("Zone %i", _mapId), aiThreads, aiGrainSize);
 
 	if (!_spawnMgr->init()) {
 		Log::error("Failed to init the spawn manager");
@@ -151,6 +225,9 @@ bool Map::init() {
 void Map::shutdown() {
 	_attackMgr.shutdown();
 	_spawnMgr->shutdown();
+	// write the queued chunks while the volume is still alive - chunks that are paged in during the
+	// shutdown of the volume are written synchronously
+	_chunkPersister->shutdown();
 	if (_pager != nullptr) {
 		_pager->shutdown();
 		_pager = voxelworld::WorldPagerPtr();
@@ -180,8 +257,8 @@ void Map::addUser(const UserPtr& user) {
 	}
 	const glm::vec3& pos = findStartPosition(user);
 	user->setMap(ptr(), pos);
-	_quadTree.insert(QuadTreeNode { user });
-	_eventBus->enqueue(std::make_shared<EntityAddToMapEvent>(user));
+	_interestGrid.add(user->id(), user->pos());
+	_eventBus->enqueue<EntityAddToMapEvent>(user);
 	_poiProvider->add(pos, poi::Type::SPAWN);
 }
 
@@ -191,9 +268,9 @@ bool Map::removeUser(EntityId id) {
 		return false;
 	}
 	UserPtr user = i->second;
-	_quadTree.remove(QuadTreeNode { user });
+	_interestGrid.remove(user->id());
 	_users.erase(i);
-	_eventBus->enqueue(std::make_shared<EntityRemoveFromMapEvent>(user));
+	_eventBus->enqueue<EntityRemoveFromMapEvent>(user);
 	return true;
 }
 
@@ -214,8 +291,8 @@ bool Map::addNpc(const NpcPtr& npc) {
 	const glm::vec3& pos = findStartPosition(npc);
 	npc->setMap(ptr(), pos);
 	_zone->addAI(npc->ai());
-	_quadTree.insert(QuadTreeNode { npc });
-	_eventBus->enqueue(std::make_shared<EntityAddToMapEvent>(npc));
+	_interestGrid.add(npc->id(), npc->pos());
+	_eventBus->enqueue<EntityAddToMapEvent>(npc);
 	_poiProvider->add(pos, poi::Type::SPAWN);
 	return true;
 }
@@ -226,10 +303,10 @@ bool Map::removeNpc(EntityId id) {
 		return false;
 	}
 	NpcPtr npc = i->second;
-	_quadTree.remove(QuadTreeNode { npc });
+	_interestGrid.remove(npc->id());
 	_npcs.erase(i);
 	_zone->removeAI(npc->ai());
-	_eventBus->enqueue(std::make_shared<EntityRemoveFromMapEvent>(npc));
+	_eventBus->enqueue<EntityRemoveFromMapEvent>(npc);
 	return true;
 }
 
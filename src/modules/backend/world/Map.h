@@ -5,8 +5,6 @@
 #pragma once
 
 #include "backend/ForwardDecl.h"
-#include "math/QuadTree.h"
-#include "math/Rect.h"
 #include "core/Common.h"
 #include "core/FourCC.h"
 #include "ai/common/CharacterId.h"
@@ -19,6 +17,7 @@
 #include "voxel/Constants.h"
 #include "DBChunkPersister.h"
 #include "MapId.h"
+#include "InterestGrid.h"
 #include <memory>
 #include <unordered_map>
 #include <glm/fwd.hpp>
@@ -56,19 +55,30 @@ private:
 
 	AttackMgr _attackMgr;
 
-	struct QuadTreeNode {
-		EntityPtr entity;
+	InterestGrid _interestGrid;
+	// they are stored as members to reduce memory allocations
+	EntityIds _entered;
+	EntityIds _left;
+	EntityList _enteredEntities;
+	DBChunkPersisterPtr _chunkPersister;
 
-		math::RectFloat getRect() const;
-		bool operator==(const QuadTreeNode& rhs) const;
-	};
+	// the chunk cache counters of the last report - the metrics are sent as deltas
+	long _volumeMetricsDelta = 0l;
+	uint64_t _volumeHits = 0u;
+	uint64_t _volumeMisses = 0u;
+	uint64_t _volumeEvictions = 0u;
+	void updateVolumeMetrics(long dt);
+	void updateTickMetrics(uint64_t startTime, long dt);
 
-	math::QuadTree<QuadTreeNode, float> _quadTree;
-	DBChunkPersisterPtr _chunkPersister;
 	/**
 	 * @return @c false if the entity should be removed from the server.
 	 */
 	bool updateEntity(const EntityPtr& entity, long dt);
+	/**
+	 * @brief Informs the entity about the entities that got visible or invisible since the last tick
+	 */
+	void updateVisible(const EntityPtr& entity);
+	EntityPtr entity(EntityId id) const;
 
 	glm::vec3 findStartPosition(const EntityPtr& entity, poi::Type type = poi::Type::GENERIC) const;
 
@@ -87,6 +97,11 @@ public:
 			const DBChunkPersisterPtr& chunkPersister);
 	~Map();
 
+	/**
+	 * @brief Ticks the map
+	 * @note Maps are ticked in parallel - see @c World::update(). Everything that is shared between the maps
+	 * must be thread safe, the events for other maps or the main thread are enqueued into the event bus.
+	 */
 	void update(long dt);
 
 	bool init() override;
@@ -8,6 +8,11 @@
 #include "core/Log.h"
 #include "core/StandardLib.h"
 #include "core/Assert.h"
+#include "core/Var.h"
+#include "core/GameConfig.h"
+#include "core/Common.h"
+#include "core/ByteStream.h"
+#include "core/StringUtil.h"
 #include "backend/entity/ai/AILoader.h"
 #include "http/HttpServer.h"
 #include "http/HttpMimeType.h"
@@ -86,46 +91,108 @@ bool MapProvider::init() {
 			response->setText("Map with given id not found");
 			return;
 		}
-		const DBChunkPersisterPtr& persister = m->chunkPersister();
-		voxelworld::WorldMgr* worldMgr = m->worldMgr();
-		voxel::PagedVolume* volume = worldMgr->volumeData();
-		const glm::ivec3& chunkPos = volume->chunkPos(x, y, z);
-		const core::VarPtr& seed = core::Var::getSafe(cfg::ServerSeed);
-		persistence::Blob blob = persister->load(chunkPos.x, chunkPos.y, chunkPos.z, mapid, seed->uintVal());
-		if (blob.length <= 0) {
-			(void)volume->voxel(x, y, z);
-			blob = persister->load(chunkPos.x, chunkPos.y, chunkPos.z, mapid, seed->uintVal());
-			if (blob.length <= 0) {
-				response->status = http::HttpStatus::NotFound;
-				response->setText(core::string::format("Chunk not found at %i:%i:%i on map %i with seed %u",
-						chunkPos.x, chunkPos.y, chunkPos.z, mapid, seed->uintVal()));
+		const DBChunkPersister::CompressedData& data = compressedChunk(m, x, y, z);
+		if (!data) {
+			response->status = http::HttpStatus::ServiceUnavailable;
+			response->setText(core::string::format("Chunk at %i:%i:%i on map %i is not yet available", x, y, z, mapid));
+			return;
+		}
+		// the compressed chunk is shared with the cache of the persister and sent without copying it
+		response->setBody(data, data->getBuffer(), data->getSize());
+		response->headers.put(http::header::CONTENT_TYPE, http::mimetype::APPLICATION_CHUNK);
+	});
+
+	// batch download to save the round trips: positions is a comma separated list of x,y,z triples. The
+	// response contains the position (x, y, z), the size and the compressed data for each requested chunk.
+	// Chunks that are not yet generated have a size of 0 - they are generated in the background and
+	// should be requested again.
+	_httpServer->registerRoute(http::HttpMethod::GET, "/chunks", [&] (const http::RequestParser& request, http::HttpResponse* response) {
+		core_trace_scoped(ChunksDownload);
+		HTTP_QUERY_GET_INT(mapid);
+		const char *positions;
+		if (!request.query.get("positions", positions)) {
+			response->status = http::HttpStatus::InternalServerError;
+			response->setText("Missing parameter positions");
+			return;
+		}
+		const MapPtr& m = map(mapid);
+		if (!m) {
+			response->status = http::HttpStatus::NotFound;
+			response->setText("Map with given id not found");
+			return;
+		}
+		const std::shared_ptr<core::ByteStream> stream = std::make_shared<core::ByteStream>();
+		int chunks = 0;
+		const char *p = positions;
+		while (*p != '\0') {
+			int coords[3];
+			for (int i = 0; i < 3; ++i) {
+				char *end;
+				coords[i] = (int)SDL_strtol(p, &end, 10);
+				if (end == p || (*end != ',' && *end != '\0') || (*end == '\0' && i != 2)) {
+					response->status = http::HttpStatus::BadRequest;
+					response->setText("Invalid positions given");
+					return;
+				}
+				p = *end == ',' ? end + 1 : end;
+			}
+			if (++chunks > MaxChunksPerRequest) {
+				response->status = http::HttpStatus::BadRequest;
+				response->setText(core::string::format("Only %i chunks per request are allowed", MaxChunksPerRequest));
 				return;
 			}
+			const DBChunkPersister::CompressedData& data = compressedChunk(m, coords[0], coords[1], coords[2]);
+			stream->addInt(coords[0]);
+			stream->addInt(coords[1]);
+			stream->addInt(coords[2]);
+			if (!data) {
+				Log::debug("Chunk at %i:%i:%i on map %i is not yet available", coords[0], coords[1], coords[2], mapid);
+				stream->addInt(0);
+				continue;
+			}
+			stream->addInt((int32_t)data->getSize());
+			stream->append(data->getBuffer(), data->getSize());
 		}
-		response->body = (char*)core_malloc(blob.length);
-		core_memcpy((void*)response->body, blob.data, blob.length);
-		response->freeBody = true;
-		response->contentLength(blob.length);
-		response->headers.put(http::header::CONTENT_TYPE, http::mimetype::APPLICATION_CHUNK);
-		blob.release();
+		response->setBody(stream, stream->getBuffer(), stream->getSize());
+		response->headers.put(http::header::CONTENT_TYPE, http::mimetype::APPLICATION_CHUNKS);
 	});
 
-	const MapId mapId = 1;
-	const MapPtr& map = std::make_shared<Map>(mapId, _eventBus, _timeProvider,
-			_filesystem, _entityStorage, _messageSender, _volumeCache,
-			_loader, _containerProvider, _cooldownProvider, _persistenceMgr,
-			_chunkPersisterFactory.create(_dbHandler, mapId));
-	if (!map->init()) {
-		Log::warn("Failed to init map %i", mapId);
-		return false;
+	const int maps = core_max(1, core::Var::get(cfg::ServerMaps, "1")->intVal());
+	for (MapId mapId = 1; mapId <= (MapId)maps; ++mapId) {
+		const MapPtr& map = std::make_shared<Map>(mapId, _eventBus, _timeProvider,
+				_filesystem, _entityStorage, _messageSender, _volumeCache,
+				_loader, _containerProvider, _cooldownProvider, _persistenceMgr,
+				_chunkPersisterFactory.create(_dbHandler, mapId));
+		if (!map->init()) {
+			Log::warn("Failed to init map %i", mapId);
+			return false;
+		}
+		_maps.insert(std::make_pair(mapId, map));
 	}
-	_maps.insert(std::make_pair(mapId, map));
 	Log::info("Map provider initialized with %i maps", (int)_maps.size());
 	return true;
 }
 
+DBChunkPersister::CompressedData MapProvider::compressedChunk(const MapPtr& map, int x, int y, int z) const {
+	const DBChunkPersisterPtr& persister = map->chunkPersister();
+	voxelworld::WorldMgr* worldMgr = map->worldMgr();
+	voxel::PagedVolume* volume = worldMgr->volumeData();
+	const glm::ivec3& chunkPos = volume->chunkPos(x, y, z);
+	const unsigned int seed = core::Var::getSafe(cfg::ServerSeed)->uintVal();
+	DBChunkPersister::CompressedData data = persister->compressedData(chunkPos.x, chunkPos.y, chunkPos.z, seed);
+	if (!data) {
+		// the routes are executed by the server loop - the chunk is generated and persisted on the paging
+		// thread of the map and answered by one of the next requests
+		if (volume->tryChunk(glm::ivec3(x, y, z))) {
+			data = persister->compressedData(chunkPos.x, chunkPos.y, chunkPos.z, seed);
+		}
+	}
+	return data;
+}
+
 void MapProvider::shutdown() {
 	_httpServer->unregisterRoute(http::HttpMethod::GET, "/chunk");
+	_httpServer->unregisterRoute(http::HttpMethod::GET, "/chunks");
 	_maps.clear();
 }
 
@@ -37,7 +37,20 @@ private:
 	persistence::DBHandlerPtr _dbHandler;
 
 	std::unordered_map<MapId, MapPtr> _maps;
+
+	/**
+	 * @brief Never blocks on the generation of a chunk - a chunk that doesn't exist yet is scheduled for
+	 * an asynchronous page-in that generates and persists it.
+	 * @return The persisted or cached compressed chunk data for the given world position or an empty
+	 * pointer if the chunk is not yet available.
+	 */
+	DBChunkPersister::CompressedData compressedChunk(const MapPtr& map, int x, int y, int z) const;
 public:
+	/**
+	 * @brief The max amount of chunks that can be requested at once from the @c /chunks route
+	 */
+	static constexpr int MaxChunksPerRequest = 64;
+
 	MapProvider(
 			const io::FilesystemPtr& filesystem,
 			const core::EventBusPtr& eventBus,
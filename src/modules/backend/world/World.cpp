@@ -14,6 +14,9 @@
 #include "core/StringUtil.h"
 #include "core/Common.h"
 #include "core/Trace.h"
+#include "core/Var.h"
+#include "core/GameConfig.h"
+#include "core/concurrent/Concurrency.h"
 #include "LUAFunctions.h"
 #include "attrib/ContainerProvider.h"
 #include <SimpleAI.h>
@@ -33,11 +36,26 @@ World::~World() {
 	core_assert_msg(_maps.empty(), "World was not properly shut down");
 }
 
+void World::updateMap(Map* map, long dt) {
+	map->update(dt);
+}
+
 void World::update(long dt) {
 	core_trace_scoped(WorldUpdate);
-	for (auto& e : _maps) {
-		const MapPtr& map = e.second;
-		map->update(dt);
+	if (_mapPool == nullptr) {
+		for (auto& e : _maps) {
+			updateMap(e.second.get(), dt);
+		}
+	} else {
+		core::TaskGroup group;
+		for (auto& e : _maps) {
+			Map* map = e.second.get();
+			_mapPool->schedule(group, [this, map, dt] () {
+				updateMap(map, dt);
+			}, core::TaskPriority::High);
+		}
+		// the main thread is ticking maps, too
+		_mapPool->wait(group);
 	}
 	_aiServer->update(dt);
 }
@@ -115,10 +133,32 @@ bool World::init() {
 		_aiServer->addZone(map->zone());
 	}
 
+	int mapThreads = core::Var::get(cfg::ServerMapThreads, "0")->intVal();
+	if (mapThreads <= 0) {
+		mapThreads = (int)core::cpus();
+	}
+	mapThreads = core_min(mapThreads, (int)_maps.size());
+	if (mapThreads > 1) {
+		Log::info("Tick %i maps with %i threads", (int)_maps.size(), mapThreads);
+		// the main thread is helping - see update()
+		_mapPool = new core::ThreadPool(mapThreads - 1, "MapTick");
+		if (!_mapPool->init()) {
+			Log::error("Failed to start the map tick threads");
+			delete _mapPool;
+			_mapPool = nullptr;
+			return false;
+		}
+	}
+
 	return true;
 }
 
 void World::shutdown() {
+	if (_mapPool != nullptr) {
+		_mapPool->shutdown(true);
+		delete _mapPool;
+		_mapPool = nullptr;
+	}
 	for (auto& e : _maps) {
 		const MapPtr& map = e.second;
 		_aiServer->removeZone(map->zone());
@@ -6,6 +6,7 @@
 
 #include "Map.h"
 #include "core/IComponent.h"
+#include "core/concurrent/ThreadPool.h"
 #include "backend/ForwardDecl.h"
 #include "ai/server/Server.h"
 #include <unordered_map>
@@ -14,6 +15,9 @@ namespace backend {
 
 /**
  * @brief The world is the whole universe of all @c Map instances.
+ *
+ * The maps are ticked in parallel on a thread pool. The main thread waits until every map finished
+ * its tick - the network messages and the events of the event bus are handled in between the ticks.
  */
 class World : public core::IComponent {
 private:
@@ -23,10 +27,16 @@ private:
 	io::FilesystemPtr _filesystem;
 	ai::Server* _aiServer = nullptr;
 	std::unordered_map<MapId, MapPtr> _maps;
+	core::ThreadPool* _mapPool = nullptr;
+protected:
+	/**
+	 * @brief Ticks a single map - might be called from any of the map tick threads
+	 */
+	virtual void updateMap(Map* map, long dt);
 public:
 	World(const MapProviderPtr& mapProvider, const AIRegistryPtr& registry,
 			const core::EventBusPtr& eventBus, const io::FilesystemPtr& filesystem);
-	~World();
+	virtual ~World();
 
 	void update(long dt);
 
@@ -53,8 +53,8 @@ App::App(const metric::MetricPtr& metric, const io::FilesystemPtr& filesystem, c
 
 App::~App() {
 	core_trace_set(nullptr);
-	_metricSender->shutdown();
 	_metric->shutdown();
+	_metricSender->shutdown();
 	Log::shutdown();
 	_threadPool = core::ThreadPoolPtr();
 }
@@ -194,6 +194,7 @@ void App::onFrame() {
 			break;
 		}
 	}
+	_metric->update(_timeProvider->tickNow());
 	onAfterFrame();
 	core_trace_end_frame("Main");
 }
@@ -249,6 +250,7 @@ AppState App::onConstruct() {
 	}
 
 	core::Var::get(cfg::MetricFlavor, "telegraf");
+	core::Var::get(cfg::MetricFlushInterval, "1000");
 	const core::String& host = core::Var::get(cfg::MetricHost, "127.0.0.1")->strVal();
 	const int port = core::Var::get(cfg::MetricPort, "8125")->intVal();
 	_metricSender = std::make_shared<metric::UDPMetricSender>(host, port);
@@ -626,12 +628,13 @@ AppState App::onCleanup() {
 
 	core_trace_shutdown();
 
-	if (_metricSender) {
-		_metricSender->shutdown();
-	}
+	// flushes the aggregated metrics - before the sender is shut down
 	if (_metric) {
 		_metric->shutdown();
 	}
+	if (_metricSender) {
+		_metricSender->shutdown();
+	}
 
 #if defined(HAVE_SYS_RESOURCE_H)
 #if defined(HAVE_SYS_TIME_H)
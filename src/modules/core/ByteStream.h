@@ -65,6 +65,8 @@ public:
 	const uint8_t* getBuffer() const;
 
 	void append(const uint8_t *buf, size_t size);
+	// advance the read position - e.g. after the data at getBuffer() was consumed
+	void skip(size_t size);
 
 	bool empty() const;
 
@@ -120,6 +122,11 @@ inline void ByteStream::append(const uint8_t *buf, size_t size) {
 	_buffer.insert(_buffer.end(), buf, buf + size);
 }
 
+inline void ByteStream::skip(size_t size) {
+	core_assert(size <= getSize());
+	_pos += (int)size;
+}
+
 inline const uint8_t* ByteStream::getBuffer() const {
 	return &_buffer[0] + _pos;
 }
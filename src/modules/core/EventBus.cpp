@@ -4,9 +4,46 @@
 
 #include "EventBus.h"
 #include "Log.h"
+#include "StandardLib.h"
+#include <thread>
+#include <functional>
 
 namespace core {
 
+namespace priv {
+
+EventBlockPool::EventBlockPool(size_t blockSize) :
+		_blockSize(blockSize) {
+}
+
+void* EventBlockPool::alloc() {
+	{
+		core::ScopedLock lock(_lock);
+		if (_free != nullptr) {
+			void* block = _free;
+			_free = *(void**)block;
+			--_freeCount;
+			return block;
+		}
+	}
+	return core_malloc(_blockSize);
+}
+
+void EventBlockPool::free(void* block) {
+	{
+		core::ScopedLock lock(_lock);
+		if (_freeCount < MaxFreeBlocks) {
+			*(void**)block = _free;
+			_free = block;
+			++_freeCount;
+			return;
+		}
+	}
+	core_free(block);
+}
+
+}
+
 EventBus::EventBus(const int initialHandlerSize) :
 		_lock("EventBus") {
 	_handlers.reserve(initialHandlerSize);
@@ -49,25 +86,73 @@ int EventBus::unsubscribe(ClassTypeId index, void* handler, const IEventBusTopic
 	return unsubscribedHandlers;
 }
 
+bool EventBus::drainQueue() {
+	size_t n = 0u;
+	for (int i = 0; i < QueueShards; ++i) {
+		QueueShard& shard = _shards[i];
+		core::ScopedLock lock(shard.lock);
+		// the drained vector was cleared after the last merge - the shard gets its memory back
+		shard.events.swap(_drained[i]);
+		n += _drained[i].size();
+	}
+	if (n == 0u) {
+		return false;
+	}
+	_pending.reserve(_pending.size() + n);
+	size_t indices[QueueShards] {};
+	for (;;) {
+		int minShard = -1;
+		for (int i = 0; i < QueueShards; ++i) {
+			if (indices[i] >= _drained[i].size()) {
+				continue;
+			}
+			if (minShard == -1 || _drained[i][indices[i]].sequence < _drained[minShard][indices[minShard]].sequence) {
+				minShard = i;
+			}
+		}
+		if (minShard == -1) {
+			break;
+		}
+		_pending.push_back(core::move(_drained[minShard][indices[minShard]++]));
+	}
+	for (int i = 0; i < QueueShards; ++i) {
+		_drained[i].clear();
+	}
+	return true;
+}
+
 int EventBus::update(int limit) {
 	core_trace_scoped(EventBusUpdate);
 	int i = 0;
-	IEventBusEventPtr event;
-	while (_queue.pop(event)) {
+	for (;;) {
+		if (_pendingIndex >= _pending.size()) {
+			_pending.clear();
+			_pendingIndex = 0u;
+			if (!drainQueue()) {
+				break;
+			}
+		}
+		// the handlers might enqueue new events - don't keep a reference into the pending list
+		const IEventBusEventPtr event = core::move(_pending[_pendingIndex++].event);
+		--_queued;
 		publish(*event);
 		if (limit > 0 && ++i >= limit) {
 			break;
 		}
 	}
-	return _queue.size();
+	return _queued;
 }
 
 int EventBus::size() const {
-	return  _queue.size();
+	return _queued;
 }
 
 void EventBus::enqueue(const IEventBusEventPtr& e) {
-	_queue.push(e);
+	static const std::hash<std::thread::id> hasher;
+	QueueShard& shard = _shards[hasher(std::this_thread::get_id()) % QueueShards];
+	core::ScopedLock lock(shard.lock);
+	shard.events.push_back(QueuedEvent{_sequence++, e});
+	++_queued;
 }
 
 int EventBus::publish(const IEventBusEvent& e) {
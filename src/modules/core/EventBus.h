@@ -6,12 +6,17 @@
 
 #include <unordered_map>
 #include <list>
+#include <vector>
+#include <atomic>
 #include <type_traits>
 #include <memory>
+#include <stddef.h>
+#include <stdint.h>
 #include "core/Log.h"
 #include "core/Common.h"
+#include "core/Trace.h"
+#include "core/concurrent/Lock.h"
 #include "core/concurrent/ReadWriteLock.h"
-#include "core/collection/ConcurrentQueue.h"
 
 namespace core {
 
@@ -124,10 +129,89 @@ public: \
 	} \
 }
 
+namespace priv {
+
+/**
+ * @brief Free list of memory blocks of the same size that are reused for the events that are
+ * given to EventBus::enqueue()
+ */
+class EventBlockPool {
+private:
+	// the max amount of free blocks that are kept for reuse
+	static constexpr int MaxFreeBlocks = 4096;
+	core_trace_mutex(core::Lock, _lock, "EventBlockPool");
+	void* _free = nullptr;
+	int _freeCount = 0;
+	const size_t _blockSize;
+public:
+	EventBlockPool(size_t blockSize);
+
+	void* alloc();
+	void free(void* block);
+
+	/**
+	 * @brief The pool for the given block size - the pools live until the application exits
+	 */
+	template<size_t SIZE>
+	static EventBlockPool& get() {
+		static EventBlockPool* pool = new EventBlockPool(SIZE);
+		return *pool;
+	}
+};
+
+}
+
+/**
+ * @brief Allocator for @c std::allocate_shared() that takes the memory for the event and the
+ * control block of the shared pointer from a pool of blocks with the same size.
+ */
+template<class T>
+class EventAllocator {
+private:
+	static constexpr size_t BlockSize = (sizeof(T) + alignof(max_align_t) - 1) / alignof(max_align_t) * alignof(max_align_t);
+	static_assert(alignof(T) <= alignof(max_align_t), "Over aligned types are not supported");
+public:
+	using value_type = T;
+
+	EventAllocator() = default;
+	template<class U>
+	EventAllocator(const EventAllocator<U>&) {
+	}
+
+	T* allocate(size_t n) {
+		if (n != 1u) {
+			return std::allocator<T>().allocate(n);
+		}
+		return (T*)priv::EventBlockPool::get<BlockSize>().alloc();
+	}
+
+	void deallocate(T* p, size_t n) {
+		if (n != 1u) {
+			std::allocator<T>().deallocate(p, n);
+			return;
+		}
+		priv::EventBlockPool::get<BlockSize>().free(p);
+	}
+
+	template<class U>
+	inline bool operator==(const EventAllocator<U>&) const {
+		return true;
+	}
+
+	template<class U>
+	inline bool operator!=(const EventAllocator<U>&) const {
+		return false;
+	}
+};
+
 /**
  * @brief EventBus with topic (IEventBusTopic) support
  *
  * Use subscribe() and unsubscribe() to manage your @c IEventBusHandler instances.
+ *
+ * The queued events (see enqueue()) are executed in the order they were enqueued in. Every thread
+ * enqueues into one of a few shards - the shards are merged by the sequence number of the events
+ * in update().
  */
 class EventBus {
 private:
@@ -136,7 +220,26 @@ private:
 	typedef std::unordered_map<ClassTypeId, EventBusHandlerReferences> EventBusHandlerReferenceMap;
 	core::ReadWriteLock _lock;
 
-	core::ConcurrentQueue<IEventBusEventPtr, std::less<IEventBusEventPtr> > _queue;
+	struct QueuedEvent {
+		uint64_t sequence;
+		IEventBusEventPtr event;
+	};
+	static constexpr int QueueShards = 8;
+	struct QueueShard {
+		core_trace_mutex(core::Lock, lock, "EventBusQueue");
+		// sorted by the sequence number as it is assigned while the lock is held
+		std::vector<QueuedEvent> events;
+	};
+	QueueShard _shards[QueueShards];
+	std::atomic<uint64_t> _sequence { 0u };
+	std::atomic<int> _queued { 0 };
+	// only accessed by update() - the events of the shards are swapped into here
+	std::vector<QueuedEvent> _drained[QueueShards];
+	// the merged events in the order they were enqueued in
+	std::vector<QueuedEvent> _pending;
+	size_t _pendingIndex = 0u;
+
+	bool drainQueue();
 
 	class EventBusHandlerReference {
 	private:
@@ -219,8 +322,18 @@ public:
 
 	/**
 	 * @brief Execute in the main thread in the next tick
+	 * @note Thread safe - the events are executed in the order they were enqueued in
 	 */
 	void enqueue(const IEventBusEventPtr& e);
+
+	/**
+	 * @brief Creates the event with memory from the event pools and enqueues it
+	 * @sa EventAllocator
+	 */
+	template<class T, class ... Args>
+	void enqueue(Args&&... args) {
+		enqueue(std::allocate_shared<T>(EventAllocator<T>(), core::forward<Args>(args)...));
+	}
 };
 
 typedef std::shared_ptr<EventBus> EventBusPtr;
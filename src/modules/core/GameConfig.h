@@ -40,6 +40,10 @@ constexpr const char *ClientCameraZoomSpeed = "cl_camzoomspeed";
 
 constexpr const char *ClientDebugShadowMapCascade = "cl_debug_cascade";
 constexpr const char *ClientDebugShadow = "cl_debug_shadow";
+// The time in milliseconds per frame that is spent on uploading extracted meshes
+constexpr const char *ClientMeshUploadBudget = "cl_meshuploadbudget";
+// The radius in chunks around the player that are downloaded before they are needed
+constexpr const char *ClientChunkPrefetchRadius = "cl_chunkprefetchradius";
 
 constexpr const char *RenderOutline = "r_renderoutline";
 
@@ -53,6 +57,20 @@ constexpr const char *ServerPostgresLib = "sv_postgreslib";
 constexpr const char *ServerHttpPort = "sv_httpport";
 // the download urls for the chunks
 constexpr const char *ServerChunkBaseUrl = "sv_httpchunkurl";
+// the amount of threads that are used to update the ai of a map
+constexpr const char *ServerAIThreads = "sv_aithreads";
+// the amount of ai instances that are updated in one task
+constexpr const char *ServerAIGrainSize = "sv_aigrainsize";
+// the amount of maps the server is hosting
+constexpr const char *ServerMaps = "sv_maps";
+// the amount of threads that are used to tick the maps - 0 means one per cpu core
+constexpr const char *ServerMapThreads = "sv_mapthreads";
+// the amount of threads per map that compress the chunks before they are written to the database - 0 writes them synchronously
+constexpr const char *ServerChunkPersistThreads = "sv_chunkpersistthreads";
+// the max amount of chunks per map that are waiting to get written to the database
+constexpr const char *ServerChunkPersistQueue = "sv_chunkpersistqueue";
+// the max amount of compressed chunks per map that are cached for the chunk downloads
+constexpr const char *ServerChunkCache = "sv_chunkcache";
 
 constexpr const char *ConsoleCurses = "con_curses";
 
@@ -63,6 +81,8 @@ constexpr const char *CorePath = "core_path";
 
 // The size of the chunk that is extracted with each step
 constexpr const char *VoxelMeshSize = "voxel_meshsize";
+// The max memory in megabytes of the cached voxel models - 0 means unbounded
+constexpr const char *VoxelVolumeCacheSize = "voxel_volumecachesize";
 
 constexpr const char *DatabaseName = "db_name";
 constexpr const char *DatabaseHost = "db_host";
@@ -78,5 +98,7 @@ constexpr const char *AppBasePath = "app_basepath";
 constexpr const char *MetricPort = "metric_port";
 constexpr const char *MetricHost = "metric_host";
 constexpr const char *MetricFlavor = "metric_flavor";
+// the interval in millis the aggregated metrics are sent in
+constexpr const char *MetricFlushInterval = "metric_flushinterval";
 
 }
@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include <type_traits>
 #include <new>
+#include <utility>
 #ifdef _WIN32
 #undef max
 #endif
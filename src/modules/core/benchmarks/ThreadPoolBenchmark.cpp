@@ -0,0 +1,146 @@
+/**
+ * @file
+ */
+
+#include "core/benchmark/AbstractBenchmark.h"
+#include "core/concurrent/ThreadPool.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+
+/**
+ * @brief The single queue thread pool that was used before the work stealing one - kept for comparison
+ */
+class SingleQueueThreadPool {
+private:
+	std::vector<std::thread> _workers;
+	std::queue<std::function<void()> > _tasks;
+	std::mutex _queueMutex;
+	std::condition_variable _queueCondition;
+	bool _stop = false;
+public:
+	explicit SingleQueueThreadPool(size_t threads) {
+		for (size_t i = 0; i < threads; ++i) {
+			_workers.emplace_back([this] {
+				for (;;) {
+					std::function<void()> task;
+					{
+						std::unique_lock<std::mutex> lock(_queueMutex);
+						_queueCondition.wait(lock, [this] { return _stop || !_tasks.empty(); });
+						if (_stop && _tasks.empty()) {
+							return;
+						}
+						task = std::move(_tasks.front());
+						_tasks.pop();
+					}
+					task();
+				}
+			});
+		}
+	}
+
+	~SingleQueueThreadPool() {
+		{
+			std::unique_lock<std::mutex> lock(_queueMutex);
+			_stop = true;
+		}
+		_queueCondition.notify_all();
+		for (std::thread &worker : _workers) {
+			worker.join();
+		}
+	}
+
+	template<class F>
+	std::future<void> enqueue(F&& f) {
+		auto task = std::make_shared<std::packaged_task<void()> >(std::forward<F>(f));
+		std::future<void> res = task->get_future();
+		{
+			std::unique_lock<std::mutex> lock(_queueMutex);
+			_tasks.emplace([task]() {(*task)();});
+		}
+		_queueCondition.notify_one();
+		return res;
+	}
+};
+
+class ThreadPoolBenchmark: public core::AbstractBenchmark {
+protected:
+	static constexpr int Threads = 4;
+	std::atomic_int _count { 0 };
+
+	// some work that is not optimized away
+	void work() {
+		int sum = 0;
+		for (int i = 0; i < 256; ++i) {
+			sum += i * i;
+		}
+		benchmark::DoNotOptimize(sum);
+		_count.fetch_add(1, std::memory_order_relaxed);
+	}
+};
+
+BENCHMARK_DEFINE_F(ThreadPoolBenchmark, singleQueueEnqueue) (benchmark::State& state) {
+	SingleQueueThreadPool pool(Threads);
+	std::vector<std::future<void>> results;
+	results.reserve(state.range(0));
+	for (auto _ : state) {
+		for (int64_t i = 0; i < state.range(0); ++i) {
+			results.emplace_back(pool.enqueue([this] () { work(); }));
+		}
+		for (auto& result : results) {
+			result.wait();
+		}
+		results.clear();
+	}
+}
+
+BENCHMARK_DEFINE_F(ThreadPoolBenchmark, enqueue) (benchmark::State& state) {
+	core::ThreadPool pool(Threads);
+	pool.init();
+	std::vector<std::future<void>> results;
+	results.reserve(state.range(0));
+	for (auto _ : state) {
+		for (int64_t i = 0; i < state.range(0); ++i) {
+			results.emplace_back(pool.enqueue([this] () { work(); }));
+		}
+		for (auto& result : results) {
+			result.wait();
+		}
+		results.clear();
+	}
+}
+
+BENCHMARK_DEFINE_F(ThreadPoolBenchmark, schedule) (benchmark::State& state) {
+	core::ThreadPool pool(Threads);
+	pool.init();
+	for (auto _ : state) {
+		core::TaskGroup group;
+		for (int64_t i = 0; i < state.range(0); ++i) {
+			pool.schedule(group, [this] () { work(); });
+		}
+		pool.wait(group);
+	}
+}
+
+BENCHMARK_DEFINE_F(ThreadPoolBenchmark, scheduleNested) (benchmark::State& state) {
+	core::ThreadPool pool(Threads);
+	pool.init();
+	for (auto _ : state) {
+		core::TaskGroup group;
+		// the tasks spawn their own tasks - they are queued in the queues of the workers
+		for (int64_t i = 0; i < state.range(0) / 16; ++i) {
+			pool.schedule(group, [this, &pool, &group] () {
+				for (int j = 0; j < 16; ++j) {
+					pool.schedule(group, [this] () { work(); });
+				}
+			});
+		}
+		pool.wait(group);
+	}
+}
+
+BENCHMARK_REGISTER_F(ThreadPoolBenchmark, singleQueueEnqueue)->RangeMultiplier(4)->Range(64, 16384);
+BENCHMARK_REGISTER_F(ThreadPoolBenchmark, enqueue)->RangeMultiplier(4)->Range(64, 16384);
+BENCHMARK_REGISTER_F(ThreadPoolBenchmark, schedule)->RangeMultiplier(4)->Range(64, 16384);
+BENCHMARK_REGISTER_F(ThreadPoolBenchmark, scheduleNested)->RangeMultiplier(4)->Range(64, 16384);
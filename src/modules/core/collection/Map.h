@@ -8,6 +8,7 @@
 #include "core/PoolAllocator.h"
 #include <stddef.h>
 #include <initializer_list>
+#include <utility>
 #include <SDL_stdinc.h>
 
 namespace core {
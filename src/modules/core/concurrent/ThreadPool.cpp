@@ -9,14 +9,216 @@
 
 namespace core {
 
+// the pool and the index of the worker the current thread belongs to
+static thread_local const ThreadPool* _currentPool = nullptr;
+static thread_local int _currentWorker = -1;
+
+Task::~Task() {
+	release();
+}
+
+Task::Task(Task&& other) noexcept :
+		_invoke(other._invoke), _relocate(other._relocate), _destroy(other._destroy), _group(other._group) {
+	if (_invoke != nullptr) {
+		_relocate(_storage, other._storage);
+	}
+	other._invoke = nullptr;
+	other._group = nullptr;
+}
+
+Task& Task::operator=(Task&& other) noexcept {
+	if (this == &other) {
+		return *this;
+	}
+	release();
+	_invoke = other._invoke;
+	_relocate = other._relocate;
+	_destroy = other._destroy;
+	_group = other._group;
+	if (_invoke != nullptr) {
+		_relocate(_storage, other._storage);
+	}
+	other._invoke = nullptr;
+	other._group = nullptr;
+	return *this;
+}
+
+bool Task::release() {
+	if (_invoke != nullptr) {
+		_destroy(_storage);
+		_invoke = nullptr;
+	}
+	if (_group == nullptr) {
+		return false;
+	}
+	// the group must not be accessed anymore after the counter was decremented
+	const bool done = _group->_pending.fetch_sub(1, std::memory_order_acq_rel) == 1;
+	_group = nullptr;
+	return done;
+}
+
+void ThreadPool::TaskQueue::push(Task&& task) {
+	const size_t size = _size.load(std::memory_order_relaxed);
+	if (size == _tasks.size()) {
+		const size_t capacity = _tasks.empty() ? 64u : _tasks.size() * 2u;
+		std::vector<Task> tasks(capacity);
+		for (size_t i = 0u; i < size; ++i) {
+			tasks[i] = std::move(_tasks[(_head + i) & (_tasks.size() - 1u)]);
+		}
+		_tasks.swap(tasks);
+		_head = 0u;
+	}
+	_tasks[(_head + size) & (_tasks.size() - 1u)] = std::move(task);
+	_size.store(size + 1u, std::memory_order_relaxed);
+}
+
+bool ThreadPool::TaskQueue::popFront(Task& task) {
+	const size_t size = _size.load(std::memory_order_relaxed);
+	if (size == 0u) {
+		return false;
+	}
+	task = std::move(_tasks[_head]);
+	_head = (_head + 1u) & (_tasks.size() - 1u);
+	_size.store(size - 1u, std::memory_order_relaxed);
+	return true;
+}
+
+bool ThreadPool::TaskQueue::popBack(Task& task) {
+	const size_t size = _size.load(std::memory_order_relaxed);
+	if (size == 0u) {
+		return false;
+	}
+	task = std::move(_tasks[(_head + size - 1u) & (_tasks.size() - 1u)]);
+	_size.store(size - 1u, std::memory_order_relaxed);
+	return true;
+}
+
 ThreadPool::ThreadPool(size_t threads, const char *name) :
-		_threads(threads), _name(name) {
+		_threads(threads), _name(name), _queues(new Worker[threads > 0 ? threads : 1]) {
 	if (_name == nullptr) {
 		_name = "ThreadPool";
 	}
 }
 
-void ThreadPool::init() {
+bool ThreadPool::submit(Task&& task, TaskPriority priority) {
+	int worker;
+	if (_currentPool == this) {
+		worker = _currentWorker;
+	} else {
+		worker = (int)(_nextQueue.fetch_add(1u, std::memory_order_relaxed) % (_threads > 0 ? _threads : 1));
+	}
+	_queued.fetch_add(1);
+	{
+		Worker& w = _queues[worker];
+		core::ScopedLock<core::Lock> lock(w._lock);
+		w._queues[(int)priority].push(std::move(task));
+	}
+	// see the worker loop - the sleeping counter and the queued counter are sequentially consistent
+	if (_sleeping.load() > 0) {
+		core::ScopedLock<core::Lock> lock(_sleepMutex);
+		_sleepCondition.notify_one();
+	}
+	// same for the threads that help to execute the tasks while they wait for a group
+	if (_helping.load() > 0) {
+		notifyGroups();
+	}
+	return true;
+}
+
+bool ThreadPool::pop(int worker, Task& task) {
+	if (_queued.load(std::memory_order_acquire) <= 0) {
+		return false;
+	}
+	const int workers = (int)(_threads > 0 ? _threads : 1);
+	for (int priority = 0; priority < (int)TaskPriority::Max; ++priority) {
+		if (worker >= 0) {
+			Worker& w = _queues[worker];
+			core::ScopedLock<core::Lock> lock(w._lock);
+			if (w._queues[priority].popFront(task)) {
+				_queued.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+		// steal the most recently queued task of the other workers - it's the one their owner would execute last
+		const int start = worker >= 0 ? worker + 1 : 0;
+		for (int i = 0; i < workers; ++i) {
+			const int victim = (start + i) % workers;
+			if (victim == worker) {
+				continue;
+			}
+			Worker& w = _queues[victim];
+			if (w._queues[priority]._size.load(std::memory_order_relaxed) == 0u) {
+				continue;
+			}
+			core::ScopedLock<core::Lock> lock(w._lock);
+			if (w._queues[priority].popBack(task)) {
+				_queued.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void ThreadPool::execute(Task& task) {
+	task();
+	// destroy the functor before the group is notified - it might reference the stack of the waiting thread
+	if (task.release()) {
+		notifyGroups();
+	}
+}
+
+void ThreadPool::notifyGroups() {
+	core::ScopedLock<core::Lock> lock(_groupMutex);
+	_groupCondition.notify_all();
+}
+
+void ThreadPool::wait(TaskGroup& group, bool help) {
+	core_trace_scoped(ThreadPoolWait);
+	if (!help) {
+		core::ScopedLock<core::Lock> lock(_groupMutex);
+		while (!group.done()) {
+			_groupCondition.wait(_groupMutex);
+		}
+		return;
+	}
+	const int worker = _currentPool == this ? _currentWorker : -1;
+	while (!group.done()) {
+		Task task;
+		if (pop(worker, task)) {
+			execute(task);
+			continue;
+		}
+		// nothing to help with - sleep until the group is done or a new task was submitted
+		core::ScopedLock<core::Lock> lock(_groupMutex);
+		_helping.fetch_add(1);
+		if (!group.done() && _queued.load() <= 0) {
+			_groupCondition.wait(_groupMutex);
+		}
+		_helping.fetch_sub(1);
+	}
+}
+
+void ThreadPool::clear() {
+	const int workers = (int)(_threads > 0 ? _threads : 1);
+	for (int i = 0; i < workers; ++i) {
+		Worker& w = _queues[i];
+		core::ScopedLock<core::Lock> lock(w._lock);
+		for (TaskQueue& queue : w._queues) {
+			Task task;
+			while (queue.popFront(task)) {
+				_queued.fetch_sub(1, std::memory_order_relaxed);
+				task.release();
+			}
+		}
+	}
+	notifyGroups();
+}
+
+bool ThreadPool::init() {
+	if (_threads == 0u || !_workers.empty()) {
+		return false;
+	}
 	_force = false;
 	_stop = false;
 	_workers.reserve(_threads);
@@ -27,43 +229,44 @@ void ThreadPool::init() {
 				Log::error("Failed to set thread name for pool thread %i", (int)i);
 			}
 			core_trace_thread(n.c_str());
+			_currentPool = this;
+			_currentWorker = (int)i;
 			for (;;) {
-				std::function<void()> task;
-				{
-					core::ScopedLock lock(this->_queueMutex);
-					if (!this->_stop) {
-						this->_queueCondition.wait(this->_queueMutex, [this] {
-							// predicate must return false if the waiting should continue
-							if (this->_stop) {
-								return true;
-							}
-							if (!this->_tasks.empty()) {
-								return true;
-							}
-							return false;
-						});
-					}
-					if (this->_stop && (this->_force || this->_tasks.empty())) {
-						Log::debug(logid, "Shutdown worker thread for %i", (int)getThreadId());
-						break;
-					}
-					task = std::move(this->_tasks.front());
-					this->_tasks.pop();
+				if (this->_stop && this->_force) {
+					break;
 				}
-
-				core_trace_begin_frame(n.c_str());
-				core_trace_scoped(ThreadPoolWorker);
-				Log::debug(logid, "Execute task in %i", (int)getThreadId());
-				task();
-				Log::debug(logid, "End of task in %i", (int)getThreadId());
-				core_trace_end_frame(n.c_str());
+				Task task;
+				if (this->pop((int)i, task)) {
+					core_trace_begin_frame(n.c_str());
+					core_trace_scoped(ThreadPoolWorker);
+					Log::debug(logid, "Execute task in %i", (int)getThreadId());
+					this->execute(task);
+					Log::debug(logid, "End of task in %i", (int)getThreadId());
+					core_trace_end_frame(n.c_str());
+					continue;
+				}
+				core::ScopedLock<core::Lock> lock(this->_sleepMutex);
+				if (this->_stop && (this->_force || this->_queued.load() <= 0)) {
+					break;
+				}
+				// a task that is submitted after the queued counter was checked will see the sleeping counter and notify us
+				this->_sleeping.fetch_add(1);
+				if (!this->_stop && this->_queued.load() <= 0) {
+					this->_sleepCondition.wait(this->_sleepMutex);
+				}
+				this->_sleeping.fetch_sub(1);
 			}
+			Log::debug(logid, "Shutdown worker thread for %i", (int)getThreadId());
+			_currentPool = nullptr;
+			_currentWorker = -1;
 		});
 	}
+	return true;
 }
 
 ThreadPool::~ThreadPool() {
 	shutdown();
+	clear();
 }
 
 void ThreadPool::shutdown(bool wait) {
@@ -71,12 +274,18 @@ void ThreadPool::shutdown(bool wait) {
 		return;
 	}
 	_force = !wait;
-	_stop = true;
-	_queueCondition.notify_all();
+	{
+		core::ScopedLock<core::Lock> lock(_sleepMutex);
+		_stop = true;
+		_sleepCondition.notify_all();
+	}
 	for (std::thread &worker : _workers) {
 		worker.join();
 	}
 	_workers.clear();
+	if (_force) {
+		clear();
+	}
 }
 
 }
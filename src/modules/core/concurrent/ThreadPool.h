@@ -28,11 +28,14 @@
 #pragma once
 
 #include <vector>
-#include <queue>
 #include <memory>
 #include <thread>
 #include <future>
 #include <functional>
+#include <atomic>
+#include <new>
+#include <cstddef>
+#include <type_traits>
 #include "core/concurrent/Atomic.h"
 #include "core/concurrent/Lock.h"
 #include "core/concurrent/ConditionVariable.h"
@@ -41,6 +44,108 @@
 
 namespace core {
 
+/**
+ * @brief The order in which the queued tasks of a @c ThreadPool are picked up by the workers
+ */
+enum class TaskPriority : uint8_t {
+	High, Normal, Low, Max
+};
+
+/**
+ * @brief Counter for fork/join style parallelism. Every task that is scheduled for the group
+ * increments the counter, and it's decremented again once the task was executed.
+ *
+ * @sa ThreadPool::schedule()
+ * @sa ThreadPool::wait()
+ */
+class TaskGroup {
+	friend class ThreadPool;
+	friend class Task;
+private:
+	std::atomic_int _pending { 0 };
+public:
+	TaskGroup() = default;
+	TaskGroup(const TaskGroup&) = delete;
+	TaskGroup& operator=(const TaskGroup&) = delete;
+
+	inline int pending() const {
+		return _pending.load(std::memory_order_acquire);
+	}
+
+	inline bool done() const {
+		return pending() == 0;
+	}
+};
+
+/**
+ * @brief Type erased, move only functor - small functors are stored without any allocation
+ */
+class Task {
+	friend class ThreadPool;
+private:
+	static constexpr size_t InlineSize = 56u;
+	alignas(std::max_align_t) uint8_t _storage[InlineSize];
+	void (*_invoke)(void*) = nullptr;
+	// move constructs the functor in the first buffer from the functor in the second buffer and destroys the latter
+	void (*_relocate)(void*, void*) = nullptr;
+	void (*_destroy)(void*) = nullptr;
+	TaskGroup* _group = nullptr;
+
+	/**
+	 * @brief Destroys the functor - the group is notified, no matter whether the task was executed or not
+	 * @return @c true if this was the last pending task of the group
+	 */
+	bool release();
+public:
+	Task() = default;
+	~Task();
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+	Task(Task&& other) noexcept;
+	Task& operator=(Task&& other) noexcept;
+
+	template<class F>
+	Task(F&& f, TaskGroup* group = nullptr);
+
+	inline bool valid() const {
+		return _invoke != nullptr;
+	}
+
+	inline TaskGroup* group() const {
+		return _group;
+	}
+
+	inline void operator()() {
+		_invoke(_storage);
+	}
+};
+
+template<class F>
+Task::Task(F&& f, TaskGroup* group) : _group(group) {
+	using Func = typename std::decay<F>::type;
+	if constexpr (sizeof(Func) <= InlineSize && alignof(Func) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible<Func>::value) {
+		new (_storage) Func(std::forward<F>(f));
+		_invoke = [] (void *p) { (*(Func*)p)(); };
+		_relocate = [] (void *dst, void *src) { new (dst) Func(std::move(*(Func*)src)); ((Func*)src)->~Func(); };
+		_destroy = [] (void *p) { ((Func*)p)->~Func(); };
+	} else {
+		*(Func**)_storage = new Func(std::forward<F>(f));
+		_invoke = [] (void *p) { (**(Func**)p)(); };
+		_relocate = [] (void *dst, void *src) { *(Func**)dst = *(Func**)src; };
+		_destroy = [] (void *p) { delete *(Func**)p; };
+	}
+}
+
+/**
+ * @brief Work stealing thread pool
+ *
+ * Every worker has its own queues (one per @c TaskPriority). Tasks that are submitted from a worker
+ * thread are put into the queues of that worker, tasks that are submitted from other threads are
+ * distributed over the workers. A worker executes its own tasks in the order they were queued. If
+ * it runs out of work, it steals tasks from the other workers before it goes to sleep. Tasks
+ * with a higher priority are always picked before the tasks with a lower priority - no matter
+ * which worker they are queued in.
+ */
 class ThreadPool final {
 private:
 	static constexpr auto logid = Log::logid("ThreadPool");
@@ -54,20 +159,84 @@ public:
 	template<class F, class ... Args>
 	auto enqueue(F&& f, Args&&... args) -> std::future<typename std::result_of<F(Args...)>::type>;
 
+	/**
+	 * Enqueue functors or lambdas into the thread pool with the given priority
+	 */
+	template<class F, class ... Args>
+	auto enqueue(TaskPriority priority, F&& f, Args&&... args) -> std::future<typename std::result_of<F(Args...)>::type>;
+
+	/**
+	 * @brief Fire and forget - no future is created and small functors don't need any allocation
+	 * @return @c false if the pool was already shut down
+	 */
+	template<class F>
+	bool schedule(F&& f, TaskPriority priority = TaskPriority::Normal);
+
+	/**
+	 * @brief Fire and forget - the given group is used to wait for the execution of the task
+	 * @sa wait()
+	 */
+	template<class F>
+	bool schedule(TaskGroup& group, F&& f, TaskPriority priority = TaskPriority::Normal);
+
+	/**
+	 * @brief Blocks until all tasks of the given group were executed.
+	 * @param help If @c true, the calling thread helps to execute the queued tasks of the pool while
+	 * waiting. Use @c false if the tasks must only be executed by the threads of the pool.
+	 */
+	void wait(TaskGroup& group, bool help = true);
+
 	size_t size() const;
-	void init();
+	/**
+	 * @brief Starts the worker threads - tasks are only executed by the pool after this was called
+	 * @return @c false if the pool has no threads or was already initialized
+	 */
+	bool init();
 	void shutdown(bool wait = false);
 private:
+	struct TaskQueue {
+		// ring buffer - the capacity is a power of two and only grows
+		std::vector<Task> _tasks;
+		size_t _head = 0u;
+		// modified under the lock of the worker - but might be peeked at without it
+		std::atomic_size_t _size { 0u };
+
+		void push(Task&& task);
+		bool popFront(Task& task);
+		bool popBack(Task& task);
+	};
+	struct Worker {
+		core_trace_mutex(core::Lock, _lock, "ThreadPoolWorker");
+		TaskQueue _queues[(int)TaskPriority::Max];
+	};
+
+	bool submit(Task&& task, TaskPriority priority);
+	/**
+	 * @param worker The index of the worker that wants to get a task or @c -1 for threads that are
+	 * not part of this pool
+	 */
+	bool pop(int worker, Task& task);
+	void execute(Task& task);
+	void notifyGroups();
+	void clear();
+
 	const size_t _threads;
 	const char *_name;
 	// need to keep track of threads so we can join them
 	std::vector<std::thread> _workers;
-	// the task queue
-	std::queue<std::function<void()> > _tasks;
+	std::unique_ptr<Worker[]> _queues;
+	// the amount of tasks in all the queues - might be higher than the actual amount while a task is pushed
+	std::atomic_int _queued { 0 };
+	std::atomic_uint _nextQueue { 0u };
+	std::atomic_int _sleeping { 0 };
+	// the threads that are blocked in wait() and would help to execute new tasks
+	std::atomic_int _helping { 0 };
 
 	// synchronization
-	core_trace_mutex(core::Lock, _queueMutex, "ThreadPoolQueue");
-	core::ConditionVariable _queueCondition;
+	core_trace_mutex(core::Lock, _sleepMutex, "ThreadPoolSleep");
+	core::ConditionVariable _sleepCondition;
+	core_trace_mutex(core::Lock, _groupMutex, "ThreadPoolGroup");
+	core::ConditionVariable _groupCondition;
 	core::AtomicBool _stop { false };
 	core::AtomicBool _force { false };
 };
@@ -75,26 +244,47 @@ private:
 // add new work item to the pool
 template<class F, class ... Args>
 auto ThreadPool::enqueue(F&& f, Args&&... args)
+-> std::future<typename std::result_of<F(Args...)>::type> {
+	return enqueue(TaskPriority::Normal, std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+template<class F, class ... Args>
+auto ThreadPool::enqueue(TaskPriority priority, F&& f, Args&&... args)
 -> std::future<typename std::result_of<F(Args...)>::type> {
 	using return_type = typename std::result_of<F(Args...)>::type;
 	if (_stop) {
 		return std::future<return_type>();
 	}
 
-	auto task = std::make_shared<std::packaged_task<return_type()> >(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
-
-	std::future<return_type> res = task->get_future();
-	{
-		std::unique_lock lock(_queueMutex);
-		if (_stop) {
-			return std::future<return_type>();
-		}
-		_tasks.emplace([task]() {(*task)();});
+	std::packaged_task<return_type()> task(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+	std::future<return_type> res = task.get_future();
+	if (!submit(Task(std::move(task)), priority)) {
+		return std::future<return_type>();
 	}
-	_queueCondition.notify_one();
 	return res;
 }
 
+template<class F>
+bool ThreadPool::schedule(F&& f, TaskPriority priority) {
+	if (_stop) {
+		return false;
+	}
+	return submit(Task(std::forward<F>(f)), priority);
+}
+
+template<class F>
+bool ThreadPool::schedule(TaskGroup& group, F&& f, TaskPriority priority) {
+	if (_stop) {
+		return false;
+	}
+	group._pending.fetch_add(1, std::memory_order_relaxed);
+	if (!submit(Task(std::forward<F>(f), &group), priority)) {
+		group._pending.fetch_sub(1, std::memory_order_release);
+		return false;
+	}
+	return true;
+}
+
 inline size_t ThreadPool::size() const {
 	return _threads;
 }
@@ -6,6 +6,17 @@
 #include "core/Log.h"
 #include "core/StringUtil.h"
 #include <SDL.h>
+#include <SDL_platform.h>
+
+#if defined(__LINUX__) || defined(__MACOSX__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(__WINDOWS__)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
 
 namespace io {
 
@@ -194,7 +205,82 @@ int File::read(void *buf, size_t size, size_t maxnum) {
 	return n;
 }
 
+const uint8_t* File::map(size_t& size) {
+	if (_mapped != nullptr) {
+		size = _mappedSize;
+		return _mapped;
+	}
+	size = 0u;
+	if (_file == nullptr || _mode != FileMode::Read) {
+		return nullptr;
+	}
+	void *mem = nullptr;
+#if defined(__LINUX__) || defined(__MACOSX__)
+	const int fd = ::open(_rawPath.c_str(), O_RDONLY);
+	if (fd == -1) {
+		return nullptr;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+		::close(fd);
+		return nullptr;
+	}
+	mem = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// the mapping keeps a reference to the file
+	::close(fd);
+	if (mem == MAP_FAILED) {
+		Log::debug("Failed to map file %s", _rawPath.c_str());
+		return nullptr;
+	}
+	_mappedSize = (size_t)st.st_size;
+#elif defined(__WINDOWS__)
+	HANDLE handle = CreateFileA(_rawPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) {
+		return nullptr;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(handle, &fileSize) || fileSize.QuadPart <= 0) {
+		CloseHandle(handle);
+		return nullptr;
+	}
+	HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(handle);
+	if (mapping == nullptr) {
+		Log::debug("Failed to map file %s", _rawPath.c_str());
+		return nullptr;
+	}
+	mem = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	// the view keeps a reference to the mapping
+	CloseHandle(mapping);
+	if (mem == nullptr) {
+		Log::debug("Failed to map file %s", _rawPath.c_str());
+		return nullptr;
+	}
+	_mappedSize = (size_t)fileSize.QuadPart;
+#else
+	return nullptr;
+#endif
+	_mapped = (const uint8_t*)mem;
+	size = _mappedSize;
+	Log::debug("Mapped %i bytes of %s", (int)_mappedSize, _rawPath.c_str());
+	return _mapped;
+}
+
+void File::unmap() {
+	if (_mapped == nullptr) {
+		return;
+	}
+#if defined(__LINUX__) || defined(__MACOSX__)
+	munmap((void*)_mapped, _mappedSize);
+#elif defined(__WINDOWS__)
+	UnmapViewOfFile(_mapped);
+#endif
+	_mapped = nullptr;
+	_mappedSize = 0u;
+}
+
 void File::close() {
+	unmap();
 	if (_file != nullptr) {
 		SDL_RWclose(_file);
 		_file = nullptr;
@@ -33,6 +33,10 @@ protected:
 	SDL_RWops* _file;
 	core::String _rawPath;
 	FileMode _mode;
+	const uint8_t* _mapped = nullptr;
+	size_t _mappedSize = 0u;
+
+	void unmap();
 
 	File(const core::String& rawPath, FileMode mode);
 public:
@@ -45,7 +49,18 @@ public:
 	 * @c true otherwise
 	 */
 	bool open(FileMode mode);
+	/**
+	 * @brief Closes the handle and releases the memory mapping (see map())
+	 */
 	void close();
+	/**
+	 * @brief Maps the whole file read-only into memory.
+	 * @param[out] size The size of the mapped memory
+	 * @return @c nullptr if the file can't be mapped - e.g. because it's not opened
+	 * in read mode, it's empty or not a local file. The memory stays valid until the file
+	 * is closed.
+	 */
+	const uint8_t* map(size_t& size);
 	int read(void *buf, size_t size, size_t maxnum);
 	long tell() const;
 	long seek(long offset, int seekType) const;
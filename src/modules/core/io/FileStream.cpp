@@ -7,21 +7,108 @@
 #include "core/io/File.h"
 #include "core/Assert.h"
 #include "core/Log.h"
+#include "core/Trace.h"
 #include <stdarg.h>
 
 namespace io {
 
 FileStream::FileStream(File* file) :
 		FileStream(file->_file) {
+	size_t size = 0u;
+	const uint8_t *mapped = file->map(size);
+	if (mapped != nullptr && (int64_t)size == _size) {
+		_mapped = mapped;
+	}
 }
 
 FileStream::FileStream(SDL_RWops* rwops) :
 		_rwops(rwops) {
 	core_assert(rwops != nullptr);
 	_size = SDL_RWsize(_rwops);
+	if (_rwops->type == SDL_RWOPS_MEMORY_RO) {
+		_mapped = _rwops->hidden.mem.base;
+	}
+}
+
+FileStream::FileStream(const uint8_t* buf, size_t size) :
+		_size((int64_t)size), _mapped(buf) {
+	core_assert(buf != nullptr || size == 0u);
 }
 
 FileStream::~FileStream() {
+	if (!flushWrites()) {
+		Log::error("Failed to write the pending %i bytes of the stream", (int)_writeBufLength);
+	}
+	delete[] _readBuf;
+	delete[] _writeBuf;
+}
+
+bool FileStream::writeRaw(int64_t pos, const uint8_t *buf, size_t size) const {
+	if (SDL_RWseek(_rwops, pos, RW_SEEK_SET) == -1) {
+		return false;
+	}
+	size_t completeBytesWritten = 0;
+	size_t bytesWritten = 1;
+	while (completeBytesWritten < size && bytesWritten > 0) {
+		bytesWritten = SDL_RWwrite(_rwops, buf + completeBytesWritten, 1, size - completeBytesWritten);
+		completeBytesWritten += bytesWritten;
+	}
+	return completeBytesWritten == size;
+}
+
+bool FileStream::flushWrites() const {
+	if (_writeBufLength <= 0) {
+		return true;
+	}
+	core_trace_scoped(FileStreamFlush);
+	bool success = writeRaw(_writeBufPos, _writeBuf, (size_t)_writeBufLength);
+	// seeking flushes the buffer of the stdio based rwops - other handles of the file see the data then
+	if (success && SDL_RWseek(_rwops, 0, RW_SEEK_CUR) == -1) {
+		success = false;
+	}
+	_writeBufLength = 0;
+	if (!success) {
+		_writeFailed = true;
+	}
+	return success;
+}
+
+bool FileStream::flush() {
+	return flushWrites() && !_writeFailed;
+}
+
+const uint8_t *FileStream::data(size_t size) const {
+	if (_mapped != nullptr) {
+		return _mapped + _pos;
+	}
+	if (_pos >= _readBufPos && _pos + (int64_t)size <= _readBufPos + _readBufLength) {
+		return _readBuf + (_pos - _readBufPos);
+	}
+	core_assert((int64_t)size <= BufferSize);
+	// the pending writes must be visible for the read
+	if (!flushWrites()) {
+		return nullptr;
+	}
+	_readBufLength = 0;
+	if (SDL_RWseek(_rwops, _pos, RW_SEEK_SET) == -1) {
+		return nullptr;
+	}
+	if (_readBuf == nullptr) {
+		_readBuf = new uint8_t[BufferSize];
+	}
+	const int64_t length = core_min(BufferSize, remaining());
+	int64_t completeBytesRead = 0;
+	size_t bytesRead = 1;
+	while (completeBytesRead < length && bytesRead != 0) {
+		bytesRead = SDL_RWread(_rwops, _readBuf + completeBytesRead, 1, (size_t)(length - completeBytesRead));
+		completeBytesRead += (int64_t)bytesRead;
+	}
+	_readBufPos = _pos;
+	_readBufLength = completeBytesRead;
+	if (completeBytesRead < (int64_t)size) {
+		return nullptr;
+	}
+	return _readBuf;
 }
 
 int FileStream::peekInt(uint32_t& val) const {
@@ -220,12 +307,34 @@ int FileStream::readInt(uint32_t& val) {
 }
 
 int FileStream::readBuf(uint8_t *buf, size_t bufSize) {
-	for (size_t i = 0; i < bufSize; ++i) {
-		if (readByte(buf[i]) != 0) {
+	// what is available is still read - but it's an error if it's not enough
+	const int64_t length = core_min((int64_t)bufSize, remaining());
+	if (length <= 0) {
+		return bufSize == 0u ? 0 : -1;
+	}
+	if (_mapped != nullptr || length <= BufferSize) {
+		const uint8_t *src = data((size_t)length);
+		if (src == nullptr) {
+			return -1;
+		}
+		SDL_memcpy(buf, src, (size_t)length);
+	} else {
+		// too big for the read-ahead window - read it directly into the target buffer
+		if (!flushWrites() || SDL_RWseek(_rwops, _pos, RW_SEEK_SET) == -1) {
+			return -1;
+		}
+		int64_t completeBytesRead = 0;
+		size_t bytesRead = 1;
+		while (completeBytesRead < length && bytesRead != 0) {
+			bytesRead = SDL_RWread(_rwops, buf + completeBytesRead, 1, (size_t)(length - completeBytesRead));
+			completeBytesRead += (int64_t)bytesRead;
+		}
+		if (completeBytesRead != length) {
 			return -1;
 		}
 	}
-	return 0;
+	_pos += length;
+	return length == (int64_t)bufSize ? 0 : -1;
 }
 
 int FileStream::readLong(uint64_t& val) {
@@ -239,30 +348,37 @@ int FileStream::readLong(uint64_t& val) {
 }
 
 bool FileStream::addByte(uint8_t val) {
-	SDL_RWseek(_rwops, _pos, RW_SEEK_SET);
-	if (SDL_RWwrite(_rwops, &val, 1, 1) != 1) {
-		return false;
-	}
-	if (_pos >= _size) {
-		++_size;
-	}
-	++_pos;
-	return true;
+	return append(&val, 1);
 }
 
 bool FileStream::append(const uint8_t *buf, size_t size) {
-	SDL_RWseek(_rwops, _pos, RW_SEEK_SET);
-	size_t completeBytesWritten = 0;
-	int32_t bytesWritten = 1;
-	const uint8_t* b = buf;
-	while (completeBytesWritten < size && bytesWritten > 0) {
-		bytesWritten = (int32_t)SDL_RWwrite(_rwops, b, 1, (size - completeBytesWritten));
-		b += bytesWritten;
-		completeBytesWritten += bytesWritten;
-	}
-	if (completeBytesWritten != size) {
+	if (_rwops == nullptr || _mapped != nullptr) {
+		Log::debug("Can't write into a read only stream");
 		return false;
 	}
+	// the read-ahead window would be outdated
+	if (_pos < _readBufPos + _readBufLength && _pos + (int64_t)size > _readBufPos) {
+		_readBufLength = 0;
+	}
+	if (_writeBufLength > 0 && (_pos != _writeBufPos + _writeBufLength || _writeBufLength + (int64_t)size > BufferSize)) {
+		if (!flushWrites()) {
+			return false;
+		}
+	}
+	if ((int64_t)size >= BufferSize) {
+		if (!writeRaw(_pos, buf, size)) {
+			return false;
+		}
+	} else {
+		if (_writeBuf == nullptr) {
+			_writeBuf = new uint8_t[BufferSize];
+		}
+		if (_writeBufLength == 0) {
+			_writeBufPos = _pos;
+		}
+		SDL_memcpy(_writeBuf + _writeBufLength, buf, size);
+		_writeBufLength += (int64_t)size;
+	}
 	if (_pos >= _size) {
 		_size += size;
 	}
@@ -311,6 +427,9 @@ int FileStream::seek(int64_t position) {
 	if (position > _size || position < 0) {
 		return -1;
 	}
+	if (!flushWrites()) {
+		return -1;
+	}
 	_pos = position;
 	return 0;
 }
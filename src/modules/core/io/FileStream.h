@@ -11,6 +11,7 @@
 #include "core/Common.h"
 #include "core/SharedPtr.h"
 #include <limits.h>
+#include <SDL_stdinc.h>
 
 namespace io {
 
@@ -19,23 +20,64 @@ typedef core::SharedPtr<File> FilePtr;
 
 /**
  * @brief Little endian file stream
+ *
+ * Reads are served from a read-ahead window or - for local files that are opened for reading
+ * and for read-only memory - directly from the mapped memory. Writes are collected in a buffer
+ * that is flushed on seek(), flush() and on destruction. Writers should call flush() at the end -
+ * the destructor can only log a failed write.
  */
 class FileStream {
 private:
+	static constexpr int64_t BufferSize = 64 * 1024;
 	int64_t _pos = 0;
 	int64_t _size = 0;
-	mutable SDL_RWops *_rwops;
+	mutable SDL_RWops *_rwops = nullptr;
+	// the complete stream content if mapped - reads don't touch the rwops in this case
+	const uint8_t *_mapped = nullptr;
+	// the read-ahead window covers the stream range [_readBufPos, _readBufPos + _readBufLength)
+	mutable uint8_t *_readBuf = nullptr;
+	mutable int64_t _readBufPos = 0;
+	mutable int64_t _readBufLength = 0;
+	// the pending writes cover the stream range [_writeBufPos, _writeBufPos + _writeBufLength)
+	mutable uint8_t *_writeBuf = nullptr;
+	mutable int64_t _writeBufPos = 0;
+	mutable int64_t _writeBufLength = 0;
+	mutable bool _writeFailed = false;
 
+	/**
+	 * @return Pointer to @c size bytes of the stream content at the current position or
+	 * @c nullptr on error
+	 */
+	const uint8_t *data(size_t size) const;
+	bool flushWrites() const;
+	bool writeRaw(int64_t pos, const uint8_t *buf, size_t size) const;
+
+	FileStream(const FileStream&) = delete;
+	FileStream &operator=(const FileStream&) = delete;
 public:
+	/**
+	 * @note Maps the file if it is opened for reading
+	 */
 	FileStream(File* file);
 	FileStream(const FilePtr& file) : FileStream(file.get()) {}
 	FileStream(SDL_RWops* rwops);
+	/**
+	 * @brief Read only stream over the given memory. The memory must stay valid for the
+	 * lifetime of the stream.
+	 */
+	FileStream(const uint8_t* buf, size_t size);
 	virtual ~FileStream();
 
 	inline int64_t remaining() const {
 		return _size - _pos;
 	}
 
+	/**
+	 * @brief Writes the pending data
+	 * @return @c false if any of the buffered writes failed
+	 */
+	bool flush();
+
 	bool addBool(bool value);
 	bool addByte(uint8_t val);
 	bool addShort(uint16_t word);
@@ -46,6 +88,9 @@ public:
 	bool addString(const core::String& string, bool terminate = true);
 	bool addFormat(const char *fmt, ...);
 
+	/**
+	 * @note Flushes the pending writes
+	 */
 	int seek(int64_t position);
 
 	/**
@@ -58,50 +103,25 @@ public:
 		if (remaining() < (int64_t)bufSize) {
 			return -1;
 		}
-		uint8_t buf[bufSize];
-		SDL_RWseek(_rwops, _pos, RW_SEEK_SET);
-		uint8_t *b = buf;
-
-		size_t completeBytesRead = 0;
-		size_t bytesRead = 1;
-		while (completeBytesRead < bufSize && bytesRead != 0) {
-			bytesRead = SDL_RWread(_rwops, b, 1, (bufSize - completeBytesRead));
-			b += bytesRead;
-			completeBytesRead += bytesRead;
-		}
-		if (completeBytesRead != bufSize) {
+		const uint8_t *buf = data(bufSize);
+		if (buf == nullptr) {
 			return -1;
 		}
-		const Ret *word = (const Ret*) (void*) buf;
-		val = *word;
+		SDL_memcpy(&val, buf, bufSize);
 		return 0;
 	}
 
+	/**
+	 * @note The data is only written to the rwops on flush()
+	 */
 	template<class Type>
 	inline bool write(Type val) {
-		SDL_RWseek(_rwops, _pos, RW_SEEK_SET);
 		const size_t bufSize = sizeof(Type);
 		uint8_t buf[bufSize];
 		for (size_t i = 0; i < bufSize; ++i) {
 			buf[i] = uint8_t(val >> (i * CHAR_BIT));
 		}
-
-		uint8_t *b = buf;
-		size_t completeBytesWritten = 0;
-		int32_t bytesWritten = 1;
-		while (completeBytesWritten < bufSize && bytesWritten > 0) {
-			bytesWritten = (int32_t)SDL_RWwrite(_rwops, b, 1, (bufSize - completeBytesWritten));
-			b += bytesWritten;
-			completeBytesWritten += bytesWritten;
-		}
-		if (completeBytesWritten != bufSize) {
-			return false;
-		}
-		if (_pos >= _size) {
-			_size += sizeof(val);
-		}
-		_pos += sizeof(val);
-		return true;
+		return append(buf, bufSize);
 	}
 
 	template<class Ret>
@@ -6,14 +6,106 @@
 #include "core/Log.h"
 #include "core/Var.h"
 #include "core/Assert.h"
+#include "core/GameConfig.h"
+#include "core/Common.h"
 #include <stdio.h>
 #include <string.h>
+#include <atomic>
+#include <algorithm>
 #include <SDL_stdinc.h>
+#include <glm/integer.hpp>
 
 namespace metric {
 
+// power of two buckets for the timing samples - bucket 0 is for the value 0
+static constexpr int TimingBuckets = 33;
+// the amount of accumulators per metric - every recording thread is assigned to one of them
+static constexpr int Shards = 8;
+
+static std::atomic_uint _nextShard { 0u };
+static thread_local int _shard = -1;
+
+static inline int currentShard() {
+	if (_shard == -1) {
+		_shard = (int)(_nextShard.fetch_add(1u, std::memory_order_relaxed) % (unsigned int)Shards);
+	}
+	return _shard;
+}
+
+struct TimingBucket {
+	std::atomic<uint64_t> samples { 0u };
+	std::atomic<uint64_t> sum { 0u };
+};
+
+/**
+ * @brief The values that the threads of one shard recorded since the last flush - the threads of
+ * different shards don't share a cache line
+ */
+struct alignas(64) MetricShard {
+	// the sum of the deltas for counters and meters
+	std::atomic<int64_t> value { 0 };
+	// the amount of recorded values since the last flush
+	std::atomic<uint32_t> samples { 0u };
+	std::atomic<uint32_t> min { UINT32_MAX };
+	std::atomic<uint32_t> max { 0u };
+	// only allocated for timings and histograms
+	std::unique_ptr<TimingBucket[]> buckets;
+};
+
+/**
+ * @brief The aggregated values of a metric since the last flush - the values are recorded
+ * lock free by any thread into the shard of the thread and merged by the flush
+ */
+struct MetricSlot {
+	core::String key;
+	MetricType type;
+	// sorted by key to get a stable order in the metric line
+	Metric::MetricTags tags;
+
+	MetricShard shards[Shards];
+	// the last value of a gauge - there is no order between the shards to find the last one
+	std::atomic<int64_t> gauge { 0 };
+
+	// the formatted parts of the metric line before and after the value - only valid for the
+	// flavor that was active when they were formatted
+	bool formatted = false;
+	// the metric line couldn't be formatted - e.g. the tags didn't fit
+	bool invalid = false;
+	core::String head;
+	core::String tail;
+
+	MetricSlot(const char* _key, MetricType _type) : key(_key), type(_type) {
+		if (type != MetricType::Timing && type != MetricType::Histogram) {
+			return;
+		}
+		for (MetricShard& shard : shards) {
+			shard.buckets.reset(new TimingBucket[TimingBuckets]);
+		}
+	}
+};
+
+static const char* typeName(MetricType type) {
+	switch (type) {
+	case MetricType::Count:
+		return "c";
+	case MetricType::Gauge:
+		return "g";
+	case MetricType::Timing:
+		return "ms";
+	case MetricType::Histogram:
+		return "h";
+	case MetricType::Meter:
+		return "m";
+	}
+	return "c";
+}
+
 Metric::~Metric() {
 	shutdown();
+	for (MetricSlot* slot : _slots) {
+		delete slot;
+	}
+	_slots.clear();
 }
 
 bool Metric::init(const char *prefix, const IMetricSenderPtr& messageSender) {
@@ -34,15 +126,22 @@ bool Metric::init(const char *prefix, const IMetricSenderPtr& messageSender) {
 	} else {
 		Log::warn("Invalid %s given - using telegraf", cfg::MetricFlavor);
 	}
+	_flushIntervalMillis = (uint64_t)core_max(0, core::Var::get(cfg::MetricFlushInterval, "1000")->intVal());
+	_lastFlushMillis = 0u;
+	core::ScopedLock lock(_lock);
+	for (MetricSlot* slot : _slots) {
+		slot->formatted = false;
+	}
 	_messageSender = messageSender;
 	return true;
 }
 
 void Metric::shutdown() {
+	flush();
 	_messageSender = IMetricSenderPtr();
 }
 
-bool Metric::createTags(char* buffer, size_t len, const TagMap& tags, const char* sep, const char* preamble, const char *split) {
+bool Metric::createTags(char* buffer, size_t len, const MetricTags& tags, const char* sep, const char* preamble, const char *split) {
 	if (tags.empty()) {
 		return true;
 	}
@@ -59,13 +158,13 @@ bool Metric::createTags(char* buffer, size_t len, const TagMap& tags, const char
 		if (remainingLen <= 0) {
 			return false;
 		}
-		size_t keyValueLen = e->key.size() + SDL_strlen(sep) + e->value.size();
+		size_t keyValueLen = e.first.size() + SDL_strlen(sep) + e.second.size();
 		int written;
 		if (first) {
-			written = SDL_snprintf(buffer, remainingLen, "%s%s%s", e->key.c_str(), sep, e->value.c_str());
+			written = SDL_snprintf(buffer, remainingLen, "%s%s%s", e.first.c_str(), sep, e.second.c_str());
 		} else {
 			keyValueLen += splitLen;
-			written = SDL_snprintf(buffer, remainingLen, "%s%s%s%s", split, e->key.c_str(), sep, e->value.c_str());
+			written = SDL_snprintf(buffer, remainingLen, "%s%s%s%s", split, e.first.c_str(), sep, e.second.c_str());
 		}
 		if (written >= remainingLen) {
 			return false;
@@ -77,43 +176,271 @@ bool Metric::createTags(char* buffer, size_t len, const TagMap& tags, const char
 	return true;
 }
 
-bool Metric::assemble(const char* key, int value, const char* type, const TagMap& tags) const {
+MetricSlot* Metric::slot(const char* key, MetricType type, const TagMap& tags, bool format) {
+	MetricTags sortedTags;
+	sortedTags.reserve(tags.size());
+	for (const auto& e : tags) {
+		sortedTags.emplace_back(e->key, e->value);
+	}
+	std::sort(sortedTags.begin(), sortedTags.end());
+	core::String lookupKey(key);
+	lookupKey += typeName(type);
+	for (const auto& e : sortedTags) {
+		lookupKey += '|';
+		lookupKey += e.first;
+		lookupKey += '=';
+		lookupKey += e.second;
+	}
+
+	core::ScopedLock lock(_lock);
+	MetricSlot* slot = nullptr;
+	if (!_slotsByKey.get(lookupKey, slot)) {
+		slot = new MetricSlot(key, type);
+		slot->tags = std::move(sortedTags);
+		_slots.push_back(slot);
+		_slotsByKey.put(lookupKey, slot);
+	}
+	if (!format) {
+		return slot;
+	}
+	if (!slot->formatted) {
+		formatLine(slot);
+	}
+	if (slot->invalid) {
+		return nullptr;
+	}
+	return slot;
+}
+
+MetricHandle Metric::registerMetric(const char* key, MetricType type, const TagMap& tags) {
+	return slot(key, type, tags);
+}
+
+void Metric::count(MetricHandle handle, int delta) const {
+	core_assert(handle->type == MetricType::Count || handle->type == MetricType::Meter);
+	MetricShard& shard = handle->shards[currentShard()];
+	shard.value.fetch_add(delta, std::memory_order_relaxed);
+	shard.samples.fetch_add(1u, std::memory_order_release);
+}
+
+void Metric::gauge(MetricHandle handle, uint32_t value) const {
+	core_assert(handle->type == MetricType::Gauge);
+	handle->gauge.store(value, std::memory_order_relaxed);
+	handle->shards[currentShard()].samples.fetch_add(1u, std::memory_order_release);
+}
+
+void Metric::timing(MetricHandle handle, uint32_t millis) const {
+	core_assert(handle->type == MetricType::Timing || handle->type == MetricType::Histogram);
+	MetricShard& shard = handle->shards[currentShard()];
+	const int bucket = millis == 0u ? 0 : glm::findMSB(millis) + 1;
+	shard.buckets[bucket].samples.fetch_add(1u, std::memory_order_relaxed);
+	shard.buckets[bucket].sum.fetch_add(millis, std::memory_order_relaxed);
+	uint32_t current = shard.min.load(std::memory_order_relaxed);
+	while (millis < current && !shard.min.compare_exchange_weak(current, millis, std::memory_order_relaxed)) {
+	}
+	current = shard.max.load(std::memory_order_relaxed);
+	while (millis > current && !shard.max.compare_exchange_weak(current, millis, std::memory_order_relaxed)) {
+	}
+	shard.samples.fetch_add(1u, std::memory_order_release);
+}
+
+bool Metric::assemble(const char* key, int value, MetricType type, const TagMap& tags) {
 	if (!_messageSender) {
 		return false;
 	}
-	constexpr int metricSize = 256;
-	char buffer[metricSize];
+	MetricSlot* s = slot(key, type, tags, true);
+	if (s == nullptr) {
+		return false;
+	}
+	switch (type) {
+	case MetricType::Count:
+	case MetricType::Meter:
+		count(s, value);
+		break;
+	case MetricType::Gauge:
+		gauge(s, (uint32_t)value);
+		break;
+	case MetricType::Timing:
+	case MetricType::Histogram:
+		timing(s, (uint32_t)value);
+		break;
+	}
+	return true;
+}
+
+void Metric::formatLine(MetricSlot* slot) {
 	constexpr int tagsSize = 256;
 	char tagsBuffer[tagsSize] = "";
+	const MetricTags& tags = slot->tags;
+	const char* type = typeName(slot->type);
+	char buffer[512];
+	bool tagsValid = true;
 	int written;
 	switch (_flavor) {
 	case Flavor::Etsy:
-		written = SDL_snprintf(buffer, sizeof(buffer), "%s.%s:%i|%s", _prefix.c_str(), key, value, type);
+		written = SDL_snprintf(buffer, sizeof(buffer), "%s.%s:", _prefix.c_str(), slot->key.c_str());
 		break;
 	case Flavor::Datadog:
-		if (!createTags(tagsBuffer, sizeof(tagsBuffer), tags, ":", "|#", ",")) {
-			return false;
-		}
-		written = SDL_snprintf(buffer, sizeof(buffer), "%s.%s:%i|%s%s", _prefix.c_str(), key, value, type, tagsBuffer);
+		tagsValid = createTags(tagsBuffer, sizeof(tagsBuffer), tags, ":", "|#", ",");
+		written = SDL_snprintf(buffer, sizeof(buffer), "%s.%s:", _prefix.c_str(), slot->key.c_str());
 		break;
 	case Flavor::Influx:
-		if (!createTags(tagsBuffer, sizeof(tagsBuffer), tags, "=", ",", ",")) {
-			return false;
-		}
-		written = SDL_snprintf(buffer, sizeof(buffer), "%s_%s,type=%s%s value=%i", _prefix.c_str(), key, type, tagsBuffer, value);
+		tagsValid = createTags(tagsBuffer, sizeof(tagsBuffer), tags, "=", ",", ",");
+		written = SDL_snprintf(buffer, sizeof(buffer), "%s_%s,type=%s%s value=", _prefix.c_str(), slot->key.c_str(), type, tagsBuffer);
 		break;
 	case Flavor::Telegraf:
 	default:
-		if (!createTags(tagsBuffer, sizeof(tagsBuffer), tags, "=", ",", ",")) {
-			return false;
-		}
-		written = SDL_snprintf(buffer, sizeof(buffer), "%s.%s%s:%i|%s", _prefix.c_str(), key, tagsBuffer, value, type);
+		tagsValid = createTags(tagsBuffer, sizeof(tagsBuffer), tags, "=", ",", ",");
+		written = SDL_snprintf(buffer, sizeof(buffer), "%s.%s%s:", _prefix.c_str(), slot->key.c_str(), tagsBuffer);
 		break;
 	}
-	if (written >= metricSize) {
-		return false;
+	slot->formatted = true;
+	slot->invalid = !tagsValid || written >= (int)sizeof(buffer);
+	if (slot->invalid) {
+		Log::warn("Failed to format the metric %s", slot->key.c_str());
+		return;
+	}
+	slot->head = buffer;
+	slot->tail = _flavor == Flavor::Datadog ? tagsBuffer : "";
+}
+
+void Metric::appendLine(const char* line, int len) {
+	if (len <= 0) {
+		return;
+	}
+	if (!_batch.empty() && _batch.size() + 1u + (size_t)len > MaxDatagramSize) {
+		sendBatch();
+	}
+	if (!_batch.empty()) {
+		_batch += '\n';
+	}
+	_batch += line;
+}
+
+void Metric::sendBatch() {
+	if (_batch.empty()) {
+		return;
+	}
+	if (_messageSender && !_messageSender->send(_batch.c_str())) {
+		_sendFailed = true;
+	}
+	_batch.clear();
+}
+
+void Metric::update(uint64_t nowMillis) {
+	if (_lastFlushMillis == 0u) {
+		_lastFlushMillis = nowMillis;
+		return;
+	}
+	if (nowMillis - _lastFlushMillis < _flushIntervalMillis) {
+		return;
+	}
+	_lastFlushMillis = nowMillis;
+	flush();
+}
+
+bool Metric::flush() {
+	core_trace_scoped(MetricFlush);
+	core::ScopedLock lock(_lock);
+	_sendFailed = false;
+	const bool influx = _flavor == Flavor::Influx;
+	char line[1024];
+	for (MetricSlot* slot : _slots) {
+		// merge the shards - the values of a shard are reset even if the metric isn't sent
+		uint32_t samples = 0u;
+		for (MetricShard& shard : slot->shards) {
+			samples += shard.samples.exchange(0u, std::memory_order_acquire);
+		}
+		if (samples == 0u) {
+			continue;
+		}
+		if (!slot->formatted) {
+			formatLine(slot);
+		}
+		const char* type = typeName(slot->type);
+		const char* head = slot->head.c_str();
+		const char* tail = slot->tail.c_str();
+		int written;
+		switch (slot->type) {
+		case MetricType::Count:
+		case MetricType::Meter:
+		case MetricType::Gauge: {
+			long long value = 0;
+			if (slot->type == MetricType::Gauge) {
+				value = (long long)slot->gauge.load(std::memory_order_relaxed);
+			} else {
+				for (MetricShard& shard : slot->shards) {
+					value += (long long)shard.value.exchange(0, std::memory_order_relaxed);
+				}
+			}
+			if (slot->invalid) {
+				break;
+			}
+			if (influx) {
+				written = SDL_snprintf(line, sizeof(line), "%s%lli", head, value);
+			} else {
+				written = SDL_snprintf(line, sizeof(line), "%s%lli|%s%s", head, value, type, tail);
+			}
+			if (written < (int)sizeof(line)) {
+				appendLine(line, written);
+			}
+			break;
+		}
+		case MetricType::Timing:
+		case MetricType::Histogram: {
+			uint64_t totalSamples = 0u;
+			uint64_t totalSum = 0u;
+			uint32_t min = UINT32_MAX;
+			uint32_t max = 0u;
+			for (MetricShard& shard : slot->shards) {
+				const uint32_t shardMin = shard.min.exchange(UINT32_MAX, std::memory_order_relaxed);
+				const uint32_t shardMax = shard.max.exchange(0u, std::memory_order_relaxed);
+				min = core_min(min, shardMin);
+				max = core_max(max, shardMax);
+			}
+			for (int i = 0; i < TimingBuckets; ++i) {
+				uint64_t bucketSamples = 0u;
+				uint64_t sum = 0u;
+				for (MetricShard& shard : slot->shards) {
+					bucketSamples += shard.buckets[i].samples.exchange(0u, std::memory_order_relaxed);
+					sum += shard.buckets[i].sum.exchange(0u, std::memory_order_relaxed);
+				}
+				if (bucketSamples == 0u) {
+					continue;
+				}
+				totalSamples += bucketSamples;
+				totalSum += sum;
+				if (influx || slot->invalid) {
+					continue;
+				}
+				const unsigned long long mean = (unsigned long long)(sum / bucketSamples);
+				if (bucketSamples == 1u) {
+					written = SDL_snprintf(line, sizeof(line), "%s%llu|%s%s", head, mean, type, tail);
+				} else {
+					written = SDL_snprintf(line, sizeof(line), "%s%llu|%s|@%g%s", head, mean, type, 1.0 / (double)bucketSamples, tail);
+				}
+				if (written < (int)sizeof(line)) {
+					appendLine(line, written);
+				}
+			}
+			if (influx && !slot->invalid && totalSamples > 0u) {
+				const unsigned long long mean = (unsigned long long)(totalSum / totalSamples);
+				if (totalSamples == 1u) {
+					written = SDL_snprintf(line, sizeof(line), "%s%llu", head, mean);
+				} else {
+					written = SDL_snprintf(line, sizeof(line), "%s%llu,count=%llu,min=%u,max=%u", head, mean,
+							(unsigned long long)totalSamples, min, max);
+				}
+				if (written < (int)sizeof(line)) {
+					appendLine(line, written);
+				}
+			}
+			break;
+		}
+		}
 	}
-	return _messageSender->send(buffer);
+	sendBatch();
+	return !_sendFailed;
 }
 
 }
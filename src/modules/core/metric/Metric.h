@@ -13,7 +13,10 @@
 #include "IMetricSender.h"
 #include "core/NonCopyable.h"
 #include "core/collection/StringMap.h"
+#include "core/concurrent/Lock.h"
+#include "core/Trace.h"
 #include <memory>
+#include <vector>
 #include <stdint.h>
 
 namespace metric {
@@ -34,13 +37,67 @@ enum class Flavor {
 using TagMap = core::StringMap<core::String, 4>;
 
 /**
- * @brief The Metric class generates and publishes metrics
+ * @brief The metric types - they define how the values are aggregated between two flushes
+ */
+enum class MetricType : uint8_t {
+	Count,		/**< the deltas are summed up */
+	Gauge,		/**< the last value wins */
+	Timing,		/**< the values are collected in power of two buckets */
+	Histogram,	/**< same as @c Timing */
+	Meter		/**< the deltas are summed up */
+};
+
+struct MetricSlot;
+/**
+ * @brief Handle of a pre-registered metric - see @c Metric::registerMetric()
+ *
+ * Recording a value for a handle doesn't need any lookup or allocation and is lock free. Every thread
+ * records into its own accumulators of the metric - they are merged by @c Metric::flush(). The handle
+ * stays valid as long as the @c Metric instance is alive.
+ */
+using MetricHandle = MetricSlot*;
+
+/**
+ * @brief The Metric class aggregates metrics and publishes them in batches
+ *
+ * Recording a value doesn't send anything - the values are aggregated per metric and sent by
+ * @c flush() (see @c update()). The key and tags based methods look up the metric and register
+ * it on first use. Use @c registerMetric() and the handle based methods to avoid the lookup.
  */
 class Metric : public core::NonCopyable {
+public:
+	/**
+	 * @brief The tags of a metric sorted by their key
+	 */
+	using MetricTags = std::vector<std::pair<core::String, core::String>>;
+	/**
+	 * @brief The max size of a datagram - multiple metric lines are joined with a newline. This
+	 * is the recommended size for statsd to not get fragmented on ethernet
+	 */
+	static constexpr size_t MaxDatagramSize = 1432u;
 private:
 	core::String _prefix;
 	Flavor _flavor = Flavor::Telegraf;
 	IMetricSenderPtr _messageSender;
+	uint64_t _flushIntervalMillis = 1000u;
+	uint64_t _lastFlushMillis = 0u;
+
+	core_trace_mutex(core::Lock, _lock, "Metric");
+	// owned - the handles are pointers to the slots
+	std::vector<MetricSlot*> _slots;
+	// the slots of the metrics that were recorded by key and tags (and not by handle)
+	core::StringMap<MetricSlot*, 256> _slotsByKey;
+	core::String _batch;
+	bool _sendFailed = false;
+
+	/**
+	 * @param[in] format Format the metric line for the current flavor
+	 * @return @c nullptr if the metric line should be formatted but couldn't - e.g. because the tags didn't fit
+	 */
+	MetricSlot* slot(const char* key, MetricType type, const TagMap& tags, bool format = false);
+	void formatLine(MetricSlot* slot);
+	void appendLine(const char* line, int len);
+	void sendBatch();
 
 	/**
 	 * @brief Create the needed tag list if it is supported by the specified flavor
@@ -51,27 +108,73 @@ private:
 	 * @param[in] split The separator between key/value pairs
 	 * @return @c false if not all tags could get written into the specified target buffer, @c true otherwise
 	 */
-	static bool createTags(char *buffer, size_t len, const TagMap& tags, const char* sep, const char* preamble, const char *split = ",");
-	bool assemble(const char* key, int value, const char* type, const TagMap& tags = {}) const;
+	static bool createTags(char *buffer, size_t len, const MetricTags& tags, const char* sep, const char* preamble, const char *split = ",");
+	/**
+	 * @return @c false if there is no sender or if the metric line can't be formatted
+	 */
+	bool assemble(const char* key, int value, MetricType type, const TagMap& tags = {});
 public:
 	~Metric();
 
 	/**
 	 * @param[in] messageSender @c IMessageSender - must already be initialized
-	 * @note Reads the @c metric_flavor cvar to configure the flavor.
+	 * @note Reads the @c metric_flavor cvar to configure the flavor and @c metric_flushinterval for
+	 * the interval in millis that @c update() is flushing the aggregated metrics in.
 	 */
 	bool init(const char *prefix, const IMetricSenderPtr& messageSender);
+	/**
+	 * @brief Flushes the metrics that were recorded since the last flush
+	 */
 	void shutdown();
 
+	/**
+	 * @brief Registers the metric with the given key, type and tags. Registering the same metric
+	 * twice returns the same handle. This should be done once at construction time for metrics
+	 * that are recorded in hot code paths - the tags are not formatted for every recorded value.
+	 * @note The metric can be registered before @c init() was called
+	 */
+	MetricHandle registerMetric(const char* key, MetricType type, const TagMap& tags = {});
+
+	/**
+	 * @brief Adds the delta to a @c MetricType::Count or @c MetricType::Meter metric
+	 */
+	void count(MetricHandle handle, int delta) const;
+	/**
+	 * @brief Sets the value of a @c MetricType::Gauge metric
+	 */
+	void gauge(MetricHandle handle, uint32_t value) const;
+	/**
+	 * @brief Records a sample for a @c MetricType::Timing or @c MetricType::Histogram metric
+	 */
+	void timing(MetricHandle handle, uint32_t millis) const;
+
+	/**
+	 * @brief Flushes the aggregated metrics if the flush interval elapsed
+	 * @param[in] nowMillis The current time in millis
+	 */
+	void update(uint64_t nowMillis);
+
+	/**
+	 * @brief Sends the values that were aggregated since the last flush as datagrams of at most
+	 * @c MaxDatagramSize bytes.
+	 *
+	 * Counters and meters are sent as the sum of their deltas, gauges with their last value. The
+	 * samples of timings and histograms are sent as the mean of each power of two bucket together
+	 * with the sample rate (1/count of the bucket) for the statsd flavors - and as mean, count, min
+	 * and max fields for influx.
+	 * @return @c false if not all datagrams could get sent
+	 */
+	bool flush();
+
 	/**
 	 * @brief Increments the key
 	 */
-	bool increment(const char* key, const TagMap& tags = {}) const;
+	bool increment(const char* key, const TagMap& tags = {});
 
 	/**
 	 * @brief Decrements the key
 	 */
-	bool decrement(const char* key, const TagMap& tags = {}) const;
+	bool decrement(const char* key, const TagMap& tags = {});
 
 	/**
 	 * @brief Add the specified delta to the given key
@@ -82,7 +185,7 @@ public:
 	 * would be exported as 0.1. Valid counter values are in the range (-2^63^, 2^63^).
 	 * @code <metric name>:<value>|c[|@<sample rate>] @endcode
 	 */
-	bool count(const char* key, int delta, const TagMap& tags = {}, float sampleRate = 1.0f) const;
+	bool count(const char* key, int delta, const TagMap& tags = {}, float sampleRate = 1.0f);
 
 	/**
 	 * @brief Records a gauge with the give value for the key
@@ -92,7 +195,7 @@ public:
 	 * client rather than the server. Valid gauge values are in the range [0, 2^64^)
 	 * @code <metric name>:<value>|g @endcode
 	 */
-	bool gauge(const char* key, uint32_t value, const TagMap& tags = {}) const;
+	bool gauge(const char* key, uint32_t value, const TagMap& tags = {});
 
 	/**
 	 * @brief Records a timing in millis for a key
@@ -101,7 +204,7 @@ public:
 	 * a user. Valid timer values are in the range [0, 2^64^).
 	 * @code <metric name>:<value>|ms @endcode
 	 */
-	bool timing(const char* key, uint32_t millis, const TagMap& tags = {}) const;
+	bool timing(const char* key, uint32_t millis, const TagMap& tags = {});
 
 	/**
 	 * @brief Records a histogram
@@ -111,7 +214,7 @@ public:
 	 * are in the range [0, 2^64^).
 	 * @code <metric name>:<value>|h @endcode
 	 */
-	bool histogram(const char* key, uint32_t millis, const TagMap& tags = {}) const;
+	bool histogram(const char* key, uint32_t millis, const TagMap& tags = {});
 
 	/**
 	 * @brief Records a meter
@@ -125,35 +228,35 @@ public:
 	 * While this is convenient, the full, explicit metric form should be used.
 	 * The shortened form is documented here for completeness.
 	 */
-	bool meter(const char* key, int value, const TagMap& tags = {}) const;
+	bool meter(const char* key, int value, const TagMap& tags = {});
 };
 
-inline bool Metric::increment(const char* key, const TagMap& tags) const {
+inline bool Metric::increment(const char* key, const TagMap& tags) {
 	return count(key, 1, tags);
 }
 
-inline bool Metric::decrement(const char* key, const TagMap& tags) const {
+inline bool Metric::decrement(const char* key, const TagMap& tags) {
 	return count(key, -1, tags);
 }
 
-inline bool Metric::count(const char* key, int delta, const TagMap& tags, float sampleRate) const {
-	return assemble(key, delta, "c", tags); // TODO:"|@%f", sampleRate
+inline bool Metric::count(const char* key, int delta, const TagMap& tags, float sampleRate) {
+	return assemble(key, delta, MetricType::Count, tags); // TODO:"|@%f", sampleRate
 }
 
-inline bool Metric::gauge(const char* key, uint32_t value, const TagMap& tags) const {
-	return assemble(key, value, "g", tags);
+inline bool Metric::gauge(const char* key, uint32_t value, const TagMap& tags) {
+	return assemble(key, value, MetricType::Gauge, tags);
 }
 
-inline bool Metric::timing(const char* key, uint32_t millis, const TagMap& tags) const {
-	return assemble(key, millis, "ms", tags);
+inline bool Metric::timing(const char* key, uint32_t millis, const TagMap& tags) {
+	return assemble(key, millis, MetricType::Timing, tags);
 }
 
-inline bool Metric::histogram(const char* key, uint32_t millis, const TagMap& tags) const {
-	return assemble(key, millis, "h", tags);
+inline bool Metric::histogram(const char* key, uint32_t millis, const TagMap& tags) {
+	return assemble(key, millis, MetricType::Histogram, tags);
 }
 
-inline bool Metric::meter(const char* key, int value, const TagMap& tags) const {
-	return assemble(key, value, "m", tags);
+inline bool Metric::meter(const char* key, int value, const TagMap& tags) {
+	return assemble(key, value, MetricType::Meter, tags);
 }
 
 using MetricPtr = std::shared_ptr<Metric>;
@@ -4,10 +4,13 @@
 
 #include "core/tests/AbstractTest.h"
 #include "core/EventBus.h"
+#include <thread>
+#include <vector>
 
 namespace core {
 
 EVENTBUSEVENT(TestEvent);
+EVENTBUSPAYLOADEVENT(TestPayloadEvent, int);
 
 template<class T>
 class CountHandlerTest: public IEventBusHandler<T> {
@@ -28,6 +31,15 @@ public:
 class HandlerTest: public CountHandlerTest<TestEvent> {
 };
 
+class PayloadHandlerTest: public IEventBusHandler<TestPayloadEvent> {
+public:
+	std::vector<int> payloads;
+
+	void onEvent(const TestPayloadEvent& event) override {
+		payloads.push_back(event.get());
+	}
+};
+
 class EventBusTest : public core::AbstractTest {
 };
 
@@ -72,6 +84,58 @@ TEST_F(EventBusTest, testSubscribeAndQueuePendingLeft) {
 	ASSERT_EQ(1, handler.getCount()) << "Expected the handler to be notified once";
 }
 
+TEST_F(EventBusTest, testQueueOrder) {
+	EventBus eventBus;
+	PayloadHandlerTest handler;
+
+	eventBus.subscribe(handler);
+	const int n = 100;
+	for (int i = 0; i < n; ++i) {
+		eventBus.enqueue(std::make_shared<TestPayloadEvent>(i));
+	}
+	ASSERT_EQ(n, eventBus.size());
+	ASSERT_EQ(n - 10, eventBus.update(10));
+	eventBus.enqueue<TestPayloadEvent>(n);
+	ASSERT_EQ(0, eventBus.update());
+	ASSERT_EQ(n + 1, (int)handler.payloads.size());
+	for (int i = 0; i <= n; ++i) {
+		EXPECT_EQ(i, handler.payloads[i]) << "Expected the events to be executed in the order they were enqueued in";
+	}
+}
+
+TEST_F(EventBusTest, testQueueMultipleThreads) {
+	EventBus eventBus;
+	PayloadHandlerTest handler;
+
+	eventBus.subscribe(handler);
+	const int threads = 4;
+	const int n = 1000;
+	std::vector<std::thread> producers;
+	for (int t = 0; t < threads; ++t) {
+		producers.emplace_back([&eventBus, t] () {
+			for (int i = 0; i < n; ++i) {
+				eventBus.enqueue<TestPayloadEvent>(t * n + i);
+			}
+		});
+	}
+	for (std::thread& thread : producers) {
+		thread.join();
+	}
+	ASSERT_EQ(threads * n, eventBus.size());
+	ASSERT_EQ(0, eventBus.update());
+	ASSERT_EQ(threads * n, (int)handler.payloads.size());
+	// the events of each thread must still be in the order they were enqueued in
+	int last[threads];
+	for (int t = 0; t < threads; ++t) {
+		last[t] = -1;
+	}
+	for (int payload : handler.payloads) {
+		const int t = payload / n;
+		EXPECT_LT(last[t], payload);
+		last[t] = payload;
+	}
+}
+
 TEST_F(EventBusTest, DISABLED_testMassSubscribeAndPublish_10000000) {
 	EventBus eventBus;
 	HandlerTest handler;
@@ -6,6 +6,8 @@
 #include "core/io/FileStream.h"
 #include "core/io/Filesystem.h"
 #include "core/FourCC.h"
+#include <SDL_endian.h>
+#include <vector>
 
 namespace io {
 
@@ -64,10 +66,128 @@ TEST_F(FileStreamTest, testFileStreamWrite) {
 	EXPECT_EQ(4l, stream.size());
 	EXPECT_TRUE(stream.addInt(1));
 	EXPECT_EQ(8l, stream.size());
+	EXPECT_TRUE(stream.flush());
 	file->close();
 	file->open(io::FileMode::Read);
 	EXPECT_TRUE(file->exists());
 	EXPECT_EQ(8l, file->length());
 }
 
+TEST_F(FileStreamTest, testFileStreamFlushIsVisible) {
+	const io::FilesystemPtr& fs = io::filesystem();
+	const core::String path = fs->homePath() + "/filestream-flushtest";
+	const FilePtr& file = fs->open(path, io::FileMode::Write);
+	ASSERT_TRUE(file->validHandle());
+	FileStream stream(file.get());
+	EXPECT_TRUE(stream.addString("flushed", false));
+	EXPECT_TRUE(stream.flush());
+	// read with another handle while the file is still open for writing
+	EXPECT_EQ("flushed", fs->load(path));
+}
+
+TEST_F(FileStreamTest, testFileStreamReadAcrossWindow) {
+	// bigger than the read-ahead window - the rwops is writable and thus not mapped
+	std::vector<uint32_t> data(40000);
+	for (size_t i = 0; i < data.size(); ++i) {
+		data[i] = SDL_SwapLE32((uint32_t)i);
+	}
+	SDL_RWops *rwops = SDL_RWFromMem(data.data(), (int)(data.size() * sizeof(uint32_t)));
+	ASSERT_NE(nullptr, rwops);
+	{
+		FileStream stream(rwops);
+		// misalign the reads to cross the window boundary within a value
+		uint8_t byte;
+		ASSERT_EQ(0, stream.readByte(byte));
+		EXPECT_EQ(0u, byte);
+		ASSERT_EQ(0, stream.seek(2));
+		uint16_t word;
+		ASSERT_EQ(0, stream.readShort(word));
+		ASSERT_EQ(0, stream.seek(4 + 1));
+		uint32_t val;
+		for (uint32_t i = 1; i < data.size() - 1; ++i) {
+			ASSERT_EQ(0, stream.readInt(val));
+			ASSERT_EQ((i >> 8) | ((i + 1) << 24), val) << i;
+		}
+		uint8_t buf[8];
+		EXPECT_EQ(-1, stream.readBuf(buf, sizeof(buf)));
+		EXPECT_EQ(0, stream.remaining());
+	}
+	SDL_RWclose(rwops);
+}
+
+TEST_F(FileStreamTest, testFileStreamReadBufBig) {
+	std::vector<uint8_t> data(200000);
+	for (size_t i = 0; i < data.size(); ++i) {
+		data[i] = (uint8_t)(i * 7);
+	}
+	SDL_RWops *rwops = SDL_RWFromMem(data.data(), (int)data.size());
+	ASSERT_NE(nullptr, rwops);
+	{
+		FileStream stream(rwops);
+		ASSERT_EQ(0, stream.seek(3));
+		std::vector<uint8_t> buf(data.size() - 3);
+		ASSERT_EQ(0, stream.readBuf(buf.data(), buf.size()));
+		EXPECT_EQ(0, memcmp(data.data() + 3, buf.data(), buf.size()));
+	}
+	SDL_RWclose(rwops);
+}
+
+TEST_F(FileStreamTest, testFileStreamMemory) {
+	const uint8_t data[] = {'W', 'i', 'n', 'd', 1, 0, 0, 0};
+	FileStream stream(data, sizeof(data));
+	EXPECT_EQ((int64_t)sizeof(data), stream.size());
+	uint32_t magic;
+	EXPECT_EQ(0, stream.readInt(magic));
+	EXPECT_EQ(FourCC('W', 'i', 'n', 'd'), magic);
+	uint32_t val;
+	EXPECT_EQ(0, stream.peekInt(val));
+	EXPECT_EQ(1u, val);
+	EXPECT_FALSE(stream.addByte(1)) << "The memory is read only";
+	EXPECT_EQ(0, stream.readInt(val));
+	EXPECT_EQ(-1, stream.readInt(val));
+}
+
+TEST_F(FileStreamTest, testFileStreamWriteFlush) {
+	uint8_t data[16] {};
+	SDL_RWops *rwops = SDL_RWFromMem(data, sizeof(data));
+	ASSERT_NE(nullptr, rwops);
+	{
+		FileStream stream(rwops);
+		EXPECT_TRUE(stream.addInt(FourCC('W', 'i', 'n', 'd')));
+		EXPECT_EQ(0u, data[0]) << "The write should be buffered";
+		EXPECT_EQ(0, stream.seek(2));
+		EXPECT_EQ('W', data[0]) << "The seek should flush the pending writes";
+		EXPECT_TRUE(stream.addShort(0));
+		EXPECT_TRUE(stream.addByte(1));
+		// the reads must see the pending writes
+		EXPECT_EQ(0, stream.seek(0));
+		uint32_t val;
+		EXPECT_EQ(0, stream.readInt(val));
+		EXPECT_EQ(FourCC('W', 'i', 0, 0), val);
+		EXPECT_TRUE(stream.addByte(2));
+		EXPECT_EQ(0, stream.seek(4));
+		uint8_t byte;
+		EXPECT_EQ(0, stream.readByte(byte));
+		EXPECT_EQ(2u, byte);
+		EXPECT_TRUE(stream.addByte(3));
+	}
+	EXPECT_EQ(3u, data[5]) << "The destruction should flush the pending writes";
+	SDL_RWclose(rwops);
+}
+
+TEST_F(FileStreamTest, testFileStreamMapped) {
+	const FilePtr& file = _testApp->filesystem()->open("iotest.txt");
+	ASSERT_TRUE(file->exists());
+	size_t size = 0u;
+	const uint8_t *mapped = file->map(size);
+	ASSERT_NE(nullptr, mapped);
+	EXPECT_EQ((size_t)file->length(), size);
+	FileStream stream(file.get());
+	uint32_t magic;
+	EXPECT_EQ(0, stream.readInt(magic));
+	EXPECT_EQ(FourCC('W', 'i', 'n', 'd'), magic);
+	file->close();
+	EXPECT_EQ(nullptr, file->map(size));
+}
+
 }
@@ -6,22 +6,35 @@
 #include "core/metric/Metric.h"
 #include "core/metric/IMetricSender.h"
 #include "core/Var.h"
+#include <thread>
+#include <vector>
 
 namespace metric {
 
 class BufferSender : public IMetricSender {
 private:
 	mutable core::String _lastBuffer;
+	mutable std::vector<core::String> _datagrams;
 public:
 
 	bool send(const char* buffer) const override {
 		_lastBuffer = buffer;
+		_datagrams.push_back(_lastBuffer);
 		return true;
 	}
 
 	inline const core::String& metricLine() const {
 		return _lastBuffer;
 	}
+
+	inline const std::vector<core::String>& datagrams() const {
+		return _datagrams;
+	}
+
+	inline void clear() {
+		_lastBuffer = "";
+		_datagrams.clear();
+	}
 };
 
 #define PREFIX "test"
@@ -47,6 +60,7 @@ protected:
 		Metric m;
 		m.init(PREFIX, sender);
 		m.count(id, value, tags);
+		m.flush();
 		return sender->metricLine();
 	}
 
@@ -55,6 +69,7 @@ protected:
 		Metric m;
 		m.init(PREFIX, sender);
 		m.gauge(id, value, tags);
+		m.flush();
 		return sender->metricLine();
 	}
 
@@ -63,6 +78,7 @@ protected:
 		Metric m;
 		m.init(PREFIX, sender);
 		m.timing(id, value, tags);
+		m.flush();
 		return sender->metricLine();
 	}
 
@@ -115,8 +131,8 @@ TEST_F(MetricTest, testTimingSingleTag) {
 		<< "Unexpected influx format";
 }
 
-// The order is not stable - thus the result string order of the tag can differ
-TEST_F(MetricTest, DISABLED_testTimingMultipleTags) {
+// The tags are sorted by their key
+TEST_F(MetricTest, testTimingMultipleTags) {
 	const TagMap map {{"key1", "value1"}, {"key2", "value2"}};
 	EXPECT_EQ(timing("test", 1, Flavor::Etsy, map), PREFIX ".test:1|ms")
 		<< "Expected to get no tags on etsy flavor";
@@ -126,4 +142,122 @@ TEST_F(MetricTest, DISABLED_testTimingMultipleTags) {
 		<< "Expected to get tags after type in datadog flavor";
 }
 
+TEST_F(MetricTest, testCounterAggregated) {
+	setFlavor(Flavor::Telegraf);
+	Metric m;
+	m.init(PREFIX, sender);
+	m.count("test", 1, {{"key1", "value1"}});
+	m.count("test", 2, {{"key1", "value1"}});
+	m.increment("test", {{"key1", "value1"}});
+	EXPECT_TRUE(sender->datagrams().empty()) << "Nothing should get sent before the flush";
+	EXPECT_TRUE(m.flush());
+	ASSERT_EQ(1u, sender->datagrams().size());
+	EXPECT_EQ(PREFIX ".test,key1=value1:4|c", sender->metricLine());
+	sender->clear();
+	EXPECT_TRUE(m.flush());
+	EXPECT_TRUE(sender->datagrams().empty()) << "Nothing was recorded since the last flush";
+}
+
+TEST_F(MetricTest, testGaugeLastValueWins) {
+	setFlavor(Flavor::Etsy);
+	Metric m;
+	m.init(PREFIX, sender);
+	const MetricHandle handle = m.registerMetric("test", MetricType::Gauge);
+	m.gauge(handle, 3);
+	m.gauge(handle, 5);
+	m.flush();
+	EXPECT_EQ(PREFIX ".test:5|g", sender->metricLine());
+}
+
+TEST_F(MetricTest, testMergeThreads) {
+	setFlavor(Flavor::Influx);
+	Metric m;
+	m.init(PREFIX, sender);
+	const MetricHandle counter = m.registerMetric("counter", MetricType::Count);
+	const MetricHandle timing = m.registerMetric("timing", MetricType::Timing);
+	std::vector<std::thread> threads;
+	for (int i = 0; i < 12; ++i) {
+		threads.emplace_back([&, i] () {
+			for (int j = 0; j < 1000; ++j) {
+				m.count(counter, 1);
+			}
+			m.timing(timing, 10u + (uint32_t)i);
+		});
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	m.flush();
+	EXPECT_EQ(PREFIX "_counter,type=c value=12000\n" PREFIX "_timing,type=ms value=15,count=12,min=10,max=21", sender->metricLine());
+}
+
+TEST_F(MetricTest, testAssembleFailures) {
+	setFlavor(Flavor::Telegraf);
+	Metric m;
+	EXPECT_FALSE(m.increment("test")) << "There is no sender";
+	m.init(PREFIX, sender);
+	EXPECT_TRUE(m.increment("test"));
+	const core::String value(300, 'x');
+	EXPECT_FALSE(m.increment("test", {{"key1", value}})) << "The tags don't fit into the metric line";
+}
+
+TEST_F(MetricTest, testRegisterSameMetric) {
+	Metric m;
+	const MetricHandle handle1 = m.registerMetric("test", MetricType::Count, {{"key1", "value1"}, {"key2", "value2"}});
+	const MetricHandle handle2 = m.registerMetric("test", MetricType::Count, {{"key2", "value2"}, {"key1", "value1"}});
+	const MetricHandle handle3 = m.registerMetric("test", MetricType::Gauge, {{"key2", "value2"}, {"key1", "value1"}});
+	EXPECT_EQ(handle1, handle2);
+	EXPECT_NE(handle1, handle3);
+}
+
+TEST_F(MetricTest, testTimingBuckets) {
+	setFlavor(Flavor::Datadog);
+	Metric m;
+	m.init(PREFIX, sender);
+	const MetricHandle handle = m.registerMetric("test", MetricType::Timing, {{"key1", "value1"}});
+	// 2 and 3 end up in the same bucket
+	m.timing(handle, 2);
+	m.timing(handle, 3);
+	m.timing(handle, 3);
+	m.timing(handle, 3);
+	m.timing(handle, 100);
+	m.flush();
+	ASSERT_EQ(1u, sender->datagrams().size());
+	EXPECT_EQ(PREFIX ".test:2|ms|@0.25|#key1:value1\n" PREFIX ".test:100|ms|#key1:value1", sender->metricLine());
+}
+
+TEST_F(MetricTest, testTimingInflux) {
+	setFlavor(Flavor::Influx);
+	Metric m;
+	m.init(PREFIX, sender);
+	m.timing("test", 2);
+	m.timing("test", 10);
+	m.flush();
+	EXPECT_EQ(PREFIX "_test,type=ms value=6,count=2,min=2,max=10", sender->metricLine());
+}
+
+TEST_F(MetricTest, testBatchedDatagrams) {
+	setFlavor(Flavor::Telegraf);
+	Metric m;
+	m.init(PREFIX, sender);
+	const int metrics = 200;
+	for (int i = 0; i < metrics; ++i) {
+		m.count("test", 1, {{"id", core::String::format("%i", i)}});
+	}
+	m.flush();
+	ASSERT_GT(sender->datagrams().size(), 1u);
+	EXPECT_LT(sender->datagrams().size(), (size_t)metrics);
+	int lines = 0;
+	for (const core::String& datagram : sender->datagrams()) {
+		EXPECT_LE(datagram.size(), Metric::MaxDatagramSize);
+		lines += 1;
+		for (size_t i = 0; i < datagram.size(); ++i) {
+			if (datagram[i] == '\n') {
+				++lines;
+			}
+		}
+	}
+	EXPECT_EQ(metrics, lines);
+}
+
 }
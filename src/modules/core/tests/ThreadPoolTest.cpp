@@ -5,6 +5,7 @@
 #include "AbstractTest.h"
 #include "core/concurrent/ThreadPool.h"
 #include "core/concurrent/Atomic.h"
+#include <vector>
 
 namespace core {
 
@@ -43,4 +44,133 @@ TEST_F(ThreadPoolTest, testMultiplePush) {
 	ASSERT_EQ(x, _count) << "Not all threads were executed";
 }
 
+TEST_F(ThreadPoolTest, testScheduleGroup) {
+	const int x = 1000;
+	core::ThreadPool pool(2);
+	pool.init();
+	core::TaskGroup group;
+	for (int i = 0; i < x; ++i) {
+		ASSERT_TRUE(pool.schedule(group, [this] () {
+			++_count;
+		}));
+	}
+	pool.wait(group);
+	EXPECT_TRUE(group.done());
+	ASSERT_EQ(x, _count) << "Not all tasks were executed";
+}
+
+TEST_F(ThreadPoolTest, testNestedGroups) {
+	core::ThreadPool pool(2);
+	pool.init();
+	core::TaskGroup group;
+	for (int i = 0; i < 10; ++i) {
+		pool.schedule(group, [this, &pool] () {
+			// wait from within a worker - the worker helps to execute the tasks
+			core::TaskGroup inner;
+			for (int j = 0; j < 10; ++j) {
+				pool.schedule(inner, [this] () {
+					++_count;
+				});
+			}
+			pool.wait(inner);
+		});
+	}
+	pool.wait(group);
+	ASSERT_EQ(100, _count);
+}
+
+TEST_F(ThreadPoolTest, testWaitWithoutWorkers) {
+	// the waiting thread executes the tasks
+	core::ThreadPool pool(1);
+	core::TaskGroup group;
+	pool.schedule(group, [this] () {
+		_executed = true;
+	});
+	pool.wait(group);
+	ASSERT_TRUE(_executed);
+}
+
+TEST_F(ThreadPoolTest, testWaitHelpsWithLateTasks) {
+	core::ThreadPool pool(1);
+	pool.init();
+	core::AtomicBool lateExecuted(false);
+	core::TaskGroup group;
+	pool.schedule(group, [&] () {
+		// give the waiting thread the chance to fall asleep
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		pool.schedule(group, [&] () {
+			lateExecuted = true;
+		});
+		// the only worker is busy here - the late task is executed by the waiting thread
+		for (int i = 0; i < 500 && !lateExecuted; ++i) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	});
+	pool.wait(group);
+	ASSERT_TRUE(lateExecuted);
+}
+
+TEST_F(ThreadPoolTest, testPriority) {
+	core::ThreadPool pool(1);
+	pool.init();
+	core::AtomicBool started(false);
+	core::AtomicBool release(false);
+	core::TaskGroup group;
+	pool.schedule(group, [&] () {
+		started = true;
+		while (!release) {
+			std::this_thread::yield();
+		}
+	});
+	while (!started) {
+		std::this_thread::yield();
+	}
+	std::vector<int> order;
+	pool.schedule(group, [&] () { order.push_back(2); }, core::TaskPriority::Low);
+	pool.schedule(group, [&] () { order.push_back(1); }, core::TaskPriority::Normal);
+	pool.schedule(group, [&] () { order.push_back(0); }, core::TaskPriority::High);
+	release = true;
+	// don't help here - the order is only defined for the single worker
+	while (!group.done()) {
+		std::this_thread::yield();
+	}
+	ASSERT_EQ(3u, order.size());
+	EXPECT_EQ(0, order[0]);
+	EXPECT_EQ(1, order[1]);
+	EXPECT_EQ(2, order[2]);
+}
+
+TEST_F(ThreadPoolTest, testShutdownNotifiesGroup) {
+	core::ThreadPool pool(1);
+	core::TaskGroup group;
+	pool.schedule(group, [this] () {
+		_executed = true;
+	});
+	EXPECT_EQ(1, group.pending());
+	pool.shutdown();
+	EXPECT_TRUE(group.done());
+	EXPECT_FALSE(_executed);
+	EXPECT_FALSE(pool.schedule([] () {}));
+}
+
+TEST_F(ThreadPoolTest, testWaitWithoutHelping) {
+	const int x = 100;
+	core::ThreadPool pool(2);
+	pool.init();
+	core::TaskGroup group;
+	const std::thread::id caller = std::this_thread::get_id();
+	core::AtomicBool executedByCaller(false);
+	for (int i = 0; i < x; ++i) {
+		pool.schedule(group, [&, this] () {
+			if (std::this_thread::get_id() == caller) {
+				executedByCaller = true;
+			}
+			++_count;
+		});
+	}
+	pool.wait(group, false);
+	ASSERT_EQ(x, _count);
+	EXPECT_FALSE(executedByCaller);
+}
+
 }
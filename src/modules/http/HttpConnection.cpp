@@ -0,0 +1,218 @@
+/**
+ * @file
+ */
+
+#include "HttpConnection.h"
+#include "Url.h"
+#include "core/App.h"
+#include "core/Log.h"
+#include "core/Trace.h"
+#include "core/StandardLib.h"
+#include <string.h>
+#include "Network.cpp.h"
+
+namespace http {
+
+namespace {
+
+// the min amount of free bytes in the receive buffer
+constexpr size_t ReceiveBufferSize = 64 * 1024;
+
+}
+
+HttpConnection::HttpConnection(const core::String &baseUrl) : _socketFD(INVALID_SOCKET) {
+	if (!baseUrl.empty()) {
+		setBaseUrl(baseUrl);
+	}
+}
+
+HttpConnection::~HttpConnection() {
+	disconnect();
+	SDL_free(_buf);
+	_buf = nullptr;
+}
+
+bool HttpConnection::setBaseUrl(const core::String &baseUrl) {
+	disconnect();
+	_baseUrl = baseUrl;
+	const Url u(baseUrl);
+	_hostname = u.hostname;
+	_port = u.port;
+	return u.valid();
+}
+
+bool HttpConnection::isConnected() const {
+	return _socketFD != INVALID_SOCKET;
+}
+
+void HttpConnection::disconnect() {
+	if (_socketFD != INVALID_SOCKET) {
+		closesocket(_socketFD);
+		_socketFD = INVALID_SOCKET;
+		network_cleanup();
+	}
+	_pending = 0;
+	_bufLength = 0u;
+}
+
+bool HttpConnection::connect() {
+	if (!networkInit()) {
+		Log::error("Failed to initialize the network");
+		return false;
+	}
+
+	_socketFD = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (_socketFD == INVALID_SOCKET) {
+		Log::error("Failed to initialize the socket");
+		network_cleanup();
+		return false;
+	}
+
+	struct addrinfo hints;
+	SDL_memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+
+	struct addrinfo* results = nullptr;
+	const int ret = getaddrinfo(_hostname.c_str(), nullptr, &hints, &results);
+	if (ret != 0) {
+		Log::error("Failed to resolve host for %s", _hostname.c_str());
+		disconnect();
+		return false;
+	}
+	const struct sockaddr_in* host_addr = (const struct sockaddr_in*) results->ai_addr;
+	struct sockaddr_in sin;
+	SDL_memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_port = htons(_port);
+	SDL_memcpy(&sin.sin_addr, &host_addr->sin_addr, sizeof(sin.sin_addr));
+	freeaddrinfo(results);
+	if (::connect(_socketFD, (const struct sockaddr *)&sin, sizeof(sin)) == -1) {
+		Log::error("Failed to connect to %s:%i", _hostname.c_str(), _port);
+		disconnect();
+		return false;
+	}
+
+#ifdef WIN32
+	const DWORD timeout = _timeoutMillis;
+#else
+	struct timeval timeout;
+	timeout.tv_sec = _timeoutMillis / 1000u;
+	timeout.tv_usec = (_timeoutMillis % 1000u) * 1000u;
+#endif
+	setsockopt(_socketFD, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+	setsockopt(_socketFD, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeout, sizeof(timeout));
+	// the requests are small and should leave the client as soon as they are written
+	const int noDelay = 1;
+	setsockopt(_socketFD, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+	return true;
+}
+
+bool HttpConnection::send(const char *data, size_t length) {
+	size_t sent = 0u;
+	while (sent < length) {
+		const network_return ret = ::send(_socketFD, data + sent, length - sent, 0);
+		if (ret <= 0) {
+			return false;
+		}
+		sent += ret;
+	}
+	return true;
+}
+
+bool HttpConnection::sendGet(const char *msg, ...) {
+	core_trace_scoped(HttpConnectionSendGet);
+	va_list ap;
+	constexpr std::size_t bufSize = 2048;
+	char text[bufSize];
+
+	va_start(ap, msg);
+	SDL_snprintf(text, bufSize, "%s", _baseUrl.c_str());
+	SDL_vsnprintf(text + _baseUrl.size(), bufSize - _baseUrl.size(), msg, ap);
+	text[sizeof(text) - 1] = '\0';
+	va_end(ap);
+
+	const Url u(text);
+	if (!u.valid()) {
+		Log::error("Invalid url given: '%s'", text);
+		return false;
+	}
+
+	char message[4096];
+	if (SDL_snprintf(message, sizeof(message),
+			"GET %s%s%s HTTP/1.1\r\n"
+			"Host: %s\r\n"
+			"User-agent: %s\r\n"
+			"Connection: keep-alive\r\n"
+			"Accept: */*\r\n"
+			"\r\n",
+			u.path.c_str(),
+			(u.query.empty() ? "" : "?"),
+			u.query.c_str(),
+			u.hostname.c_str(),
+			core::App::getInstance()->appname().c_str()) >= (int)sizeof(message)) {
+		Log::error("Failed to assemble request");
+		return false;
+	}
+
+	if (_socketFD == INVALID_SOCKET && !connect()) {
+		return false;
+	}
+	if (!send(message, SDL_strlen(message))) {
+		Log::debug("Failed to perform http request to %s", text);
+		const bool idle = _pending == 0;
+		disconnect();
+		// the server might have closed the idle connection - try again on a new connection. If
+		// there are pending requests their responses are lost anyway.
+		if (!idle || !connect() || !send(message, SDL_strlen(message))) {
+			Log::error("Failed to perform http request to %s", text);
+			disconnect();
+			return false;
+		}
+	}
+	++_pending;
+	return true;
+}
+
+ResponseParser HttpConnection::receive() {
+	core_trace_scoped(HttpConnectionReceive);
+	if (_pending <= 0 || _socketFD == INVALID_SOCKET) {
+		return ResponseParser(nullptr, 0u);
+	}
+	for (;;) {
+		const int64_t size = HttpParser::messageSize(_buf, _bufLength);
+		if (size < 0) {
+			Log::error("Received malformed http response from %s", _hostname.c_str());
+			disconnect();
+			return ResponseParser(nullptr, 0u);
+		}
+		if (size > 0) {
+			// the parser modifies and owns the memory
+			uint8_t *mem = (uint8_t *)SDL_malloc(size + 1);
+			SDL_memcpy(mem, _buf, size);
+			mem[size] = '\0';
+			_bufLength -= size;
+			SDL_memmove(_buf, _buf + size, _bufLength);
+			--_pending;
+			ResponseParser response(mem, size);
+			const char *connection = response.headerValue(header::CONNECTION);
+			if (connection != nullptr && !SDL_strcasecmp(connection, "close")) {
+				disconnect();
+			}
+			return response;
+		}
+		if (_bufCapacity - _bufLength < ReceiveBufferSize) {
+			_bufCapacity = _bufLength + ReceiveBufferSize * 2;
+			_buf = (uint8_t*)SDL_realloc(_buf, _bufCapacity);
+		}
+		const network_return received = recv(_socketFD, (char*)_buf + _bufLength, _bufCapacity - _bufLength, 0);
+		if (received <= 0) {
+			Log::error("Failed to read http response from %s:%i", _hostname.c_str(), _port);
+			disconnect();
+			return ResponseParser(nullptr, 0u);
+		}
+		_bufLength += received;
+	}
+}
+
+}
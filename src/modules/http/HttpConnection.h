@@ -0,0 +1,82 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "ResponseParser.h"
+#include "Network.h"
+#include "core/Common.h"
+#include "core/String.h"
+#include <stdint.h>
+
+namespace http {
+
+/**
+ * @brief Persistent (keep-alive) http connection that allows to pipeline get requests.
+ *
+ * Several requests can be sent before the first response is received - the responses are
+ * returned by receive() in the order the requests were sent. The connection is established
+ * lazily and re-established by the next request if the server closed it.
+ *
+ * @note Not thread safe - the connection is meant to be used by one thread.
+ */
+class HttpConnection {
+private:
+	core::String _baseUrl;
+	core::String _hostname;
+	uint16_t _port = 80;
+	SOCKET _socketFD;
+	// the amount of requests that were sent but not yet answered
+	int _pending = 0;
+	uint32_t _timeoutMillis = 10000u;
+
+	uint8_t *_buf = nullptr;
+	size_t _bufLength = 0u;
+	size_t _bufCapacity = 0u;
+
+	bool connect();
+	bool send(const char *data, size_t length);
+public:
+	HttpConnection(const core::String &baseUrl = "");
+	~HttpConnection();
+
+	/**
+	 * @brief Change the base url that is put in front of every request. Closes the connection.
+	 * @return @c false if the given base url is not a valid url
+	 */
+	bool setBaseUrl(const core::String &baseUrl);
+	/**
+	 * @brief Sending and receiving fails if the socket is blocked for longer than the given millis
+	 */
+	void setTimeout(uint32_t millis);
+
+	/**
+	 * @brief Sends a get request for the url that is built from the base url and the given format string
+	 * without waiting for the response.
+	 * @return @c false if the request couldn't get sent. All pending requests are lost in this case.
+	 */
+	bool sendGet(CORE_FORMAT_STRING const char *msg, ...) CORE_PRINTF_VARARG_FUNC(2);
+	/**
+	 * @brief Blocks until the response for the oldest pending request was received
+	 * @return An invalid response if the connection failed - all pending requests are lost in this case.
+	 */
+	ResponseParser receive();
+
+	/**
+	 * @return The amount of requests that are waiting for their response
+	 */
+	int pending() const;
+	bool isConnected() const;
+	void disconnect();
+};
+
+inline int HttpConnection::pending() const {
+	return _pending;
+}
+
+inline void HttpConnection::setTimeout(uint32_t millis) {
+	_timeoutMillis = millis;
+}
+
+}
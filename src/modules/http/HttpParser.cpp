@@ -4,6 +4,8 @@
 
 #include "HttpParser.h"
 #include "core/StringUtil.h"
+#include "core/ArrayLength.h"
+#include <SDL_stdinc.h>
 
 namespace http {
 
@@ -125,6 +127,47 @@ bool HttpParser::parseHeaders(char **bufPos) {
 	return true;
 }
 
+int64_t HttpParser::messageSize(const uint8_t* buf, size_t length) {
+	size_t headerEnd = 0u;
+	for (size_t i = 3u; i < length; ++i) {
+		if (buf[i - 3] == '\r' && buf[i - 2] == '\n' && buf[i - 1] == '\r' && buf[i] == '\n') {
+			headerEnd = i + 1;
+			break;
+		}
+	}
+	if (headerEnd == 0u) {
+		return 0;
+	}
+	static const char key[] = "content-length:";
+	const size_t keyLength = lengthof(key) - 1;
+	int64_t contentLength = 0;
+	size_t lineStart = 0u;
+	for (size_t i = 0u; i + 1 < headerEnd; ++i) {
+		if (buf[i] != '\r' || buf[i + 1] != '\n') {
+			continue;
+		}
+		if (i - lineStart > keyLength && !SDL_strncasecmp((const char*)buf + lineStart, key, keyLength)) {
+			contentLength = 0;
+			for (size_t j = lineStart + keyLength; j < i; ++j) {
+				const char c = (char)buf[j];
+				if (c == ' ' || c == '\t') {
+					continue;
+				}
+				if (c < '0' || c > '9' || contentLength > INT32_MAX) {
+					return -1;
+				}
+				contentLength = contentLength * 10 + (c - '0');
+			}
+		}
+		lineStart = i + 2;
+	}
+	const int64_t size = (int64_t)headerEnd + contentLength;
+	if (size > (int64_t)length) {
+		return 0;
+	}
+	return size;
+}
+
 const char *HttpParser::headerValue(const char *name) const {
 	const char *val = nullptr;
 	headers.get(name, val);
@@ -75,6 +75,13 @@ public:
 
 	bool valid() const;
 
+	/**
+	 * @brief Used to split a stream of pipelined messages into single messages
+	 * @return The size of the first complete message (header and content) in the buffer, @c 0 if
+	 * the message isn't complete yet or @c -1 if the message is malformed
+	 */
+	static int64_t messageSize(const uint8_t* buf, size_t length);
+
 	HttpParser(HttpParser&& other);
 	HttpParser(const HttpParser& other);
 	~HttpParser();
@@ -9,6 +9,7 @@
 #include "HttpHeader.h"
 #include "HttpMimeType.h"
 #include <SDL_stdinc.h>
+#include <memory>
 
 namespace http {
 
@@ -21,11 +22,23 @@ struct HttpResponse {
 	// if the route handler sets this to false, the memory is not freed. Can be useful for static content
 	// like error pages.
 	bool freeBody = true;
+	// keeps the body memory alive until the response was sent - see setBody()
+	std::shared_ptr<const void> bodyOwner;
 
 	void contentLength(size_t len) {
 		bodySize = len;
 	}
 
+	/**
+	 * @brief Sends the given memory without copying it. The owner is released after the response was sent.
+	 */
+	void setBody(const std::shared_ptr<const void>& owner, const void *data, size_t size) {
+		bodyOwner = owner;
+		body = (const char*)data;
+		contentLength(size);
+		freeBody = false;
+	}
+
 	void setText(const char *body) {
 		this->body = body;
 		contentLength(SDL_strlen(body));
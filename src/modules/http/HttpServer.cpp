@@ -6,7 +6,10 @@
 #include "RequestParser.h"
 #include "core/Assert.h"
 #include "core/ArrayLength.h"
+#include "core/Common.h"
 #include "core/Log.h"
+#include "core/Trace.h"
+#include "Network.h"
 #include "Network.cpp.h"
 #include "core/App.h"
 #include <string.h>
@@ -14,14 +17,42 @@
 
 namespace http {
 
+namespace {
+
+// the min amount of free bytes in the read buffer of a client
+constexpr size_t ReadBufferSize = 4096u;
+
+bool isKeepAlive(const RequestParser& request) {
+	const char *connection = request.headerValue(header::CONNECTION);
+	if (request.protocolVersion != nullptr && !SDL_strcmp(request.protocolVersion, "HTTP/1.0")) {
+		return connection != nullptr && !SDL_strcasecmp(connection, "keep-alive");
+	}
+	return connection == nullptr || SDL_strcasecmp(connection, "close") != 0;
+}
+
+}
+
+struct HttpServer::WriteRequest {
+	uv_write_t req;
+	Client* client = nullptr;
+	char header[4096];
+	const char *body = nullptr;
+	bool freeBody = false;
+	std::shared_ptr<const void> bodyOwner;
+
+	~WriteRequest() {
+		if (freeBody) {
+			SDL_free((char*)body);
+		}
+	}
+};
+
 HttpServer::HttpServer(const metric::MetricPtr& metric) :
-		_socketFD(INVALID_SOCKET), _metric(metric) {
-	FD_ZERO(&_readFDSet);
-	FD_ZERO(&_writeFDSet);
+		_metric(metric) {
 }
 
 HttpServer::~HttpServer() {
-	core_assert(_socketFD == INVALID_SOCKET);
+	core_assert(_server == nullptr);
 }
 
 void HttpServer::setErrorText(HttpStatus status, const char *body) {
@@ -53,212 +84,244 @@ bool HttpServer::unregisterRoute(HttpMethod method, const char *path) {
 }
 
 bool HttpServer::init(int16_t port) {
-	_socketFD = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
-	if (_socketFD == INVALID_SOCKET) {
-		network_cleanup();
-		return false;
-	}
-	struct sockaddr_in sin;
-	SDL_memset(&sin, 0, sizeof(sin));
-	sin.sin_family = AF_INET;
-	sin.sin_addr.s_addr = INADDR_ANY;
-	sin.sin_port = htons(port);
-
-	FD_ZERO(&_readFDSet);
-	FD_ZERO(&_writeFDSet);
-
-	int t = 1;
-#ifdef _WIN32
-	if (setsockopt(_socketFD, SOL_SOCKET, SO_REUSEADDR, (char*) &t, sizeof(t)) != 0) {
-#else
-	if (setsockopt(_socketFD, SOL_SOCKET, SO_REUSEADDR, &t, sizeof(t)) != 0) {
-#endif
-		network_cleanup();
-		closesocket(_socketFD);
-		_socketFD = INVALID_SOCKET;
+	uv_loop_t* loop = new uv_loop_t;
+	if (uv_loop_init(loop) != 0) {
+		delete loop;
 		return false;
 	}
+	_ownLoop = true;
+	return init(loop, port);
+}
 
-	if (bind(_socketFD, (struct sockaddr *) &sin, sizeof(sin)) < 0) {
-		network_cleanup();
-		closesocket(_socketFD);
-		_socketFD = INVALID_SOCKET;
-		return false;
+bool HttpServer::init(uv_loop_t* loop, int16_t port) {
+	core_assert(_server == nullptr);
+	_loop = loop;
+	networkInit();
+	_server = new uv_tcp_t;
+	uv_tcp_init(_loop, _server);
+	_server->data = this;
+
+	struct sockaddr_in addr;
+	uv_ip4_addr("0.0.0.0", port, &addr);
+	int error = uv_tcp_bind(_server, (const struct sockaddr*)&addr, 0);
+	if (error == 0) {
+		error = uv_listen((uv_stream_t*)_server, SOMAXCONN, onConnection);
 	}
-
-	if (listen(_socketFD, 5) < 0) {
-		network_cleanup();
-		closesocket(_socketFD);
-		_socketFD = INVALID_SOCKET;
+	if (error != 0) {
+		Log::error("Failed to listen on port %i: %s", (int)port, uv_strerror(error));
+		shutdown();
 		return false;
 	}
-
-	networkNonBlocking(_socketFD);
-
-	FD_SET(_socketFD, &_readFDSet);
-
 	return true;
 }
 
-HttpServer::ClientSocketsIter HttpServer::closeClient(ClientSocketsIter& iter) {
-	Client& client = *iter;
-	const SOCKET clientSocket = client.socket;
-	FD_CLR(clientSocket, &_readFDSet);
-	FD_CLR(clientSocket, &_writeFDSet);
-	closesocket(clientSocket);
-	client.socket = INVALID_SOCKET;
-	SDL_free(client.request);
-	SDL_free(client.response);
-	return _clientSockets.erase(iter);
+void HttpServer::onConnection(uv_stream_t* stream, int status) {
+	HttpServer* server = (HttpServer*)stream->data;
+	if (status < 0) {
+		Log::debug("Failed to accept a connection: %s", uv_strerror(status));
+		return;
+	}
+	Client* client = new Client();
+	client->server = server;
+	uv_tcp_init(server->_loop, &client->tcp);
+	client->tcp.data = client;
+	client->handles = 1;
+	if (uv_accept(stream, (uv_stream_t*)&client->tcp) != 0) {
+		client->closing = true;
+		uv_close((uv_handle_t*)&client->tcp, onClientClosed);
+		return;
+	}
+	uv_timer_init(server->_loop, &client->timer);
+	client->timer.data = client;
+	client->handles = 2;
+	uv_tcp_nodelay(&client->tcp, 1);
+	server->_clients.insert(client);
+	uv_timer_start(&client->timer, onTimeout, server->_keepAliveTimeoutMillis, 0);
+	uv_read_start((uv_stream_t*)&client->tcp, onAlloc, onRead);
 }
 
-bool HttpServer::update() {
-	core_trace_scoped(HttpServerUpdate);
-	fd_set readFDsOut;
-	fd_set writeFDsOut;
+void HttpServer::onAlloc(uv_handle_t* handle, size_t suggestedSize, uv_buf_t* buf) {
+	// read directly into the request buffer of the client
+	Client* client = (Client*)handle->data;
+	if (client->requestCapacity - client->requestLength < ReadBufferSize) {
+		client->requestCapacity = client->requestLength + core_max(suggestedSize, ReadBufferSize);
+		client->request = (uint8_t*)SDL_realloc(client->request, client->requestCapacity);
+	}
+	*buf = uv_buf_init((char*)client->request + client->requestLength, (unsigned int)(client->requestCapacity - client->requestLength));
+}
 
-	SDL_memcpy(&readFDsOut, &_readFDSet, sizeof(readFDsOut));
-	SDL_memcpy(&writeFDsOut, &_writeFDSet, sizeof(writeFDsOut));
+void HttpServer::onRead(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+	Client* client = (Client*)stream->data;
+	if (nread < 0) {
+		client->server->closeClient(client);
+		return;
+	}
+	if (nread == 0) {
+		return;
+	}
+	client->requestLength += nread;
+	uv_timer_start(&client->timer, onTimeout, client->server->_keepAliveTimeoutMillis, 0);
+	client->server->handleRequests(client);
+}
 
-	struct timeval tv;
-	tv.tv_sec = 0;
-	tv.tv_usec = 0;
-	const int ready = select(FD_SETSIZE, &readFDsOut, &writeFDsOut, nullptr, &tv);
-	if (ready < 0) {
-		return false;
+void HttpServer::onWrite(uv_write_t* req, int status) {
+	WriteRequest* request = (WriteRequest*)req->data;
+	Client* client = request->client;
+	delete request;
+	--client->pendingWrites;
+	if (status < 0) {
+		Log::debug("Failed to send to the client: %s", uv_strerror(status));
+		client->server->closeClient(client);
+		return;
 	}
-	if (_socketFD != INVALID_SOCKET && FD_ISSET(_socketFD, &readFDsOut)) {
-		const SOCKET clientSocket = accept(_socketFD, nullptr, nullptr);
-		if (clientSocket != INVALID_SOCKET) {
-			FD_SET(clientSocket, &_readFDSet);
-			Client c;
-			c.socket = clientSocket;
-			_clientSockets.insert(c);
-			networkNonBlocking(clientSocket);
-		}
+	if (client->closeAfterWrite && client->pendingWrites == 0) {
+		client->server->closeClient(client);
 	}
+}
 
-	for (ClientSocketsIter i = _clientSockets.begin(); i != _clientSockets.end();) {
-		Client& client = *i;
-		const SOCKET clientSocket = client.socket;
-		if (clientSocket == INVALID_SOCKET) {
-			i = closeClient(i);
-			continue;
-		}
+void HttpServer::onTimeout(uv_timer_t* handle) {
+	Client* client = (Client*)handle->data;
+	if (client->pendingWrites > 0) {
+		// still sending - the connection isn't idle
+		uv_timer_start(handle, onTimeout, client->server->_keepAliveTimeoutMillis, 0);
+		return;
+	}
+	client->server->closeClient(client);
+}
 
-		if (FD_ISSET(clientSocket, &writeFDsOut)) {
-			if (!sendMessage(client) || client.finished()) {
-				i = closeClient(i);
-			} else {
-				++i;
-			}
-			continue;
-		}
+void HttpServer::onClientClosed(uv_handle_t* handle) {
+	Client* client = (Client*)handle->data;
+	if (--client->handles > 0) {
+		return;
+	}
+	SDL_free(client->request);
+	delete client;
+}
 
-		if (!FD_ISSET(clientSocket, &readFDsOut)) {
-			++i;
-			continue;
-		}
+void HttpServer::closeClient(Client* client) {
+	if (client->closing) {
+		return;
+	}
+	client->closing = true;
+	_clients.erase(client);
+	uv_close((uv_handle_t*)&client->timer, onClientClosed);
+	// pending writes are canceled
+	uv_close((uv_handle_t*)&client->tcp, onClientClosed);
+}
 
-		constexpr const int BUFFERSIZE = 2048;
-		uint8_t recvBuf[BUFFERSIZE];
-		const network_return len = recv(clientSocket, (char*)recvBuf, BUFFERSIZE - 1, 0);
-		if (len < 0) {
-			i = closeClient(i);
-			continue;
-		}
-		if (len == 0) {
-			++i;
-			continue;
+void HttpServer::handleRequests(Client* client) {
+	core_trace_scoped(HttpServerHandleRequests);
+	size_t offset = 0u;
+	while (!client->closing && !client->closeAfterWrite) {
+		const uint8_t* buf = client->request + offset;
+		const size_t remaining = client->requestLength - offset;
+		if (remaining == 0u) {
+			break;
 		}
-
-		client.request = (uint8_t*)SDL_realloc(client.request, client.requestLength + len);
-		SDL_memcpy(client.request + client.requestLength, recvBuf, len);
-		client.requestLength += len;
-
-		if (client.requestLength == 0) {
-			++i;
-			continue;
+		if (remaining >= 4 && SDL_memcmp(buf, "GET ", 4) != 0 && SDL_memcmp(buf, "POST", 4) != 0) {
+			writeError(client, HttpStatus::NotImplemented, false);
+			break;
 		}
-
-		// GET / HTTP/1.1\r\n\r\n
-		if (client.requestLength < 18) {
-			++i;
-			continue;
+		const int64_t size = HttpParser::messageSize(buf, remaining);
+		if (size < 0) {
+			writeError(client, HttpStatus::BadRequest, false);
+			break;
 		}
-
-		if (SDL_memcmp(client.request, "GET", 3) != 0 && SDL_memcmp(client.request, "POST", 4) != 0) {
-			FD_CLR(clientSocket, &_readFDSet);
-			FD_CLR(clientSocket, &readFDsOut);
-			assembleError(client, HttpStatus::NotImplemented);
-			++i;
-			continue;
+		if ((size == 0 && remaining > _maxRequestBytes) || (size_t)size > _maxRequestBytes) {
+			writeError(client, HttpStatus::InternalServerError, false);
+			break;
 		}
-
-		if (client.requestLength > _maxRequestBytes) {
-			FD_CLR(clientSocket, &_readFDSet);
-			FD_CLR(clientSocket, &readFDsOut);
-			assembleError(client, HttpStatus::InternalServerError);
-			++i;
-			continue;
+		if (size == 0) {
+			// wait for the rest of the request
+			break;
 		}
 
-		uint8_t *mem = (uint8_t *)SDL_malloc(client.requestLength);
-		SDL_memcpy(mem, client.request, client.requestLength);
-		const RequestParser request(mem, client.requestLength);
+		// the parser modifies and owns the memory
+		uint8_t *mem = (uint8_t *)SDL_malloc(size + 1);
+		SDL_memcpy(mem, buf, size);
+		mem[size] = '\0';
+		offset += size;
+		const RequestParser request(mem, size);
 		if (!request.valid()) {
-			++i;
-			continue;
+			writeError(client, HttpStatus::BadRequest, false);
+			break;
 		}
-
-		FD_CLR(clientSocket, &_readFDSet);
-		FD_CLR(clientSocket, &readFDsOut);
-
+		const bool keepAlive = isKeepAlive(request);
 		HttpResponse response;
 		if (!route(request, response)) {
-			assembleError(client, HttpStatus::NotFound);
-			++i;
+			writeError(client, HttpStatus::NotFound, keepAlive);
 			continue;
 		}
-		assembleResponse(client, response);
-		if (response.freeBody) {
-			SDL_free((char*)response.body);
-		}
+		writeResponse(client, response, keepAlive);
+	}
+	if (offset > 0u) {
+		// keep the beginning of the next pipelined request
+		client->requestLength -= offset;
+		SDL_memmove(client->request, client->request + offset, client->requestLength);
 	}
-	return true;
 }
 
-void HttpServer::assembleError(Client& client, HttpStatus status) {
-	char buf[512];
-	SDL_snprintf(buf, sizeof(buf),
+void HttpServer::write(Client* client, WriteRequest* request, size_t headerSize, size_t bodySize, bool keepAlive) {
+	request->client = client;
+	request->req.data = request;
+	// the header and the body are written with one writev call - the body is not copied
+	uv_buf_t bufs[2];
+	int bufCount = 0;
+	bufs[bufCount++] = uv_buf_init(request->header, (unsigned int)headerSize);
+	if (bodySize > 0u) {
+		bufs[bufCount++] = uv_buf_init((char*)request->body, (unsigned int)bodySize);
+	}
+	if (!keepAlive) {
+		client->closeAfterWrite = true;
+		uv_read_stop((uv_stream_t*)&client->tcp);
+	}
+	++client->pendingWrites;
+	if (uv_write(&request->req, (uv_stream_t*)&client->tcp, bufs, bufCount, onWrite) != 0) {
+		--client->pendingWrites;
+		delete request;
+		closeClient(client);
+	}
+}
+
+void HttpServer::writeError(Client* client, HttpStatus status, bool keepAlive) {
+	const char *errorPage = "";
+	_errorPages.get((int)status, errorPage);
+	const size_t bodySize = SDL_strlen(errorPage);
+
+	WriteRequest* request = new WriteRequest();
+	const int headerSize = SDL_snprintf(request->header, sizeof(request->header),
 			"HTTP/1.1 %i %s\r\n"
-			"Connection: close\r\n"
+			"Content-length: %u\r\n"
+			"Connection: %s\r\n"
 			"Server: %s\r\n"
 			"\r\n",
 			(int)status,
 			toStatusString(status),
+			(unsigned int)bodySize,
+			keepAlive ? "keep-alive" : "close",
 			core::App::getInstance()->appname().c_str());
-
-	const char *errorPage = "";
-	_errorPages.get((int)status, errorPage);
-
-	const size_t responseSize = SDL_strlen(errorPage) + SDL_strlen(buf);
-	char *responseBuf = (char*)SDL_malloc(responseSize + 1);
-	SDL_snprintf(responseBuf, responseSize + 1, "%s%s", buf, errorPage);
-	client.setResponse(responseBuf, responseSize);
+	// the error pages are released in shutdown()
+	request->body = errorPage;
 	metric(status);
-	FD_SET(client.socket, &_writeFDSet);
+	write(client, request, core_min((size_t)headerSize, sizeof(request->header) - 1), bodySize, keepAlive);
 }
 
-void HttpServer::assembleResponse(Client& client, const HttpResponse& response) {
+void HttpServer::writeResponse(Client* client, HttpResponse& response, bool keepAlive) {
+	response.headers.put(header::CONNECTION, keepAlive ? "keep-alive" : "close");
+	WriteRequest* request = new WriteRequest();
+	// the body is released after it was sent
+	request->body = response.body;
+	request->freeBody = response.freeBody;
+	request->bodyOwner = std::move(response.bodyOwner);
+
 	char headers[2048];
 	if (!buildHeaderBuffer(headers, lengthof(headers), response.headers)) {
-		assembleError(client, HttpStatus::InternalServerError);
+		delete request;
+		writeError(client, HttpStatus::InternalServerError, keepAlive);
 		return;
 	}
 
-	char buf[4096];
-	const int headerSize = SDL_snprintf(buf, sizeof(buf),
+	const int headerSize = SDL_snprintf(request->header, sizeof(request->header),
 			"HTTP/1.1 %i %s\r\n"
 			"Content-length: %u\r\n"
 			"%s"
@@ -267,19 +330,14 @@ void HttpServer::assembleResponse(Client& client, const HttpResponse& response)
 			toStatusString(response.status),
 			(unsigned int)response.bodySize,
 			headers);
-	if (headerSize >= lengthof(buf)) {
-		assembleError(client, HttpStatus::InternalServerError);
+	if (headerSize >= (int)lengthof(request->header)) {
+		delete request;
+		writeError(client, HttpStatus::InternalServerError, keepAlive);
 		return;
 	}
-
-	const size_t responseSize = response.bodySize + SDL_strlen(buf);
-	char *responseBuf = (char*)SDL_malloc(responseSize);
-	SDL_memcpy(responseBuf, buf, headerSize);
-	SDL_memcpy(responseBuf + headerSize, response.body, response.bodySize);
-	client.setResponse(responseBuf, responseSize);
-	Log::trace("Response buffer of size %i", (int)responseSize);
+	Log::trace("Response of size %i", (int)(headerSize + response.bodySize));
 	metric(response.status);
-	FD_SET(client.socket, &_writeFDSet);
+	write(client, request, headerSize, response.bodySize, keepAlive);
 }
 
 void HttpServer::metric(HttpStatus status) const {
@@ -288,26 +346,6 @@ void HttpServer::metric(HttpStatus status) const {
 	_metric->count("http.request", 1, {{"status", buf}});
 }
 
-bool HttpServer::sendMessage(Client& client) {
-	core_assert(client.response != nullptr);
-	int remaining = (int)client.responseLength - (int)client.alreadySent;
-	if (remaining <= 0) {
-		return false;
-	}
-	const char* p = client.response + client.alreadySent;
-	const network_return sent = ::send(client.socket, p, remaining, 0);
-	if (sent < 0) {
-		Log::debug("Failed to send to the client");
-		return false;
-	}
-	if (sent == 0) {
-		return true;
-	}
-	remaining -= sent;
-	client.alreadySent += sent;
-	return remaining > 0;
-}
-
 bool HttpServer::route(const RequestParser& request, HttpResponse& response) {
 	Routes* routes = getRoutes(request.method);
 	Log::trace("lookup for %s", request.path);
@@ -340,7 +378,6 @@ bool HttpServer::route(const RequestParser& request, HttpResponse& response) {
 		return false;
 	}
 	response.headers.put(header::CONTENT_TYPE, http::mimetype::TEXT_PLAIN);
-	response.headers.put(header::CONNECTION, "close");
 	response.headers.put(header::SERVER, core::App::getInstance()->appname().c_str());
 	// TODO urldecode of request data
 	//core::string::urlDecode(request.query);
@@ -348,43 +385,43 @@ bool HttpServer::route(const RequestParser& request, HttpResponse& response) {
 	return true;
 }
 
+bool HttpServer::update() {
+	core_trace_scoped(HttpServerUpdate);
+	if (_ownLoop && _loop != nullptr) {
+		uv_run(_loop, UV_RUN_NOWAIT);
+	}
+	return true;
+}
+
 void HttpServer::shutdown() {
 	const size_t l = lengthof(_routes);
 	for (size_t i = 0; i < l; ++i) {
 		_routes[i].clear();
 	}
-	for (ClientSocketsIter i = _clientSockets.begin(); i != _clientSockets.end();) {
-		i = closeClient(i);
+	const std::vector<Client*> clients(_clients.begin(), _clients.end());
+	for (Client* client : clients) {
+		closeClient(client);
+	}
+	if (_server != nullptr) {
+		uv_close((uv_handle_t*)_server, [] (uv_handle_t* handle) {
+			delete (uv_tcp_t*)handle;
+		});
+		_server = nullptr;
+	}
+	if (_ownLoop && _loop != nullptr) {
+		// run the close callbacks
+		uv_run(_loop, UV_RUN_DEFAULT);
+		uv_loop_close(_loop);
+		delete _loop;
 	}
+	_loop = nullptr;
+	_ownLoop = false;
 
 	for (auto i : _errorPages) {
 		SDL_free((char*)i->second);
 	}
 	_errorPages.clear();
-
-	FD_ZERO(&_readFDSet);
-	FD_ZERO(&_writeFDSet);
-	closesocket(_socketFD);
-	_socketFD = INVALID_SOCKET;
 	network_cleanup();
 }
 
-HttpServer::Client::Client() :
-		socket(INVALID_SOCKET) {
-}
-
-void HttpServer::Client::setResponse(char* responseBuf, size_t responseBufLength) {
-	core_assert(response == nullptr);
-	response = responseBuf;
-	responseLength = responseBufLength;
-	alreadySent = 0u;
-}
-
-bool HttpServer::Client::finished() const {
-	if (response == nullptr) {
-		return false;
-	}
-	return responseLength == alreadySent;
-}
-
 }
@@ -8,60 +8,83 @@
 #include "HttpResponse.h"
 #include "HttpStatus.h"
 #include "RequestParser.h"
-#include "Network.h"
 #include "HttpHeader.h"
 #include "HttpQuery.h"
 #include "core/collection/Map.h"
-#include "core/collection/List.h"
 #include "core/metric/Metric.h"
 #include <stdint.h>
 #include <functional>
 #include <memory>
+#include <unordered_set>
+#include <uv.h>
 
 namespace http {
 
 class RequestParser;
 
+/**
+ * @brief Event driven http server on top of a libuv loop.
+ *
+ * The connections are kept alive (HTTP/1.1) and pipelined requests are answered in order. The
+ * response header and body are handed to the socket in one scatter/gather write - the body is
+ * not copied (see @c HttpResponse::setBody()).
+ */
 class HttpServer {
 public:
 	using RouteCallback = std::function<void(const RequestParser& query, HttpResponse* response)>;
 private:
-	SOCKET _socketFD;
-	fd_set _readFDSet;
-	fd_set _writeFDSet;
+	uv_loop_t* _loop = nullptr;
+	// the server created the loop and runs it in update()
+	bool _ownLoop = false;
+	uv_tcp_t* _server = nullptr;
 	using Routes = core::Map<const char*, RouteCallback, 8, core::hashCharPtr, core::hashCharCompare>;
 	core::Map<int, const char*, 8, std::hash<int>> _errorPages;
 	Routes _routes[2];
 	size_t _maxRequestBytes = 1 * 1024 * 1024;
+	uint64_t _keepAliveTimeoutMillis = 60000u;
 	metric::MetricPtr _metric;
 
 	struct Client {
-		Client();
-		SOCKET socket;
+		HttpServer* server = nullptr;
+		uv_tcp_t tcp;
+		// closes idle keep-alive connections
+		uv_timer_t timer;
+		// the tcp handle and the timer - the client is deleted once both are closed
+		int handles = 0;
 
 		uint8_t *request = nullptr;
 		size_t requestLength = 0u;
+		size_t requestCapacity = 0u;
 
-		char* response = nullptr;
-		size_t responseLength = 0u;
-		size_t alreadySent = 0u;
-
-		void setResponse(char* responseBuf, size_t responseBufLength);
-		bool finished() const;
+		// the amount of responses that are not yet written to the socket
+		int pendingWrites = 0;
+		// close the connection once the pending responses are written
+		bool closeAfterWrite = false;
+		bool closing = false;
 	};
+	struct WriteRequest;
+
+	std::unordered_set<Client*> _clients;
 
-	using ClientSockets = core::List<Client>;
-	using ClientSocketsIter = ClientSockets::iterator;
-	ClientSockets _clientSockets { 1024 };
+	static void onConnection(uv_stream_t* server, int status);
+	static void onAlloc(uv_handle_t* handle, size_t suggestedSize, uv_buf_t* buf);
+	static void onRead(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf);
+	static void onWrite(uv_write_t* req, int status);
+	static void onTimeout(uv_timer_t* handle);
+	static void onClientClosed(uv_handle_t* handle);
 
-	ClientSocketsIter closeClient (ClientSocketsIter& i);
+	void closeClient(Client* client);
+	/**
+	 * @brief Handles all complete requests in the read buffer of the client
+	 */
+	void handleRequests(Client* client);
 
 	void metric(HttpStatus status) const;
 
 	bool route(const RequestParser& request, HttpResponse& response);
-	void assembleResponse(Client& client, const HttpResponse& response);
-	void assembleError(Client& client, HttpStatus status);
-	bool sendMessage(Client& client);
+	void write(Client* client, WriteRequest* request, size_t headerSize, size_t bodySize, bool keepAlive);
+	void writeResponse(Client* client, HttpResponse& response, bool keepAlive);
+	void writeError(Client* client, HttpStatus status, bool keepAlive);
 
 	Routes* getRoutes(HttpMethod method);
 
@@ -70,13 +93,28 @@ public:
 	~HttpServer();
 
 	void setMaxRequestSize(size_t maxBytes);
+	/**
+	 * @brief Idle keep-alive connections are closed after this amount of millis
+	 */
+	void setKeepAliveTimeout(uint64_t millis);
 
 	/**
 	 * @param[in] body The status code body. The pointer is copied and then released by the server.
 	 */
 	void setErrorText(HttpStatus status, const char *body);
 
+	/**
+	 * @brief Listens on the given port with an own event loop - see update()
+	 */
 	bool init(int16_t port = 8080);
+	/**
+	 * @brief Listens on the given port in the given event loop - the loop is run by the caller
+	 * and update() doesn't do anything.
+	 */
+	bool init(uv_loop_t* loop, int16_t port = 8080);
+	/**
+	 * @brief Runs the own event loop once without blocking
+	 */
 	bool update();
 	void shutdown();
 
@@ -88,6 +126,9 @@ inline void HttpServer::setMaxRequestSize(size_t maxBytes) {
 	_maxRequestBytes = maxBytes;
 }
 
+inline void HttpServer::setKeepAliveTimeout(uint64_t millis) {
+	_keepAliveTimeoutMillis = millis;
+}
 
 typedef std::shared_ptr<HttpServer> HttpServerPtr;
 
@@ -0,0 +1,63 @@
+/**
+ * @file
+ */
+
+#include "core/tests/AbstractTest.h"
+#include "http/HttpConnection.h"
+#include "http/HttpServer.h"
+#include "core/StringUtil.h"
+#include <atomic>
+#include <thread>
+
+namespace http {
+
+class HttpConnectionTest : public core::AbstractTest {
+};
+
+TEST_F(HttpConnectionTest, testPipelining) {
+	HttpServer server(_testApp->metric());
+	ASSERT_TRUE(server.init(10111));
+	server.registerRoute(HttpMethod::GET, "/echo", [] (const http::RequestParser& request, HttpResponse* response) {
+		const char *value = "";
+		request.query.get("value", value);
+		response->setText(value);
+	});
+	std::atomic_bool running(true);
+	std::thread serverThread([&] () {
+		while (running) {
+			server.update();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	});
+
+	HttpConnection connection("http://127.0.0.1:10111/echo");
+	connection.setTimeout(5000u);
+	EXPECT_TRUE(connection.sendGet("?value=%i", 1));
+	EXPECT_TRUE(connection.sendGet("?value=%i", 2));
+	EXPECT_TRUE(connection.sendGet("?value=%i", 3));
+	EXPECT_EQ(3, connection.pending());
+	for (int i = 1; i <= 3; ++i) {
+		const ResponseParser& response = connection.receive();
+		ASSERT_TRUE(response.valid()) << "Response " << i;
+		EXPECT_EQ(HttpStatus::Ok, response.status);
+		EXPECT_EQ(core::string::format("%i", i), core::String(response.content, response.contentLength));
+	}
+	EXPECT_EQ(0, connection.pending());
+	EXPECT_TRUE(connection.isConnected());
+
+	// the connection is reused for the next request
+	EXPECT_TRUE(connection.sendGet("?value=%s", "next"));
+	const ResponseParser& response = connection.receive();
+	ASSERT_TRUE(response.valid());
+	EXPECT_EQ("next", core::String(response.content, response.contentLength));
+
+	// nothing is pending
+	EXPECT_FALSE(connection.receive().valid());
+
+	connection.disconnect();
+	running = false;
+	serverThread.join();
+	server.shutdown();
+}
+
+}
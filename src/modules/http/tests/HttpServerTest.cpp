@@ -4,10 +4,57 @@
 
 #include "core/tests/AbstractTest.h"
 #include "http/HttpServer.h"
+#include "http/Network.h"
+#include "http/Network.cpp.h"
+#include <chrono>
+#include <string>
 
 namespace http {
 
 class HttpServerTest : public core::AbstractTest {
+protected:
+	SOCKET connectTo(int16_t port) {
+		SOCKET s = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if (s == INVALID_SOCKET) {
+			return s;
+		}
+		struct sockaddr_in sin;
+		SDL_memset(&sin, 0, sizeof(sin));
+		sin.sin_family = AF_INET;
+		sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		sin.sin_port = htons(port);
+		if (connect(s, (struct sockaddr *) &sin, sizeof(sin)) != 0) {
+			closesocket(s);
+			return INVALID_SOCKET;
+		}
+		networkNonBlocking(s);
+		return s;
+	}
+
+	void sendRequest(SOCKET s, const char *request) {
+		const size_t length = SDL_strlen(request);
+		ASSERT_EQ((network_return)length, ::send(s, request, length, 0));
+	}
+
+	/**
+	 * @brief Runs the server and reads the responses until the given string was received
+	 * @return @c false if the connection was closed before
+	 */
+	bool receive(HttpServer& server, SOCKET s, std::string& received, const char *until, int timeoutMillis = 5000) {
+		const auto timeout = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMillis);
+		while (received.find(until) == std::string::npos && std::chrono::steady_clock::now() < timeout) {
+			server.update();
+			char buf[1024];
+			const network_return len = recv(s, buf, sizeof(buf), 0);
+			if (len == 0) {
+				return false;
+			}
+			if (len > 0) {
+				received.append(buf, len);
+			}
+		}
+		return received.find(until) != std::string::npos;
+	}
 };
 
 TEST_F(HttpServerTest, testSimple) {
@@ -19,4 +66,66 @@ TEST_F(HttpServerTest, testSimple) {
 	server.shutdown();
 }
 
+TEST_F(HttpServerTest, testKeepAlivePipelining) {
+	HttpServer server(_testApp->metric());
+	ASSERT_TRUE(server.init(10102));
+	server.setErrorText(HttpStatus::NotFound, "missing");
+	const std::shared_ptr<core::String> blob = std::make_shared<core::String>("0123456789");
+	server.registerRoute(HttpMethod::GET, "/text", [] (const http::RequestParser& request, HttpResponse* response) {
+		response->setText("text");
+	});
+	server.registerRoute(HttpMethod::GET, "/blob", [&] (const http::RequestParser& request, HttpResponse* response) {
+		response->setBody(blob, blob->c_str(), blob->size());
+	});
+	const SOCKET s = connectTo(10102);
+	ASSERT_NE(INVALID_SOCKET, s);
+
+	// three requests in one packet - the responses must be in the same order
+	sendRequest(s, "GET /text HTTP/1.1\r\nHost: localhost\r\n\r\n"
+			"GET /blob HTTP/1.1\r\nHost: localhost\r\n\r\n"
+			"GET /unknown HTTP/1.1\r\nHost: localhost\r\n\r\n");
+	std::string received;
+	ASSERT_TRUE(receive(server, s, received, "missing")) << received;
+	const size_t text = received.find("\r\n\r\ntext");
+	const size_t body = received.find("\r\n\r\n0123456789");
+	const size_t notFound = received.find("HTTP/1.1 404");
+	ASSERT_NE(std::string::npos, text) << received;
+	ASSERT_NE(std::string::npos, body) << received;
+	ASSERT_NE(std::string::npos, notFound) << received;
+	EXPECT_LT(text, body);
+	EXPECT_LT(body, notFound);
+	// the write callbacks are executed in the next loop iteration
+	for (int i = 0; i < 100 && blob.use_count() > 1; ++i) {
+		server.update();
+	}
+	EXPECT_EQ(1, blob.use_count()) << "The body must be released after it was sent";
+
+	// the connection is still open - and is closed after this request was answered
+	received.clear();
+	sendRequest(s, "GET /text HTTP/1.1\r\nConnection: close\r\n\r\n");
+	ASSERT_TRUE(receive(server, s, received, "\r\n\r\ntext")) << received;
+	EXPECT_NE(std::string::npos, received.find("Connection: close")) << received;
+	EXPECT_FALSE(receive(server, s, received, "never received")) << "The connection wasn't closed";
+
+	closesocket(s);
+	server.shutdown();
+}
+
+TEST_F(HttpServerTest, testPartialRequest) {
+	HttpServer server(_testApp->metric());
+	ASSERT_TRUE(server.init(10103));
+	server.registerRoute(HttpMethod::POST, "/post", [] (const http::RequestParser& request, HttpResponse* response) {
+		response->setText(core::String(request.content, request.contentLength));
+	});
+	const SOCKET s = connectTo(10103);
+	ASSERT_NE(INVALID_SOCKET, s);
+	sendRequest(s, "POST /post HTTP/1.1\r\nContent-length: 8\r\n\r\nfoo");
+	std::string received;
+	EXPECT_FALSE(receive(server, s, received, "HTTP/1.1", 100)) << "Answered an incomplete request: " << received;
+	sendRequest(s, "barba");
+	ASSERT_TRUE(receive(server, s, received, "\r\n\r\nfoobarba")) << received;
+	closesocket(s);
+	server.shutdown();
+}
+
 }
@@ -20,8 +20,8 @@ ClientMessageSender::ClientMessageSender(const ClientNetworkPtr& network) :
 		_network(network) {
 }
 
-bool ClientMessageSender::sendClientMessage(FlatBufferBuilder& fbb, ClientMsgType type, Offset<void> data, uint32_t flags) {
-	const bool retVal = _network->sendMessage(createClientPacket(fbb, type, data, flags));
+bool ClientMessageSender::sendClientMessage(FlatBufferBuilder& fbb, ClientMsgType type, Offset<void> data, uint32_t flags, int channel) {
+	const bool retVal = _network->sendMessage(createClientPacket(fbb, type, data, flags), channel);
 	fbb.Clear();
 	return retVal;
 }
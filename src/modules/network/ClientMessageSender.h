@@ -23,7 +23,7 @@ public:
 	/**
 	 * @return @c true if the message was queued for sending.
 	 */
-	bool sendClientMessage(FlatBufferBuilder& fbb, ClientMsgType type, Offset<void> data, uint32_t flags = ENET_PACKET_FLAG_RELIABLE);
+	bool sendClientMessage(FlatBufferBuilder& fbb, ClientMsgType type, Offset<void> data, uint32_t flags = ENET_PACKET_FLAG_RELIABLE, int channel = ChannelReliable);
 };
 
 typedef std::shared_ptr<ClientMessageSender> ClientMessageSenderPtr;
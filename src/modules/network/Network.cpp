@@ -42,7 +42,10 @@ bool Network::disconnectPeer(ENetPeer *peer, DisconnectReason reason) {
 		return false;
 	}
 	Log::info("trying to disconnect peer: %u", peer->connectID);
-	enet_peer_disconnect(peer, core::enumVal(reason));
+	{
+		core::ScopedLock lock(_lock);
+		enet_peer_disconnect(peer, core::enumVal(reason));
+	}
 	if (peer->state == ENET_PEER_STATE_DISCONNECTED) {
 		_eventBus->publish(DisconnectEvent(peer, reason));
 	}
@@ -53,9 +56,18 @@ void Network::updateHost(ENetHost* host) {
 	if (host == nullptr) {
 		return;
 	}
-	enet_host_flush(host);
+	{
+		core::ScopedLock lock(_lock);
+		enet_host_flush(host);
+	}
 	ENetEvent event;
-	while (enet_host_service(host, &event, 0) > 0) {
+	for (;;) {
+		{
+			core::ScopedLock lock(_lock);
+			if (enet_host_service(host, &event, 0) <= 0) {
+				break;
+			}
+		}
 		core_trace_scoped(NetworkEventHandling);
 		switch (event.type) {
 		case ENET_EVENT_TYPE_CONNECT: {
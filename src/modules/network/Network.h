@@ -13,11 +13,25 @@
 #include "core/EventBus.h"
 #include "core/IComponent.h"
 #include "core/String.h"
+#include "core/Trace.h"
+#include "core/concurrent/Lock.h"
 #include <stdint.h>
 #include <memory>
 
 namespace network {
 
+/**
+ * @brief The channels of a connection
+ */
+enum Channel {
+	// the reliable messages
+	ChannelReliable,
+	// the unreliable world snapshots - see @c WorldSnapshot
+	ChannelSnapshot,
+
+	MaxChannels
+};
+
 enum class DisconnectReason {
 	ProtocolError,
 	Disconnect,
@@ -33,6 +47,8 @@ private:
 protected:
 	ProtocolHandlerRegistryPtr _protocolHandlerRegistry;
 	core::EventBusPtr _eventBus;
+	// enet is not thread safe - but messages might be sent from the threads the maps are ticking in
+	core_trace_mutex(core::Lock, _lock, "Network");
 
 	/**
 	 * @brief Package deserialization
@@ -51,6 +67,9 @@ public:
 
 	const ProtocolHandlerRegistryPtr& registry();
 
+	/**
+	 * @note This is thread safe
+	 */
 	bool sendMessage(ENetPeer* peer, ENetPacket* packet, int channel = 0);
 };
 
@@ -60,6 +79,7 @@ inline bool Network::sendMessage(ENetPeer* peer, ENetPacket* packet, int channel
 		enet_packet_destroy(packet);
 		return false;
 	}
+	core::ScopedLock lock(_lock);
 	if (enet_peer_send(peer, channel, packet) == 0) {
 		return true;
 	}
@@ -14,9 +14,9 @@ ENetPacket* ServerMessageSender::createServerPacket(ServerMsgType type, const vo
 	ENetPacket* packet = enet_packet_create(data, dataLength, flags);
 	const char *msgType = EnumNameServerMsgType(type);
 	Log::trace(logid, "Create server package: %s - size %u", msgType, (unsigned int)dataLength);
-	const metric::TagMap& tags {{"direction", "out"}, {"type", msgType}};
-	_metric->count("network_packet_count", 1, tags);
-	_metric->count("network_packet_size", (int)dataLength, tags);
+	const Metrics& metrics = _metrics[(int)type];
+	_metric->count(metrics.packetCount, 1);
+	_metric->count(metrics.packetSize, (int)dataLength);
 	return packet;
 }
 
@@ -28,28 +28,41 @@ ENetPacket* ServerMessageSender::createServerPacket(FlatBufferBuilder& fbb, Serv
 
 ServerMessageSender::ServerMessageSender(const ServerNetworkPtr& network, const metric::MetricPtr& metric) :
 		_network(network), _metric(metric) {
+	const int types = (int)ServerMsgType::MAX + 1;
+	_metrics.resize(types);
+	for (int i = 0; i < types; ++i) {
+		const char *msgType = EnumNameServerMsgType((ServerMsgType)i);
+		const metric::TagMap out {{"direction", "out"}, {"type", msgType}};
+		const metric::TagMap broadcast {{"direction", "broadcast"}, {"type", msgType}};
+		Metrics& metrics = _metrics[i];
+		metrics.packetCount = _metric->registerMetric("network_packet_count", metric::MetricType::Count, out);
+		metrics.packetSize = _metric->registerMetric("network_packet_size", metric::MetricType::Count, out);
+		metrics.sent = _metric->registerMetric("network_sent", metric::MetricType::Count, out);
+		metrics.notSent = _metric->registerMetric("network_not_sent", metric::MetricType::Count, out);
+		metrics.broadcastSent = _metric->registerMetric("network_sent", metric::MetricType::Count, broadcast);
+	}
 }
 
-bool ServerMessageSender::sendServerMessage(ENetPeer* peer, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags) {
+bool ServerMessageSender::sendServerMessage(ENetPeer* peer, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags, int channel) {
 	core_assert(peer != nullptr);
-	return sendServerMessage(&peer, 1, fbb, type, data, flags);
+	return sendServerMessage(&peer, 1, fbb, type, data, flags, channel);
 }
 
-bool ServerMessageSender::sendServerMessage(ENetPeer** peers, int numPeers, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags) {
+bool ServerMessageSender::sendServerMessage(ENetPeer** peers, int numPeers, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags, int channel) {
 	const char *msgType = network::EnumNameServerMsgType(type);
 	Log::debug(logid, "Send %s to %i peers", msgType, numPeers);
 	core_assert(numPeers > 0);
 	int sent = 0;
 	auto packet = createServerPacket(fbb, type, data, flags);
-	const metric::TagMap& tags {{"direction", "out"}, {"type", msgType}};
+	const Metrics& metrics = _metrics[(int)type];
 	{
 		// TODO: lock
 		for (int i = 0; i < numPeers; ++i) {
-			if (!_network->sendMessage(peers[i], packet)) {
-				_metric->count("network_not_sent", 1, tags);
+			if (!_network->sendMessage(peers[i], packet, channel)) {
+				_metric->count(metrics.notSent, 1);
 				Log::trace(logid, "Could not send message of type %s to peer %i", msgType, i);
 			} else {
-				_metric->count("network_sent", 1, tags);
+				_metric->count(metrics.sent, 1);
 				++sent;
 			}
 		}
@@ -65,8 +78,7 @@ bool ServerMessageSender::broadcastServerMessage(FlatBufferBuilder& fbb, ServerM
 	{
 		// TODO: lock
 		success = _network->broadcast(createServerPacket(fbb, type, data, flags), channel);
-		const metric::TagMap& tags {{"direction", "broadcast"}, {"type", msgType}};
-		_metric->count("network_sent", 1, tags);
+		_metric->count(_metrics[(int)type].broadcastSent, 1);
 	}
 	fbb.Clear();
 	return success;
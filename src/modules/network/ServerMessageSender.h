@@ -9,6 +9,7 @@
 #include "core/metric/Metric.h"
 #include "core/Log.h"
 #include <memory>
+#include <vector>
 
 namespace network {
 
@@ -22,22 +23,31 @@ private:
 	static constexpr auto logid = Log::logid("ServerMessageSender");
 	ServerNetworkPtr _network;
 	metric::MetricPtr _metric;
+	// pre-registered metrics per server message type
+	struct Metrics {
+		metric::MetricHandle packetCount;
+		metric::MetricHandle packetSize;
+		metric::MetricHandle sent;
+		metric::MetricHandle notSent;
+		metric::MetricHandle broadcastSent;
+	};
+	std::vector<Metrics> _metrics;
 
 public:
 	ENetPacket* createServerPacket(ServerMsgType type, const void * data, size_t dataLength, uint32_t flags);
 	ENetPacket* createServerPacket(FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags);
 	ServerMessageSender(const ServerNetworkPtr& network, const metric::MetricPtr& metric);
 
-	bool sendServerMessage(ENetPeer* peer, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags = ENET_PACKET_FLAG_RELIABLE);
-	bool sendServerMessage(std::vector<ENetPeer*> peers, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags = ENET_PACKET_FLAG_RELIABLE);
-	bool sendServerMessage(ENetPeer** peers, int numPeers, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags = ENET_PACKET_FLAG_RELIABLE);
+	bool sendServerMessage(ENetPeer* peer, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags = ENET_PACKET_FLAG_RELIABLE, int channel = ChannelReliable);
+	bool sendServerMessage(std::vector<ENetPeer*> peers, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags = ENET_PACKET_FLAG_RELIABLE, int channel = ChannelReliable);
+	bool sendServerMessage(ENetPeer** peers, int numPeers, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags = ENET_PACKET_FLAG_RELIABLE, int channel = ChannelReliable);
 	bool broadcastServerMessage(FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, int channel = 0, uint32_t flags = ENET_PACKET_FLAG_RELIABLE);
 };
 
 typedef std::shared_ptr<ServerMessageSender> ServerMessageSenderPtr;
 
-inline bool ServerMessageSender::sendServerMessage(std::vector<ENetPeer*> peers, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags) {
-	return sendServerMessage(&peers.front(), peers.size(), fbb, type, data, flags);
+inline bool ServerMessageSender::sendServerMessage(std::vector<ENetPeer*> peers, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags, int channel) {
+	return sendServerMessage(&peers.front(), peers.size(), fbb, type, data, flags, channel);
 }
 
 }
@@ -12,6 +12,14 @@ namespace network {
 ServerNetwork::ServerNetwork(const ProtocolHandlerRegistryPtr& protocolHandlerRegistry,
 		const core::EventBusPtr& eventBus, const metric::MetricPtr& metric) :
 		Super(protocolHandlerRegistry, eventBus), _metric(metric) {
+	const int types = (int)ClientMsgType::MAX + 1;
+	_packetCount.resize(types);
+	_packetSize.resize(types);
+	for (int i = 0; i < types; ++i) {
+		const metric::TagMap tags {{"direction", "in"}, {"type", EnumNameClientMsgType((ClientMsgType)i)}};
+		_packetCount[i] = _metric->registerMetric("network_packet_count", metric::MetricType::Count, tags);
+		_packetSize[i] = _metric->registerMetric("network_packet_size", metric::MetricType::Count, tags);
+	}
 }
 
 bool ServerNetwork::packetReceived(ENetEvent& event) {
@@ -29,9 +37,8 @@ bool ServerNetwork::packetReceived(ENetEvent& event) {
 		Log::error("No handler for client msg type %s", clientMsgType);
 		return false;
 	}
-	const metric::TagMap& tags  {{"direction", "in"}, {"type", clientMsgType}};
-	_metric->count("network_packet_count", 1, tags);
-	_metric->count("network_packet_size", (int)event.packet->dataLength, tags);
+	_metric->count(_packetCount[(int)type], 1);
+	_metric->count(_packetSize[(int)type], (int)event.packet->dataLength);
 
 	Log::debug("Received %s", clientMsgType);
 	handler->execute(event.peer, reinterpret_cast<const flatbuffers::Table*>(req->data()));
@@ -83,6 +90,7 @@ bool ServerNetwork::broadcast(ENetPacket* packet, int channel) {
 		return false;
 	}
 	Log::debug("Broadcasting a message on channel %i", channel);
+	core::ScopedLock lock(_lock);
 	enet_host_broadcast(_server, channel, packet);
 	return true;
 }
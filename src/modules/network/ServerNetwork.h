@@ -6,6 +6,7 @@
 
 #include "Network.h"
 #include "core/metric/Metric.h"
+#include <vector>
 
 namespace network {
 
@@ -13,6 +14,9 @@ class ServerNetwork : public Network {
 private:
 	ENetHost* _server = nullptr;
 	metric::MetricPtr _metric;
+	// pre-registered metrics per client message type
+	std::vector<metric::MetricHandle> _packetCount;
+	std::vector<metric::MetricHandle> _packetSize;
 	using Super = Network;
 public:
 	ServerNetwork(const ProtocolHandlerRegistryPtr& protocolHandlerRegistry,
@@ -0,0 +1,227 @@
+/**
+ * @file
+ */
+
+#include "Snapshot.h"
+#include <glm/common.hpp>
+#include <glm/gtc/constants.hpp>
+
+namespace network {
+
+enum SnapshotEntryMask : uint8_t {
+	SnapshotRemoved = 1 << 0,
+	SnapshotPosition = 1 << 1,
+	SnapshotRotation = 1 << 2,
+	SnapshotAnimation = 1 << 3
+};
+
+glm::ivec3 quantizePosition(const glm::vec3& pos) {
+	return glm::ivec3(glm::round(pos * PositionScale));
+}
+
+glm::vec3 dequantizePosition(const glm::ivec3& pos) {
+	return glm::vec3(pos) / PositionScale;
+}
+
+uint16_t quantizeRotation(float radians) {
+	const float turns = radians / glm::two_pi<float>();
+	const float fraction = turns - glm::floor(turns);
+	return (uint16_t)((uint32_t)glm::round(fraction * 65536.0f) & 0xFFFFu);
+}
+
+float dequantizeRotation(uint16_t rotation) {
+	return (float)rotation / 65536.0f * glm::two_pi<float>();
+}
+
+static inline void writeVarUInt(std::vector<uint8_t>& out, uint64_t value) {
+	while (value >= 0x80u) {
+		out.push_back((uint8_t)(value | 0x80u));
+		value >>= 7;
+	}
+	out.push_back((uint8_t)value);
+}
+
+static inline void writeVarInt(std::vector<uint8_t>& out, int32_t value) {
+	writeVarUInt(out, ((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+static inline bool readVarUInt(const uint8_t*& data, const uint8_t* end, uint64_t& value) {
+	value = 0u;
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (data >= end) {
+			return false;
+		}
+		const uint8_t byte = *data++;
+		value |= (uint64_t)(byte & 0x7Fu) << shift;
+		if ((byte & 0x80u) == 0u) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static inline bool readVarInt(const uint8_t*& data, const uint8_t* end, int32_t& value) {
+	uint64_t raw;
+	if (!readVarUInt(data, end, raw)) {
+		return false;
+	}
+	const uint32_t zigzag = (uint32_t)raw;
+	value = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1u);
+	return true;
+}
+
+static void writeEntry(std::vector<uint8_t>& out, int64_t& lastId, const SnapshotEntity* base, const SnapshotEntity& entity, uint8_t mask) {
+	writeVarUInt(out, (uint64_t)(entity.id - lastId));
+	lastId = entity.id;
+	out.push_back(mask);
+	if (mask & SnapshotPosition) {
+		const glm::ivec3 basePos = base != nullptr ? base->pos : glm::ivec3(0);
+		writeVarInt(out, entity.pos.x - basePos.x);
+		writeVarInt(out, entity.pos.y - basePos.y);
+		writeVarInt(out, entity.pos.z - basePos.z);
+	}
+	if (mask & SnapshotRotation) {
+		out.push_back((uint8_t)(entity.rotation & 0xFFu));
+		out.push_back((uint8_t)(entity.rotation >> 8));
+	}
+	if (mask & SnapshotAnimation) {
+		out.push_back((uint8_t)entity.animation);
+	}
+}
+
+static inline uint8_t changeMask(const SnapshotEntity& base, const SnapshotEntity& entity) {
+	uint8_t mask = 0u;
+	if (base.pos != entity.pos) {
+		mask |= SnapshotPosition;
+	}
+	if (base.rotation != entity.rotation) {
+		mask |= SnapshotRotation;
+	}
+	if (base.animation != entity.animation) {
+		mask |= SnapshotAnimation;
+	}
+	return mask;
+}
+
+int encodeSnapshot(const SnapshotEntities* baseline, const SnapshotEntities& current, std::vector<uint8_t>& out) {
+	static const SnapshotEntities empty;
+	const SnapshotEntities& base = baseline != nullptr ? *baseline : empty;
+	const uint8_t all = SnapshotPosition | SnapshotRotation | SnapshotAnimation;
+	out.clear();
+	int entries = 0;
+	int64_t lastId = 0;
+	size_t b = 0u;
+	size_t c = 0u;
+	// both lists are sorted - merge them
+	while (b < base.size() || c < current.size()) {
+		if (c == current.size() || (b < base.size() && base[b].id < current[c].id)) {
+			writeEntry(out, lastId, nullptr, base[b], SnapshotRemoved);
+			++entries;
+			++b;
+		} else if (b == base.size() || current[c].id < base[b].id) {
+			writeEntry(out, lastId, nullptr, current[c], all);
+			++entries;
+			++c;
+		} else {
+			const uint8_t mask = changeMask(base[b], current[c]);
+			if (mask != 0u) {
+				writeEntry(out, lastId, &base[b], current[c], mask);
+				++entries;
+			}
+			++b;
+			++c;
+		}
+	}
+	return entries;
+}
+
+bool decodeSnapshot(const SnapshotEntities* baseline, const uint8_t* data, size_t size, SnapshotEntities& out) {
+	static const SnapshotEntities empty;
+	const SnapshotEntities& base = baseline != nullptr ? *baseline : empty;
+	out.clear();
+	out.reserve(base.size());
+	const uint8_t* end = data + size;
+	int64_t lastId = 0;
+	size_t b = 0u;
+	while (data < end) {
+		uint64_t idDelta;
+		if (!readVarUInt(data, end, idDelta) || data >= end) {
+			return false;
+		}
+		const int64_t id = lastId + (int64_t)idDelta;
+		lastId = id;
+		const uint8_t mask = *data++;
+		// the unchanged entities of the baseline
+		while (b < base.size() && base[b].id < id) {
+			out.push_back(base[b++]);
+		}
+		const SnapshotEntity* prev = nullptr;
+		if (b < base.size() && base[b].id == id) {
+			prev = &base[b++];
+		}
+		if (mask & SnapshotRemoved) {
+			if (prev == nullptr) {
+				return false;
+			}
+			continue;
+		}
+		SnapshotEntity entity;
+		if (prev != nullptr) {
+			entity = *prev;
+		} else {
+			entity.id = id;
+		}
+		if (mask & SnapshotPosition) {
+			int32_t dx, dy, dz;
+			if (!readVarInt(data, end, dx) || !readVarInt(data, end, dy) || !readVarInt(data, end, dz)) {
+				return false;
+			}
+			entity.pos += glm::ivec3(dx, dy, dz);
+		}
+		if (mask & SnapshotRotation) {
+			if (end - data < 2) {
+				return false;
+			}
+			entity.rotation = (uint16_t)(data[0] | (data[1] << 8));
+			data += 2;
+		}
+		if (mask & SnapshotAnimation) {
+			if (data >= end) {
+				return false;
+			}
+			entity.animation = (Animation)*data++;
+		}
+		out.push_back(entity);
+	}
+	while (b < base.size()) {
+		out.push_back(base[b++]);
+	}
+	return true;
+}
+
+const SnapshotEntities* SnapshotHistory::get(uint32_t sequence) const {
+	if (sequence == 0u) {
+		return nullptr;
+	}
+	const Entry& entry = _entries[sequence % Size];
+	if (entry.sequence != sequence) {
+		return nullptr;
+	}
+	return &entry.entities;
+}
+
+void SnapshotHistory::put(uint32_t sequence, SnapshotEntities& entities) {
+	Entry& entry = _entries[sequence % Size];
+	entry.sequence = sequence;
+	entry.entities.swap(entities);
+	entities.clear();
+}
+
+void SnapshotHistory::reset() {
+	for (Entry& entry : _entries) {
+		entry.sequence = 0u;
+		entry.entities.clear();
+	}
+}
+
+}
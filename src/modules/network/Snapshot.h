@@ -0,0 +1,88 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "Shared_generated.h"
+#include "core/GLM.h"
+#include <vector>
+#include <stdint.h>
+
+namespace network {
+
+/**
+ * @brief The quantized state of an entity in a @c WorldSnapshot
+ */
+struct SnapshotEntity {
+	int64_t id = 0;
+	// in 1/PositionScale voxels
+	glm::ivec3 pos { 0 };
+	// in 1/65536 of a full turn
+	uint16_t rotation = 0u;
+	Animation animation = Animation::IDLE;
+
+	inline bool operator==(const SnapshotEntity& other) const {
+		return id == other.id && pos == other.pos && rotation == other.rotation && animation == other.animation;
+	}
+};
+
+/**
+ * @brief The entities of a snapshot - sorted by their id
+ */
+typedef std::vector<SnapshotEntity> SnapshotEntities;
+
+static constexpr float PositionScale = 16.0f;
+
+glm::ivec3 quantizePosition(const glm::vec3& pos);
+glm::vec3 dequantizePosition(const glm::ivec3& pos);
+uint16_t quantizeRotation(float radians);
+float dequantizeRotation(uint16_t rotation);
+
+/**
+ * @brief Encodes the entities that were added, removed or changed in relation to the given baseline.
+ *
+ * Every entry is encoded as the varint id delta to the previous entry, a mask of the changed fields
+ * and the changed fields itself. The position is encoded as zigzag varint delta to the baseline.
+ *
+ * @param[in] baseline The state the client acknowledged or @c nullptr if the client doesn't have any state yet
+ * @param[in] current The current state - sorted by the entity id
+ * @param[out] out The encoded entries
+ * @return The amount of encoded entries - @c 0 if there is nothing to send
+ */
+int encodeSnapshot(const SnapshotEntities* baseline, const SnapshotEntities& current, std::vector<uint8_t>& out);
+
+/**
+ * @brief Reconstructs the full state from the baseline and the encoded entries.
+ * @sa encodeSnapshot()
+ * @return @c false if the data is invalid
+ */
+bool decodeSnapshot(const SnapshotEntities* baseline, const uint8_t* data, size_t size, SnapshotEntities& out);
+
+/**
+ * @brief The recently sent (server) or received (client) snapshots that can be used as baseline for the delta encoding
+ */
+class SnapshotHistory {
+public:
+	static constexpr uint32_t Size = 32u;
+private:
+	struct Entry {
+		// 0 is used for empty entries
+		uint32_t sequence = 0u;
+		SnapshotEntities entities;
+	};
+	Entry _entries[Size];
+public:
+	/**
+	 * @return @c nullptr if the snapshot with the given sequence number isn't known (anymore)
+	 */
+	const SnapshotEntities* get(uint32_t sequence) const;
+	/**
+	 * @brief Stores the given entities for the given sequence number - the given list receives the
+	 * storage of the replaced entry to be reused.
+	 */
+	void put(uint32_t sequence, SnapshotEntities& entities);
+	void reset();
+};
+
+}
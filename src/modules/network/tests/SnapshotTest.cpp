@@ -0,0 +1,113 @@
+/**
+ * @file
+ */
+
+#include "core/tests/AbstractTest.h"
+#include "network/Snapshot.h"
+#include <glm/gtc/constants.hpp>
+
+namespace network {
+
+class SnapshotTest : public core::AbstractTest {
+protected:
+	SnapshotEntity entity(int64_t id, const glm::vec3& pos, float rotation = 0.0f, Animation animation = Animation::IDLE) const {
+		SnapshotEntity e;
+		e.id = id;
+		e.pos = quantizePosition(pos);
+		e.rotation = quantizeRotation(rotation);
+		e.animation = animation;
+		return e;
+	}
+
+	void roundTrip(const SnapshotEntities* baseline, const SnapshotEntities& current, int expectedEntries) {
+		std::vector<uint8_t> buf;
+		EXPECT_EQ(expectedEntries, encodeSnapshot(baseline, current, buf));
+		SnapshotEntities decoded;
+		ASSERT_TRUE(decodeSnapshot(baseline, buf.data(), buf.size(), decoded));
+		EXPECT_EQ(current, decoded);
+	}
+};
+
+TEST_F(SnapshotTest, testQuantization) {
+	const glm::vec3 pos(100.5f, -3.25f, 4096.0625f);
+	EXPECT_EQ(pos, dequantizePosition(quantizePosition(pos)));
+	EXPECT_NEAR(glm::half_pi<float>(), dequantizeRotation(quantizeRotation(glm::half_pi<float>())), 0.0001f);
+	// negative angles are wrapped into a full turn
+	EXPECT_EQ(quantizeRotation(glm::two_pi<float>() - 1.0f), quantizeRotation(-1.0f));
+}
+
+TEST_F(SnapshotTest, testFullSnapshot) {
+	const SnapshotEntities current {
+		entity(1, glm::vec3(1.0f, 2.0f, 3.0f)),
+		entity(5, glm::vec3(-10.0f, 64.0f, 100.0f), 1.0f, Animation::RUN),
+		entity(1000000, glm::vec3(0.5f), 3.0f)
+	};
+	roundTrip(nullptr, current, 3);
+}
+
+TEST_F(SnapshotTest, testDeltaOnlyContainsChanges) {
+	SnapshotEntities baseline;
+	for (int i = 0; i < 100; ++i) {
+		baseline.push_back(entity(i + 1, glm::vec3(i, 10.0f, i * 2)));
+	}
+	SnapshotEntities current = baseline;
+	current[10].pos.x += 3;
+	current[50].animation = Animation::RUN;
+	roundTrip(&baseline, current, 2);
+
+	std::vector<uint8_t> full;
+	std::vector<uint8_t> delta;
+	encodeSnapshot(nullptr, current, full);
+	encodeSnapshot(&baseline, current, delta);
+	EXPECT_LT(delta.size() * 20u, full.size());
+
+	// nothing changed - nothing to send
+	EXPECT_EQ(0, encodeSnapshot(&baseline, baseline, delta));
+}
+
+TEST_F(SnapshotTest, testAddAndRemove) {
+	const SnapshotEntities baseline {
+		entity(1, glm::vec3(1.0f)),
+		entity(2, glm::vec3(2.0f)),
+		entity(3, glm::vec3(3.0f))
+	};
+	const SnapshotEntities current {
+		entity(1, glm::vec3(1.0f)),
+		entity(3, glm::vec3(3.0f)),
+		entity(4, glm::vec3(4.0f))
+	};
+	// entity 2 removed, entity 4 added
+	roundTrip(&baseline, current, 2);
+}
+
+TEST_F(SnapshotTest, testInvalidData) {
+	const SnapshotEntities current { entity(1, glm::vec3(1.0f, 2.0f, 3.0f), 1.0f) };
+	std::vector<uint8_t> buf;
+	ASSERT_EQ(1, encodeSnapshot(nullptr, current, buf));
+	SnapshotEntities decoded;
+	EXPECT_FALSE(decodeSnapshot(nullptr, buf.data(), buf.size() - 1, decoded));
+	// removing an entity that is not part of the baseline
+	const uint8_t removeUnknown[] = {1, 1};
+	EXPECT_FALSE(decodeSnapshot(nullptr, removeUnknown, sizeof(removeUnknown), decoded));
+}
+
+TEST_F(SnapshotTest, testHistory) {
+	SnapshotHistory history;
+	EXPECT_EQ(nullptr, history.get(0u));
+	SnapshotEntities entities { entity(1, glm::vec3(1.0f)) };
+	history.put(1u, entities);
+	const SnapshotEntities* stored = history.get(1u);
+	ASSERT_NE(nullptr, stored);
+	EXPECT_EQ(1u, stored->size());
+	for (uint32_t i = 2u; i < 2u + SnapshotHistory::Size; ++i) {
+		SnapshotEntities e;
+		history.put(i, e);
+	}
+	// overwritten by newer snapshots
+	EXPECT_EQ(nullptr, history.get(1u));
+	EXPECT_NE(nullptr, history.get(SnapshotHistory::Size + 1u));
+	history.reset();
+	EXPECT_EQ(nullptr, history.get(SnapshotHistory::Size + 1u));
+}
+
+}
@@ -0,0 +1,144 @@
+/**
+ * @file
+ */
+
+#include "SimplexBatch.h"
+#include "SimplexBatchKernel.h"
+#include "Simplex.h"
+#include <SDL_cpuinfo.h>
+#include <atomic>
+
+namespace noise {
+
+static_assert(sizeof(glm::vec2) == 2 * sizeof(float), "The batch kernels expect tightly packed coordinates");
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "The batch kernels expect tightly packed coordinates");
+
+namespace {
+
+std::atomic<SIMDLevel> _simdLevel(detectSIMDLevel());
+
+/**
+ * @brief The permutation table of the scalar noise as 32 bit values - they can be loaded by the gather instructions
+ */
+const int32_t* permTable() {
+	static int32_t table[512];
+	static const bool initialized = [] () {
+		for (int i = 0; i < 512; ++i) {
+			table[i] = details::perm[i];
+		}
+		return true;
+	}();
+	(void)initialized;
+	return table;
+}
+
+template<class Vec, class ScalarFunc>
+void evaluate(const Vec* in, float* out, size_t n, const batch::Params& params, ScalarFunc&& scalar) {
+	if (n == 0u) {
+		return;
+	}
+	const float* coords = &in[0].x;
+	constexpr size_t stride = sizeof(Vec) / sizeof(float);
+	constexpr bool is2D = stride == 2;
+	switch (_simdLevel.load(std::memory_order_relaxed)) {
+#ifdef NOISE_SIMD
+	case SIMDLevel::AVX2:
+		if (is2D) {
+			batch::simplex2AVX2(coords, stride, out, n, params, permTable());
+		} else {
+			batch::simplex3AVX2(coords, stride, out, n, params, permTable());
+		}
+		return;
+	case SIMDLevel::SSE41:
+		if (is2D) {
+			batch::simplex2SSE41(coords, stride, out, n, params, permTable());
+		} else {
+			batch::simplex3SSE41(coords, stride, out, n, params, permTable());
+		}
+		return;
+#endif
+	default:
+		for (size_t i = 0; i < n; ++i) {
+			out[i] = scalar(in[i]);
+		}
+		return;
+	}
+}
+
+batch::Params params(batch::Function function, uint8_t octaves = 0u, float lacunarity = 0.0f, float gain = 0.0f) {
+	batch::Params p;
+	p.function = function;
+	p.octaves = octaves;
+	p.lacunarity = lacunarity;
+	p.gain = gain;
+	return p;
+}
+
+}
+
+SIMDLevel detectSIMDLevel() {
+#ifdef NOISE_SIMD
+	if (SDL_HasAVX2()) {
+		return SIMDLevel::AVX2;
+	}
+	if (SDL_HasSSE41()) {
+		return SIMDLevel::SSE41;
+	}
+#endif
+	return SIMDLevel::Scalar;
+}
+
+SIMDLevel simdLevel() {
+	return _simdLevel;
+}
+
+SIMDLevel setSIMDLevel(SIMDLevel level) {
+	const SIMDLevel maxLevel = detectSIMDLevel();
+	if ((uint8_t)level > (uint8_t)maxLevel) {
+		level = maxLevel;
+	}
+	_simdLevel = level;
+	return level;
+}
+
+const char* simdLevelName(SIMDLevel level) {
+	switch (level) {
+	case SIMDLevel::AVX2:
+		return "avx2";
+	case SIMDLevel::SSE41:
+		return "sse4.1";
+	case SIMDLevel::Scalar:
+	default:
+		return "scalar";
+	}
+}
+
+void noise(const glm::vec2* in, float* out, size_t n) {
+	evaluate(in, out, n, params(batch::Function::Noise), [] (const glm::vec2& v) { return noise(v); });
+}
+
+void noise(const glm::vec3* in, float* out, size_t n) {
+	evaluate(in, out, n, params(batch::Function::Noise), [] (const glm::vec3& v) { return noise(v); });
+}
+
+void ridgedNoise(const glm::vec2* in, float* out, size_t n) {
+	evaluate(in, out, n, params(batch::Function::RidgedNoise), [] (const glm::vec2& v) { return ridgedNoise(v); });
+}
+
+void ridgedNoise(const glm::vec3* in, float* out, size_t n) {
+	evaluate(in, out, n, params(batch::Function::RidgedNoise), [] (const glm::vec3& v) { return ridgedNoise(v); });
+}
+
+void fBm(const glm::vec2* in, float* out, size_t n, uint8_t octaves, float lacunarity, float gain) {
+	evaluate(in, out, n, params(batch::Function::FBm, octaves, lacunarity, gain), [=] (const glm::vec2& v) {
+		return fBm(v, octaves, lacunarity, gain);
+	});
+}
+
+void fBm(const glm::vec3* in, float* out, size_t n, uint8_t octaves, float lacunarity, float gain) {
+	evaluate(in, out, n, params(batch::Function::FBm, octaves, lacunarity, gain), [=] (const glm::vec3& v) {
+		return fBm(v, octaves, lacunarity, gain);
+	});
+}
+
+}
@@ -0,0 +1,53 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace noise {
+
+/**
+ * @brief The instruction sets the batch noise functions can use
+ */
+enum class SIMDLevel : uint8_t {
+	Scalar,
+	SSE41,
+	AVX2
+};
+
+/**
+ * @return The best instruction set of this cpu that the batch noise functions were compiled for
+ */
+SIMDLevel detectSIMDLevel();
+/**
+ * @return The instruction set the batch noise functions are currently using. Defaults to detectSIMDLevel().
+ */
+SIMDLevel simdLevel();
+/**
+ * @brief Changes the instruction set of the batch noise functions - e.g. to compare them in tests or benchmarks.
+ * Levels above detectSIMDLevel() are clamped.
+ * @return The level that is used from now on
+ */
+SIMDLevel setSIMDLevel(SIMDLevel level);
+const char* simdLevelName(SIMDLevel level);
+
+/**
+ * @brief Batch versions of the simplex noise functions from Simplex.h.
+ *
+ * They evaluate the noise for @c n coordinates at once and write the results into @c out (which must have room for
+ * @c n values). The results are bit-identical to calling the scalar functions for every coordinate - no matter which
+ * instruction set is used - so terrain that was generated with the scalar functions doesn't change.
+ */
+void noise(const glm::vec2* in, float* out, size_t n);
+void noise(const glm::vec3* in, float* out, size_t n);
+void ridgedNoise(const glm::vec2* in, float* out, size_t n);
+void ridgedNoise(const glm::vec3* in, float* out, size_t n);
+void fBm(const glm::vec2* in, float* out, size_t n, uint8_t octaves = 4, float lacunarity = 2.0f, float gain = 0.5f);
+void fBm(const glm::vec3* in, float* out, size_t n, uint8_t octaves = 4, float lacunarity = 2.0f, float gain = 0.5f);
+
+}
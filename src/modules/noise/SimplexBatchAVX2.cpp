@@ -0,0 +1,82 @@
+/**
+ * @file
+ * @note Compiled with avx2 enabled - only called if the cpu supports it
+ */
+
+#include "SimplexBatchKernel.cpp.h"
+#include <immintrin.h>
+
+namespace noise {
+namespace batch {
+
+namespace {
+
+struct AVX2 {
+	static constexpr int Width = 8;
+	typedef __m256 F;
+	typedef __m256i I;
+
+	static inline F set1(float v) { return _mm256_set1_ps(v); }
+	static inline F load(const float* p) { return _mm256_load_ps(p); }
+	static inline void store(float* p, F v) { _mm256_storeu_ps(p, v); }
+	static inline F add(F a, F b) { return _mm256_add_ps(a, b); }
+	static inline F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+	static inline F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+	static inline F gt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static inline F lt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static inline F ge(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+	static inline F fand(F a, F b) { return _mm256_and_ps(a, b); }
+	static inline F f_or(F a, F b) { return _mm256_or_ps(a, b); }
+	static inline F fnot(F a) { return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+	// mask ? a : b
+	static inline F select(F mask, F a, F b) { return _mm256_blendv_ps(b, a, mask); }
+	// mask ? 0 : v
+	static inline F andnot(F mask, F v) { return _mm256_andnot_ps(mask, v); }
+	// mask ? -v : v
+	static inline F negate(F mask, F v) { return _mm256_xor_ps(v, _mm256_and_ps(mask, _mm256_set1_ps(-0.0f))); }
+	static inline F abs(F v) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v); }
+
+	// float(double(a) + c)
+	static inline F addd(F a, double c) {
+		const __m256d cd = _mm256_set1_pd(c);
+		const __m128 lo = _mm256_cvtpd_ps(_mm256_add_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(a)), cd));
+		const __m128 hi = _mm256_cvtpd_ps(_mm256_add_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(a, 1)), cd));
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+	}
+	// float(double(a) * c)
+	static inline F muld(F a, double c) {
+		const __m256d cd = _mm256_set1_pd(c);
+		const __m128 lo = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(a)), cd));
+		const __m128 hi = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(a, 1)), cd));
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+	}
+
+	static inline I truncate(F v) { return _mm256_cvttps_epi32(v); }
+	static inline F toFloat(I v) { return _mm256_cvtepi32_ps(v); }
+	static inline I imask(F mask) { return _mm256_castps_si256(mask); }
+	static inline F fmask(I mask) { return _mm256_castsi256_ps(mask); }
+	static inline I iset1(int v) { return _mm256_set1_epi32(v); }
+	static inline I iadd(I a, I b) { return _mm256_add_epi32(a, b); }
+	static inline I iand(I a, I b) { return _mm256_and_si256(a, b); }
+	static inline I ior(I a, I b) { return _mm256_or_si256(a, b); }
+	static inline I iandnot(I mask, I v) { return _mm256_andnot_si256(mask, v); }
+	static inline I ieq(I a, I b) { return _mm256_cmpeq_epi32(a, b); }
+	static inline I ilt(I a, I b) { return _mm256_cmpgt_epi32(b, a); }
+
+	static inline I gather(const int32_t* table, I idx) {
+		return _mm256_i32gather_epi32((const int*)table, idx, 4);
+	}
+};
+
+}
+
+void simplex2AVX2(const float* in, size_t stride, float* out, size_t n, const Params& params, const int32_t* perm) {
+	SimplexKernel<AVX2>::run(in, stride, out, n, params, perm, 2);
+}
+
+void simplex3AVX2(const float* in, size_t stride, float* out, size_t n, const Params& params, const int32_t* perm) {
+	SimplexKernel<AVX2>::run(in, stride, out, n, params, perm, 3);
+}
+
+}
+}
@@ -0,0 +1,228 @@
+/**
+ * @file
+ * @brief Vectorized versions of the 2d and 3d simplex noise from Simplex.h.
+ *
+ * Included by the translation units of the different instruction sets. The template parameter @c V wraps the
+ * intrinsics of one instruction set - @c V::F is a vector of @c V::Width floats and @c V::I of as many ints.
+ *
+ * Every lane must produce the same bits as the scalar code. That's why the operations are done in the same
+ * order as there, and why the skewing factors are applied in double precision - they are double constants in
+ * the scalar code.
+ */
+
+#include "SimplexBatchKernel.h"
+
+namespace noise {
+namespace batch {
+
+// keep in sync with Simplex.h
+constexpr double SkewF2 = 0.366025403;
+constexpr double SkewG2 = 0.211324865;
+constexpr double SkewF3 = 0.333333333;
+constexpr double SkewG3 = 0.166666667;
+
+template<class V>
+class SimplexKernel {
+private:
+	typedef typename V::F F;
+	typedef typename V::I I;
+
+	// x > 0 ? (int)x : (int)x - 1
+	static inline I fastFloor(F x) {
+		return V::iadd(V::truncate(x), V::iandnot(V::imask(V::gt(x, V::set1(0.0f))), V::iset1(-1)));
+	}
+
+	// mask of the lanes where the given bits of h are set
+	static inline F bitsSet(I h, int bits) {
+		const I b = V::iset1(bits);
+		return V::fmask(V::ieq(V::iand(h, b), b));
+	}
+
+	static inline I lookup(const int32_t* perm, I idx) {
+		return V::gather(perm, idx);
+	}
+
+	static inline F grad2(I hash, F x, F y) {
+		const I h = V::iand(hash, V::iset1(7));
+		const F lower = V::fmask(V::ilt(h, V::iset1(4)));
+		const F u = V::select(lower, x, y);
+		const F v = V::select(lower, y, x);
+		return V::add(V::negate(bitsSet(h, 1), u), V::negate(bitsSet(h, 2), V::mul(V::set1(2.0f), v)));
+	}
+
+	static inline F grad3(I hash, F x, F y, F z) {
+		const I h = V::iand(hash, V::iset1(15));
+		const F u = V::select(V::fmask(V::ilt(h, V::iset1(8))), x, y);
+		const F xMask = V::fmask(V::ior(V::ieq(h, V::iset1(12)), V::ieq(h, V::iset1(14))));
+		const F v = V::select(V::fmask(V::ilt(h, V::iset1(4))), y, V::select(xMask, x, z));
+		return V::add(V::negate(bitsSet(h, 1), u), V::negate(bitsSet(h, 2), v));
+	}
+
+	static inline F corner2(F x, F y, I hash) {
+		F t = V::sub(V::sub(V::set1(0.5f), V::mul(x, x)), V::mul(y, y));
+		const F outside = V::lt(t, V::set1(0.0f));
+		t = V::mul(t, t);
+		return V::andnot(outside, V::mul(V::mul(t, t), grad2(hash, x, y)));
+	}
+
+	static inline F corner3(F x, F y, F z, I hash) {
+		F t = V::sub(V::sub(V::sub(V::set1(0.6f), V::mul(x, x)), V::mul(y, y)), V::mul(z, z));
+		const F outside = V::lt(t, V::set1(0.0f));
+		t = V::mul(t, t);
+		return V::andnot(outside, V::mul(V::mul(t, t), grad3(hash, x, y, z)));
+	}
+
+	// converts a lane mask into 1.0f/0.0f
+	static inline F one(F mask) {
+		return V::fand(mask, V::set1(1.0f));
+	}
+
+	// converts a lane mask into 1/0
+	static inline I ione(F mask) {
+		return V::iand(V::imask(mask), V::iset1(1));
+	}
+
+	static F noise2(F x, F y, const int32_t* perm) {
+		const F s = V::muld(V::add(x, y), SkewF2);
+		const I i = fastFloor(V::add(x, s));
+		const I j = fastFloor(V::add(y, s));
+
+		const F t = V::muld(V::toFloat(V::iadd(i, j)), SkewG2);
+		const F x0 = V::sub(x, V::sub(V::toFloat(i), t));
+		const F y0 = V::sub(y, V::sub(V::toFloat(j), t));
+
+		const F lower = V::gt(x0, y0);
+		const F upper = V::fnot(lower);
+		const I i1 = ione(lower);
+		const I j1 = ione(upper);
+
+		const F x1 = V::addd(V::sub(x0, one(lower)), SkewG2);
+		const F y1 = V::addd(V::sub(y0, one(upper)), SkewG2);
+		const F x2 = V::addd(V::sub(x0, V::set1(1.0f)), 2.0f * SkewG2);
+		const F y2 = V::addd(V::sub(y0, V::set1(1.0f)), 2.0f * SkewG2);
+
+		const I ii = V::iand(i, V::iset1(0xff));
+		const I jj = V::iand(j, V::iset1(0xff));
+		const I iOne = V::iset1(1);
+
+		const I h0 = lookup(perm, V::iadd(ii, lookup(perm, jj)));
+		const I h1 = lookup(perm, V::iadd(V::iadd(ii, i1), lookup(perm, V::iadd(jj, j1))));
+		const I h2 = lookup(perm, V::iadd(V::iadd(ii, iOne), lookup(perm, V::iadd(jj, iOne))));
+
+		const F n0 = corner2(x0, y0, h0);
+		const F n1 = corner2(x1, y1, h1);
+		const F n2 = corner2(x2, y2, h2);
+		return V::mul(V::set1(40.0f), V::add(V::add(n0, n1), n2));
+	}
+
+	static F noise3(F x, F y, F z, const int32_t* perm) {
+		const F s = V::muld(V::add(V::add(x, y), z), SkewF3);
+		const I i = fastFloor(V::add(x, s));
+		const I j = fastFloor(V::add(y, s));
+		const I k = fastFloor(V::add(z, s));
+
+		const F t = V::muld(V::toFloat(V::iadd(V::iadd(i, j), k)), SkewG3);
+		const F x0 = V::sub(x, V::sub(V::toFloat(i), t));
+		const F y0 = V::sub(y, V::sub(V::toFloat(j), t));
+		const F z0 = V::sub(z, V::sub(V::toFloat(k), t));
+
+		// the branches of the scalar simplex selection expressed as lane masks
+		const F xy = V::ge(x0, y0);
+		const F yz = V::ge(y0, z0);
+		const F xz = V::ge(x0, z0);
+		const F nxy = V::fnot(xy);
+		const F nyz = V::fnot(yz);
+		const F m1i = V::fand(xy, V::f_or(yz, xz));
+		const F m1j = V::fand(nxy, yz);
+		const F m1k = V::f_or(V::fand(xy, V::fand(nyz, V::fnot(xz))), V::fand(nxy, nyz));
+		const F m2i = V::f_or(xy, V::fand(yz, xz));
+		const F m2j = V::f_or(nxy, yz);
+		const F m2k = V::f_or(V::fand(xy, nyz), V::fand(nxy, V::fnot(V::fand(yz, xz))));
+
+		const F x1 = V::addd(V::sub(x0, one(m1i)), SkewG3);
+		const F y1 = V::addd(V::sub(y0, one(m1j)), SkewG3);
+		const F z1 = V::addd(V::sub(z0, one(m1k)), SkewG3);
+		const F x2 = V::addd(V::sub(x0, one(m2i)), 2.0f * SkewG3);
+		const F y2 = V::addd(V::sub(y0, one(m2j)), 2.0f * SkewG3);
+		const F z2 = V::addd(V::sub(z0, one(m2k)), 2.0f * SkewG3);
+		const F x3 = V::addd(V::sub(x0, V::set1(1.0f)), 3.0f * SkewG3);
+		const F y3 = V::addd(V::sub(y0, V::set1(1.0f)), 3.0f * SkewG3);
+		const F z3 = V::addd(V::sub(z0, V::set1(1.0f)), 3.0f * SkewG3);
+
+		const I ii = V::iand(i, V::iset1(0xff));
+		const I jj = V::iand(j, V::iset1(0xff));
+		const I kk = V::iand(k, V::iset1(0xff));
+		const I iOne = V::iset1(1);
+
+		const I h0 = lookup(perm, V::iadd(ii, lookup(perm, V::iadd(jj, lookup(perm, kk)))));
+		const I h1 = lookup(perm, V::iadd(V::iadd(ii, ione(m1i)),
+				lookup(perm, V::iadd(V::iadd(jj, ione(m1j)), lookup(perm, V::iadd(kk, ione(m1k)))))));
+		const I h2 = lookup(perm, V::iadd(V::iadd(ii, ione(m2i)),
+				lookup(perm, V::iadd(V::iadd(jj, ione(m2j)), lookup(perm, V::iadd(kk, ione(m2k)))))));
+		const I h3 = lookup(perm, V::iadd(V::iadd(ii, iOne),
+				lookup(perm, V::iadd(V::iadd(jj, iOne), lookup(perm, V::iadd(kk, iOne))))));
+
+		const F n0 = corner3(x0, y0, z0, h0);
+		const F n1 = corner3(x1, y1, z1, h1);
+		const F n2 = corner3(x2, y2, z2, h2);
+		const F n3 = corner3(x3, y3, z3, h3);
+		return V::mul(V::set1(32.0f), V::add(V::add(V::add(n0, n1), n2), n3));
+	}
+
+	static inline F ridged(F n) {
+		const F unit = V::set1(1.0f);
+		return V::sub(V::mul(V::sub(unit, V::abs(n)), V::set1(2.0f)), unit);
+	}
+
+	static inline F evaluate(const F* c, const Params& params, const int32_t* perm, int dimensions) {
+		switch (params.function) {
+		case Function::RidgedNoise:
+			return ridged(dimensions == 2 ? noise2(c[0], c[1], perm) : noise3(c[0], c[1], c[2], perm));
+		case Function::FBm: {
+			F sum = V::set1(0.0f);
+			float freq = 1.0f;
+			float amp = 0.5f;
+			for (uint8_t o = 0; o < params.octaves; ++o) {
+				const F f = V::set1(freq);
+				const F n = dimensions == 2 ? noise2(V::mul(c[0], f), V::mul(c[1], f), perm)
+						: noise3(V::mul(c[0], f), V::mul(c[1], f), V::mul(c[2], f), perm);
+				sum = V::add(sum, V::mul(n, V::set1(amp)));
+				freq *= params.lacunarity;
+				amp *= params.gain;
+			}
+			return sum;
+		}
+		case Function::Noise:
+		default:
+			return dimensions == 2 ? noise2(c[0], c[1], perm) : noise3(c[0], c[1], c[2], perm);
+		}
+	}
+
+public:
+	static void run(const float* in, size_t stride, float* out, size_t n, const Params& params, const int32_t* perm, int dimensions) {
+		alignas(32) float lanes[3][V::Width];
+		alignas(32) float result[V::Width];
+		F c[3];
+		for (size_t i = 0; i < n; i += V::Width) {
+			const size_t count = n - i < (size_t)V::Width ? n - i : (size_t)V::Width;
+			for (int d = 0; d < dimensions; ++d) {
+				for (size_t l = 0; l < (size_t)V::Width; ++l) {
+					lanes[d][l] = l < count ? in[(i + l) * stride + d] : 0.0f;
+				}
+				c[d] = V::load(lanes[d]);
+			}
+			const F value = evaluate(c, params, perm, dimensions);
+			if (count == (size_t)V::Width) {
+				V::store(out + i, value);
+				continue;
+			}
+			V::store(result, value);
+			for (size_t l = 0; l < count; ++l) {
+				out[i + l] = result[l];
+			}
+		}
+	}
+};
+
+}
+}
@@ -0,0 +1,40 @@
+/**
+ * @file
+ * @brief Internal interface between the batch noise dispatcher and the simd kernels.
+ *
+ * The kernels are compiled with their own instruction set flags - don't include anything here that could
+ * leak inline functions into them.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace noise {
+namespace batch {
+
+enum class Function : uint8_t {
+	Noise,
+	RidgedNoise,
+	FBm
+};
+
+struct Params {
+	Function function = Function::Noise;
+	uint8_t octaves = 0u;
+	float lacunarity = 0.0f;
+	float gain = 0.0f;
+};
+
+/**
+ * @param[in] in The coordinates - the components of coordinate @c i start at @code in + i * stride @endcode
+ * @param[in] perm The permutation table of the scalar noise as 32 bit values
+ */
+void simplex2SSE41(const float* in, size_t stride, float* out, size_t n, const Params& params, const int32_t* perm);
+void simplex3SSE41(const float* in, size_t stride, float* out, size_t n, const Params& params, const int32_t* perm);
+void simplex2AVX2(const float* in, size_t stride, float* out, size_t n, const Params& params, const int32_t* perm);
+void simplex3AVX2(const float* in, size_t stride, float* out, size_t n, const Params& params, const int32_t* perm);
+
+}
+}
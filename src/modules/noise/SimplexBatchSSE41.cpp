@@ -0,0 +1,84 @@
+/**
+ * @file
+ * @note Compiled with sse4.1 enabled - only called if the cpu supports it
+ */
+
+#include "SimplexBatchKernel.cpp.h"
+#include <smmintrin.h>
+
+namespace noise {
+namespace batch {
+
+namespace {
+
+struct SSE41 {
+	static constexpr int Width = 4;
+	typedef __m128 F;
+	typedef __m128i I;
+
+	static inline F set1(float v) { return _mm_set1_ps(v); }
+	static inline F load(const float* p) { return _mm_load_ps(p); }
+	static inline void store(float* p, F v) { _mm_storeu_ps(p, v); }
+	static inline F add(F a, F b) { return _mm_add_ps(a, b); }
+	static inline F sub(F a, F b) { return _mm_sub_ps(a, b); }
+	static inline F mul(F a, F b) { return _mm_mul_ps(a, b); }
+	static inline F gt(F a, F b) { return _mm_cmpgt_ps(a, b); }
+	static inline F lt(F a, F b) { return _mm_cmplt_ps(a, b); }
+	static inline F ge(F a, F b) { return _mm_cmpge_ps(a, b); }
+	static inline F fand(F a, F b) { return _mm_and_ps(a, b); }
+	static inline F f_or(F a, F b) { return _mm_or_ps(a, b); }
+	static inline F fnot(F a) { return _mm_xor_ps(a, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+	// mask ? a : b
+	static inline F select(F mask, F a, F b) { return _mm_blendv_ps(b, a, mask); }
+	// mask ? 0 : v
+	static inline F andnot(F mask, F v) { return _mm_andnot_ps(mask, v); }
+	// mask ? -v : v
+	static inline F negate(F mask, F v) { return _mm_xor_ps(v, _mm_and_ps(mask, _mm_set1_ps(-0.0f))); }
+	static inline F abs(F v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+
+	// float(double(a) + c)
+	static inline F addd(F a, double c) {
+		const __m128d cd = _mm_set1_pd(c);
+		const __m128 lo = _mm_cvtpd_ps(_mm_add_pd(_mm_cvtps_pd(a), cd));
+		const __m128 hi = _mm_cvtpd_ps(_mm_add_pd(_mm_cvtps_pd(_mm_movehl_ps(a, a)), cd));
+		return _mm_movelh_ps(lo, hi);
+	}
+	// float(double(a) * c)
+	static inline F muld(F a, double c) {
+		const __m128d cd = _mm_set1_pd(c);
+		const __m128 lo = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtps_pd(a), cd));
+		const __m128 hi = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(a, a)), cd));
+		return _mm_movelh_ps(lo, hi);
+	}
+
+	static inline I truncate(F v) { return _mm_cvttps_epi32(v); }
+	static inline F toFloat(I v) { return _mm_cvtepi32_ps(v); }
+	static inline I imask(F mask) { return _mm_castps_si128(mask); }
+	static inline F fmask(I mask) { return _mm_castsi128_ps(mask); }
+	static inline I iset1(int v) { return _mm_set1_epi32(v); }
+	static inline I iadd(I a, I b) { return _mm_add_epi32(a, b); }
+	static inline I iand(I a, I b) { return _mm_and_si128(a, b); }
+	static inline I ior(I a, I b) { return _mm_or_si128(a, b); }
+	static inline I iandnot(I mask, I v) { return _mm_andnot_si128(mask, v); }
+	static inline I ieq(I a, I b) { return _mm_cmpeq_epi32(a, b); }
+	static inline I ilt(I a, I b) { return _mm_cmplt_epi32(a, b); }
+
+	// there is no gather instruction before avx2
+	static inline I gather(const int32_t* table, I idx) {
+		return _mm_setr_epi32(table[_mm_extract_epi32(idx, 0)], table[_mm_extract_epi32(idx, 1)],
+				table[_mm_extract_epi32(idx, 2)], table[_mm_extract_epi32(idx, 3)]);
+	}
+};
+
+}
+
+void simplex2SSE41(const float* in, size_t stride, float* out, size_t n, const Params& params, const int32_t* perm) {
+	SimplexKernel<SSE41>::run(in, stride, out, n, params, perm, 2);
+}
+
+void simplex3SSE41(const float* in, size_t stride, float* out, size_t n, const Params& params, const int32_t* perm) {
+	SimplexKernel<SSE41>::run(in, stride, out, n, params, perm, 3);
+}
+
+}
+}
@@ -0,0 +1,97 @@
+/**
+ * @file
+ */
+
+#include "core/benchmark/AbstractBenchmark.h"
+#include "noise/Simplex.h"
+#include "noise/SimplexBatch.h"
+#include <vector>
+
+namespace {
+
+// one row of columns of a chunk and one column of a chunk
+constexpr int Amount = 256;
+constexpr uint8_t Octaves = 4;
+
+}
+
+class NoiseBenchmark : public core::AbstractBenchmark {
+protected:
+	std::vector<glm::vec2> _positions2d;
+	std::vector<glm::vec3> _positions3d;
+	std::vector<float> _out;
+
+	bool onInitApp() override {
+		_positions2d.resize(Amount);
+		_positions3d.resize(Amount);
+		_out.resize(Amount);
+		for (int i = 0; i < Amount; ++i) {
+			_positions2d[i] = glm::vec2(1000.0f + i, 4711.0f) * 0.01f;
+			_positions3d[i] = glm::vec3(1000.0f, (float)i, 4711.0f) * 0.02f;
+		}
+		return true;
+	}
+
+	void onCleanupApp() override {
+		noise::setSIMDLevel(noise::detectSIMDLevel());
+	}
+
+	bool setLevel(benchmark::State& state) {
+		const noise::SIMDLevel level = (noise::SIMDLevel)state.range(0);
+		if (noise::setSIMDLevel(level) != level) {
+			state.SkipWithError("Instruction set is not supported");
+			return false;
+		}
+		state.SetLabel(noise::simdLevelName(level));
+		return true;
+	}
+};
+
+BENCHMARK_DEFINE_F(NoiseBenchmark, Scalar2D) (benchmark::State& state) {
+	for (auto _ : state) {
+		for (int i = 0; i < Amount; ++i) {
+			_out[i] = noise::fBm(_positions2d[i], Octaves);
+		}
+		benchmark::DoNotOptimize(_out.data());
+	}
+	state.SetItemsProcessed(state.iterations() * Amount);
+}
+
+BENCHMARK_DEFINE_F(NoiseBenchmark, Batch2D) (benchmark::State& state) {
+	if (!setLevel(state)) {
+		return;
+	}
+	for (auto _ : state) {
+		noise::fBm(_positions2d.data(), _out.data(), Amount, Octaves);
+		benchmark::DoNotOptimize(_out.data());
+	}
+	state.SetItemsProcessed(state.iterations() * Amount);
+}
+
+BENCHMARK_DEFINE_F(NoiseBenchmark, Scalar3D) (benchmark::State& state) {
+	for (auto _ : state) {
+		for (int i = 0; i < Amount; ++i) {
+			_out[i] = noise::fBm(_positions3d[i], Octaves);
+		}
+		benchmark::DoNotOptimize(_out.data());
+	}
+	state.SetItemsProcessed(state.iterations() * Amount);
+}
+
+BENCHMARK_DEFINE_F(NoiseBenchmark, Batch3D) (benchmark::State& state) {
+	if (!setLevel(state)) {
+		return;
+	}
+	for (auto _ : state) {
+		noise::fBm(_positions3d.data(), _out.data(), Amount, Octaves);
+		benchmark::DoNotOptimize(_out.data());
+	}
+	state.SetItemsProcessed(state.iterations() * Amount);
+}
+
+BENCHMARK_REGISTER_F(NoiseBenchmark, Scalar2D);
+BENCHMARK_REGISTER_F(NoiseBenchmark, Batch2D)->DenseRange((int)noise::SIMDLevel::Scalar, (int)noise::SIMDLevel::AVX2);
+BENCHMARK_REGISTER_F(NoiseBenchmark, Scalar3D);
+BENCHMARK_REGISTER_F(NoiseBenchmark, Batch3D)->DenseRange((int)noise::SIMDLevel::Scalar, (int)noise::SIMDLevel::AVX2);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,91 @@
+/**
+ * @file
+ */
+
+#include "core/tests/AbstractTest.h"
+#include "noise/Simplex.h"
+#include "noise/SimplexBatch.h"
+#include <random>
+#include <string.h>
+#include <vector>
+
+namespace noise {
+
+class SimplexBatchTest: public core::AbstractTest {
+protected:
+	// not a multiple of the simd width to also cover the remainder
+	static constexpr int Amount = 1003;
+	std::vector<glm::vec2> _positions2d;
+	std::vector<glm::vec3> _positions3d;
+
+	void SetUp() override {
+		core::AbstractTest::SetUp();
+		std::mt19937 rnd(4711);
+		std::uniform_real_distribution<float> dist(-300.0f, 300.0f);
+		_positions2d.resize(Amount);
+		_positions3d.resize(Amount);
+		for (int i = 0; i < Amount; ++i) {
+			_positions2d[i] = glm::vec2(dist(rnd), dist(rnd));
+			_positions3d[i] = glm::vec3(dist(rnd), dist(rnd), dist(rnd));
+		}
+		// integer coordinates and zero hit the edge cases of the floor and the simplex selection
+		for (int i = 0; i < 64; ++i) {
+			_positions2d[i] = glm::vec2((float)(i % 8 - 4), (float)(i / 8 - 4));
+			_positions3d[i] = glm::vec3((float)(i % 4 - 2), (float)(i / 4 % 4 - 2), (float)(i / 16 - 2));
+		}
+	}
+
+	void TearDown() override {
+		setSIMDLevel(detectSIMDLevel());
+		core::AbstractTest::TearDown();
+	}
+
+	template<class Vec, class Batch, class Scalar>
+	void compare(const std::vector<Vec>& positions, Batch&& batch, Scalar&& scalar) {
+		for (int l = (int)SIMDLevel::Scalar; l <= (int)SIMDLevel::AVX2; ++l) {
+			const SIMDLevel level = (SIMDLevel)l;
+			if (setSIMDLevel(level) != level) {
+				continue;
+			}
+			std::vector<float> out(positions.size());
+			batch(positions.data(), out.data(), positions.size());
+			for (size_t i = 0; i < positions.size(); ++i) {
+				const float expected = scalar(positions[i]);
+				// bit-identical - not just almost equal
+				ASSERT_EQ(0, memcmp(&expected, &out[i], sizeof(float)))
+						<< "Mismatch at " << i << " for " << simdLevelName(level) << ": " << expected << " vs " << out[i];
+			}
+		}
+	}
+};
+
+TEST_F(SimplexBatchTest, testNoise2D) {
+	compare(_positions2d, [] (const glm::vec2* in, float* out, size_t n) { noise(in, out, n); },
+			[] (const glm::vec2& v) { return noise(v); });
+}
+
+TEST_F(SimplexBatchTest, testNoise3D) {
+	compare(_positions3d, [] (const glm::vec3* in, float* out, size_t n) { noise(in, out, n); },
+			[] (const glm::vec3& v) { return noise(v); });
+}
+
+TEST_F(SimplexBatchTest, testRidgedNoise) {
+	compare(_positions2d, [] (const glm::vec2* in, float* out, size_t n) { ridgedNoise(in, out, n); },
+			[] (const glm::vec2& v) { return ridgedNoise(v); });
+	compare(_positions3d, [] (const glm::vec3* in, float* out, size_t n) { ridgedNoise(in, out, n); },
+			[] (const glm::vec3& v) { return ridgedNoise(v); });
+}
+
+TEST_F(SimplexBatchTest, testFBm) {
+	compare(_positions2d, [] (const glm::vec2* in, float* out, size_t n) { fBm(in, out, n, 6, 2.1f, 0.45f); },
+			[] (const glm::vec2& v) { return fBm(v, 6, 2.1f, 0.45f); });
+	compare(_positions3d, [] (const glm::vec3* in, float* out, size_t n) { fBm(in, out, n, 3, 1.9f, 0.6f); },
+			[] (const glm::vec3& v) { return fBm(v, 3, 1.9f, 0.6f); });
+}
+
+TEST_F(SimplexBatchTest, testEmpty) {
+	noise((const glm::vec2*)nullptr, nullptr, 0u);
+	fBm((const glm::vec3*)nullptr, nullptr, 0u);
+}
+
+}
@@ -5,11 +5,159 @@
 #include "MassQuery.h"
 #include "ISavable.h"
 #include "DBHandler.h"
+#include "Connection.h"
+#include "ScopedConnection.h"
 #include "SQLGenerator.h"
+#include "State.h"
 #include "core/Assert.h"
+#include "core/Log.h"
+#include "core/StringUtil.h"
+#include "core/Trace.h"
+#include <SDL_endian.h>
+#include <unordered_map>
+#include <string.h>
 
 namespace persistence {
 
+namespace {
+
+// seconds between the unix epoch and the postgres epoch (2000-01-01)
+constexpr int64_t PostgresEpochOffset = 946684800;
+
+/**
+ * @brief Writes the rows in the binary format of the postgres @c COPY command
+ * @see https://www.postgresql.org/docs/current/sql-copy.html
+ */
+class CopyBuffer {
+private:
+	std::vector<uint8_t> _buffer;
+
+	inline void append(const void *data, size_t size) {
+		const uint8_t *bytes = (const uint8_t*)data;
+		_buffer.insert(_buffer.end(), bytes, bytes + size);
+	}
+
+	template<class T>
+	static T value(const Model& model, const Field& f) {
+		return f.nulloffset == -1 ? model.getValue<T>(f) : *model.getValuePointer<T>(f);
+	}
+public:
+	CopyBuffer() {
+		static const char signature[] = "PGCOPY\n\377\r\n";
+		// including the terminating null byte
+		append(signature, sizeof(signature));
+		// flags and the length of the header extension
+		addInt(0);
+		addInt(0);
+	}
+
+	inline void addShort(int16_t value) {
+		const uint16_t v = SDL_SwapBE16((uint16_t)value);
+		append(&v, sizeof(v));
+	}
+
+	inline void addInt(int32_t value) {
+		const uint32_t v = SDL_SwapBE32((uint32_t)value);
+		append(&v, sizeof(v));
+	}
+
+	inline void addLong(int64_t value) {
+		const uint64_t v = SDL_SwapBE64((uint64_t)value);
+		append(&v, sizeof(v));
+	}
+
+	inline void addData(const void *data, size_t size) {
+		addInt((int32_t)size);
+		append(data, size);
+	}
+
+	void addRow(const Model& model, int columns) {
+		addShort((int16_t)columns);
+		for (const Field& f : model.fields()) {
+			if (!model.isValid(f)) {
+				continue;
+			}
+			if (model.isNull(f)) {
+				addInt(-1);
+				continue;
+			}
+			switch (f.type) {
+			case FieldType::PASSWORD:
+			case FieldType::STRING:
+			case FieldType::TEXT: {
+				const core::String& str = value<core::String>(model, f);
+				addData(str.c_str(), str.size());
+				break;
+			}
+			case FieldType::BLOB: {
+				const Blob& blob = value<Blob>(model, f);
+				addData(blob.data, blob.length);
+				break;
+			}
+			case FieldType::LONG:
+				addInt(8);
+				addLong(value<int64_t>(model, f));
+				break;
+			case FieldType::INT:
+				addInt(4);
+				addInt(value<int32_t>(model, f));
+				break;
+			case FieldType::SHORT:
+				addInt(2);
+				addShort(value<int16_t>(model, f));
+				break;
+			case FieldType::BYTE:
+				// same conversion as for the bound parameters
+				addInt(2);
+				addShort((int8_t)value<uint8_t>(model, f));
+				break;
+			case FieldType::DOUBLE: {
+				const double d = value<double>(model, f);
+				int64_t bits;
+				memcpy(&bits, &d, sizeof(bits));
+				addInt(8);
+				addLong(bits);
+				break;
+			}
+			case FieldType::BOOLEAN: {
+				const uint8_t b = value<bool>(model, f) ? 1u : 0u;
+				addData(&b, sizeof(b));
+				break;
+			}
+			case FieldType::TIMESTAMP: {
+				const Timestamp& ts = value<Timestamp>(model, f);
+				addInt(8);
+				addLong(((int64_t)ts.seconds() - PostgresEpochOffset) * (int64_t)1000000);
+				break;
+			}
+			case FieldType::MAX:
+				addInt(-1);
+				break;
+			}
+		}
+	}
+
+	inline const std::vector<uint8_t>& finish() {
+		addShort(-1);
+		return _buffer;
+	}
+};
+
+/**
+ * @brief The name of the prepared statement - the shape is hashed to stay below the max identifier length
+ */
+core::String statementName(char type, int rows, const core::String& shape) {
+	// fnv-1a
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0u; i < shape.size(); ++i) {
+		hash ^= (uint8_t)shape[i];
+		hash *= 1099511628211ull;
+	}
+	return core::string::format("massquery_%c%i_%016llx", type, rows, (unsigned long long)hash);
+}
+
+}
+
 MassQuery::MassQuery(const DBHandler* dbHandler, size_t amount) :
 		_dbHandler(dbHandler), _commitSize(amount) {
 	_insertOrUpdate.reserve(_commitSize);
@@ -20,16 +168,154 @@ MassQuery::~MassQuery() {
 	commit();
 }
 
-void MassQuery::commit() {
-	// TODO: how to handle the error state here?
-	if (!_insertOrUpdate.empty()) {
-		_dbHandler->insert(_insertOrUpdate);
-		_insertOrUpdate.clear();
+void MassQuery::group(const std::vector<const Model*>& models, std::vector<Group>& groups) {
+	std::unordered_map<core::String, size_t, core::StringHash> indices;
+	core::String shape;
+	for (const Model* m : models) {
+		shape.clear();
+		createStatementShape(*m, shape);
+		auto i = indices.find(shape);
+		if (i == indices.end()) {
+			i = indices.emplace(shape, groups.size()).first;
+			groups.push_back(Group{shape, {}});
+		}
+		groups[i->second].models.push_back(m);
+	}
+}
+
+bool MassQuery::exec(Connection* c, const char *statement) {
+	State s(c);
+	if (!s.exec(statement)) {
+		Log::error("Failed to execute query '%s'", statement);
+		return false;
+	}
+	return true;
+}
+
+bool MassQuery::execPrepared(Connection* c, const core::String& name, const core::String& statement, const BindParam& params) {
+	if (!c->hasPreparedStatement(name)) {
+		State prepare(c);
+		if (!prepare.prepare(name.c_str(), statement.c_str(), params.position)) {
+			Log::error("Failed to prepare query '%s'", statement.c_str());
+			return false;
+		}
+	}
+	State s(c);
+	if (!s.execPrepared(name.c_str(), params.position, &params.values[0], &params.lengths[0], &params.formats[0])) {
+		Log::error("Failed to execute prepared statement %s", name.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool MassQuery::insertPrepared(Connection* c, const Model* const* models, int amount, const core::String& shape) const {
+	const core::String& name = statementName('i', amount, shape);
+	BindParam params((int)models[0]->fields().size() * amount);
+	for (int i = 0; i < amount; ++i) {
+		bindInsertValues(*models[i], params);
 	}
-	if (!_delete.empty()) {
-		_dbHandler->deleteModels(_delete);
+	core::String statement;
+	if (!c->hasPreparedStatement(name)) {
+		statement = createInsertStatement(std::vector<const Model*>(models, models + amount));
+	}
+	return execPrepared(c, name, statement, params);
+}
+
+bool MassQuery::insertCopy(Connection* c, const Group& group, int groupIndex) const {
+	core_trace_scoped(MassQueryCopy);
+	const Model& model = *group.models.front();
+	const core::String& stagingTable = core::string::format("%s_staging%i", model.tableName(), groupIndex);
+	if (!exec(c, createStagingTableStatement(model, stagingTable.c_str()).c_str())) {
+		return false;
+	}
+	int columns = 0;
+	for (const Field& f : model.fields()) {
+		if (model.isValid(f)) {
+			++columns;
+		}
+	}
+	CopyBuffer buffer;
+	for (const Model* m : group.models) {
+		buffer.addRow(*m, columns);
+	}
+	const std::vector<uint8_t>& data = buffer.finish();
+	const core::String& copy = createCopyStatement(model, stagingTable.c_str());
+	State s(c);
+	if (!s.copy(copy.c_str(), data.data(), data.size())) {
+		Log::error("Failed to copy %i rows into %s", (int)group.models.size(), stagingTable.c_str());
+		return false;
+	}
+	return exec(c, createInsertFromStagingStatement(model, stagingTable.c_str()).c_str());
+}
+
+bool MassQuery::insert(Connection* c, const Group& group, int groupIndex) const {
+	const int size = (int)group.models.size();
+	if ((size_t)size >= CopyThreshold && isCopySupported(*group.models.front())) {
+		return insertCopy(c, group, groupIndex);
+	}
+	const Model* const* models = group.models.data();
+	int offset = 0;
+	while (offset < size) {
+		int amount = MaxPreparedRows;
+		while (amount > size - offset) {
+			amount /= 2;
+		}
+		if (!insertPrepared(c, models + offset, amount, group.shape)) {
+			return false;
+		}
+		offset += amount;
+	}
+	return true;
+}
+
+bool MassQuery::remove(Connection* c, const Group& group) const {
+	const core::String& name = statementName('d', 1, group.shape);
+	core::String statement;
+	if (!c->hasPreparedStatement(name)) {
+		statement = createDeleteStatement(*group.models.front());
+	}
+	for (const Model* m : group.models) {
+		BindParam params((int)m->primaryKeys().size() + 1);
+		bindPrimaryKeys(*m, params);
+		if (!execPrepared(c, name, statement, params)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool MassQuery::commit() {
+	if (_insertOrUpdate.empty() && _delete.empty()) {
+		return true;
+	}
+	core_trace_scoped(MassQueryCommit);
+	ScopedConnection scoped(_dbHandler->_connectionPool, _dbHandler->connection());
+	if (!scoped) {
+		Log::error("Could not commit %i models - could not acquire connection", (int)(_insertOrUpdate.size() + _delete.size()));
+		_insertOrUpdate.clear();
 		_delete.clear();
+		return false;
+	}
+	Connection* c = scoped.connection();
+	bool state = exec(c, createTransactionBegin());
+	std::vector<Group> groups;
+	group(_insertOrUpdate, groups);
+	for (size_t i = 0u; state && i < groups.size(); ++i) {
+		state = insert(c, groups[i], (int)i);
+	}
+	groups.clear();
+	group(_delete, groups);
+	for (size_t i = 0u; state && i < groups.size(); ++i) {
+		state = remove(c, groups[i]);
+	}
+	if (state) {
+		state = exec(c, createTransactionCommit());
+	} else {
+		exec(c, createTransactionRollback());
 	}
+	_insertOrUpdate.clear();
+	_delete.clear();
+	return state;
 }
 
 void MassQuery::add(ISavable* savable) {
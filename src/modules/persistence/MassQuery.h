@@ -5,6 +5,8 @@
 #pragma once
 
 #include "BindParam.h"
+#include "ForwardDecl.h"
+#include "core/String.h"
 #include <memory>
 #include <vector>
 
@@ -15,9 +17,28 @@ class DBHandler;
 
 /**
  * @brief Implements mass updates for @c ISavable instances.
+ *
+ * The models are grouped by their table and the statement they lead to (see @c createStatementShape()).
+ * The groups are written in one transaction with prepared statements that are cached per connection.
+ * Groups with at least @c CopyThreshold models that can be copied (see @c isCopySupported()) are sent
+ * in the binary @c COPY format into a staging table and are inserted or updated from there.
  */
 class MassQuery {
+public:
+	/**
+	 * @brief The min amount of models of one group that are sent via @c COPY
+	 */
+	static constexpr size_t CopyThreshold = 256u;
+	/**
+	 * @brief The max amount of rows that are inserted with one prepared statement. Smaller amounts
+	 * are split into powers of two to limit the amount of prepared statements.
+	 */
+	static constexpr int MaxPreparedRows = 64;
 private:
+	struct Group {
+		core::String shape;
+		std::vector<const Model*> models;
+	};
 	const DBHandler * const _dbHandler;
 	const size_t _commitSize;
 	std::vector<const Model*> _insertOrUpdate;
@@ -25,11 +46,22 @@ private:
 	friend class DBHandler;
 	MassQuery(const DBHandler* dbHandler, size_t amount = 1000);
 
+	static void group(const std::vector<const Model*>& models, std::vector<Group>& groups);
+	static bool exec(Connection* c, const char *statement);
+	static bool execPrepared(Connection* c, const core::String& name, const core::String& statement, const BindParam& params);
+	bool insertPrepared(Connection* c, const Model* const* models, int amount, const core::String& shape) const;
+	bool insertCopy(Connection* c, const Group& group, int groupIndex) const;
+	bool insert(Connection* c, const Group& group, int groupIndex) const;
+	bool remove(Connection* c, const Group& group) const;
+
 public:
 	~MassQuery();
 
 	void add(ISavable* savable);
-	void commit();
+	/**
+	 * @return @c false if the models couldn't get written - the transaction was rolled back in this case
+	 */
+	bool commit();
 };
 
 }
@@ -66,7 +66,9 @@ void PersistenceMgr::update(long dt) {
 		for (ISavable *savable : collection.second) {
 			stmt.add(savable);
 		}
-		stmt.commit();
+		if (!stmt.commit()) {
+			Log::warn(logid, "Failed to persist the dirty states of %i savables", (int)collection.second.size());
+		}
 	}
 	Log::debug(logid, "Persisted dirty states of %i savables", (int)_savables.size());
 }
@@ -58,6 +58,20 @@ static inline void createSequenceIdentifier(core::String& stmt, const Model& tab
 	stmt += "_seq\"";
 }
 
+/**
+ * @return @c false if the value is not bound as parameter but is part of the statement (NULL or NOW())
+ */
+static inline bool isParameter(const Model& table, const Field& field) {
+	if (table.isNull(field)) {
+		return false;
+	}
+	if (field.type == FieldType::TIMESTAMP) {
+		const Timestamp& ts = field.nulloffset == -1 ? table.getValue<Timestamp>(field) : *table.getValuePointer<Timestamp>(field);
+		return !ts.isNow();
+	}
+	return true;
+}
+
 static inline bool placeholder(const Model& table, const Field& field, core::String& ss, int count, bool select) {
 	if (table.isNull(field)) {
 		core_assert(!field.isNotNull());
@@ -900,6 +914,113 @@ core::String createInsertStatement(const Model& model, BindParam* params, int* p
 	return createInsertStatement({&model}, params, parameterCount);
 }
 
+void createStatementShape(const Model& model, core::String& shape) {
+	shape += model.schema();
+	shape += ".";
+	shape += model.tableName();
+	shape += ":";
+	for (const persistence::Field& f : model.fields()) {
+		if (!model.isValid(f)) {
+			shape += "-";
+		} else if (model.isNull(f)) {
+			shape += "n";
+		} else if (!isParameter(model, f)) {
+			shape += "t";
+		} else {
+			shape += "v";
+		}
+	}
+}
+
+void bindInsertValues(const Model& model, BindParam& params) {
+	for (const persistence::Field& f : model.fields()) {
+		if (!model.isValid(f) || !isParameter(model, f)) {
+			continue;
+		}
+		params.push(model, f);
+	}
+}
+
+void bindPrimaryKeys(const Model& model, BindParam& params) {
+	for (const persistence::Field& f : model.fields()) {
+		if (!model.isValid(f) || !f.isPrimaryKey() || !isParameter(model, f)) {
+			continue;
+		}
+		params.push(model, f);
+	}
+}
+
+static void createColumnList(core::String& stmt, const Model& table) {
+	int columns = 0;
+	for (const persistence::Field& f : table.fields()) {
+		if (!table.isValid(f)) {
+			continue;
+		}
+		if (columns > 0) {
+			stmt += ", ";
+		}
+		stmt += "\"";
+		stmt += f.name;
+		stmt += "\"";
+		++columns;
+	}
+}
+
+bool isCopySupported(const Model& table) {
+	for (const persistence::Field& f : table.fields()) {
+		if (!table.isValid(f) || table.isNull(f)) {
+			continue;
+		}
+		// the value is only known to the server
+		if (f.type == FieldType::PASSWORD || !isParameter(table, f)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+core::String createStagingTableStatement(const Model& table, const char *stagingTable) {
+	core::String stmt;
+	stmt += "CREATE TEMPORARY TABLE \"";
+	stmt += stagingTable;
+	stmt += "\" ON COMMIT DROP AS SELECT ";
+	createColumnList(stmt, table);
+	stmt += " FROM ";
+	createTableIdentifier(stmt, table);
+	stmt += " WITH NO DATA;";
+	return stmt;
+}
+
+core::String createCopyStatement(const Model& table, const char *stagingTable) {
+	core::String stmt;
+	stmt += "COPY \"";
+	stmt += stagingTable;
+	stmt += "\" (";
+	createColumnList(stmt, table);
+	stmt += ") FROM STDIN (FORMAT binary);";
+	return stmt;
+}
+
+core::String createInsertFromStagingStatement(const Model& table, const char *stagingTable) {
+	bool primaryKeyIncluded = false;
+	core::String stmt;
+	stmt += createInsertBaseStatement(table, primaryKeyIncluded);
+	stmt += " SELECT ";
+	createColumnList(stmt, table);
+	stmt += " FROM \"";
+	stmt += stagingTable;
+	stmt += "\"";
+	int insertValueIndex = 1;
+	for (const persistence::Field& f : table.fields()) {
+		if (table.isValid(f)) {
+			++insertValueIndex;
+		}
+	}
+	createUpsertStatement(table, stmt, primaryKeyIncluded, insertValueIndex - 1);
+	stmt += ";";
+	return stmt;
+}
+
 // https://www.postgresql.org/docs/current/static/functions-formatting.html
 // https://www.postgresql.org/docs/current/static/functions-datetime.html
 core::String createSelect(const Model& model, BindParam* params) {
@@ -28,6 +28,37 @@ extern core::String createInsertBaseStatement(const Model& table, bool& primaryK
 extern core::String createInsertValuesStatement(const Model& table, BindParam* params, int& insertValueIndex);
 extern core::String createInsertStatement(const Model& model, BindParam* params = nullptr, int* parameterCount = nullptr);
 extern core::String createInsertStatement(const std::vector<const Model*>& tables, BindParam* params = nullptr, int* parameterCount = nullptr);
+extern void createUpsertStatement(const Model& table, core::String& stmt, bool primaryKeyIncluded, int insertValueIndex);
+
+/**
+ * @brief Appends a key to the given string that is the same for all models of the same table that
+ * lead to the same insert, update or delete statement - e.g. to look up prepared statements
+ */
+extern void createStatementShape(const Model& model, core::String& shape);
+/**
+ * @brief Binds the parameters of the statement that @c createInsertStatement() creates for the model
+ */
+extern void bindInsertValues(const Model& model, BindParam& params);
+/**
+ * @brief Binds the parameters of the statement that @c createDeleteStatement() creates for the model
+ */
+extern void bindPrimaryKeys(const Model& model, BindParam& params);
+
+/**
+ * @return @c false if the values of the model can't get transferred with @c COPY - e.g. because
+ * they are created by the server (passwords, @c NOW() timestamps)
+ */
+extern bool isCopySupported(const Model& table);
+/**
+ * @brief Creates a temporary table with the columns of the valid fields that is dropped with the end of
+ * the transaction
+ */
+extern core::String createStagingTableStatement(const Model& table, const char *stagingTable);
+extern core::String createCopyStatement(const Model& table, const char *stagingTable);
+/**
+ * @brief Inserts or updates the rows of the given staging table into the table of the model
+ */
+extern core::String createInsertFromStagingStatement(const Model& table, const char *stagingTable);
 
 extern core::String createSelect(const Model& model, BindParam* params = nullptr);
 extern const char* createTransactionBegin();
@@ -71,6 +71,42 @@ bool State::execPrepared(const char *name, int parameterCount, const char *const
 	return result;
 }
 
+bool State::copy(const char *statement, const uint8_t *data, size_t size) {
+	ConnectionType* c = _connection->connection();
+#ifdef HAVE_POSTGRES
+	res = PQexec(c, statement);
+	if (res == nullptr || PQresultStatus(res) != PGRES_COPY_IN) {
+		checkLastResult(c);
+		Log::error("Failed to start the copy: '%s'", statement);
+		result = false;
+		return false;
+	}
+	PQclear(res);
+	res = nullptr;
+	// send the data in slices - the size parameter of the api is an int
+	const size_t sliceSize = 1024u * 1024u;
+	bool sent = true;
+	for (size_t offset = 0u; offset < size && sent; offset += sliceSize) {
+		const size_t remaining = size - offset;
+		const int len = (int)(remaining < sliceSize ? remaining : sliceSize);
+		sent = PQputCopyData(c, (const char*)data + offset, len) == 1;
+	}
+	if (PQputCopyEnd(c, sent ? nullptr : "Failed to send the data") != 1) {
+		sent = false;
+	}
+	res = PQgetResult(c);
+	checkLastResult(c);
+	// the result of the copy is followed by a null result
+	while (ResultType* r = PQgetResult(c)) {
+		PQclear(r);
+	}
+	result &= sent;
+#else
+	checkLastResult(c);
+#endif
+	return result;
+}
+
 bool State::isBool(const char *value) {
 	return *value == '1' || *value == 't' || *value == 'y' || *value == 'o' || *value == 'T';
 }
@@ -8,6 +8,8 @@
 #include "core/NonCopyable.h"
 #include "FieldType.h"
 #include "core/String.h"
+#include <stdint.h>
+#include <stddef.h>
 
 namespace persistence {
 
@@ -34,6 +36,13 @@ public:
 	bool exec(const char* statement, int parameterCount = 0, const char *const *paramValues = nullptr, const int *paramLengths = nullptr, const int *paramFormats = nullptr);
 	bool prepare(const char *name, const char* statement, int parameterCount);
 	bool execPrepared(const char *name, int parameterCount, const char *const *paramValues = nullptr, const int *paramLengths = nullptr, const int *paramFormats = nullptr);
+	/**
+	 * @brief Executes a @c COPY ... @c FROM @c STDIN statement and sends the given data
+	 * @param[in] statement The copy statement
+	 * @param[in] data The data in the format that was specified in the copy statement
+	 * @param[in] size The size of the data in bytes
+	 */
+	bool copy(const char *statement, const uint8_t *data, size_t size);
 
 	/**
 	 * @param[in] colIndex The column index of the current row. Starting at index 0 for the first column
@@ -0,0 +1,100 @@
+/**
+ * @file
+ */
+
+#include "core/benchmark/AbstractBenchmark.h"
+#include "core/Var.h"
+#include "core/GameConfig.h"
+#include "persistence/DBHandler.h"
+#include "persistence/ISavable.h"
+#include "persistence/MassQuery.h"
+#include "BlobtestModel.h"
+
+namespace persistence {
+
+/**
+ * @brief Compares the generated sql statements of @c DBHandler::insert() with the prepared statements
+ * and the @c COPY of the @c MassQuery. Needs a running postgres server - see @c AbstractDatabaseTest
+ * for the connection settings.
+ */
+class MassQueryBenchmark : public core::AbstractBenchmark, public ISavable {
+protected:
+	DBHandlerPtr _dbHandler;
+	std::vector<db::BlobtestModel> _models;
+	bool _supported = false;
+	uint8_t _data[64] {};
+
+	bool onInitApp() override {
+		core::Var::get(cfg::DatabaseMinConnections, "1");
+		core::Var::get(cfg::DatabaseMaxConnections, "2");
+		core::Var::get(cfg::DatabaseName, "enginetest");
+		core::Var::get(cfg::DatabaseHost, "localhost");
+		core::Var::get(cfg::DatabasePort, "5432");
+		core::Var::get(cfg::DatabaseUser, "vengi");
+		core::Var::get(cfg::DatabasePassword, "engine");
+		_dbHandler = std::make_shared<DBHandler>();
+		_supported = _dbHandler->init();
+		if (_supported) {
+			_supported = _dbHandler->createOrUpdateTable(db::BlobtestModel());
+		}
+		return true;
+	}
+
+	void onCleanupApp() override {
+		_dbHandler->shutdown();
+		_dbHandler.reset();
+	}
+
+	bool getDirtyModels(Models& models) override {
+		for (const db::BlobtestModel& m : _models) {
+			models.push_back(&m);
+		}
+		return true;
+	}
+
+	bool prepare(benchmark::State& state) {
+		if (!_supported) {
+			state.SkipWithError("No database connection");
+			return false;
+		}
+		_models.clear();
+		_models.resize(state.range(0));
+		for (int64_t i = 0; i < state.range(0); ++i) {
+			_models[i].setId((int32_t)i);
+			_models[i].setData(Blob(_data, sizeof(_data)));
+		}
+		return _dbHandler->truncate(db::BlobtestModel());
+	}
+};
+
+BENCHMARK_DEFINE_F(MassQueryBenchmark, insertStatement) (benchmark::State& state) {
+	if (!prepare(state)) {
+		return;
+	}
+	std::vector<const Model*> models;
+	for (auto _ : state) {
+		models.clear();
+		getDirtyModels(models);
+		_dbHandler->insert(models);
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_DEFINE_F(MassQueryBenchmark, massQuery) (benchmark::State& state) {
+	if (!prepare(state)) {
+		return;
+	}
+	for (auto _ : state) {
+		MassQuery stmt = _dbHandler->massQuery();
+		stmt.add(this);
+		stmt.commit();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_REGISTER_F(MassQueryBenchmark, insertStatement)->RangeMultiplier(4)->Range(16, 4096);
+BENCHMARK_REGISTER_F(MassQueryBenchmark, massQuery)->RangeMultiplier(4)->Range(16, 4096);
+
+}
+
+BENCHMARK_MAIN();
@@ -57,6 +57,9 @@ void postgresShutdown() {
 	PQsetNoticeProcessor = nullptr;
 	PQflush = nullptr;
 	PQfname = nullptr;
+	PQputCopyData = nullptr;
+	PQputCopyEnd = nullptr;
+	PQgetResult = nullptr;
 #endif
 }
 
@@ -123,11 +126,15 @@ bool postgresInit() {
 	DYNLOAD(obj, PQsetNoticeProcessor);
 	DYNLOAD(obj, PQflush);
 	DYNLOAD(obj, PQfname);
+	DYNLOAD(obj, PQputCopyData);
+	DYNLOAD(obj, PQputCopyEnd);
+	DYNLOAD(obj, PQgetResult);
 
 	if (PQescapeStringConn == nullptr || PQexec == nullptr
 			|| PQinitSSL == nullptr || PQsetdbLogin == nullptr
 			|| PQsslInUse == nullptr || PQsetNoticeProcessor == nullptr
-			|| PQflush == nullptr || PQfname == nullptr || PQunescapeBytea == nullptr) {
+			|| PQflush == nullptr || PQfname == nullptr || PQunescapeBytea == nullptr
+			|| PQputCopyData == nullptr || PQputCopyEnd == nullptr || PQgetResult == nullptr) {
 		Log::error("Could not load all the needed symbols from libpg");
 		return false;
 	}
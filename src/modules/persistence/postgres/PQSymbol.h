@@ -60,6 +60,9 @@ DYNDEFINE(PQsslInUse);
 DYNDEFINE(PQsetNoticeProcessor);
 DYNDEFINE(PQflush);
 DYNDEFINE(PQfname);
+DYNDEFINE(PQputCopyData);
+DYNDEFINE(PQputCopyEnd);
+DYNDEFINE(PQgetResult);
 #undef DYNDEFINE
 #endif
 }
@@ -5,7 +5,10 @@
 #include "AbstractDatabaseTest.h"
 #include "persistence/PersistenceMgr.h"
 #include "TestModels.h"
+#include "BlobtestModel.h"
+#include "persistence/MassQuery.h"
 #include "core/FourCC.h"
+#include "core/StringUtil.h"
 
 namespace persistence {
 
@@ -140,4 +143,43 @@ TEST_F(PersistenceMgrTest, testSavableRelativeUpdateNegative) {
 	relativeUpdate(mgr, create(), 100, -110);
 }
 
+TEST_F(PersistenceMgrTest, testSavableMassUpdate) {
+	if (!_supported) {
+		return;
+	}
+	ASSERT_TRUE(_dbHandler->createOrUpdateTable(db::BlobtestModel()));
+	ASSERT_TRUE(_dbHandler->truncate(db::BlobtestModel()));
+	// more than MassQuery::CopyThreshold models - the blobs are copied, the test models need
+	// the server to encrypt the password and are inserted with prepared statements
+	const int amount = (int)MassQuery::CopyThreshold + 3;
+	std::vector<db::TestModel> testModels;
+	std::vector<db::BlobtestModel> blobModels(amount);
+	uint8_t data[] = {1, 2, 3, 4};
+	for (int i = 0; i < amount; ++i) {
+		testModels.push_back(create(i + 1, core::string::format("%i", i)));
+		blobModels[i].setId(i);
+		blobModels[i].setData(Blob(data, sizeof(data)));
+	}
+	for (int i = 0; i < amount; ++i) {
+		_dirtyModels.push_back(&testModels[i]);
+		_dirtyModels.push_back(&blobModels[i]);
+	}
+	PersistenceMgr mgr(_dbHandler);
+	EXPECT_TRUE(mgr.init());
+	EXPECT_TRUE(mgr.registerSavable(FourCC('F','O','O','O'), this));
+	mgr.update(0l);
+	EXPECT_TRUE(mgr.unregisterSavable(FourCC('F','O','O','O'), this));
+	mgr.shutdown();
+	int found = 0;
+	EXPECT_TRUE(_dbHandler->select(db::TestModel(), DBConditionOne(), [&] (db::TestModel&& mdl) {
+		++found;
+	}));
+	EXPECT_EQ(amount, found);
+	found = 0;
+	EXPECT_TRUE(_dbHandler->select(db::BlobtestModel(), DBConditionOne(), [&] (db::BlobtestModel&& mdl) {
+		++found;
+	}));
+	EXPECT_EQ(amount, found);
+}
+
 }
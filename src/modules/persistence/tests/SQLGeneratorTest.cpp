@@ -105,4 +105,75 @@ TEST_F(SQLGeneratorTest, testInsertMultiple) {
 	ASSERT_EQ(amount * 3, p.position);
 }
 
+TEST_F(SQLGeneratorTest, testStatementShape) {
+	db::TestModel model1;
+	model1.setId(1);
+	model1.setPoints(2);
+	db::TestModel model2;
+	model2.setId(3);
+	model2.setPoints(4);
+	db::TestModel model3;
+	model3.setId(3);
+	model3.setName("testname");
+	core::String shape1;
+	createStatementShape(model1, shape1);
+	core::String shape2;
+	createStatementShape(model2, shape2);
+	core::String shape3;
+	createStatementShape(model3, shape3);
+	EXPECT_EQ(shape1, shape2) << "The values must not influence the shape";
+	EXPECT_NE(shape1, shape3) << "The set fields must influence the shape";
+}
+
+TEST_F(SQLGeneratorTest, testBindInsertValues) {
+	db::TestModel model;
+	model.setId(1);
+	model.setName("testname");
+	model.setPassword("secret");
+	model.setRegistrationdate(Timestamp::now());
+	BindParam expected(10);
+	createInsertStatement(model, &expected);
+	BindParam params(10);
+	bindInsertValues(model, params);
+	ASSERT_EQ(3, params.position);
+	ASSERT_EQ(expected.position, params.position);
+	for (int i = 0; i < params.position; ++i) {
+		EXPECT_STREQ(expected.values[i], params.values[i]);
+	}
+}
+
+TEST_F(SQLGeneratorTest, testBindPrimaryKeys) {
+	db::TestModel model;
+	model.setId(1);
+	model.setName("testname");
+	BindParam params(10);
+	bindPrimaryKeys(model, params);
+	ASSERT_EQ(1, params.position);
+	EXPECT_STREQ("1", params.values[0]);
+}
+
+TEST_F(SQLGeneratorTest, testCopyStatements) {
+	db::TestModel model;
+	model.setId(1);
+	model.setPoints(2);
+	ASSERT_TRUE(isCopySupported(model));
+	EXPECT_EQ(R"(CREATE TEMPORARY TABLE "test_staging" ON COMMIT DROP AS SELECT "id", "points" FROM "public"."test" WITH NO DATA;)",
+			createStagingTableStatement(model, "test_staging"));
+	EXPECT_EQ(R"(COPY "test_staging" ("id", "points") FROM STDIN (FORMAT binary);)",
+			createCopyStatement(model, "test_staging"));
+	EXPECT_EQ(R"(INSERT INTO "public"."test" ("id", "points") SELECT "id", "points" FROM "test_staging" ON CONFLICT ("id") DO UPDATE SET "points" = "public"."test"."points" + EXCLUDED."points";)",
+			createInsertFromStagingStatement(model, "test_staging"));
+}
+
+TEST_F(SQLGeneratorTest, testCopyNotSupported) {
+	db::TestModel model;
+	model.setId(1);
+	model.setPassword("secret");
+	EXPECT_FALSE(isCopySupported(model)) << "Passwords are encrypted by the server";
+	db::TestModel model2;
+	model2.setId(1);
+	model2.setRegistrationdate(Timestamp::now());
+	EXPECT_FALSE(isCopySupported(model2)) << "NOW() timestamps are created by the server";
+}
+
 }
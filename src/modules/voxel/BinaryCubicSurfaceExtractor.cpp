@@ -0,0 +1,256 @@
+/**
+ * @file
+ */
+
+#include "BinaryCubicSurfaceExtractor.h"
+#include "core/Trace.h"
+#include <glm/integer.hpp>
+
+namespace voxel {
+
+// see CubicSurfaceExtractor - the voxels that are taken into account for the ambient occlusion
+static inline bool isOccluding(const Voxel& voxel) {
+	const VoxelType material = voxel.getMaterial();
+	return !isAir(material) && !isWater(material);
+}
+
+const BinaryCubicMesher::SliceAxes BinaryCubicMesher::_axes[NoOfFaces] = {
+	{0, 2, 1, false}, // PositiveX
+	{1, 2, 0, false}, // PositiveY
+	{2, 0, 1, false}, // PositiveZ
+	{0, 2, 1, true},  // NegativeX
+	{1, 2, 0, true},  // NegativeY
+	{2, 0, 1, true}   // NegativeZ
+};
+
+BinaryCubicMesher::BinaryCubicMesher(const Region& region) :
+		_size(region.getDimensionsInVoxels()), _paddedSize(_size + 2) {
+	_voxels.resize(_paddedSize.x * _paddedSize.y * _paddedSize.z);
+}
+
+void BinaryCubicMesher::allocateMasks() {
+	for (int f = 0; f < NoOfFaces; ++f) {
+		const SliceAxes& axes = _axes[f];
+		_masks[f].assign(_size[axes.normal] * _size[axes.u] * words(_size[axes.v]), 0u);
+	}
+}
+
+void BinaryCubicMesher::cullFaces() {
+	core_trace_scoped(BinaryCullFaces);
+	allocateMasks();
+
+	// the occupancy of the columns (along y) and the rows (along x) of the padded region
+	const int yWords = words(_size.y);
+	const int xWords = words(_size.x);
+	std::vector<uint64_t> columns(_paddedSize.x * _paddedSize.z * yWords, 0u);
+	std::vector<uint64_t> rows(_paddedSize.y * _paddedSize.z * xWords, 0u);
+	const Voxel* voxels = _voxels.data();
+	for (int pz = 0; pz < _paddedSize.z; ++pz) {
+		for (int px = 0; px < _paddedSize.x; ++px) {
+			uint64_t* column = &columns[(pz * _paddedSize.x + px) * yWords];
+			const int x = px - 1;
+			for (int py = 0; py < _paddedSize.y; ++py, ++voxels) {
+				if (!isOccluding(*voxels)) {
+					continue;
+				}
+				const int y = py - 1;
+				if (y >= 0 && y < _size.y) {
+					column[y >> 6] |= 1ull << (y & 63);
+				}
+				if (x >= 0 && x < _size.x) {
+					rows[(pz * _paddedSize.y + py) * xWords + (x >> 6)] |= 1ull << (x & 63);
+				}
+			}
+		}
+	}
+	auto column = [&] (int x, int z) {
+		return &columns[((z + 1) * _paddedSize.x + (x + 1)) * yWords];
+	};
+	auto row = [&] (int y, int z) {
+		return &rows[((z + 1) * _paddedSize.y + (y + 1)) * xWords];
+	};
+
+	// a quad is needed where an occluding voxel is next to a non occluding one
+	for (int x = 0; x < _size.x; ++x) {
+		for (int z = 0; z < _size.z; ++z) {
+			const uint64_t* current = column(x, z);
+			const uint64_t* left = column(x - 1, z);
+			uint64_t* negative = mask(NegativeX, x, z);
+			uint64_t* positive = mask(PositiveX, x, z);
+			for (int w = 0; w < yWords; ++w) {
+				negative[w] = current[w] & ~left[w];
+				positive[w] = left[w] & ~current[w];
+			}
+		}
+	}
+	for (int z = 0; z < _size.z; ++z) {
+		for (int x = 0; x < _size.x; ++x) {
+			const uint64_t* current = column(x, z);
+			const uint64_t* before = column(x, z - 1);
+			uint64_t* negative = mask(NegativeZ, z, x);
+			uint64_t* positive = mask(PositiveZ, z, x);
+			for (int w = 0; w < yWords; ++w) {
+				negative[w] = current[w] & ~before[w];
+				positive[w] = before[w] & ~current[w];
+			}
+		}
+	}
+	for (int y = 0; y < _size.y; ++y) {
+		for (int z = 0; z < _size.z; ++z) {
+			const uint64_t* current = row(y, z);
+			const uint64_t* below = row(y - 1, z);
+			uint64_t* negative = mask(NegativeY, y, z);
+			uint64_t* positive = mask(PositiveY, y, z);
+			for (int w = 0; w < xWords; ++w) {
+				negative[w] = current[w] & ~below[w];
+				positive[w] = below[w] & ~current[w];
+			}
+		}
+	}
+}
+
+uint16_t BinaryCubicMesher::quadKey(FaceNames face, int slice, int u, int v) const {
+	const SliceAxes& axes = _axes[face];
+	glm::ivec3 back;
+	glm::ivec3 front;
+	quadVoxels(face, slice, u, v, back, front);
+	uint16_t key = voxel(back).getColor();
+	// the ambient occlusion is calculated from the voxels in front of the quad
+	for (int du = 0; du <= 1; ++du) {
+		for (int dv = 0; dv <= 1; ++dv) {
+			glm::ivec3 side1 = front;
+			side1[axes.u] += du ? 1 : -1;
+			glm::ivec3 side2 = front;
+			side2[axes.v] += dv ? 1 : -1;
+			glm::ivec3 corner = side1;
+			corner[axes.v] += dv ? 1 : -1;
+			const uint8_t ao = vertexAmbientOcclusion(isOccluding(voxel(side1)), isOccluding(voxel(side2)), isOccluding(voxel(corner)));
+			key |= ao << (8 + (du * 2 + dv) * 2);
+		}
+	}
+	return key;
+}
+
+void BinaryCubicMesher::addQuad(Mesh* result, FaceNames face, int slice, int u, int v, int width, int height, uint16_t key, const glm::ivec3& translate) const {
+	// the corners (u, v) of the quad in the vertex order of the CubicSurfaceExtractor - this defines the winding
+	static constexpr int CornersA[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+	static constexpr int CornersB[4][2] = {{0, 0}, {0, 1}, {1, 1}, {1, 0}};
+	const bool orderA = face == NegativeX || face == PositiveY || face == PositiveZ;
+	const int (*corners)[2] = orderA ? CornersA : CornersB;
+	const SliceAxes& axes = _axes[face];
+
+	IndexType indices[4];
+	uint8_t ambientOcclusion[4];
+	for (int i = 0; i < 4; ++i) {
+		const int du = corners[i][0];
+		const int dv = corners[i][1];
+		glm::ivec3 pos;
+		pos[axes.normal] = slice;
+		pos[axes.u] = u + du * width;
+		pos[axes.v] = v + dv * height;
+		VoxelVertex vertex;
+		vertex.position = pos + translate;
+		vertex.colorIndex = key & 0xFF;
+		vertex.ambientOcclusion = (key >> (8 + (du * 2 + dv) * 2)) & 3;
+		ambientOcclusion[i] = vertex.ambientOcclusion;
+		indices[i] = result->addVertex(vertex);
+	}
+
+	// see meshify() and isQuadFlipped()
+	if (ambientOcclusion[3] + ambientOcclusion[1] > ambientOcclusion[0] + ambientOcclusion[2]) {
+		result->addTriangle(indices[1], indices[2], indices[3]);
+		result->addTriangle(indices[1], indices[3], indices[0]);
+	} else {
+		result->addTriangle(indices[0], indices[1], indices[2]);
+		result->addTriangle(indices[0], indices[2], indices[3]);
+	}
+}
+
+void BinaryCubicMesher::meshifySlice(Mesh* result, FaceNames face, int slice, bool mergeQuads, const glm::ivec3& translate) {
+	const SliceAxes& axes = _axes[face];
+	const int uSize = _size[axes.u];
+	const int vSize = _size[axes.v];
+	const int vWords = words(vSize);
+	uint64_t* masks = mask(face, slice, 0);
+
+	uint64_t any = 0u;
+	for (int i = 0; i < uSize * vWords; ++i) {
+		any |= masks[i];
+	}
+	if (any == 0u) {
+		return;
+	}
+
+	if (!mergeQuads) {
+		for (int u = 0; u < uSize; ++u) {
+			for (int w = 0; w < vWords; ++w) {
+				for (uint64_t bits = masks[u * vWords + w]; bits != 0u; bits &= bits - 1u) {
+					const int v = w * 64 + glm::findLSB(bits);
+					addQuad(result, face, slice, u, v, 1, 1, quadKey(face, slice, u, v), translate);
+				}
+			}
+		}
+		return;
+	}
+
+	_keys.resize(uSize * vSize);
+	for (int u = 0; u < uSize; ++u) {
+		for (int w = 0; w < vWords; ++w) {
+			for (uint64_t bits = masks[u * vWords + w]; bits != 0u; bits &= bits - 1u) {
+				const int v = w * 64 + glm::findLSB(bits);
+				_keys[u * vSize + v] = quadKey(face, slice, u, v);
+			}
+		}
+	}
+
+	// the masks are consumed here - every bit that is part of a quad is cleared
+	for (int u = 0; u < uSize; ++u) {
+		const uint16_t* keys = &_keys[u * vSize];
+		for (int w = 0; w < vWords; ++w) {
+			uint64_t& bits = masks[u * vWords + w];
+			while (bits != 0u) {
+				const int start = glm::findLSB(bits);
+				const int v = w * 64 + start;
+				const uint16_t key = keys[v];
+				// grow along v as long as the bits are set and the quads look the same
+				int height = 1;
+				while (start + height < 64 && (bits & (1ull << (start + height))) != 0u && keys[v + height] == key) {
+					++height;
+				}
+				const uint64_t run = (height == 64 ? ~0ull : ((1ull << height) - 1ull)) << start;
+				bits &= ~run;
+
+				// grow along u as long as the next row contains the same run
+				int width = 1;
+				for (; u + width < uSize; ++width) {
+					uint64_t& next = masks[(u + width) * vWords + w];
+					if ((next & run) != run) {
+						break;
+					}
+					const uint16_t* nextKeys = &_keys[(u + width) * vSize + v];
+					int i = 0;
+					while (i < height && nextKeys[i] == key) {
+						++i;
+					}
+					if (i < height) {
+						break;
+					}
+					next &= ~run;
+				}
+				addQuad(result, face, slice, u, v, width, height, key, translate);
+			}
+		}
+	}
+}
+
+void BinaryCubicMesher::meshify(Mesh* result, const glm::ivec3& translate, bool mergeQuads) {
+	core_trace_scoped(BinaryMeshify);
+	for (int f = 0; f < NoOfFaces; ++f) {
+		const FaceNames face = (FaceNames)f;
+		for (int slice = 0; slice < _size[_axes[face].normal]; ++slice) {
+			meshifySlice(result, face, slice, mergeQuads, translate);
+		}
+	}
+}
+
+}
@@ -0,0 +1,182 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "CubicSurfaceExtractor.h"
+#include "IsQuadNeeded.h"
+#include <type_traits>
+#include <vector>
+
+namespace voxel {
+
+/**
+ * @brief The state of the binary cubic surface extraction - a copy of the voxels of the region (including a border of
+ * one voxel for the neighbours) and one bit per possible quad for each face.
+ *
+ * The quads of a face are organized in slices along the face normal. Each row of a slice is a bitmask with one bit
+ * per voxel. For the default @c IsQuadNeeded criteria the masks are calculated with bitwise operations on the
+ * occupancy masks of the voxel columns. The quads are merged greedily by scanning the bits of the masks.
+ */
+class BinaryCubicMesher {
+public:
+	explicit BinaryCubicMesher(const Region& region);
+
+	/**
+	 * @brief Access to the voxels of the region - @c pos is relative to the lower corner of the region and
+	 * may be one voxel outside of the region.
+	 */
+	inline Voxel& voxel(const glm::ivec3& pos) {
+		return _voxels[index(pos)];
+	}
+
+	inline const Voxel& voxel(const glm::ivec3& pos) const {
+		return _voxels[index(pos)];
+	}
+
+	/**
+	 * @brief Calculates the quad masks with the default @c IsQuadNeeded criteria
+	 */
+	void cullFaces();
+
+	/**
+	 * @brief Calculates the quad masks with a custom criteria - the voxel pairs are checked one by one here
+	 */
+	template<typename IsQuadNeeded>
+	void cullFaces(IsQuadNeeded& isQuadNeeded);
+
+	/**
+	 * @brief Creates the quads for all bits that are set in the quad masks
+	 * @param[in] mergeQuads Merge adjacent quads of the same color and ambient occlusion into bigger quads
+	 */
+	void meshify(Mesh* result, const glm::ivec3& translate, bool mergeQuads);
+
+private:
+	struct SliceAxes {
+		int normal;
+		int u;
+		int v;
+		// @c true for the faces that look into the negative direction of the normal
+		bool negative;
+	};
+	static const SliceAxes _axes[NoOfFaces];
+
+	inline int index(const glm::ivec3& pos) const {
+		// y is the fastest moving coordinate - the voxels of a column are next to each other
+		return ((pos.z + 1) * _paddedSize.x + (pos.x + 1)) * _paddedSize.y + (pos.y + 1);
+	}
+
+	inline int words(int bits) const {
+		return (bits + 63) / 64;
+	}
+
+	/**
+	 * @brief The cell of a quad - the voxel in front of it and behind it
+	 */
+	inline void quadVoxels(FaceNames face, int slice, int u, int v, glm::ivec3& back, glm::ivec3& front) const {
+		const SliceAxes& axes = _axes[face];
+		back[axes.normal] = slice;
+		back[axes.u] = u;
+		back[axes.v] = v;
+		front = back;
+		if (axes.negative) {
+			--front[axes.normal];
+		} else {
+			--back[axes.normal];
+		}
+	}
+
+	inline uint64_t* mask(FaceNames face, int slice, int u) {
+		const SliceAxes& axes = _axes[face];
+		return &_masks[face][(slice * _size[axes.u] + u) * words(_size[axes.v])];
+	}
+
+	void allocateMasks();
+	/**
+	 * @return The color and the ambient occlusion of the four corners of the quad - quads with the same key can be merged
+	 */
+	uint16_t quadKey(FaceNames face, int slice, int u, int v) const;
+	void addQuad(Mesh* result, FaceNames face, int slice, int u, int v, int width, int height, uint16_t key, const glm::ivec3& translate) const;
+	void meshifySlice(Mesh* result, FaceNames face, int slice, bool mergeQuads, const glm::ivec3& translate);
+
+	glm::ivec3 _size;
+	glm::ivec3 _paddedSize;
+	std::vector<Voxel> _voxels;
+	std::vector<uint64_t> _masks[NoOfFaces];
+	// scratch buffer for the merge keys of one slice
+	std::vector<uint16_t> _keys;
+};
+
+template<typename IsQuadNeeded>
+void BinaryCubicMesher::cullFaces(IsQuadNeeded& isQuadNeeded) {
+	core_trace_scoped(BinaryCullFaces);
+	allocateMasks();
+	for (int f = 0; f < NoOfFaces; ++f) {
+		const FaceNames face = (FaceNames)f;
+		const SliceAxes& axes = _axes[face];
+		for (int slice = 0; slice < _size[axes.normal]; ++slice) {
+			for (int u = 0; u < _size[axes.u]; ++u) {
+				uint64_t* row = mask(face, slice, u);
+				for (int v = 0; v < _size[axes.v]; ++v) {
+					glm::ivec3 back;
+					glm::ivec3 front;
+					quadVoxels(face, slice, u, v, back, front);
+					if (isQuadNeeded(voxel(back).getMaterial(), voxel(front).getMaterial(), face)) {
+						row[v >> 6] |= 1ull << (v & 63);
+					}
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @brief Alternative to @c extractCubicMesh() that produces the same kind of mesh (including the ambient occlusion)
+ * but works on bitmasks instead of sampling the volume for every voxel and merging quad lists.
+ *
+ * The voxels of the region are copied once, the quads are found with bitwise operations on 64 bit voxel
+ * masks and are merged greedily. Quads are not merged across 64 voxel boundaries and vertices are not
+ * shared between quads.
+ *
+ * @sa extractCubicMesh()
+ */
+template<typename VolumeType, typename IsQuadNeeded>
+void extractBinaryCubicMesh(VolumeType* volData, const Region& region, Mesh* result, IsQuadNeeded isQuadNeeded, const glm::ivec3& translate, bool mergeQuads = true) {
+	core_trace_scoped(ExtractBinaryCubicMesh);
+
+	result->clear();
+	const glm::ivec3& offset = region.getLowerCorner();
+	const glm::ivec3& upper = region.getUpperCorner();
+	result->setOffset(offset);
+
+	if (isEmptyUniformRegion(volData, region, isQuadNeeded)) {
+		return;
+	}
+
+	BinaryCubicMesher mesher(region);
+	{
+		core_trace_scoped(BinaryReadVoxels);
+		typename VolumeType::Sampler volumeSampler(volData);
+		for (int32_t z = offset.z - 1; z <= upper.z + 1; ++z) {
+			for (int32_t x = offset.x - 1; x <= upper.x + 1; ++x) {
+				volumeSampler.setPosition(x, offset.y - 1, z);
+				Voxel* column = &mesher.voxel(glm::ivec3(x - offset.x, -1, z - offset.z));
+				for (int32_t y = offset.y - 1; y <= upper.y + 1; ++y) {
+					*column++ = volumeSampler.voxel();
+					volumeSampler.movePositiveY();
+				}
+			}
+		}
+	}
+
+	if constexpr (std::is_same<IsQuadNeeded, voxel::IsQuadNeeded>::value) {
+		mesher.cullFaces();
+	} else {
+		mesher.cullFaces(isQuadNeeded);
+	}
+	mesher.meshify(result, translate, mergeQuads);
+	result->compressIndices();
+}
+
+}
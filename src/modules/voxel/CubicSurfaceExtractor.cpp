@@ -86,17 +86,6 @@ static bool performQuadMerging(QuadList& quads, Mesh* meshCurrent) {
 	return didMerge;
 }
 
-/**
- * @brief We are checking the voxels above us. There are four possible ambient occlusion values
- * for a vertex.
- */
-SDL_FORCE_INLINE uint8_t vertexAmbientOcclusion(bool side1, bool side2, bool corner) {
-	if (side1 && side2) {
-		return 0;
-	}
-	return 3 - (side1 + side2 + corner);
-}
-
 void meshify(Mesh* result, bool mergeQuads, QuadListVector& vecListQuads) {
 	core_trace_scoped(GenerateMeshify);
 	for (QuadList& listQuads : vecListQuads) {
@@ -108,8 +108,45 @@ SDL_FORCE_INLINE bool isQuadFlipped(const VoxelVertex& v00, const VoxelVertex& v
 	return v00.ambientOcclusion + v11.ambientOcclusion > v01.ambientOcclusion + v10.ambientOcclusion;
 }
 
+/**
+ * @brief We are checking the voxels above us. There are four possible ambient occlusion values
+ * for a vertex.
+ */
+SDL_FORCE_INLINE uint8_t vertexAmbientOcclusion(bool side1, bool side2, bool corner) {
+	if (side1 && side2) {
+		return 0;
+	}
+	return 3 - (side1 + side2 + corner);
+}
+
 extern void meshify(Mesh* result, bool mergeQuads, QuadListVector& vecListQuads);
 
+/**
+ * @brief Volumes that know about uniform chunks provide an overload to skip the extraction of regions
+ * that can't have any surface.
+ * @return @c true if all voxels in the given region have the same value
+ */
+template<typename VolumeType>
+inline bool isUniformRegion(const VolumeType* volData, const Region& region, Voxel& voxel) {
+	return false;
+}
+
+/**
+ * @return @c true if the region and its direct neighbours are uniform and don't need any quads
+ */
+template<typename VolumeType, typename IsQuadNeeded>
+bool isEmptyUniformRegion(const VolumeType* volData, const Region& region, IsQuadNeeded& isQuadNeeded) {
+	// the extraction also peeks into the neighbours of the region
+	Voxel uniformVoxel;
+	if (!isUniformRegion(volData, Region(region.getLowerCorner() - 1, region.getUpperCorner() + 1), uniformVoxel)) {
+		return false;
+	}
+	const VoxelType type = uniformVoxel.getMaterial();
+	return !isQuadNeeded(type, type, NegativeX) && !isQuadNeeded(type, type, PositiveX)
+		&& !isQuadNeeded(type, type, NegativeY) && !isQuadNeeded(type, type, PositiveY)
+		&& !isQuadNeeded(type, type, NegativeZ) && !isQuadNeeded(type, type, PositiveZ);
+}
+
 /**
  * The CubicSurfaceExtractor creates a mesh in which each voxel appears to be rendered as a cube
  * Introduction
@@ -208,6 +245,11 @@ void extractCubicMesh(VolumeType* volData, const Region& region, Mesh* result, I
 	const glm::ivec3& upper = region.getUpperCorner();
 	result->setOffset(offset);
 
+	if (isEmptyUniformRegion(volData, region, isQuadNeeded)) {
+		core_trace_scoped(ExtractUniformRegion);
+		return;
+	}
+
 	// Used to avoid creating duplicate vertices.
 	const int widthInCells = upper.x - offset.x;
 	const int heightInCells = upper.y - offset.y;
@@ -391,7 +433,7 @@ void extractCubicMesh(VolumeType* volData, const Region& region, Mesh* result, I
 
 				// Z [F] BEHIND
 				if (isQuadNeeded(voxelBeforeMaterial, voxelCurrentMaterial, PositiveZ)) {
-					const VoxelType _voxelRightBehind      = volumeSampler.peekVoxel1px0py1pz().getMaterial();
+					const VoxelType _voxelRightBehind      = volumeSampler.peekVoxel1px0py0pz().getMaterial();
 					const VoxelType _voxelAboveBehind      = volumeSampler.peekVoxel0px1py0pz().getMaterial();
 					const VoxelType _voxelAboveRightBehind = volumeSampler.peekVoxel1px1py0pz().getMaterial();
 					const VoxelType _voxelBelowRightBehind = volumeSampler.peekVoxel1px1ny0pz().getMaterial();
@@ -7,12 +7,20 @@
 #include "core/Log.h"
 #include "core/Common.h"
 #include "core/Trace.h"
+#include "core/concurrent/ThreadPool.h"
+#include "core/concurrent/Concurrency.h"
 #include "math/Functions.h"
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtc/round.hpp>
 
 namespace voxel {
 
+/**
+ * Page-ins that are triggered from within a pager (e.g. for writing into a neighbouring chunk) are
+ * always executed inline - this avoids waiting for our own worker thread.
+ */
+static thread_local int pagingDepth = 0;
+
 /**
  * This constructor creates a volume with a fixed size which is specified as a parameter. By default this constructor will not enable paging
  * but you can override this if desired. If you do wish to enable
@@ -36,21 +44,26 @@ PagedVolume::PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes, uint16
 	// Use to perform modulo by bit operations
 	_chunkMask = _chunkSideLength - 1;
 
-	// Calculate the number of chunks based on the memory limit and the size of each chunk.
+	// Calculate the number of uncompressed chunks based on the memory limit and the size of each chunk.
 	uint32_t chunkSizeInBytes = PagedVolume::Chunk::calculateSizeInBytes(_chunkSideLength);
-	_chunkCountLimit = targetMemoryUsageInBytes / chunkSizeInBytes;
+	uint32_t chunkCountLimit = targetMemoryUsageInBytes / chunkSizeInBytes;
 
 	// Enforce sensible limits on the number of chunks.
 	const uint32_t minPracticalNoOfChunks = 32; // Enough to make sure a chunks and it's neighbours can be loaded, with a few to spare.
-	if (_chunkCountLimit < minPracticalNoOfChunks) {
+	if (chunkCountLimit < minPracticalNoOfChunks) {
 		Log::warn("Requested memory usage limit of %uMb is too low and cannot be adhered to. Chunk limit is at %i, Chunk size: %uKb",
-				targetMemoryUsageInBytes / (1024 * 1024), _chunkCountLimit, chunkSizeInBytes / 1024);
+				targetMemoryUsageInBytes / (1024 * 1024), chunkCountLimit, chunkSizeInBytes / 1024);
 	}
-	_chunkCountLimit = core_max(_chunkCountLimit, minPracticalNoOfChunks);
+	chunkCountLimit = core_max(chunkCountLimit, minPracticalNoOfChunks);
+	_targetMemoryUsage = (uint64_t)chunkCountLimit * chunkSizeInBytes;
+	_chunkCountLimit = chunkCountLimit * 4u;
+	// compress and evict in batches to not touch the clock on every page-in once the budget is exceeded
+	_lowWaterMemoryUsage = _targetMemoryUsage - _targetMemoryUsage / 8u;
+	_clock.reserve(chunkCountLimit);
 
 	// Inform the user about the chosen memory configuration.
-	Log::info("Memory usage limit for volume now set to %uMb (%u chunks of %uKb each).",
-			(_chunkCountLimit * chunkSizeInBytes) / (1024 * 1024), _chunkCountLimit, chunkSizeInBytes / 1024);
+	Log::info("Memory usage limit for volume now set to %uMb (%u uncompressed chunks of %uKb each).",
+			(uint32_t)(_targetMemoryUsage / (1024 * 1024)), chunkCountLimit, chunkSizeInBytes / 1024);
 }
 
 /**
@@ -58,9 +71,25 @@ PagedVolume::PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes, uint16
  * data via the dataOverflowHandler() if desired.
  */
 PagedVolume::~PagedVolume() {
+	if (_pagingPool != nullptr) {
+		// finish the pending page-ins
+		_pagingPool->shutdown(true);
+		delete _pagingPool;
+		_pagingPool = nullptr;
+	}
 	flushAll();
 }
 
+void PagedVolume::initAsyncPaging(uint32_t threads) {
+	core_assert_msg(_pagingPool == nullptr, "Async paging is already initialized");
+	if (threads == 0u) {
+		return;
+	}
+	_pagingPool = new core::ThreadPool(threads, "PagedVolume");
+	_pagingPool->init();
+	Log::info("Async paging with %u threads", threads);
+}
+
 /**
  * This version of the function is provided so that the wrap mode does not need
  * to be specified as a template parameter, as it may be confusing to some users.
@@ -167,43 +196,223 @@ void PagedVolume::setVoxels(int32_t uXPos, int32_t uYPos, int32_t uZPos, int nx,
 
 /**
  * Removes all voxels from memory by removing all chunks. The application has the chance to persist the data via @c Pager::pageOut
+ * @note Waits for the pending asynchronous page-ins
  */
 void PagedVolume::flushAll() {
-	core::ScopedWriteLock writeLock(_volumeLock);
-	_chunks.clear();
+	{
+		core::ScopedLock<core::Lock> lock(_pagedInLock);
+		_pagedInCondition.wait(_pagedInLock, [this] () {
+			return _pendingPageIns.load(std::memory_order_acquire) == 0u;
+		});
+	}
+	for (uint32_t i = 0u; i < ChunkShardCount; ++i) {
+		ChunkShard& chunkShard = _shards[i];
+		core::ScopedLock<core::Lock> lock(chunkShard.lock);
+		chunkShard.chunks.clear();
+	}
+	{
+		core::ScopedLock<core::Lock> lock(_clockLock);
+		// chunks that are still referenced elsewhere don't count against this volume anymore
+		for (const ChunkPtr& chunk : _clock) {
+			if (chunk) {
+				chunk->_volume = nullptr;
+			}
+		}
+		_clock.clear();
+		_clockFreeSlots.clear();
+		_clockHand = 0u;
+	}
+	_chunkCount = 0u;
+	_compressedChunks = 0u;
+	_memoryUsage = 0u;
+	_compressedMemoryUsage = 0u;
+}
+
+PagedVolume::Statistics PagedVolume::statistics() const {
+	Statistics stats;
+	for (uint32_t i = 0u; i < ChunkShardCount; ++i) {
+		ChunkShard& chunkShard = _shards[i];
+		core::ScopedLock<core::Lock> lock(chunkShard.lock);
+		stats.hits += chunkShard.hits;
+		stats.misses += chunkShard.misses;
+	}
+	stats.evictions = _evictions.load(std::memory_order_relaxed);
+	stats.chunks = _chunkCount.load(std::memory_order_relaxed);
+	stats.compressed = _compressedChunks.load(std::memory_order_relaxed);
+	stats.memoryUsage = _memoryUsage.load(std::memory_order_relaxed);
+	return stats;
+}
+
+PagedVolume::ChunkShard& PagedVolume::shard(const glm::ivec3& pos) const {
+	// use the upper bits here - the lower bits of the glm hash are used to select the bucket in the shard map
+	const uint32_t hash = ((uint32_t)pos.x * 73856093u) ^ ((uint32_t)pos.y * 19349663u) ^ ((uint32_t)pos.z * 83492791u);
+	return _shards[hash >> 28];
+}
+
+bool PagedVolume::existingChunk(ChunkShard& chunkShard, const glm::ivec3& pos, ChunkPtr& chunk) const {
+	bool decompressed = false;
+	{
+		core::ScopedLock<core::Lock> lock(chunkShard.lock);
+		auto i = chunkShard.chunks.find(pos);
+		if (i == chunkShard.chunks.end()) {
+			++chunkShard.misses;
+			return false;
+		}
+		++chunkShard.hits;
+		chunk = i->second;
+		// the chunk can't get compressed again while we hold the shard lock
+		if (chunk->isCompressed()) {
+			decompressChunk(chunk);
+			decompressed = true;
+		}
+	}
+	// avoid dirtying the cache line if the bit is already set
+	if (!chunk->_referenced.load(std::memory_order_relaxed)) {
+		chunk->_referenced.store(true, std::memory_order_relaxed);
+	}
+	if (decompressed && _memoryUsage.load(std::memory_order_relaxed) >= _targetMemoryUsage) {
+		deleteOldestChunkIfNeeded();
+	}
+	return true;
+}
+
+bool PagedVolume::insertChunk(ChunkShard& chunkShard, const glm::ivec3& pos, ChunkPtr& chunk) const {
+	// allocate outside of the lock - if we lose the race, the chunk is just thrown away
+	ChunkPtr newChunk = core::make_shared<Chunk>(pos, _chunkSideLength, _pager);
+	newChunk->_volume = this;
+	{
+		core::ScopedLock<core::Lock> lock(chunkShard.lock);
+		auto i = chunkShard.chunks.find(pos);
+		if (i != chunkShard.chunks.end()) {
+			chunk = i->second;
+			return false;
+		}
+		chunkShard.chunks.put(pos, newChunk);
+	}
+	chunk = newChunk;
+	addToClock(newChunk);
+	const uint32_t chunkCount = _chunkCount.fetch_add(1u, std::memory_order_relaxed) + 1u;
+	// new chunks are usually uniform and don't occupy any memory until they are paged in
+	updateMemoryUsage(newChunk.get());
+	if (chunkCount > _chunkCountLimit) {
+		deleteOldestChunkIfNeeded();
+	}
+	return true;
+}
+
+void PagedVolume::addToClock(const ChunkPtr& chunk) const {
+	core::ScopedLock<core::Lock> lock(_clockLock);
+	if (_clockFreeSlots.empty()) {
+		_clock.push_back(chunk);
+		return;
+	}
+	const uint32_t slot = _clockFreeSlots.back();
+	_clockFreeSlots.pop_back();
+	_clock[slot] = chunk;
+}
+
+bool PagedVolume::evictionNeeded() const {
+	return _memoryUsage.load(std::memory_order_relaxed) > _lowWaterMemoryUsage
+		|| _chunkCount.load(std::memory_order_relaxed) > _chunkCountLimit;
+}
+
+void PagedVolume::decompressChunk(const ChunkPtr& chunk) const {
+	core_trace_scoped(DecompressChunk);
+	_compressedMemoryUsage.fetch_sub(chunk->residentSizeInBytes(), std::memory_order_relaxed);
+	chunk->decompress();
+	chunk->buildColumnIndex();
+	updateMemoryUsage(chunk.get());
+	_compressedChunks.fetch_sub(1u, std::memory_order_relaxed);
+}
+
+void PagedVolume::updateMemoryUsage(Chunk* chunk) const {
+	const uint32_t size = chunk->residentSizeInBytes();
+	const uint32_t accounted = chunk->_accountedSize.exchange(size, std::memory_order_relaxed);
+	// unsigned wrap around handles shrinking chunks
+	_memoryUsage.fetch_add((uint64_t)size - (uint64_t)accounted, std::memory_order_relaxed);
 }
 
 /**
- * As we have added a chunk we may have exceeded our target chunk limit. Search through the array to
- * determine how many chunks we have, as well as finding the oldest timestamp. Note that this is potentially
- * wasteful and we may instead wish to track how many chunks we have and/or delete a chunk at random (or
- * just check e.g. 10 and delete the oldest of those) but we'll see if this is a bottleneck first. Paging
- * the data in is probably more expensive.
+ * As we have added a chunk we may have exceeded our memory budget. Advance the clock hand and move chunks
+ * that were not accessed since the hand passed them the last time into the compressed tier - or evict them
+ * if they are not compressible. This is done until the low water mark is reached. Compressed and uniform
+ * chunks are only evicted if the compressed chunks occupy more than a quarter of the budget or if there are
+ * too many chunks - evicting them wouldn't free a noticeable amount of memory otherwise.
+ * @note The shard locks are only acquired while the clock lock is held - never the other way around.
  */
 void PagedVolume::deleteOldestChunkIfNeeded() const {
+	if (!_evictionLock.try_lock()) {
+		// another thread is already evicting
+		return;
+	}
 	core_trace_scoped(DeleteOldestChunk);
-	ChunkMap::iterator oldestChunk = _chunks.end();
-	uint32_t oldestChunkTimestamp = _timestamper;
-	for (ChunkMap::iterator i = _chunks.begin(); i != _chunks.end(); ++i) {
-		const ChunkPtr& chunk = i->second;
-		if (chunk->_chunkLastAccessed < oldestChunkTimestamp) {
-			oldestChunkTimestamp = chunk->_chunkLastAccessed;
-			oldestChunk = i;
+	// keep a reference to release the chunks (and let them page out) after all locks were released
+	std::vector<ChunkPtr> victims;
+	uint32_t compressed = 0u;
+	{
+		core::ScopedLock<core::Lock> lock(_clockLock);
+		const uint32_t size = (uint32_t)_clock.size();
+		// three full sweeps are enough to clear all reference bits, compress and evict - only pending chunks could stop us
+		for (uint32_t steps = 0u; steps < 3u * size && evictionNeeded(); ++steps) {
+			const uint32_t slot = _clockHand;
+			_clockHand = (_clockHand + 1u) % size;
+			ChunkPtr& chunk = _clock[slot];
+			// empty slot or pending chunk that can't get evicted
+			if (!chunk || !chunk->pagedIn()) {
+				continue;
+			}
+			if (chunk->_referenced.exchange(false, std::memory_order_relaxed)) {
+				continue;
+			}
+			const glm::ivec3& pos = chunk->chunkPos();
+			ChunkShard& chunkShard = shard(pos);
+			core::ScopedLock<core::Lock> shardLock(chunkShard.lock);
+			// the shard and the clock are the only owners - and nobody can get a new reference while we hold the shard lock
+			if ((int)*chunk.refCnt() > 2) {
+				// still in use by a sampler or wrapper
+				continue;
+			}
+			if (!chunk->isCompressed() && !chunk->isUniform()) {
+				if (chunk->compress()) {
+					updateMemoryUsage(chunk.get());
+					_compressedMemoryUsage.fetch_add(chunk->residentSizeInBytes(), std::memory_order_relaxed);
+					_compressedChunks.fetch_add(1u, std::memory_order_relaxed);
+					++compressed;
+					continue;
+				}
+			} else if (_compressedMemoryUsage.load(std::memory_order_relaxed) <= _targetMemoryUsage / 4u
+					&& _chunkCount.load(std::memory_order_relaxed) <= _chunkCountLimit) {
+				continue;
+			}
+			auto i = chunkShard.chunks.find(pos);
+			if (i != chunkShard.chunks.end() && i->second.get() == chunk.get()) {
+				chunkShard.chunks.erase(i);
+			}
+			if (chunk->isCompressed()) {
+				_compressedChunks.fetch_sub(1u, std::memory_order_relaxed);
+				_compressedMemoryUsage.fetch_sub(chunk->residentSizeInBytes(), std::memory_order_relaxed);
+			}
+			_memoryUsage.fetch_sub(chunk->_accountedSize.exchange(0u, std::memory_order_relaxed), std::memory_order_relaxed);
+			chunk->_volume = nullptr;
+			_chunkCount.fetch_sub(1u, std::memory_order_relaxed);
+			victims.push_back(core::move(chunk));
+			chunk = ChunkPtr();
+			_clockFreeSlots.push_back(slot);
 		}
 	}
-	if (oldestChunk != _chunks.end()) {
-		Log::debug("delete oldest chunk - reached %u", _chunkCountLimit);
-		_chunks.erase(oldestChunk);
-	}
+	const uint32_t evicted = (uint32_t)victims.size();
+	_evictions.fetch_add(evicted, std::memory_order_relaxed);
+	core_trace_value_scoped(EvictedChunks, evicted);
+	Log::debug("compressed %u and evicted %u chunks - memory budget is %uMb", compressed, evicted, (uint32_t)(_targetMemoryUsage / (1024 * 1024)));
+	_evictionLock.unlock();
 }
 
-PagedVolume::ChunkPtr PagedVolume::createNewChunk(int32_t chunkX, int32_t chunkY, int32_t chunkZ) const {
-	core_trace_scoped(CreateNewChunk);
-	// The chunk was not found so we will create a new one.
-	glm::ivec3 pos(chunkX, chunkY, chunkZ);
-	Log::debug("create new chunk at %i:%i:%i", chunkX, chunkY, chunkZ);
-	ChunkPtr chunk = core::make_shared<Chunk>(pos, _chunkSideLength, _pager);
-	chunk->_chunkLastAccessed = ++_timestamper; // Important, as we may soon delete the oldest chunk
+void PagedVolume::pageIn(const ChunkPtr& chunk) const {
+	core_trace_scoped(PageInChunk);
+	const glm::ivec3& pos = chunk->chunkPos();
+	Log::debug("create new chunk at %i:%i:%i", pos.x, pos.y, pos.z);
+	chunk->_pagingThreadId = core::getThreadId();
+	++pagingDepth;
 
 	// Pass the chunk to the Pager to give it a chance to initialise it with any data
 	// From the coordinates of the chunk we deduce the coordinates of the contained voxels.
@@ -216,28 +425,136 @@ PagedVolume::ChunkPtr PagedVolume::createNewChunk(int32_t chunkX, int32_t chunkY
 	// Page the data in
 	// We'll use this later to decide if data needs to be paged out again.
 	chunk->_dataModified = _pager->pageIn(pctx);
-	Log::debug("finished creating new chunk at %i:%i:%i", chunkX, chunkY, chunkZ);
+	--pagingDepth;
+	// open terrain is full of chunks that are only air or water
+	if (!chunk->tryMakeUniform()) {
+		// the floor queries of the npcs are answered from this index
+		chunk->buildColumnIndex();
+	}
+	updateMemoryUsage(chunk.get());
+	Log::debug("finished creating new chunk at %i:%i:%i", pos.x, pos.y, pos.z);
 
-	return chunk;
+	{
+		// publish the chunk to the threads that are waiting for it
+		core::ScopedLock<core::Lock> lock(_pagedInLock);
+		chunk->_pagedIn.store(true, std::memory_order_release);
+		_pagedInCondition.notify_all();
+	}
+	if (_memoryUsage.load(std::memory_order_relaxed) >= _targetMemoryUsage) {
+		deleteOldestChunkIfNeeded();
+	}
+}
+
+void PagedVolume::waitForPageIn(const ChunkPtr& chunk) const {
+	if (chunk->pagedIn()) {
+		return;
+	}
+	// the pager is accessing the chunk it is currently paging in
+	if (chunk->_pagingThreadId == core::getThreadId()) {
+		return;
+	}
+	core_trace_scoped(WaitForPageIn);
+	core::ScopedLock<core::Lock> lock(_pagedInLock);
+	_pagedInCondition.wait(_pagedInLock, [&chunk] () {
+		return chunk->pagedIn();
+	});
+}
+
+void PagedVolume::schedulePageIn(const ChunkPtr& chunk) const {
+	if (_pagingPool == nullptr || pagingDepth > 0) {
+		pageIn(chunk);
+		return;
+	}
+	_pendingPageIns.fetch_add(1u, std::memory_order_acq_rel);
+	// the extraction is blocked until the chunks are paged in
+	_pagingPool->schedule([this, chunk] () {
+		pageIn(chunk);
+		core::ScopedLock<core::Lock> lock(_pagedInLock);
+		_pendingPageIns.fetch_sub(1u, std::memory_order_acq_rel);
+		_pagedInCondition.notify_all();
+	}, core::TaskPriority::High);
 }
 
 PagedVolume::ChunkPtr PagedVolume::chunk(int32_t chunkX, int32_t chunkY, int32_t chunkZ) const {
 	core_trace_scoped(PagedVolumeChunk);
-	core::ScopedWriteLock chunkWriteLock(_volumeLock);
 	const glm::ivec3 pos(chunkX, chunkY, chunkZ);
-	auto i = _chunks.find(pos);
-	if (i == _chunks.end()) {
-		const ChunkPtr& chunk = createNewChunk(chunkX, chunkY, chunkZ);
-		_chunks.put(pos, chunk);
-		const std::size_t chunkCount = _chunks.size();
-		if (chunkCount >= _chunkCountLimit) {
-			deleteOldestChunkIfNeeded();
-		}
-		return chunk;
+	ChunkShard& chunkShard = shard(pos);
+	ChunkPtr chunk;
+	if (!existingChunk(chunkShard, pos, chunk) && insertChunk(chunkShard, pos, chunk)) {
+		schedulePageIn(chunk);
 	}
-	const ChunkPtr& chunk = i->second;
-	chunk->_chunkLastAccessed = ++_timestamper;
+	waitForPageIn(chunk);
 	return chunk;
 }
 
+PagedVolume::ChunkPtr PagedVolume::tryChunk(const glm::ivec3& worldPos) const {
+	const glm::ivec3& pos = chunkPos(worldPos);
+	ChunkShard& chunkShard = shard(pos);
+	ChunkPtr chunk;
+	if (!existingChunk(chunkShard, pos, chunk) && insertChunk(chunkShard, pos, chunk)) {
+		schedulePageIn(chunk);
+	}
+	if (chunk->pagedIn()) {
+		return chunk;
+	}
+	return ChunkPtr();
+}
+
+bool PagedVolume::isUniform(const Region& region, Voxel& voxel) const {
+	core_trace_scoped(PagedVolumeIsUniform);
+	const glm::ivec3& mins = chunkPos(region.getLowerCorner());
+	const glm::ivec3& maxs = chunkPos(region.getUpperCorner());
+	bool first = true;
+	for (int32_t x = mins.x; x <= maxs.x; ++x) {
+		for (int32_t y = mins.y; y <= maxs.y; ++y) {
+			for (int32_t z = mins.z; z <= maxs.z; ++z) {
+				const ChunkPtr& c = chunk(x, y, z);
+				if (!c->isUniform()) {
+					return false;
+				}
+				const Voxel& uniformVoxel = c->uniformVoxel();
+				if (first) {
+					voxel = uniformVoxel;
+					first = false;
+				} else if (uniformVoxel.getMaterial() != voxel.getMaterial() || uniformVoxel.getColor() != voxel.getColor()) {
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+bool PagedVolume::prefetch(const Region& region) const {
+	core_trace_scoped(PagedVolumePrefetch);
+	const glm::ivec3& mins = chunkPos(region.getLowerCorner());
+	const glm::ivec3& maxs = chunkPos(region.getUpperCorner());
+	bool pagedIn = true;
+	for (int32_t x = mins.x; x <= maxs.x; ++x) {
+		for (int32_t y = mins.y; y <= maxs.y; ++y) {
+			for (int32_t z = mins.z; z <= maxs.z; ++z) {
+				const glm::ivec3 worldPos(x << _chunkSideLengthPower, y << _chunkSideLengthPower, z << _chunkSideLengthPower);
+				if (!tryChunk(worldPos)) {
+					pagedIn = false;
+				}
+			}
+		}
+	}
+	return pagedIn;
+}
+
+void PagedVolume::waitForPageIn(const Region& region) const {
+	core_trace_scoped(PagedVolumeWaitForRegion);
+	const glm::ivec3& mins = chunkPos(region.getLowerCorner());
+	const glm::ivec3& maxs = chunkPos(region.getUpperCorner());
+	for (int32_t x = mins.x; x <= maxs.x; ++x) {
+		for (int32_t y = mins.y; y <= maxs.y; ++y) {
+			for (int32_t z = mins.z; z <= maxs.z; ++z) {
+				// blocks on the page-in condition until the chunk is published
+				(void)chunk(x, y, z);
+			}
+		}
+	}
+}
+
 }
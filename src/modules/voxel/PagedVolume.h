@@ -9,10 +9,17 @@
 #include "core/NonCopyable.h"
 #include "core/GLM.h"
 #include "core/Assert.h"
-#include "core/concurrent/ReadWriteLock.h"
-#include "core/concurrent/Atomic.h"
+#include "core/concurrent/Lock.h"
+#include "core/concurrent/ConditionVariable.h"
 #include "core/collection/Map.h"
 #include "core/SharedPtr.h"
+#include "core/Trace.h"
+#include <atomic>
+#include <vector>
+
+namespace core {
+class ThreadPool;
+}
 
 namespace voxel {
 
@@ -46,7 +53,13 @@ public:
 		~Chunk();
 
 		bool setData(const Voxel* voxels, size_t sizeInBytes);
-		Voxel* data() const;
+		/**
+		 * @brief Write access to the raw voxel data - a uniform chunk gets its own voxel buffer here
+		 * @note Writes through this pointer are not reflected in the column index - use @c setData() or
+		 * @c setVoxel() for chunks that are already paged in.
+		 */
+		Voxel* data();
+		const Voxel* data() const;
 		uint32_t dataSizeInBytes() const;
 		uint32_t voxels() const;
 
@@ -60,15 +73,119 @@ public:
 
 		const glm::ivec3& chunkPos() const;
 		int16_t sideLength() const;
+		/**
+		 * @return @c false if the pager didn't finish the page-in of this chunk yet
+		 */
+		bool pagedIn() const;
+
+		/**
+		 * @return @c true if all voxels of the chunk have the same value - the chunk doesn't own any voxel
+		 * data then. The first differing write gives the chunk its own buffer.
+		 * @sa uniformVoxel()
+		 */
+		bool isUniform() const;
+		const Voxel& uniformVoxel() const;
+		/**
+		 * @brief Sets all voxels of the chunk to the given value and releases the voxel buffer
+		 */
+		void setUniform(const Voxel& voxel);
+
+		/**
+		 * @return The highest local y coordinate in the given column that is less or equal to @c y and holds a
+		 * voxel that is not enterable - or @c -1 if there is none.
+		 * @note Uses the column index if the chunk has one - otherwise the column is scanned.
+		 */
+		int highestSolidVoxel(uint32_t x, uint32_t z, int y) const;
+		/**
+		 * @return The lowest local y coordinate in the given column that is greater or equal to @c y and holds an
+		 * enterable voxel - or @c -1 if there is none.
+		 * @note Uses the column index if the chunk has one - otherwise the column is scanned.
+		 */
+		int lowestEnterableVoxel(uint32_t x, uint32_t z, int y) const;
 
 	private:
-		// This is updated by the PagedVolume and used to discard the least recently used chunks.
-		uint32_t _chunkLastAccessed = 0u;
+		// The second chance bit of the clock eviction - set on every access, cleared by the clock hand.
+		// Only ever accessed with relaxed memory order - it's just a hint for the eviction.
+		std::atomic_bool _referenced { true };
+		// Published with release semantics after the pager filled the chunk
+		std::atomic_bool _pagedIn { false };
+		// The thread that is paging in the chunk - the pager is allowed to access its own chunk
+		std::atomic<size_t> _pagingThreadId { 0u };
+		// The resident size that is currently accounted for in the memory usage of the volume
+		std::atomic<uint32_t> _accountedSize { 0u };
 
 		static uint32_t calculateSizeInBytes(uint32_t sideLength);
 
+		/**
+		 * @brief A run of equal voxels in morton order
+		 */
+		struct VoxelRun {
+			uint32_t length;
+			Voxel voxel;
+		};
+
+		/**
+		 * @brief Moves the chunk into the compressed tier - the raw voxel data is released.
+		 * @return @c false if the run length encoding wouldn't save any memory - the chunk is unchanged then.
+		 * @note Nobody else is allowed to access the chunk while this is executed.
+		 */
+		bool compress();
+		/**
+		 * @brief Restores the raw voxel data of a compressed chunk
+		 */
+		void decompress();
+		bool isCompressed() const;
+		/**
+		 * @return The amount of bytes the chunk currently occupies - either compressed or uncompressed. Uniform
+		 * chunks don't occupy any voxel memory.
+		 */
+		uint32_t residentSizeInBytes() const;
+
+		/**
+		 * @brief Points the chunk to the shared voxel buffer for the given value
+		 * @return @c false if there is no shared buffer available - the chunk keeps its own voxel buffer
+		 */
+		bool makeUniform(const Voxel& voxel);
+		/**
+		 * @brief Converts the chunk into a uniform chunk if all voxels have the same value
+		 */
+		bool tryMakeUniform();
+		/**
+		 * @brief Gives a uniform chunk its own voxel buffer before it gets modified (copy-on-write)
+		 */
+		void materialize();
+		/**
+		 * @brief Updates the memory usage of the owning volume after the resident size of the chunk changed
+		 */
+		void accountMemory();
+
+		/**
+		 * @brief Builds the column index for the walkable floor queries - it's kept up to date by every write
+		 * afterwards. Uniform chunks don't need an index.
+		 */
+		void buildColumnIndex();
+		/**
+		 * @brief Builds the column index of a raw chunk that is paged in (or not part of any volume). Chunks
+		 * that are still paged in get their index once the pager is done.
+		 */
+		void ensureColumnIndex();
+		void releaseColumnIndex();
+		uint32_t columnIndexSizeInBytes() const;
+		inline void updateColumnIndex(uint32_t x, uint32_t y, uint32_t z, const Voxel& value);
+
+		// For uniform chunks this points to a shared and read-only buffer that is filled with @c _uniformVoxel. This
+		// keeps the samplers working without any special handling for uniform chunks.
 		Voxel* _data = nullptr;
+		Voxel _uniformVoxel;
+		bool _uniform = false;
+		// The run length encoded voxels if the chunk is in the compressed tier, @c _data is @c nullptr then
+		VoxelRun* _runs = nullptr;
+		uint32_t _runCount = 0u;
+		// One bit per voxel that is not enterable - the bits of a column (x, z) are stored in @c _columnWords
+		// consecutive words with the y coordinate as bit index. Only raw chunks that are paged in have an index.
+		uint64_t* _solidColumns = nullptr;
 		uint16_t _sideLength = 0u;
+		uint8_t _columnWords = 0u;
 
 		// This is so we can tell whether a uncompressed chunk has to be recompressed and whether
 		// a compressed chunk has to be paged back to disk, or whether they can just be discarded.
@@ -76,6 +193,8 @@ public:
 
 		uint8_t _sideLengthPower = 0b0;
 		Pager* _pager;
+		// The volume that accounts the memory of this chunk - @c nullptr for chunks that are not part of a volume
+		const PagedVolume* _volume = nullptr;
 
 		// Note: Do we really need to store this position here as well as in the block maps?
 		glm::ivec3 _chunkSpacePosition;
@@ -111,6 +230,20 @@ public:
 
 	typedef core::SharedPtr<Pager> PagerPtr;
 
+	/**
+	 * @brief Cumulative chunk cache counters since the volume was created
+	 */
+	struct Statistics {
+		uint64_t hits = 0u;
+		uint64_t misses = 0u;
+		uint64_t evictions = 0u;
+		uint32_t chunks = 0u;
+		// chunks that are currently in the compressed tier
+		uint32_t compressed = 0u;
+		// raw and compressed chunk data
+		uint64_t memoryUsage = 0u;
+	};
+
 	class Sampler {
 	public:
 		Sampler(const PagedVolume* volume);
@@ -237,7 +370,40 @@ public:
 	/** @brief Removes all voxels from memory */
 	void flushAll();
 
+	/**
+	 * @brief Page-ins are executed on a worker pool with the given amount of threads. Without this, they
+	 * are performed synchronously by the thread that requested the chunk.
+	 * @note The pager must be able to handle concurrent page-ins if more than one thread is used.
+	 */
+	void initAsyncPaging(uint32_t threads);
+
+	/**
+	 * @brief Returns the chunk for the given world position - blocks until the chunk was paged in.
+	 */
 	ChunkPtr chunk(const glm::ivec3& pos) const;
+	/**
+	 * @brief Non-blocking version of @c chunk()
+	 * @return An empty pointer if the chunk is still pending - a page-in is scheduled in that case. Concurrent
+	 * requests for the same chunk are coalesced.
+	 */
+	ChunkPtr tryChunk(const glm::ivec3& pos) const;
+	/**
+	 * @brief Schedules the page-in for all chunks that are touched by the given region.
+	 * @return @c true if all the chunks are already paged in and can be accessed without blocking.
+	 */
+	bool prefetch(const Region& region) const;
+	/**
+	 * @brief Blocks until all the chunks that are touched by the given region are paged in. Use @c prefetch()
+	 * before to page in the chunks in parallel.
+	 */
+	void waitForPageIn(const Region& region) const;
+	/**
+	 * @brief Checks whether all the chunks that are touched by the given region are uniform chunks with the same voxel
+	 * @note Pages in the chunks
+	 */
+	bool isUniform(const Region& region, Voxel& voxel) const;
+
+	Statistics statistics() const;
 
 	glm::ivec3 chunkPos(int x, int y, int z) const;
 
@@ -258,15 +424,60 @@ protected:
 
 private:
 	ChunkPtr chunk(int32_t uChunkX, int32_t uChunkY, int32_t uChunkZ) const;
-	ChunkPtr createNewChunk(int32_t uChunkX, int32_t uChunkY, int32_t uChunkZ) const;
+	void pageIn(const ChunkPtr& chunk) const;
+	/**
+	 * @brief Executes the page-in on the async paging pool - or inline if there is no such pool
+	 */
+	void schedulePageIn(const ChunkPtr& chunk) const;
+	void waitForPageIn(const ChunkPtr& chunk) const;
 	void deleteOldestChunkIfNeeded() const;
+	void addToClock(const ChunkPtr& chunk) const;
 
-	mutable int32_t _timestamper = 0;
-
+	void decompressChunk(const ChunkPtr& chunk) const;
+	bool evictionNeeded() const;
+	/**
+	 * @brief Brings the memory usage of the volume in sync with the resident size of the chunk
+	 */
+	void updateMemoryUsage(Chunk* chunk) const;
+
+	mutable std::atomic<uint32_t> _chunkCount { 0u };
+	mutable std::atomic<uint32_t> _compressedChunks { 0u };
+	mutable std::atomic<uint64_t> _evictions { 0u };
+	// the memory budget counts the resident size of the chunks - compressed chunks only count with their compressed size
+	mutable std::atomic<uint64_t> _memoryUsage { 0u };
+	// the part of the memory usage that is occupied by compressed chunks
+	mutable std::atomic<uint64_t> _compressedMemoryUsage { 0u };
+
+	uint64_t _targetMemoryUsage = 0u;
+	// compressed and uniform chunks barely occupy memory - but the amount of chunks is still limited
 	uint32_t _chunkCountLimit = 0u;
+	// once the budget is exceeded, chunks are compressed or evicted until this amount is reached
+	uint64_t _lowWaterMemoryUsage = 0u;
 
 	typedef core::Map<glm::ivec3, ChunkPtr, 64, glm::hash<glm::ivec3>> ChunkMap;
-	mutable ChunkMap _chunks;
+
+	/**
+	 * @brief The chunk index is split into several shards - each with its own lock. A lookup of an
+	 * already paged in chunk only locks the shard the chunk lives in - and only for the duration of the
+	 * lookup. This allows the mesh extraction, the ai and the world threads to query chunks in parallel.
+	 */
+	struct ChunkShard {
+		core_trace_mutex(core::Lock, lock, "PagedVolumeShard");
+		ChunkMap chunks;
+		// only modified while the shard lock is held
+		uint64_t hits = 0u;
+		uint64_t misses = 0u;
+	};
+	static constexpr uint32_t ChunkShardCount = 16u;
+	mutable ChunkShard _shards[ChunkShardCount];
+
+	ChunkShard& shard(const glm::ivec3& pos) const;
+	bool existingChunk(ChunkShard& chunkShard, const glm::ivec3& pos, ChunkPtr& chunk) const;
+	/**
+	 * @return @c true if a new chunk was inserted - the caller is responsible for paging it in then.
+	 * @c false if another thread was faster and the chunk already exists (it might still be pending).
+	 */
+	bool insertChunk(ChunkShard& chunkShard, const glm::ivec3& pos, ChunkPtr& chunk) const;
 
 	// The size of the chunks
 	uint16_t _chunkSideLength;
@@ -277,9 +488,33 @@ private:
 
 	Region _region;
 
-	mutable core::ReadWriteLock _volumeLock{"pagedvolume"};
+	core::ThreadPool* _pagingPool = nullptr;
+	mutable std::atomic<uint32_t> _pendingPageIns { 0u };
+	// used to wake up the threads that are waiting for a pending chunk
+	mutable core_trace_mutex(core::Lock, _pagedInLock, "PagedVolumePagedIn");
+	mutable core::ConditionVariable _pagedInCondition;
+	// only one thread is evicting chunks at a time
+	core_trace_mutex(core::Lock, _evictionLock, "PagedVolumeEviction");
+
+	/**
+	 * @brief The eviction uses the clock (second chance) algorithm. Every chunk has a slot in the ring,
+	 * touching a chunk only sets its reference bit. The clock hand clears the bits and moves the first
+	 * chunk that wasn't referenced since the last sweep into the compressed tier. If the chunk is
+	 * passed again without being referenced, it is evicted. Both operations are O(1) (amortized).
+	 */
+	mutable core_trace_mutex(core::Lock, _clockLock, "PagedVolumeClock");
+	mutable std::vector<ChunkPtr> _clock;
+	mutable std::vector<uint32_t> _clockFreeSlots;
+	mutable uint32_t _clockHand = 0u;
 };
 
+/**
+ * @brief Allows the surface extractors to skip regions that are made of uniform chunks
+ */
+inline bool isUniformRegion(const PagedVolume* volume, const Region& region, Voxel& voxel) {
+	return volume->isUniform(region, voxel);
+}
+
 inline const Voxel& PagedVolume::Sampler::voxel() const {
 	return *_currentVoxel;
 }
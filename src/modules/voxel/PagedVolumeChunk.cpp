@@ -7,9 +7,56 @@
 #include "math/Functions.h"
 #include "core/Common.h"
 #include "core/StandardLib.h"
+#include "core/Trace.h"
+#include "core/concurrent/Lock.h"
+#include <glm/integer.hpp>
 
 namespace voxel {
 
+static inline bool isSameVoxel(const Voxel& a, const Voxel& b) {
+	return a.getMaterial() == b.getMaterial() && a.getColor() == b.getColor();
+}
+
+/**
+ * @brief The read-only voxel buffers of the uniform chunks are shared between all chunks (and volumes) with the same
+ * voxel value and side length. They are never released. To limit the memory that is used here, only a few of them
+ * are created - chunks of other values just keep their own buffer.
+ * @return @c nullptr if the limit was reached
+ */
+static Voxel* uniformData(const Voxel& voxel, uint16_t sideLength) {
+	struct UniformData {
+		Voxel voxel;
+		uint16_t sideLength;
+		Voxel* data;
+	};
+	static constexpr int MaxUniformData = 16;
+	static constexpr size_t MaxUniformDataBytes = 64 * 1024 * 1024;
+	static core_trace_mutex(core::Lock, lock, "UniformChunkData");
+	static UniformData entries[MaxUniformData];
+	static int entryCount = 0;
+	static size_t bytes = 0u;
+
+	core::ScopedLock<core::Lock> scopedLock(lock);
+	for (int i = 0; i < entryCount; ++i) {
+		const UniformData& e = entries[i];
+		if (e.sideLength == sideLength && isSameVoxel(e.voxel, voxel)) {
+			return e.data;
+		}
+	}
+	const uint32_t voxels = sideLength * sideLength * sideLength;
+	const size_t size = voxels * sizeof(Voxel);
+	if (entryCount >= MaxUniformData || bytes + size > MaxUniformDataBytes) {
+		return nullptr;
+	}
+	Voxel* data = (Voxel*)core_malloc(size);
+	for (uint32_t i = 0u; i < voxels; ++i) {
+		data[i] = voxel;
+	}
+	entries[entryCount++] = UniformData{voxel, sideLength, data};
+	bytes += size;
+	return data;
+}
+
 PagedVolume::Chunk::Chunk(const glm::ivec3& pos, uint16_t sideLength, Pager* pager) :
 		_pager(pager), _chunkSpacePosition(pos) {
 	core_assert_msg(_pager, "No valid pager supplied to chunk constructor.");
@@ -18,20 +65,298 @@ PagedVolume::Chunk::Chunk(const glm::ivec3& pos, uint16_t sideLength, Pager* pag
 	// Compute the side length
 	_sideLength = sideLength;
 	_sideLengthPower = math::logBase2(sideLength);
+	_columnWords = (sideLength + 63) / 64;
 
-	// Allocate the data
-	const uint32_t uNoOfVoxels = _sideLength * _sideLength * _sideLength;
-	_data = (Voxel*)core_malloc(uNoOfVoxels * sizeof(Voxel));
-	core_memset(_data, 0, uNoOfVoxels * sizeof(Voxel));
+	// Empty chunks don't allocate any voxel data until the first voxel is set
+	if (!makeUniform(Voxel())) {
+		const uint32_t uNoOfVoxels = _sideLength * _sideLength * _sideLength;
+		_data = (Voxel*)core_malloc(uNoOfVoxels * sizeof(Voxel));
+		core_memset(_data, 0, uNoOfVoxels * sizeof(Voxel));
+	}
 }
 
 PagedVolume::Chunk::~Chunk() {
 	if (_dataModified && _pager) {
+		// the pager needs the raw voxel data
+		if (isCompressed()) {
+			decompress();
+		}
 		_pager->pageOut(this);
 	}
 
+	if (!_uniform) {
+		core_free(_data);
+	}
+	_data = nullptr;
+	core_free(_runs);
+	_runs = nullptr;
+	releaseColumnIndex();
+}
+
+bool PagedVolume::Chunk::makeUniform(const Voxel& voxel) {
+	Voxel* data = uniformData(voxel, _sideLength);
+	if (data == nullptr) {
+		return false;
+	}
+	if (!_uniform) {
+		core_free(_data);
+	}
+	core_free(_runs);
+	_runs = nullptr;
+	_runCount = 0u;
+	releaseColumnIndex();
+	_data = data;
+	_uniformVoxel = voxel;
+	_uniform = true;
+	accountMemory();
+	return true;
+}
+
+bool PagedVolume::Chunk::tryMakeUniform() {
+	if (_uniform) {
+		return true;
+	}
+	if (_data == nullptr) {
+		return false;
+	}
+	core_trace_scoped(ChunkTryMakeUniform);
+	const Voxel first = _data[0];
+	const uint32_t n = voxels();
+	for (uint32_t i = 1u; i < n; ++i) {
+		if (!isSameVoxel(_data[i], first)) {
+			return false;
+		}
+	}
+	return makeUniform(first);
+}
+
+void PagedVolume::Chunk::materialize() {
+	core_assert_msg(_uniform, "Chunk already owns its voxel data");
+	core_trace_scoped(ChunkMaterialize);
+	// the shared buffer is already filled with the uniform voxel
+	Voxel* data = (Voxel*)core_malloc(dataSizeInBytes());
+	core_memcpy(data, _data, dataSizeInBytes());
+	_data = data;
+	_uniform = false;
+	ensureColumnIndex();
+	accountMemory();
+}
+
+void PagedVolume::Chunk::accountMemory() {
+	if (_volume != nullptr) {
+		_volume->updateMemoryUsage(this);
+	}
+}
+
+bool PagedVolume::Chunk::isUniform() const {
+	return _uniform;
+}
+
+const Voxel& PagedVolume::Chunk::uniformVoxel() const {
+	core_assert_msg(_uniform, "Chunk is not uniform");
+	return _uniformVoxel;
+}
+
+void PagedVolume::Chunk::setUniform(const Voxel& voxel) {
+	_dataModified = true;
+	if (makeUniform(voxel)) {
+		return;
+	}
+	if (_uniform) {
+		materialize();
+	}
+	const uint32_t n = voxels();
+	for (uint32_t i = 0u; i < n; ++i) {
+		_data[i] = voxel;
+	}
+	ensureColumnIndex();
+}
+
+bool PagedVolume::Chunk::compress() {
+	core_assert_msg(_data, "Chunk is already compressed");
+	core_assert_msg(!_uniform, "Uniform chunks are not compressed");
+	const uint32_t n = voxels();
+	// count the runs first to allocate the exact amount of memory
+	uint32_t runCount = 1u;
+	for (uint32_t i = 1u; i < n; ++i) {
+		if (!isSameVoxel(_data[i], _data[i - 1])) {
+			++runCount;
+		}
+	}
+	if (runCount * sizeof(VoxelRun) >= dataSizeInBytes()) {
+		return false;
+	}
+	_runs = (VoxelRun*)core_malloc(runCount * sizeof(VoxelRun));
+	_runCount = runCount;
+	VoxelRun* run = _runs;
+	run->length = 1u;
+	run->voxel = _data[0];
+	for (uint32_t i = 1u; i < n; ++i) {
+		if (isSameVoxel(_data[i], run->voxel)) {
+			++run->length;
+			continue;
+		}
+		++run;
+		run->length = 1u;
+		run->voxel = _data[i];
+	}
 	core_free(_data);
 	_data = nullptr;
+	// rebuilt by the volume on decompression
+	releaseColumnIndex();
+	return true;
+}
+
+void PagedVolume::Chunk::decompress() {
+	core_assert_msg(_runs, "Chunk is not compressed");
+	if (_runCount == 1u && makeUniform(_runs[0].voxel)) {
+		return;
+	}
+	_data = (Voxel*)core_malloc(dataSizeInBytes());
+	Voxel* voxel = _data;
+	for (uint32_t r = 0u; r < _runCount; ++r) {
+		const VoxelRun& run = _runs[r];
+		for (uint32_t i = 0u; i < run.length; ++i) {
+			*voxel++ = run.voxel;
+		}
+	}
+	core_free(_runs);
+	_runs = nullptr;
+	_runCount = 0u;
+}
+
+bool PagedVolume::Chunk::isCompressed() const {
+	return _runs != nullptr;
+}
+
+uint32_t PagedVolume::Chunk::residentSizeInBytes() const {
+	if (_uniform) {
+		return 0u;
+	}
+	if (isCompressed()) {
+		return _runCount * sizeof(VoxelRun);
+	}
+	return dataSizeInBytes() + columnIndexSizeInBytes();
+}
+
+uint32_t PagedVolume::Chunk::columnIndexSizeInBytes() const {
+	if (_solidColumns == nullptr) {
+		return 0u;
+	}
+	return _sideLength * _sideLength * _columnWords * sizeof(uint64_t);
+}
+
+void PagedVolume::Chunk::buildColumnIndex() {
+	if (_uniform || _data == nullptr) {
+		releaseColumnIndex();
+		return;
+	}
+	core_trace_scoped(ChunkBuildColumnIndex);
+	if (_solidColumns == nullptr) {
+		_solidColumns = (uint64_t*)core_malloc(_sideLength * _sideLength * _columnWords * sizeof(uint64_t));
+	}
+	core_memset(_solidColumns, 0, columnIndexSizeInBytes());
+	for (uint32_t z = 0u; z < _sideLength; ++z) {
+		for (uint32_t x = 0u; x < _sideLength; ++x) {
+			uint64_t* column = &_solidColumns[(x + z * _sideLength) * _columnWords];
+			for (uint32_t y = 0u; y < _sideLength; ++y) {
+				if (!isEnterable(voxel(x, y, z).getMaterial())) {
+					column[y >> 6] |= 1ull << (y & 63u);
+				}
+			}
+		}
+	}
+}
+
+void PagedVolume::Chunk::ensureColumnIndex() {
+	if (pagedIn() || _volume == nullptr) {
+		buildColumnIndex();
+	}
+}
+
+void PagedVolume::Chunk::releaseColumnIndex() {
+	core_free(_solidColumns);
+	_solidColumns = nullptr;
+}
+
+inline void PagedVolume::Chunk::updateColumnIndex(uint32_t x, uint32_t y, uint32_t z, const Voxel& value) {
+	if (_solidColumns == nullptr) {
+		return;
+	}
+	uint64_t& word = _solidColumns[(x + z * _sideLength) * _columnWords + (y >> 6)];
+	const uint64_t bit = 1ull << (y & 63u);
+	if (isEnterable(value.getMaterial())) {
+		word &= ~bit;
+	} else {
+		word |= bit;
+	}
+}
+
+int PagedVolume::Chunk::highestSolidVoxel(uint32_t x, uint32_t z, int y) const {
+	core_assert_msg(x < _sideLength && z < _sideLength, "Supplied position is outside of the chunk");
+	if (y < 0) {
+		return -1;
+	}
+	y = core_min(y, _sideLength - 1);
+	if (_uniform) {
+		return isEnterable(_uniformVoxel.getMaterial()) ? -1 : y;
+	}
+	if (_solidColumns == nullptr) {
+		for (int i = y; i >= 0; --i) {
+			if (!isEnterable(voxel(x, i, z).getMaterial())) {
+				return i;
+			}
+		}
+		return -1;
+	}
+	const uint64_t* column = &_solidColumns[(x + z * _sideLength) * _columnWords];
+	int word = y >> 6;
+	const int bit = y & 63;
+	// mask out everything above y
+	uint64_t bits = column[word] & (bit == 63 ? ~0ull : ((1ull << (bit + 1)) - 1ull));
+	for (;;) {
+		if (bits != 0u) {
+			return word * 64 + glm::findMSB(bits);
+		}
+		if (--word < 0) {
+			return -1;
+		}
+		bits = column[word];
+	}
+}
+
+int PagedVolume::Chunk::lowestEnterableVoxel(uint32_t x, uint32_t z, int y) const {
+	core_assert_msg(x < _sideLength && z < _sideLength, "Supplied position is outside of the chunk");
+	if (y >= _sideLength) {
+		return -1;
+	}
+	y = core_max(y, 0);
+	if (_uniform) {
+		return isEnterable(_uniformVoxel.getMaterial()) ? y : -1;
+	}
+	if (_solidColumns == nullptr) {
+		for (int i = y; i < _sideLength; ++i) {
+			if (isEnterable(voxel(x, i, z).getMaterial())) {
+				return i;
+			}
+		}
+		return -1;
+	}
+	const uint64_t* column = &_solidColumns[(x + z * _sideLength) * _columnWords];
+	int word = y >> 6;
+	// mask out everything below y
+	uint64_t bits = ~column[word] & (~0ull << (y & 63));
+	for (;;) {
+		if (bits != 0u) {
+			const int found = word * 64 + glm::findLSB(bits);
+			// chunks with less than 64 voxels per column have unused bits
+			return found < _sideLength ? found : -1;
+		}
+		if (++word >= _columnWords) {
+			return -1;
+		}
+		bits = ~column[word];
+	}
 }
 
 bool PagedVolume::Chunk::setData(const Voxel* voxels, size_t sizeInBytes) {
@@ -39,11 +364,25 @@ bool PagedVolume::Chunk::setData(const Voxel* voxels, size_t sizeInBytes) {
 		return false;
 	}
 	_dataModified = true;
+	if (_uniform) {
+		// no need to copy the shared buffer - everything is overwritten anyway
+		_data = (Voxel*)core_malloc(sizeInBytes);
+		_uniform = false;
+	}
 	core_memcpy((uint8_t*)_data, (const uint8_t*)voxels, sizeInBytes);
+	ensureColumnIndex();
+	accountMemory();
 	return true;
 }
 
-Voxel* PagedVolume::Chunk::data() const {
+Voxel* PagedVolume::Chunk::data() {
+	if (_uniform) {
+		materialize();
+	}
+	return _data;
+}
+
+const Voxel* PagedVolume::Chunk::data() const {
 	return _data;
 }
 
@@ -79,8 +418,15 @@ void PagedVolume::Chunk::setVoxel(uint32_t x, uint32_t y, uint32_t z, const Voxe
 	core_assert_msg(z < _sideLength, "Supplied position is outside of the chunk");
 	core_assert_msg(_data, "No uncompressed data - chunk must be decompressed before accessing voxels.");
 
+	if (_uniform) {
+		if (isSameVoxel(value, _uniformVoxel)) {
+			return;
+		}
+		materialize();
+	}
 	const uint32_t index = morton256_x[x] | morton256_y[y] | morton256_z[z];
 	_data[index] = value;
+	updateColumnIndex(x, y, z, value);
 	_dataModified = true;
 }
 
@@ -97,9 +443,21 @@ void PagedVolume::Chunk::setVoxels(uint32_t x, uint32_t y, uint32_t z, const Vox
 	core_assert_msg(z < _sideLength, "Supplied z position is outside of the chunk");
 	core_assert_msg(_data, "No uncompressed data - chunk must be decompressed before accessing voxels.");
 
+	if (_uniform) {
+		for (int i = y; i < amount; ++i) {
+			if (!isSameVoxel(values[i], _uniformVoxel)) {
+				materialize();
+				break;
+			}
+		}
+		if (_uniform) {
+			return;
+		}
+	}
 	for (int i = y; i < amount; ++i) {
 		const uint32_t index = morton256_x[x] | morton256_y[i] | morton256_z[z];
 		_data[index] = values[i];
+		updateColumnIndex(x, i, z, values[i]);
 	}
 	_dataModified = true;
 }
@@ -112,6 +470,10 @@ const glm::ivec3& PagedVolume::Chunk::chunkPos() const {
 	return _chunkSpacePosition;
 }
 
+bool PagedVolume::Chunk::pagedIn() const {
+	return _pagedIn.load(std::memory_order_acquire);
+}
+
 void PagedVolume::Chunk::setVoxel(const glm::i16vec3& pos, const Voxel& value) {
 	setVoxel(pos.x, pos.y, pos.z, value);
 }
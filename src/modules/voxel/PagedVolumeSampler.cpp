@@ -96,7 +96,11 @@ bool PagedVolume::Sampler::setVoxel(const Voxel& voxel) {
 	//Need to think what effect this has on any existing iterators.
 	//core_assert_msg(false, "This function cannot be used on PagedVolume samplers.");
 	//TODO: the region is not updated properly - but we might not need this for paged volumes.
-	*_currentVoxel = voxel;
+	// the chunk keeps its column index up to date - and doesn't write into the shared buffer of a uniform chunk
+	_currentChunk->setVoxel(_xPosInChunk, _yPosInChunk, _zPosInChunk, voxel);
+	// a uniform chunk got its own voxel buffer
+	const uint32_t voxelIndexInChunk = morton256_x[_xPosInChunk] | morton256_y[_yPosInChunk] | morton256_z[_zPosInChunk];
+	_currentVoxel = _currentChunk->_data + voxelIndexInChunk;
 	return true;
 }
 
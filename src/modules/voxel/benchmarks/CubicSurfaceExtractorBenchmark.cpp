@@ -4,6 +4,7 @@
 
 #include "core/benchmark/AbstractBenchmark.h"
 #include "voxel/CubicSurfaceExtractor.h"
+#include "voxel/BinaryCubicSurfaceExtractor.h"
 #include "voxel/IsQuadNeeded.h"
 #include "voxel/MaterialColor.h"
 #include "voxel/Constants.h"
@@ -30,6 +31,21 @@ public:
 		}
 	}
 
+	/**
+	 * @brief Hills with some color variation - this is what the world meshes look like
+	 */
+	template<class Volume>
+	void fillTerrain(const voxel::Region& region, Volume* v) const {
+		for (int x = region.getLowerX(); x < region.getUpperX(); ++x) {
+			for (int z = region.getLowerZ(); z < region.getUpperZ(); ++z) {
+				const int height = 20 + (x / 4 + z / 3) % 12;
+				for (int y = region.getLowerY(); y < height; ++y) {
+					v->setVoxel(x, y, z, voxel::createColorVoxel(voxel::VoxelType::Generic, y / 8));
+				}
+			}
+		}
+	}
+
 	class BenchmarkPager: public voxel::PagedVolume::Pager {
 	public:
 		bool pageIn(voxel::PagedVolume::PagerContext& ctx) override {
@@ -90,6 +106,50 @@ BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractEmpty)(benchm
 	}
 }
 
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractBinaryGreedy)(benchmark::State &state) {
+	const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
+	constexpr voxel::Region volumeRegion(0, MAX_BENCHMARK_VOLUME_SIZE);
+	voxel::RawVolume volume(volumeRegion);
+	fill(region, &volume);
+	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
+	for (auto _ : state) {
+		voxel::extractBinaryCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true);
+	}
+}
+
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractBinary)(benchmark::State &state) {
+	const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
+	constexpr voxel::Region volumeRegion(0, MAX_BENCHMARK_VOLUME_SIZE);
+	voxel::RawVolume volume(volumeRegion);
+	fill(region, &volume);
+	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
+	for (auto _ : state) {
+		voxel::extractBinaryCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), false);
+	}
+}
+
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractBinaryGreedyTerrain)(benchmark::State &state) {
+	const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
+	constexpr voxel::Region volumeRegion(0, MAX_BENCHMARK_VOLUME_SIZE);
+	voxel::RawVolume volume(volumeRegion);
+	fillTerrain(region, &volume);
+	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
+	for (auto _ : state) {
+		voxel::extractBinaryCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true);
+	}
+}
+
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractGreedyTerrain)(benchmark::State &state) {
+	const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
+	constexpr voxel::Region volumeRegion(0, MAX_BENCHMARK_VOLUME_SIZE);
+	voxel::RawVolume volume(volumeRegion);
+	fillTerrain(region, &volume);
+	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
+	for (auto _ : state) {
+		voxel::extractCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true, true);
+	}
+}
+
 BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractGreedy)(benchmark::State &state) {
 	const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
 	BenchmarkPager pager;
@@ -132,14 +192,66 @@ BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractEmpty)(benc
 	}
 }
 
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractBinaryGreedy)(benchmark::State &state) {
+	const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
+	BenchmarkPager pager;
+	voxel::PagedVolume volume(&pager, 1024 * 1024 * 1024, 256);
+	fill(region, &volume);
+	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
+	for (auto _ : state) {
+		voxel::extractBinaryCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true);
+	}
+}
+
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractBinary)(benchmark::State &state) {
+	const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
+	BenchmarkPager pager;
+	voxel::PagedVolume volume(&pager, 1024 * 1024 * 1024, 256);
+	fill(region, &volume);
+	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
+	for (auto _ : state) {
+		voxel::extractBinaryCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), false);
+	}
+}
+
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractBinaryGreedyTerrain)(benchmark::State &state) {
+	const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
+	BenchmarkPager pager;
+	voxel::PagedVolume volume(&pager, 1024 * 1024 * 1024, 256);
+	fillTerrain(region, &volume);
+	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
+	for (auto _ : state) {
+		voxel::extractBinaryCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true);
+	}
+}
+
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractGreedyTerrain)(benchmark::State &state) {
+	const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
+	BenchmarkPager pager;
+	voxel::PagedVolume volume(&pager, 1024 * 1024 * 1024, 256);
+	fillTerrain(region, &volume);
+	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
+	for (auto _ : state) {
+		voxel::extractCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true, true);
+	}
+}
+
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractGreedy)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtract)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractGreedyEmpty)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractEmpty)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractBinaryGreedy)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractBinary)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractGreedyTerrain)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractBinaryGreedyTerrain)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractGreedy)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtract)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractGreedyEmpty)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractEmpty)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractBinaryGreedy)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractBinary)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractGreedyTerrain)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractBinaryGreedyTerrain)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 
 BENCHMARK_MAIN();
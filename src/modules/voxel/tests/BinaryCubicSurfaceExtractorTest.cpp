@@ -0,0 +1,155 @@
+/**
+ * @file
+ */
+
+#include "AbstractVoxelTest.h"
+#include "voxel/BinaryCubicSurfaceExtractor.h"
+#include "voxel/IsQuadNeeded.h"
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+namespace voxel {
+
+class BinaryCubicSurfaceExtractorTest: public AbstractVoxelTest {
+protected:
+	// position, color and ambient occlusion of the four corners of a quad
+	typedef std::vector<std::tuple<int, int, int, int, int>> QuadVertices;
+
+	void fill(RawVolume& volume) const {
+		const Region& region = volume.region();
+		const VoxelType materials[] = {VoxelType::Air, VoxelType::Grass, VoxelType::Water, VoxelType::Rock, VoxelType::Air};
+		for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+			for (int y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+				for (int x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+					// large areas to merge with some holes in them
+					const int idx = glm::abs(x / 3 + y * 7 + (z / 2) * 3 + x * y * z) % 5;
+					volume.setVoxel(x, y, z, createVoxel(materials[idx], glm::abs(x + z) % 3));
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief Both extractors emit two consecutive triangles per quad
+	 */
+	std::vector<QuadVertices> quads(const Mesh& mesh) const {
+		std::vector<QuadVertices> result;
+		const size_t indices = mesh.getNoOfIndices();
+		for (size_t i = 0; i < indices; i += 6) {
+			std::vector<IndexType> quad;
+			for (size_t j = i; j < i + 6; ++j) {
+				const IndexType index = mesh.getIndex(j);
+				if (std::find(quad.begin(), quad.end(), index) == quad.end()) {
+					quad.push_back(index);
+				}
+			}
+			QuadVertices vertices;
+			for (IndexType index : quad) {
+				const VoxelVertex& v = mesh.getVertex(index);
+				vertices.emplace_back(v.position.x, v.position.y, v.position.z, v.colorIndex, v.ambientOcclusion);
+			}
+			std::sort(vertices.begin(), vertices.end());
+			result.push_back(vertices);
+		}
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+
+	/**
+	 * @return The covered area per color
+	 */
+	std::vector<int> area(const Mesh& mesh) const {
+		std::vector<int> result(256, 0);
+		const size_t indices = mesh.getNoOfIndices();
+		for (size_t i = 0; i < indices; i += 3) {
+			const VoxelVertex& v0 = mesh.getVertex(mesh.getIndex(i));
+			const glm::ivec3 p0(v0.position);
+			const glm::ivec3 p1(mesh.getVertex(mesh.getIndex(i + 1)).position);
+			const glm::ivec3 p2(mesh.getVertex(mesh.getIndex(i + 2)).position);
+			const glm::ivec3 a = p1 - p0;
+			const glm::ivec3 b = p2 - p0;
+			const glm::ivec3 c(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+			// the signed area keeps track of the winding - all quads are axis aligned
+			result[v0.colorIndex] += c.x + c.y + c.z;
+		}
+		return result;
+	}
+};
+
+TEST_F(BinaryCubicSurfaceExtractorTest, testSameQuadsAsCubicSurfaceExtractor) {
+	RawVolume volume(Region(glm::ivec3(-2), glm::ivec3(80, 40, 20)));
+	fill(volume);
+	// larger than 64 voxels on one axis
+	const Region region(glm::ivec3(0), glm::ivec3(70, 35, 17));
+	Mesh expected(1024, 1024, true);
+	extractCubicMesh(&volume, region, &expected, IsQuadNeeded(), glm::ivec3(3, 4, 5), false, true);
+	Mesh mesh(1024, 1024, true);
+	extractBinaryCubicMesh(&volume, region, &mesh, IsQuadNeeded(), glm::ivec3(3, 4, 5), false);
+	ASSERT_GT(expected.getNoOfIndices(), 0u);
+	ASSERT_EQ(expected.getNoOfIndices(), mesh.getNoOfIndices());
+	EXPECT_TRUE(quads(expected) == quads(mesh));
+	// the winding must match, too
+	EXPECT_EQ(area(expected), area(mesh));
+}
+
+TEST_F(BinaryCubicSurfaceExtractorTest, testCustomIsQuadNeeded) {
+	RawVolume volume(Region(glm::ivec3(-2), glm::ivec3(20)));
+	fill(volume);
+	const Region region(glm::ivec3(0), glm::ivec3(15));
+	// water is meshed, too - see MeshCache
+	auto isQuadNeeded = [] (const VoxelType& back, const VoxelType& front, FaceNames face) {
+		return isBlocked(back) && !isBlocked(front);
+	};
+	Mesh expected(1024, 1024, true);
+	extractCubicMesh(&volume, region, &expected, isQuadNeeded, region.getLowerCorner(), false, true);
+	Mesh mesh(1024, 1024, true);
+	extractBinaryCubicMesh(&volume, region, &mesh, isQuadNeeded, region.getLowerCorner(), false);
+	ASSERT_GT(expected.getNoOfIndices(), 0u);
+	EXPECT_TRUE(quads(expected) == quads(mesh));
+}
+
+TEST_F(BinaryCubicSurfaceExtractorTest, testMergeQuads) {
+	RawVolume volume(Region(glm::ivec3(-2), glm::ivec3(80, 40, 20)));
+	fill(volume);
+	const Region region(glm::ivec3(0), glm::ivec3(70, 35, 17));
+	Mesh unmerged(1024, 1024, true);
+	extractBinaryCubicMesh(&volume, region, &unmerged, IsQuadNeeded(), region.getLowerCorner(), false);
+	Mesh expected(1024, 1024, true);
+	extractCubicMesh(&volume, region, &expected, IsQuadNeeded(), region.getLowerCorner(), true, true);
+	Mesh mesh(1024, 1024, true);
+	extractBinaryCubicMesh(&volume, region, &mesh, IsQuadNeeded(), region.getLowerCorner(), true);
+	EXPECT_LT(mesh.getNoOfIndices(), unmerged.getNoOfIndices());
+	// the same surface is covered
+	EXPECT_EQ(area(unmerged), area(mesh));
+	EXPECT_EQ(area(expected), area(mesh));
+}
+
+TEST_F(BinaryCubicSurfaceExtractorTest, testMergeQuadsKeepsAmbientOcclusion) {
+	RawVolume volume(Region(glm::ivec3(0), glm::ivec3(15)));
+	// a flat floor with a single voxel on top of it
+	for (int x = 0; x <= 15; ++x) {
+		for (int z = 0; z <= 15; ++z) {
+			volume.setVoxel(x, 0, z, createVoxel(VoxelType::Grass, 0));
+		}
+	}
+	volume.setVoxel(7, 1, 7, createVoxel(VoxelType::Grass, 0));
+	const Region region(glm::ivec3(0), glm::ivec3(14));
+	Mesh mesh(1024, 1024, true);
+	extractBinaryCubicMesh(&volume, region, &mesh, IsQuadNeeded(), region.getLowerCorner(), true);
+	const size_t vertices = mesh.getNoOfVertices();
+	int occluded = 0;
+	for (size_t i = 0; i < vertices; ++i) {
+		const VoxelVertex& v = mesh.getVertex(i);
+		if (v.ambientOcclusion != 3) {
+			// only the floor around the single voxel is occluded
+			EXPECT_EQ(1, v.position.y);
+			EXPECT_GE(v.position.x, 6);
+			EXPECT_LE(v.position.x, 9);
+			++occluded;
+		}
+	}
+	EXPECT_GT(occluded, 0);
+}
+
+}
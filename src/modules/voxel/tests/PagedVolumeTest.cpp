@@ -0,0 +1,229 @@
+/**
+ * @file
+ */
+
+#include "AbstractVoxelTest.h"
+#include "voxel/CubicSurfaceExtractor.h"
+#include "voxel/IsQuadNeeded.h"
+#include <atomic>
+#include <vector>
+
+namespace voxel {
+
+class PagedVolumeTest: public AbstractVoxelTest {
+protected:
+	std::atomic_int _pageIns { 0 };
+	// fill the chunks with data that can't be compressed
+	bool _noise = false;
+	// fill the chunks completely with water
+	bool _water = false;
+
+	bool pageIn(const voxel::Region& region, const PagedVolume::ChunkPtr& chunk) override {
+		++_pageIns;
+		if (_noise) {
+			const int size = chunk->sideLength();
+			for (int x = 0; x < size; ++x) {
+				for (int y = 0; y < size; ++y) {
+					for (int z = 0; z < size; ++z) {
+						chunk->setVoxel(x, y, z, createVoxel(VoxelType::Grass, (x + y * 3 + z * 7) % 255));
+					}
+				}
+			}
+			return true;
+		}
+		if (_water) {
+			const int size = chunk->sideLength();
+			for (int x = 0; x < size; ++x) {
+				for (int y = 0; y < size; ++y) {
+					for (int z = 0; z < size; ++z) {
+						chunk->setVoxel(x, y, z, createVoxel(VoxelType::Water, 0));
+					}
+				}
+			}
+			return true;
+		}
+		chunk->setVoxel(0, 0, 0, createVoxel(VoxelType::Grass, 0));
+		return true;
+	}
+};
+
+TEST_F(PagedVolumeTest, testChunkIsPagedInSynchronously) {
+	const PagedVolume::ChunkPtr& chunk = _volData.chunk(glm::ivec3(0, 0, 0));
+	ASSERT_TRUE(chunk);
+	EXPECT_TRUE(chunk->pagedIn());
+	EXPECT_EQ(VoxelType::Grass, chunk->voxel(0, 0, 0).getMaterial());
+}
+
+TEST_F(PagedVolumeTest, testTryChunkWithoutAsyncPaging) {
+	// without a paging pool the page-in is done inline
+	const PagedVolume::ChunkPtr& chunk = _volData.tryChunk(glm::ivec3(1024, 0, 0));
+	ASSERT_TRUE(chunk);
+	EXPECT_TRUE(chunk->pagedIn());
+}
+
+TEST_F(PagedVolumeTest, testAsyncPagingCoalescesRequests) {
+	Pager pager(this);
+	PagedVolume volume(&pager, 128 * 1024 * 1024, 64);
+	volume.initAsyncPaging(2);
+	const int before = _pageIns;
+	const Region region(glm::ivec3(0), glm::ivec3(127));
+	volume.prefetch(region);
+	volume.prefetch(region);
+	volume.tryChunk(glm::ivec3(0));
+	// the blocking access waits for the pending page-in
+	const PagedVolume::ChunkPtr& chunk = volume.chunk(glm::ivec3(0));
+	ASSERT_TRUE(chunk);
+	EXPECT_TRUE(chunk->pagedIn());
+	EXPECT_EQ(VoxelType::Grass, chunk->voxel(0, 0, 0).getMaterial());
+	volume.flushAll();
+	// 2x2x2 chunks - but every chunk is only paged in once
+	EXPECT_EQ(8, _pageIns - before);
+}
+
+TEST_F(PagedVolumeTest, testWaitForPageIn) {
+	Pager pager(this);
+	PagedVolume volume(&pager, 128 * 1024 * 1024, 64);
+	volume.initAsyncPaging(2);
+	const Region region(glm::ivec3(0), glm::ivec3(127));
+	volume.prefetch(region);
+	volume.waitForPageIn(region);
+	EXPECT_TRUE(volume.prefetch(region));
+}
+
+TEST_F(PagedVolumeTest, testEvictionToLowWaterMark) {
+	_noise = true;
+	Pager pager(this);
+	// the minimum of 32 chunks is enforced
+	PagedVolume volume(&pager, 1 * 1024 * 1024, 32);
+	for (int i = 0; i < 64; ++i) {
+		volume.chunk(glm::ivec3(i * 32, 0, 0));
+	}
+	const PagedVolume::Statistics& stats = volume.statistics();
+	EXPECT_LT(stats.chunks, 32u);
+	EXPECT_EQ(64u, stats.chunks + stats.evictions);
+	EXPECT_EQ(64u, stats.misses);
+	// evicted in batches - not one chunk per page-in
+	EXPECT_GE(stats.evictions, 32u);
+	EXPECT_EQ(0u, stats.evictions % 4u);
+	EXPECT_EQ(0u, stats.compressed);
+}
+
+TEST_F(PagedVolumeTest, testCompressedTier) {
+	Pager pager(this);
+	// the minimum of 32 chunks is enforced
+	PagedVolume volume(&pager, 1 * 1024 * 1024, 32);
+	for (int i = 0; i < 64; ++i) {
+		volume.chunk(glm::ivec3(i * 32, 0, 0));
+	}
+	PagedVolume::Statistics stats = volume.statistics();
+	// the cold chunks are compressed instead of evicted
+	EXPECT_EQ(64u, stats.chunks);
+	EXPECT_EQ(0u, stats.evictions);
+	EXPECT_GT(stats.compressed, 0u);
+	EXPECT_LE(stats.memoryUsage, 2u * 1024u * 1024u);
+	// decompressed on access
+	for (int i = 0; i < 64; ++i) {
+		EXPECT_EQ(VoxelType::Grass, volume.voxel(i * 32, 0, 0).getMaterial());
+		EXPECT_EQ(VoxelType::Air, volume.voxel(i * 32 + 1, 0, 0).getMaterial());
+	}
+	stats = volume.statistics();
+	EXPECT_EQ(0u, stats.evictions);
+	EXPECT_LE(stats.memoryUsage, 2u * 1024u * 1024u);
+}
+
+TEST_F(PagedVolumeTest, testStatistics) {
+	Pager pager(this);
+	PagedVolume volume(&pager, 128 * 1024 * 1024, 64);
+	volume.voxel(0, 0, 0);
+	volume.voxel(1, 1, 1);
+	volume.voxel(2, 2, 2);
+	const PagedVolume::Statistics& stats = volume.statistics();
+	EXPECT_EQ(1u, stats.misses);
+	EXPECT_EQ(2u, stats.hits);
+	EXPECT_EQ(1u, stats.chunks);
+	EXPECT_EQ(0u, stats.evictions);
+}
+
+TEST_F(PagedVolumeTest, testUniformChunk) {
+	PagedVolume::Chunk chunk(glm::ivec3(0), 32, &_pager);
+	ASSERT_TRUE(chunk.isUniform());
+	EXPECT_EQ(VoxelType::Air, chunk.uniformVoxel().getMaterial());
+	// writing the same value keeps the chunk uniform
+	chunk.setVoxel(1, 2, 3, Voxel());
+	ASSERT_TRUE(chunk.isUniform());
+	chunk.setVoxel(1, 2, 3, createVoxel(VoxelType::Grass, 0));
+	ASSERT_FALSE(chunk.isUniform());
+	EXPECT_EQ(VoxelType::Grass, chunk.voxel(1, 2, 3).getMaterial());
+	EXPECT_EQ(VoxelType::Air, chunk.voxel(3, 2, 1).getMaterial());
+}
+
+TEST_F(PagedVolumeTest, testUniformChunkAfterPageIn) {
+	_water = true;
+	Pager pager(this);
+	PagedVolume volume(&pager, 128 * 1024 * 1024, 32);
+	const PagedVolume::ChunkPtr& chunk = volume.chunk(glm::ivec3(0));
+	ASSERT_TRUE(chunk->isUniform());
+	EXPECT_EQ(VoxelType::Water, chunk->uniformVoxel().getMaterial());
+	EXPECT_EQ(0u, volume.statistics().memoryUsage);
+
+	// the sampler must not write into the shared voxel buffer
+	PagedVolume::Sampler sampler(volume);
+	sampler.setPosition(1, 1, 1);
+	ASSERT_TRUE(sampler.setVoxel(createVoxel(VoxelType::Grass, 0)));
+	EXPECT_FALSE(chunk->isUniform());
+	// the own voxel buffer counts against the memory budget
+	EXPECT_GE(volume.statistics().memoryUsage, chunk->dataSizeInBytes());
+	EXPECT_EQ(VoxelType::Grass, volume.voxel(1, 1, 1).getMaterial());
+	EXPECT_EQ(VoxelType::Water, volume.voxel(2, 2, 2).getMaterial());
+	EXPECT_EQ(VoxelType::Water, volume.voxel(32, 2, 2).getMaterial());
+}
+
+TEST_F(PagedVolumeTest, testFloorAfterSetDataOnUniformChunk) {
+	_water = true;
+	Pager pager(this);
+	PagedVolume volume(&pager, 128 * 1024 * 1024, 32);
+	const PagedVolume::ChunkPtr& chunk = volume.chunk(glm::ivec3(0));
+	ASSERT_TRUE(chunk->isUniform());
+	std::vector<Voxel> voxels(chunk->voxels(), createVoxel(VoxelType::Water, 0));
+	voxels[0] = createVoxel(VoxelType::Grass, 0);
+	ASSERT_TRUE(chunk->setData(voxels.data(), voxels.size() * sizeof(Voxel)));
+	ASSERT_FALSE(chunk->isUniform());
+	EXPECT_EQ(0, chunk->highestSolidVoxel(0, 0, 31));
+	EXPECT_EQ(1, chunk->lowestEnterableVoxel(0, 0, 0));
+	EXPECT_EQ(-1, chunk->highestSolidVoxel(1, 0, 31));
+	// the voxel buffer and the column index count against the memory budget
+	EXPECT_GT(volume.statistics().memoryUsage, chunk->dataSizeInBytes());
+}
+
+TEST_F(PagedVolumeTest, testFloorAfterSamplerWrite) {
+	_noise = true;
+	Pager pager(this);
+	PagedVolume volume(&pager, 128 * 1024 * 1024, 32);
+	const PagedVolume::ChunkPtr& chunk = volume.chunk(glm::ivec3(0));
+	ASSERT_FALSE(chunk->isUniform());
+	ASSERT_EQ(31, chunk->highestSolidVoxel(0, 0, 31));
+	PagedVolume::Sampler sampler(volume);
+	for (int y = 0; y < 32; ++y) {
+		sampler.setPosition(0, y, 0);
+		ASSERT_TRUE(sampler.setVoxel(Voxel()));
+	}
+	sampler.setPosition(0, 5, 0);
+	ASSERT_TRUE(sampler.setVoxel(createVoxel(VoxelType::Grass, 0)));
+	EXPECT_EQ(5, chunk->highestSolidVoxel(0, 0, 31));
+	EXPECT_EQ(6, chunk->lowestEnterableVoxel(0, 0, 5));
+}
+
+TEST_F(PagedVolumeTest, testExtractUniformRegion) {
+	_water = true;
+	Pager pager(this);
+	PagedVolume volume(&pager, 128 * 1024 * 1024, 32);
+	const Region region(glm::ivec3(32), glm::ivec3(63));
+	Voxel voxel;
+	ASSERT_TRUE(volume.isUniform(region, voxel));
+	EXPECT_EQ(VoxelType::Water, voxel.getMaterial());
+	Mesh mesh(128, 128, true);
+	extractCubicMesh(&volume, region, &mesh, IsQuadNeeded(), region.getLowerCorner());
+	EXPECT_EQ(0u, mesh.getNoOfIndices());
+}
+
+}
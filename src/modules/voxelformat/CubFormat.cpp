@@ -110,7 +110,7 @@ bool CubFormat::saveGroups(const VoxelVolumes& volumes, const io::FilePtr& file)
 		}
 	}
 	delete mergedVolume;
-	return true;
+	return stream.flush();
 }
 
 }
@@ -157,7 +157,7 @@ bool QBFormat::saveGroups(const VoxelVolumes& volumes, const io::FilePtr& file)
 			return false;
 		}
 	}
-	return true;
+	return stream.flush();
 }
 
 bool QBFormat::setVoxel(voxel::RawVolume* volume, uint32_t x, uint32_t y, uint32_t z, const glm::ivec3& offset, const voxel::Voxel& voxel) {
@@ -209,7 +209,7 @@ bool QBTFormat::saveGroups(const VoxelVolumes& volumes, const io::FilePtr& file)
 	}
 	saveModel(stream, volumes, colorMap);
 	Log::debug("Saved %i layers", layers);
-	return success;
+	return success && stream.flush();
 }
 
 bool QBTFormat::skipNode(io::FileStream& stream) {
@@ -189,7 +189,7 @@ bool VXLFormat::saveGroups(const VoxelVolumes& volumes, const io::FilePtr& file)
 	for (uint32_t i = 0; i < volumes.size(); ++i) {
 		wrapBool(writeLimbFooter(stream, volumes, i, limbOffsets[i]))
 	}
-	return true;
+	return stream.flush();
 }
 
 bool VXLFormat::readLimb(io::FileStream& stream, vxl_mdl& mdl, uint32_t limbIdx, VoxelVolumes& volumes) const {
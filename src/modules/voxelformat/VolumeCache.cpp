@@ -7,6 +7,8 @@
 #include "voxelformat/VoxFileFormat.h"
 #include "core/io/Filesystem.h"
 #include "core/App.h"
+#include "core/GameConfig.h"
+#include "core/Var.h"
 #include "core/command/Command.h"
 #include "core/Log.h"
 
@@ -16,15 +18,8 @@ VolumeCache::~VolumeCache() {
 	core_assert_msg(_volumes.empty(), "VolumeCache wasn't shut down properly");
 }
 
-voxel::RawVolume* VolumeCache::loadVolume(const char* fullPath) {
-	const core::String filename = fullPath;
-	{
-		core::ScopedLock lock(_mutex);
-		auto i = _volumes.find(filename);
-		if (i != _volumes.end()) {
-			return i->second;
-		}
-	}
+CachedVolumePtr VolumeCache::load(const char* fullPath) {
+	core_trace_scoped(VolumeCacheLoad);
 	Log::info("Loading volume from %s", fullPath);
 	const io::FilesystemPtr& fs = io::filesystem();
 
@@ -39,45 +34,181 @@ voxel::RawVolume* VolumeCache::loadVolume(const char* fullPath) {
 	if (!voxelformat::loadVolumeFormat(file, volumes)) {
 		Log::error("Failed to load %s", file->name().c_str());
 		voxelformat::clearVolumes(volumes);
-		core::ScopedLock lock(_mutex);
-		_volumes.put(filename, nullptr);
-		return nullptr;
+		return CachedVolumePtr();
 	}
-	voxel::RawVolume* v = volumes.merge();
+	CachedVolumePtr v(volumes.merge());
 	voxelformat::clearVolumes(volumes);
+	return v;
+}
+
+CachedVolumePtr VolumeCache::loadEntry(const core::String& filename, const std::shared_ptr<std::promise<CachedVolumePtr>>& promise) {
+	const CachedVolumePtr v = load(filename.c_str());
+	// failed loads are cached, too - to not try it again and again
+	promise->set_value(v);
 
 	core::ScopedLock lock(_mutex);
-	_volumes.put(filename, v);
+	auto i = _volumes.find(filename);
+	// the cache might have been cleared in the meantime
+	if (i == _volumes.end() || i->value.promise != promise) {
+		return v;
+	}
+	Entry& entry = i->value;
+	entry.state = State::Loaded;
+	entry.promise = nullptr;
+	if (v) {
+		entry.bytes = sizeof(voxel::RawVolume) + (size_t)v->region().voxels() * sizeof(voxel::Voxel);
+		_bytes += entry.bytes;
+		evict(filename);
+	}
 	return v;
 }
 
+CachedVolumePtr VolumeCache::loadVolume(const char* fullPath) {
+	const core::String filename = fullPath;
+	std::shared_ptr<std::promise<CachedVolumePtr>> promise;
+	std::shared_future<CachedVolumePtr> future;
+	{
+		core::ScopedLock lock(_mutex);
+		auto i = _volumes.find(filename);
+		if (i == _volumes.end()) {
+			Entry entry;
+			entry.promise = std::make_shared<std::promise<CachedVolumePtr>>();
+			entry.future = entry.promise->get_future().share();
+			entry.lastAccess = ++_accessCounter;
+			_volumes.put(filename, entry);
+			promise = entry.promise;
+			++_misses;
+		} else {
+			Entry& entry = i->value;
+			entry.lastAccess = ++_accessCounter;
+			if (entry.state == State::Queued) {
+				// don't wait for the thread pool - the prefetch task skips entries that were claimed
+				entry.state = State::Loading;
+				promise = entry.promise;
+				++_misses;
+			} else {
+				future = entry.future;
+				++_hits;
+			}
+		}
+	}
+	if (promise) {
+		return loadEntry(filename, promise);
+	}
+	// another thread might still load it
+	return future.get();
+}
+
+void VolumeCache::prefetch(const char* fullPath) {
+	const core::String filename = fullPath;
+	std::shared_ptr<std::promise<CachedVolumePtr>> promise;
+	{
+		core::ScopedLock lock(_mutex);
+		if (_volumes.find(filename) != _volumes.end()) {
+			return;
+		}
+		Entry entry;
+		entry.promise = std::make_shared<std::promise<CachedVolumePtr>>();
+		entry.future = entry.promise->get_future().share();
+		entry.state = State::Queued;
+		entry.lastAccess = ++_accessCounter;
+		_volumes.put(filename, entry);
+		promise = entry.promise;
+	}
+	const bool scheduled = core::App::getInstance()->threadPool().schedule(_prefetchGroup, [this, filename, promise] () {
+		{
+			core::ScopedLock lock(_mutex);
+			auto i = _volumes.find(filename);
+			if (i == _volumes.end() || i->value.promise != promise || i->value.state != State::Queued) {
+				return;
+			}
+			i->value.state = State::Loading;
+		}
+		loadEntry(filename, promise);
+	}, core::TaskPriority::Low);
+	if (scheduled) {
+		return;
+	}
+	core::ScopedLock lock(_mutex);
+	auto i = _volumes.find(filename);
+	if (i != _volumes.end() && i->value.promise == promise && i->value.state == State::Queued) {
+		_volumes.erase(i);
+	}
+}
+
+void VolumeCache::evict(const core::String& keep) {
+	if (_maxBytes == 0u) {
+		return;
+	}
+	while (_bytes > _maxBytes) {
+		core::String lru;
+		uint64_t lruAccess = UINT64_MAX;
+		size_t lruBytes = 0u;
+		for (const auto& e : _volumes) {
+			const Entry& entry = e->value;
+			// volumes that are still loading are not part of the budget yet
+			if (entry.state != State::Loaded || entry.bytes == 0u || e->key == keep) {
+				continue;
+			}
+			if (entry.lastAccess < lruAccess) {
+				lruAccess = entry.lastAccess;
+				lru = e->key;
+				lruBytes = entry.bytes;
+			}
+		}
+		if (lruBytes == 0u) {
+			break;
+		}
+		Log::debug("Evict volume %s from the cache", lru.c_str());
+		_volumes.remove(lru);
+		_bytes -= lruBytes;
+		++_evictions;
+	}
+}
+
+void VolumeCache::setMaxSize(size_t bytes) {
+	core::ScopedLock lock(_mutex);
+	_maxBytes = bytes;
+	evict("");
+}
+
+void VolumeCache::clear() {
+	core::ScopedLock lock(_mutex);
+	_volumes.clear();
+	_bytes = 0u;
+}
+
 void VolumeCache::construct() {
 	core::Command::registerCommand("volumecachelist", [&] (const core::CmdArgs& argv) {
 		Log::info("Cache content");
 		core::ScopedLock lock(_mutex);
 		for (const auto& e : _volumes) {
-			Log::info(" * %s", e->key.c_str());
+			const Entry& entry = e->value;
+			if (entry.state == State::Loaded) {
+				Log::info(" * %s (%i kb)", e->key.c_str(), (int)(entry.bytes / 1024u));
+			} else {
+				Log::info(" * %s (loading)", e->key.c_str());
+			}
 		}
+		Log::info("Memory: %i/%i kb", (int)(_bytes / 1024u), (int)(_maxBytes / 1024u));
+		Log::info("Hits: %i, misses: %i, evictions: %i", hits(), misses(), evictions());
 	});
 	core::Command::registerCommand("volumecacheclear", [&] (const core::CmdArgs& argv) {
-		core::ScopedLock lock(_mutex);
-		for (const auto & e : _volumes) {
-			delete e->value;
-		}
-		_volumes.clear();
+		clear();
 	});
 }
 
 bool VolumeCache::init() {
+	const int maxSize = core::Var::get(cfg::VoxelVolumeCacheSize, "256")->intVal();
+	_maxBytes = (size_t)core_max(0, maxSize) * 1024u * 1024u;
 	return true;
 }
 
 void VolumeCache::shutdown() {
-	core::ScopedLock lock(_mutex);
-	for (const auto & e : _volumes) {
-		delete e->value;
+	if (!_prefetchGroup.done()) {
+		core::App::getInstance()->threadPool().wait(_prefetchGroup);
 	}
-	_volumes.clear();
+	clear();
 }
 
 }
@@ -7,28 +7,112 @@
 #include "core/IComponent.h"
 #include "voxel/RawVolume.h"
 #include "core/collection/StringMap.h"
+#include "core/concurrent/ThreadPool.h"
 #include <memory>
+#include <future>
+#include <atomic>
 #include "core/concurrent/Lock.h"
 #include "core/Trace.h"
 
 namespace voxelformat {
 
+/**
+ * @brief The cached volumes are shared with the callers - an evicted volume stays
+ * alive until the last user released it.
+ */
+using CachedVolumePtr = std::shared_ptr<const voxel::RawVolume>;
+
+/**
+ * @brief Thread safe cache of the merged volumes of voxel models
+ *
+ * Concurrent requests for the same model are only loaded once - the other callers
+ * wait for the result of the first one. The memory of the cached volumes is bounded
+ * by @c cfg::VoxelVolumeCacheSize - the least recently used volumes are evicted.
+ */
 class VolumeCache : public core::IComponent {
 private:
-	core::StringMap<voxel::RawVolume*> _volumes;
+	enum class State : uint8_t {
+		// the load was scheduled by prefetch() but didn't start yet
+		Queued,
+		Loading,
+		Loaded
+	};
+	struct Entry {
+		std::shared_ptr<std::promise<CachedVolumePtr>> promise;
+		std::shared_future<CachedVolumePtr> future;
+		State state = State::Loading;
+		size_t bytes = 0u;
+		uint64_t lastAccess = 0u;
+	};
+	core::StringMap<Entry> _volumes;
 	core_trace_mutex(core::Lock, _mutex, "VolumeCache");
+	size_t _maxBytes = 0u;
+	// the memory of the loaded volumes - only modified with the mutex locked
+	std::atomic_size_t _bytes { 0u };
+	uint64_t _accessCounter = 0u;
+	std::atomic_int _hits { 0 };
+	std::atomic_int _misses { 0 };
+	std::atomic_int _evictions { 0 };
+	core::TaskGroup _prefetchGroup;
+
+	static CachedVolumePtr load(const char* fullPath);
+	/**
+	 * @brief Loads the volume of an entry that was claimed by the caller and publishes the result
+	 */
+	CachedVolumePtr loadEntry(const core::String& filename, const std::shared_ptr<std::promise<CachedVolumePtr>>& promise);
+	/**
+	 * @brief Evicts the least recently used volumes until the cache fits into the memory budget
+	 * @note The mutex must be locked
+	 * @param[in] keep This entry is never evicted
+	 */
+	void evict(const core::String& keep);
+	void clear();
 public:
 	~VolumeCache();
 	/**
-	 * The returned volume is not owned by the caller. The cache will delete the memory.
+	 * @note The cache keeps a reference to the volume - but it might get evicted at any time.
+	 * @return @c nullptr if the volume couldn't get loaded
 	 */
-	voxel::RawVolume* loadVolume(const char* fullPath);
+	CachedVolumePtr loadVolume(const char* fullPath);
+	/**
+	 * @brief Loads the given volume asynchronously on the app thread pool if it's not
+	 * yet cached or being loaded.
+	 */
+	void prefetch(const char* fullPath);
+
+	/**
+	 * @brief The memory budget in bytes - @c 0 means unbounded. Overrides @c cfg::VoxelVolumeCacheSize.
+	 */
+	void setMaxSize(size_t bytes);
+	/**
+	 * @return The memory of the cached volumes in bytes
+	 */
+	size_t size() const;
+	int hits() const;
+	int misses() const;
+	int evictions() const;
 
 	bool init() override;
 	void shutdown() override;
 	void construct() override;
 };
 
+inline size_t VolumeCache::size() const {
+	return _bytes;
+}
+
+inline int VolumeCache::hits() const {
+	return _hits;
+}
+
+inline int VolumeCache::misses() const {
+	return _misses;
+}
+
+inline int VolumeCache::evictions() const {
+	return _evictions;
+}
+
 using VolumeCachePtr = std::shared_ptr<VolumeCache>;
 
 }
@@ -317,7 +317,7 @@ bool VoxFormat::saveGroups(const VoxelVolumes& volumes, const io::FilePtr& file)
 
 	wrapBool(saveSceneGraph(stream, volumes, modelId))
 
-	return true;
+	return stream.flush();
 }
 
 bool VoxFormat::readAttributes(Attributes& attributes, io::FileStream& stream) const {
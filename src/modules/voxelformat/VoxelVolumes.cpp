@@ -24,7 +24,7 @@ VoxelVolumes::~VoxelVolumes() {
 	volumes.clear();
 }
 
-voxel::RawVolume *VoxelVolumes::merge() const {
+voxel::RawVolume *VoxelVolumes::merge(core::ThreadPool* threadPool) const {
 	if (volumes.empty()) {
 		return nullptr;
 	}
@@ -45,7 +45,7 @@ voxel::RawVolume *VoxelVolumes::merge() const {
 	if (rawVolumes.empty()) {
 		return nullptr;
 	}
-	return ::voxel::merge(rawVolumes);
+	return ::voxel::merge(rawVolumes, threadPool);
 }
 
 }
@@ -9,6 +9,10 @@
 #include "core/Common.h"
 #include <vector>
 
+namespace core {
+class ThreadPool;
+}
+
 namespace voxel {
 
 static constexpr int MaxRegionSize = 256;
@@ -71,7 +75,11 @@ struct VoxelVolumes {
 		return volumes[idx];
 	}
 
-	voxel::RawVolume* merge() const;
+	/**
+	 * @param[in] threadPool Optional thread pool to merge the volumes in parallel
+	 * @sa voxel::merge()
+	 */
+	voxel::RawVolume* merge(core::ThreadPool* threadPool = nullptr) const;
 };
 
 }
\ No newline at end of file
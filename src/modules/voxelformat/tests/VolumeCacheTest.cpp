@@ -0,0 +1,85 @@
+/**
+ * @file
+ */
+
+#include "AbstractVoxFormatTest.h"
+#include "voxelformat/VolumeCache.h"
+#include <thread>
+#include <vector>
+
+namespace voxel {
+
+class VolumeCacheTest: public AbstractVoxFormatTest {
+protected:
+	voxelformat::VolumeCache _cache;
+
+	void SetUp() override {
+		AbstractVoxFormatTest::SetUp();
+		_cache.construct();
+		ASSERT_TRUE(_cache.init());
+	}
+
+	void TearDown() override {
+		_cache.shutdown();
+		AbstractVoxFormatTest::TearDown();
+	}
+};
+
+TEST_F(VolumeCacheTest, testLoad) {
+	const voxelformat::CachedVolumePtr& v = _cache.loadVolume("magicavoxel");
+	ASSERT_TRUE((bool)v);
+	EXPECT_EQ(v, _cache.loadVolume("magicavoxel"));
+	EXPECT_EQ(1, _cache.misses());
+	EXPECT_EQ(1, _cache.hits());
+	EXPECT_LT(0u, _cache.size());
+}
+
+TEST_F(VolumeCacheTest, testLoadFailed) {
+	EXPECT_FALSE((bool)_cache.loadVolume("doesnotexist"));
+	EXPECT_FALSE((bool)_cache.loadVolume("doesnotexist"));
+	EXPECT_EQ(1, _cache.misses()) << "Failed loads should be cached, too";
+}
+
+TEST_F(VolumeCacheTest, testConcurrentLoad) {
+	constexpr int Threads = 4;
+	voxelformat::CachedVolumePtr volumes[Threads];
+	std::vector<std::thread> threads;
+	for (int i = 0; i < Threads; ++i) {
+		threads.emplace_back([this, &volumes, i] () {
+			volumes[i] = _cache.loadVolume("qubicle");
+		});
+	}
+	for (std::thread& t : threads) {
+		t.join();
+	}
+	ASSERT_TRUE((bool)volumes[0]);
+	for (int i = 1; i < Threads; ++i) {
+		EXPECT_EQ(volumes[0], volumes[i]);
+	}
+	EXPECT_EQ(1, _cache.misses()) << "The volume should only be loaded once";
+	EXPECT_EQ(Threads - 1, _cache.hits());
+}
+
+TEST_F(VolumeCacheTest, testEviction) {
+	const voxelformat::CachedVolumePtr& first = _cache.loadVolume("magicavoxel");
+	ASSERT_TRUE((bool)first);
+	const size_t firstSize = _cache.size();
+	_cache.setMaxSize(firstSize);
+	ASSERT_TRUE((bool)_cache.loadVolume("qubicle"));
+	// the volume that was loaded last is kept - even if it exceeds the budget on its own
+	EXPECT_EQ(1, _cache.evictions());
+	// the evicted volume is still alive because it's shared with this caller - so the reload
+	// can't end up at the same address
+	EXPECT_NE(first, _cache.loadVolume("magicavoxel")) << "The least recently used volume should have been evicted";
+	EXPECT_EQ(3, _cache.misses());
+}
+
+TEST_F(VolumeCacheTest, testPrefetch) {
+	_cache.prefetch("magicavoxel");
+	_cache.prefetch("magicavoxel");
+	ASSERT_TRUE((bool)_cache.loadVolume("magicavoxel"));
+	EXPECT_GE(1, _cache.misses());
+	EXPECT_EQ(1, _cache.misses() + _cache.hits());
+}
+
+}
@@ -45,8 +45,45 @@ FloorTraceResult findWalkableFloor(voxel::PagedVolume::Sampler *sampler, const g
 }
 
 FloorTraceResult findWalkableFloor(voxel::PagedVolume* volume, const glm::ivec3& position, int maxDistanceUpwards) {
-	voxel::PagedVolume::Sampler sampler(volume);
-	return findWalkableFloor(&sampler, position, maxDistanceUpwards);
+	core_trace_scoped(FindWalkableFloor);
+	// this is answered from the column index of the chunks - every chunk that the column
+	// crosses is only visited once instead of sampling every single voxel
+	const int sideLength = volume->chunkSideLength();
+	const int mask = sideLength - 1;
+	const uint32_t x = (uint32_t)(position.x & mask);
+	const uint32_t z = (uint32_t)(position.z & mask);
+
+	voxel::PagedVolume::ChunkPtr chunk = volume->chunk(position);
+	const voxel::VoxelType type = chunk->voxel(x, position.y & mask, z).getMaterial();
+	if (voxel::isEnterable(type)) {
+		int y = position.y - 1;
+		while (y >= 0) {
+			chunk = volume->chunk(glm::ivec3(position.x, y, position.z));
+			const int chunkY = y & ~mask;
+			const int solid = chunk->highestSolidVoxel(x, z, y & mask);
+			if (solid >= 0) {
+				return FloorTraceResult(chunkY + solid + 1, chunk->voxel(x, solid, z));
+			}
+			y = chunkY - 1;
+		}
+		return FloorTraceResult();
+	}
+
+	const int maxY = position.y + core_min(maxDistanceUpwards, voxel::MAX_HEIGHT - position.y);
+	int y = position.y + 1;
+	while (y <= maxY) {
+		chunk = volume->chunk(glm::ivec3(position.x, y, position.z));
+		const int chunkY = y & ~mask;
+		const int enterable = chunk->lowestEnterableVoxel(x, z, y & mask);
+		if (enterable >= 0) {
+			if (chunkY + enterable > maxY) {
+				break;
+			}
+			return FloorTraceResult(chunkY + enterable, chunk->voxel(x, enterable, z));
+		}
+		y = chunkY + sideLength;
+	}
+	return FloorTraceResult();
 }
 
 }
@@ -6,11 +6,13 @@
 #include <limits>
 #include "core/GLM.h"
 #include "core/Log.h"
+#include "core/concurrent/ThreadPool.h"
 #include <glm/common.hpp>
 
 namespace voxel {
 
-RawVolume* merge(const std::vector<const RawVolume*>& volumes) {
+RawVolume* merge(const std::vector<const RawVolume*>& volumes, core::ThreadPool* threadPool) {
+	core_trace_scoped(MergeVolumes);
 	glm::ivec3 mins((std::numeric_limits<int32_t>::max)() / 2);
 	glm::ivec3 maxs((std::numeric_limits<int32_t>::min)() / 2);
 	for (const voxel::RawVolume* v : volumes) {
@@ -25,17 +27,47 @@ RawVolume* merge(const std::vector<const RawVolume*>& volumes) {
 			mergedRegion.getUpperX(), mergedRegion.getUpperY(), mergedRegion.getUpperZ());
 	Log::debug("Mins: %i:%i:%i Maxs %i:%i:%i", mins.x, mins.y, mins.z, maxs.x, maxs.y, maxs.z);
 	voxel::RawVolume* merged = new voxel::RawVolume(mergedRegion);
-	for (const voxel::RawVolume* v : volumes) {
-		const voxel::Region& sr = v->region();
-		const glm::ivec3& destMins = sr.getLowerCorner() - mins;
-		const voxel::Region dr(destMins, destMins + sr.getDimensionsInCells());
-		Log::debug("Merge %i:%i:%i - %i:%i:%i into %i:%i:%i - %i:%i:%i",
-				sr.getLowerX(), sr.getLowerY(), sr.getLowerZ(),
-				sr.getUpperX(), sr.getUpperY(), sr.getUpperZ(),
-				dr.getLowerX(), dr.getLowerY(), dr.getLowerZ(),
-				dr.getUpperX(), dr.getUpperY(), dr.getUpperZ());
-		voxel::mergeVolumes(merged, v, dr, sr);
+
+	// merges all the volumes (in the given order) into the slices [lowerZ, upperZ] of the merged volume
+	auto mergeSlices = [&volumes, &mins, merged] (int lowerZ, int upperZ) {
+		for (const voxel::RawVolume* v : volumes) {
+			const voxel::Region& sr = v->region();
+			const glm::ivec3& destMins = sr.getLowerCorner() - mins;
+			const voxel::Region dr(destMins, destMins + sr.getDimensionsInCells());
+			const int destLowerZ = core_max(dr.getLowerZ(), lowerZ);
+			const int destUpperZ = core_min(dr.getUpperZ(), upperZ);
+			if (destLowerZ > destUpperZ) {
+				continue;
+			}
+			const voxel::Region clippedDest(dr.getLowerX(), dr.getLowerY(), destLowerZ, dr.getUpperX(), dr.getUpperY(), destUpperZ);
+			const voxel::Region clippedSource(sr.getLowerX(), sr.getLowerY(), sr.getLowerZ() + destLowerZ - dr.getLowerZ(),
+					sr.getUpperX(), sr.getUpperY(), sr.getLowerZ() + destUpperZ - dr.getLowerZ());
+			Log::debug("Merge %i:%i:%i - %i:%i:%i into %i:%i:%i - %i:%i:%i",
+					clippedSource.getLowerX(), clippedSource.getLowerY(), clippedSource.getLowerZ(),
+					clippedSource.getUpperX(), clippedSource.getUpperY(), clippedSource.getUpperZ(),
+					clippedDest.getLowerX(), clippedDest.getLowerY(), clippedDest.getLowerZ(),
+					clippedDest.getUpperX(), clippedDest.getUpperY(), clippedDest.getUpperZ());
+			voxel::mergeVolumes(merged, v, clippedDest, clippedSource);
+		}
+	};
+
+	const int depth = mergedRegion.getDepthInVoxels();
+	if (threadPool == nullptr || threadPool->size() <= 1u) {
+		mergeSlices(0, depth - 1);
+		return merged;
+	}
+	// the slices don't share any voxels - so the tasks don't need any synchronization
+	const int tasks = core_min(depth, (int)threadPool->size() * 2);
+	const int slices = (depth + tasks - 1) / tasks;
+	core::TaskGroup group;
+	for (int z = 0; z < depth; z += slices) {
+		const int lowerZ = z;
+		const int upperZ = core_min(z + slices, depth) - 1;
+		if (!threadPool->schedule(group, [&mergeSlices, lowerZ, upperZ] () { mergeSlices(lowerZ, upperZ); })) {
+			mergeSlices(lowerZ, upperZ);
+		}
 	}
+	threadPool->wait(group);
 	return merged;
 }
 
@@ -9,6 +9,10 @@
 #include "core/Assert.h"
 #include <vector>
 
+namespace core {
+class ThreadPool;
+}
+
 namespace voxel {
 
 /**
@@ -61,6 +65,12 @@ inline int mergeRawVolumesSameDimension(RawVolume* destination, const RawVolume*
 	return mergeVolumes(destination, source, destination->region(), source->region());
 }
 
-extern RawVolume* merge(const std::vector<const RawVolume*>& volumes);
+/**
+ * @brief Merges the given volumes into one new volume that covers all of them. Overlapping voxels
+ * of later volumes overwrite the earlier ones.
+ * @param[in] threadPool If given, the slices of the new volume are merged in parallel - the
+ * result is the same as for the serial merge.
+ */
+extern RawVolume* merge(const std::vector<const RawVolume*>& volumes, core::ThreadPool* threadPool = nullptr);
 
 }
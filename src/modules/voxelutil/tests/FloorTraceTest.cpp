@@ -0,0 +1,107 @@
+/**
+ * @file
+ */
+
+#include "core/tests/AbstractTest.h"
+#include "voxel/PagedVolume.h"
+#include "voxelutil/FloorTrace.h"
+
+namespace voxelutil {
+
+class FloorTraceTest: public core::AbstractTest {
+protected:
+	/**
+	 * @brief Terrain with caves and overhangs - some of them cross the chunk borders
+	 */
+	class TerrainPager: public voxel::PagedVolume::Pager {
+	public:
+		static voxel::Voxel voxelAt(int x, int y, int z) {
+			if (y < 0) {
+				return voxel::Voxel();
+			}
+			const int height = 10 + (x + z) % 7;
+			const bool cave = x % 5 == 0 && y >= 4 && y <= 6;
+			if (y <= height && !cave) {
+				return voxel::createVoxel(voxel::VoxelType::Grass, x % 3);
+			}
+			if (y == height + 1 && z % 4 == 0) {
+				return voxel::createVoxel(voxel::VoxelType::Water, 0);
+			}
+			// overhang that crosses the border between the first and the second chunk
+			if (z % 3 == 0 && y >= 30 && y <= 33) {
+				return voxel::createVoxel(voxel::VoxelType::Rock, 0);
+			}
+			// floating island at the top of the world
+			if (x % 7 == 0 && y >= 100 && y <= 130) {
+				return voxel::createVoxel(voxel::VoxelType::Dirt, 0);
+			}
+			return voxel::Voxel();
+		}
+
+		bool pageIn(voxel::PagedVolume::PagerContext& ctx) override {
+			const voxel::Region& region = ctx.region;
+			const int sideLength = ctx.chunk->sideLength();
+			for (int x = 0; x < sideLength; ++x) {
+				for (int y = 0; y < sideLength; ++y) {
+					for (int z = 0; z < sideLength; ++z) {
+						const voxel::Voxel& v = voxelAt(region.getLowerX() + x, region.getLowerY() + y, region.getLowerZ() + z);
+						ctx.chunk->setVoxel(x, y, z, v);
+					}
+				}
+			}
+			return false;
+		}
+
+		void pageOut(voxel::PagedVolume::Chunk* chunk) override {
+		}
+	};
+
+	TerrainPager _pager;
+
+	void compare(voxel::PagedVolume& volume) {
+		voxel::PagedVolume::Sampler sampler(volume);
+		const int maxDistances[] = {voxel::MAX_HEIGHT, 3};
+		for (int x = 0; x < 24; ++x) {
+			for (int z = 0; z < 24; ++z) {
+				for (int y = -1; y <= voxel::MAX_HEIGHT + 1; y += 3) {
+					for (int maxDistance : maxDistances) {
+						const glm::ivec3 pos(x, y, z);
+						const FloorTraceResult& expected = findWalkableFloor(&sampler, pos, maxDistance);
+						const FloorTraceResult& result = findWalkableFloor(&volume, pos, maxDistance);
+						ASSERT_EQ(expected.heightLevel, result.heightLevel) << "at " << x << ":" << y << ":" << z << " (" << maxDistance << ")";
+						ASSERT_EQ(expected.voxel.getMaterial(), result.voxel.getMaterial());
+						ASSERT_EQ(expected.voxel.getColor(), result.voxel.getColor());
+					}
+				}
+			}
+		}
+	}
+};
+
+TEST_F(FloorTraceTest, testColumnIndexMatchesSampler) {
+	voxel::PagedVolume volume(&_pager, 128 * 1024 * 1024, 32);
+	compare(volume);
+}
+
+TEST_F(FloorTraceTest, testColumnIndexMatchesSamplerLargeChunks) {
+	// more than 64 voxels per column
+	voxel::PagedVolume volume(&_pager, 128 * 1024 * 1024, 128);
+	compare(volume);
+}
+
+TEST_F(FloorTraceTest, testColumnIndexIsUpdated) {
+	voxel::PagedVolume volume(&_pager, 128 * 1024 * 1024, 32);
+	const glm::ivec3 pos(1, 20, 1);
+	EXPECT_EQ(13, findWalkableFloor(&volume, pos, voxel::MAX_HEIGHT).heightLevel);
+	volume.setVoxel(glm::ivec3(1, 18, 1), voxel::createVoxel(voxel::VoxelType::Rock, 0));
+	EXPECT_EQ(19, findWalkableFloor(&volume, pos, voxel::MAX_HEIGHT).heightLevel);
+	volume.setVoxel(glm::ivec3(1, 18, 1), voxel::Voxel());
+	EXPECT_EQ(13, findWalkableFloor(&volume, pos, voxel::MAX_HEIGHT).heightLevel);
+	// the uniform chunk above gets its own voxels and index
+	volume.setVoxel(glm::ivec3(1, 70, 1), voxel::createVoxel(voxel::VoxelType::Rock, 0));
+	EXPECT_EQ(71, findWalkableFloor(&volume, glm::ivec3(1, 80, 1), voxel::MAX_HEIGHT).heightLevel);
+	EXPECT_EQ(71, findWalkableFloor(&volume, glm::ivec3(1, 70, 1), voxel::MAX_HEIGHT).heightLevel);
+	compare(volume);
+}
+
+}
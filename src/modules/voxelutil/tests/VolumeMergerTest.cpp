@@ -4,6 +4,7 @@
 
 #include "voxel/tests/AbstractVoxelTest.h"
 #include "voxelutil/VolumeMerger.h"
+#include "core/concurrent/ThreadPool.h"
 
 namespace voxel {
 
@@ -57,4 +58,44 @@ TEST_F(VolumeMergerTest, testOffsets) {
 	ASSERT_EQ(smallVolume.voxel(regionSmall.getUpperCorner()), createVoxel(voxel::VoxelType::Grass, 0)) << smallVolume << ", " << bigVolume;
 }
 
+TEST_F(VolumeMergerTest, testMergeParallel) {
+	// overlapping volumes - the later ones win
+	voxel::RawVolume first(voxel::Region(-4, 12));
+	voxel::RawVolume second(voxel::Region(glm::ivec3(2, 3, 5), glm::ivec3(20, 9, 31)));
+	voxel::RawVolume third(voxel::Region(0, 7));
+	const voxel::Voxel grass = createVoxel(VoxelType::Grass, 0);
+	const voxel::Voxel rock = createVoxel(VoxelType::Rock, 0);
+	const voxel::Voxel sand = createVoxel(VoxelType::Sand, 0);
+	for (int i = -4; i <= 12; ++i) {
+		first.setVoxel(i, i, i, grass);
+		first.setVoxel(i, 4, 6, grass);
+	}
+	for (int z = 5; z <= 31; ++z) {
+		second.setVoxel(4, 6, z, rock);
+	}
+	for (int z = 0; z <= 7; z += 2) {
+		third.setVoxel(4, 6, z, sand);
+	}
+	const std::vector<const voxel::RawVolume*> volumes {&first, &second, &third};
+	voxel::RawVolume* serial = voxel::merge(volumes);
+	core::ThreadPool threadPool(4, "MergeTest");
+	threadPool.init();
+	voxel::RawVolume* parallel = voxel::merge(volumes, &threadPool);
+	threadPool.shutdown();
+	ASSERT_EQ(serial->region(), parallel->region());
+	const voxel::Region& region = serial->region();
+	for (int32_t z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+		for (int32_t y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+			for (int32_t x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+				ASSERT_EQ(serial->voxel(x, y, z), parallel->voxel(x, y, z)) << x << ":" << y << ":" << z;
+			}
+		}
+	}
+	// the voxel of the last volume wins - the merged volume starts at the mins of all volumes
+	EXPECT_EQ(sand, parallel->voxel(glm::ivec3(4, 6, 6) + 4));
+	EXPECT_EQ(rock, parallel->voxel(glm::ivec3(4, 6, 7) + 4));
+	delete serial;
+	delete parallel;
+}
+
 }
@@ -73,6 +73,7 @@ public:
 	bool init(const core::String& luaString);
 
 	Biome* addBiome(int lower, int upper, float humidity, float temperature, voxel::VoxelType type, bool underGround, int treeDistribution);
+	const std::vector<Biome*>& biomes() const;
 
 	// this lookup must be really really fast - it is executed once per generated voxel
 	// iterating in y direction is fastest, because the last biome is cached on a per-thread-basis
@@ -116,6 +117,10 @@ public:
 	const Biome* getBiome(const glm::ivec3& pos, bool underground = false) const;
 };
 
+inline const std::vector<Biome*>& BiomeManager::biomes() const {
+	return _biomes;
+}
+
 typedef std::shared_ptr<BiomeManager> BiomeManagerPtr;
 
 }
@@ -3,7 +3,6 @@
  */
 
 #include "CachedFloorResolver.h"
-#include "voxelutil/FloorTrace.h"
 
 namespace voxelworld {
 
@@ -11,7 +10,7 @@ voxelutil::FloorTraceResult CachedFloorResolver::findWalkableFloor(const glm::iv
 	if (_lastPos == position && _lastMaxDistanceY == maxDistanceY) {
 		return _last;
 	}
-	voxelutil::FloorTraceResult trace = voxelutil::findWalkableFloor(_sampler, position, maxDistanceY);
+	voxelutil::FloorTraceResult trace = _worldMgr->findWalkableFloor(position, maxDistanceY);
 	_lastPos = position;
 	_lastMaxDistanceY = maxDistanceY;
 	_last = trace;
@@ -20,12 +19,11 @@ voxelutil::FloorTraceResult CachedFloorResolver::findWalkableFloor(const glm::iv
 
 bool CachedFloorResolver::init(const voxelworld::WorldMgrPtr& worldMgr) {
 	_worldMgr = worldMgr;
-	_sampler = new voxel::PagedVolume::Sampler(_worldMgr->volumeData());
 	return true;
 }
 
 void CachedFloorResolver::shutdown() {
-	delete _sampler;
+	_worldMgr = voxelworld::WorldMgrPtr();
 }
 
 }
\ No newline at end of file
@@ -15,7 +15,6 @@ private:
 	glm::ivec3 _lastPos { -1 };
 	int _lastMaxDistanceY = -1;
 	voxelutil::FloorTraceResult _last;
-	voxel::PagedVolume::Sampler* _sampler = nullptr;
 	voxelworld::WorldMgrPtr _worldMgr;
 public:
 	voxelutil::FloorTraceResult findWalkableFloor(const glm::ivec3& position, int maxDistanceY);
@@ -14,10 +14,40 @@ namespace voxelworld {
 
 #define WORLD_FILE_VERSION 2
 
+ChunkPersister::ChunkSnapshot::ChunkSnapshot(const voxel::PagedVolume::Chunk& chunk) {
+	if (chunk.isUniform()) {
+		uniformVoxel = chunk.uniformVoxel();
+		return;
+	}
+	core_trace_scoped(ChunkPersisterSnapshot);
+	const voxel::Voxel* voxelBuf = chunk.data();
+	voxels.assign(voxelBuf, voxelBuf + chunk.voxels());
+}
+
 bool ChunkPersister::saveCompressed(const voxel::PagedVolume::ChunkPtr& chunk, core::ByteStream& outStream) const {
+	if (chunk->isUniform()) {
+		return saveCompressed(nullptr, 0, chunk->uniformVoxel(), outStream);
+	}
+	return saveCompressed(chunk->data(), (int)chunk->dataSizeInBytes(), voxel::Voxel(), outStream);
+}
+
+bool ChunkPersister::saveCompressed(const ChunkSnapshot& snapshot, core::ByteStream& outStream) const {
+	const int voxelSize = (int)(snapshot.voxels.size() * sizeof(voxel::Voxel));
+	return saveCompressed(snapshot.voxels.data(), voxelSize, snapshot.uniformVoxel, outStream);
+}
+
+bool ChunkPersister::saveCompressed(const voxel::Voxel* voxelBuf, int voxelSize, const voxel::Voxel& uniformVoxel, core::ByteStream& outStream) const {
+	if (voxelSize == 0) {
+		// a zero size marks a uniform chunk - the voxel value follows the header
+		core_trace_scoped(ChunkPersisterSaveUniform);
+		const voxel::Voxel& voxel = uniformVoxel;
+		outStream.addInt(0);
+		outStream.addByte(WORLD_FILE_VERSION);
+		outStream.addByte((uint8_t)voxel.getMaterial());
+		outStream.addByte(voxel.getColor());
+		return true;
+	}
 	// save the stuff
-	const voxel::Voxel* voxelBuf = chunk->data();
-	const int voxelSize = chunk->dataSizeInBytes();
 	uint32_t neededVoxelBufLen = core::zip::compressBound(voxelSize);
 	uint8_t* compressedVoxelBuf = new uint8_t[neededVoxelBufLen];
 	std::unique_ptr<uint8_t[]> smartBuf(compressedVoxelBuf);
@@ -55,14 +85,21 @@ bool ChunkPersister::loadCompressed(const voxel::PagedVolume::ChunkPtr& chunk, c
 				version, WORLD_FILE_VERSION);
 		return false;
 	}
+	const uint8_t* buf = fileBuf + headerSize;
+	const size_t remaining = fileLen - headerSize;
+	if (len == 0) {
+		if (remaining != 2u) {
+			Log::error("invalid uniform chunk data");
+			return false;
+		}
+		chunk->setUniform(voxel::createVoxel((voxel::VoxelType)buf[0], buf[1]));
+		return true;
+	}
 	const int sizeLimit = chunk->dataSizeInBytes();
 	if (len != sizeLimit) {
 		Log::error("extracted memory would not fit the target chunk (%i bytes vs %i chunk size)", len, sizeLimit);
 		return false;
 	}
-	const uint8_t* buf = fileBuf + headerSize;
-	const size_t remaining = fileLen - headerSize;
-
 	// TODO: doesn't work on big endian
 	uint8_t *targetBuf = (uint8_t*)chunk->data();
 	if (!core::zip::uncompress(buf, remaining, targetBuf, sizeLimit)) {
@@ -10,11 +10,28 @@
 #include "core/Zip.h"
 #include "core/ByteStream.h"
 #include <memory>
+#include <vector>
 
 namespace voxelworld {
 
 class ChunkPersister : public core::IComponent {
+private:
+	/**
+	 * @param[in] voxelSize A size of @c 0 stores a uniform chunk with the given voxel
+	 */
+	bool saveCompressed(const voxel::Voxel* voxelBuf, int voxelSize, const voxel::Voxel& uniformVoxel, core::ByteStream& outStream) const;
 public:
+	/**
+	 * @brief A copy of the voxels of a chunk - it can be compressed without access to the chunk
+	 */
+	struct ChunkSnapshot {
+		// empty for uniform chunks
+		std::vector<voxel::Voxel> voxels;
+		voxel::Voxel uniformVoxel;
+
+		explicit ChunkSnapshot(const voxel::PagedVolume::Chunk& chunk);
+	};
+
 	virtual ~ChunkPersister() {}
 
 	virtual bool init() override { return true; };
@@ -26,6 +43,7 @@ public:
 
 	bool loadCompressed(const voxel::PagedVolume::ChunkPtr& chunk, const uint8_t *fileBuf, size_t fileLen) const;
 	bool saveCompressed(const voxel::PagedVolume::ChunkPtr& chunk, core::ByteStream& outStream) const;
+	bool saveCompressed(const ChunkSnapshot& snapshot, core::ByteStream& outStream) const;
 };
 
 typedef std::shared_ptr<ChunkPersister> ChunkPersisterPtr;
@@ -0,0 +1,129 @@
+/**
+ * @file
+ */
+
+#include "DensityField.h"
+#include "noise/Noise.h"
+#include "noise/SimplexBatch.h"
+#include "voxel/Constants.h"
+#include "core/Assert.h"
+#include "core/Trace.h"
+#include "core/Common.h"
+#include <glm/common.hpp>
+#include <glm/vec3.hpp>
+#include <limits>
+#include <math.h>
+
+namespace voxelworld {
+
+namespace {
+
+inline int floorDiv(int value, int divisor) {
+	const int q = value / divisor;
+	return (value % divisor != 0 && value < 0) ? q - 1 : q;
+}
+
+// the max amount of lattice points that are evaluated for a column
+constexpr int MaxColumnSamples = 4 * (voxel::MAX_TERRAIN_HEIGHT + 1);
+
+}
+
+DensityField::DensityField(const WorldContext& ctx, const glm::vec2& noiseOffset) :
+		_ctx(ctx), _noiseOffset(noiseOffset), _step(core_max(1, ctx.caveNoiseSampleStep)) {
+	_height = (voxel::MAX_TERRAIN_HEIGHT - 1 + _step - 1) / _step + 1;
+}
+
+void DensityField::reset(int lowerX, int lowerZ, int upperX, int upperZ) {
+	_latticeX = floorDiv(lowerX, _step);
+	_latticeZ = floorDiv(lowerZ, _step);
+	// one more lattice column to interpolate the last world column
+	_width = floorDiv(upperX, _step) + 2 - _latticeX;
+	_depth = floorDiv(upperZ, _step) + 2 - _latticeZ;
+	_values.assign((size_t)_width * _height * _depth, std::numeric_limits<float>::quiet_NaN());
+}
+
+bool DensityField::contains(int x, int z) const {
+	const int lx = floorDiv(x, _step);
+	const int lz = floorDiv(z, _step);
+	return lx >= _latticeX && lx < _latticeX + _width - 1 && lz >= _latticeZ && lz < _latticeZ + _depth - 1;
+}
+
+void DensityField::evaluate(const int* lx, const int* lz, int columns, int lyMin, int lyMax) {
+	glm::vec3 positions[MaxColumnSamples];
+	int indices[MaxColumnSamples];
+	float values[MaxColumnSamples];
+	int n = 0;
+	for (int c = 0; c < columns; ++c) {
+		for (int ly = lyMin; ly <= lyMax; ++ly) {
+			const int idx = index(lx[c], ly, lz[c]);
+			if (!isnan(_values[idx])) {
+				continue;
+			}
+			const glm::vec3 noisePos3d(_noiseOffset.x + (float)(lx[c] * _step), (float)(ly * _step), _noiseOffset.y + (float)(lz[c] * _step));
+			positions[n] = noisePos3d * _ctx.caveNoiseFrequency;
+			indices[n] = idx;
+			++n;
+		}
+	}
+	if (n == 0) {
+		return;
+	}
+	core_trace_scoped(DensityFieldEvaluate);
+	noise::fBm(positions, values, n, _ctx.caveNoiseOctaves, _ctx.caveNoiseLacunarity, _ctx.caveNoiseGain);
+	for (int i = 0; i < n; ++i) {
+		_values[indices[i]] = noise::norm(values[i]);
+	}
+}
+
+void DensityField::column(int x, int z, int minY, int maxY, float* out) {
+	if (maxY < minY) {
+		return;
+	}
+	core_assert(contains(x, z));
+	core_assert(minY >= 0 && maxY < voxel::MAX_TERRAIN_HEIGHT);
+	const int lx = floorDiv(x, _step);
+	const int lz = floorDiv(z, _step);
+	const int rx = x - lx * _step;
+	const int rz = z - lz * _step;
+	const float fx = (float)rx / (float)_step;
+	const float fz = (float)rz / (float)_step;
+
+	// the neighbouring lattice columns are only needed if the column is not on the lattice
+	int columnsX[4];
+	int columnsZ[4];
+	int columns = 0;
+	for (int dz = 0; dz <= (rz > 0 ? 1 : 0); ++dz) {
+		for (int dx = 0; dx <= (rx > 0 ? 1 : 0); ++dx) {
+			columnsX[columns] = lx + dx;
+			columnsZ[columns] = lz + dz;
+			++columns;
+		}
+	}
+	const int lyMin = minY / _step;
+	const int lyMax = (maxY + _step - 1) / _step;
+	evaluate(columnsX, columnsZ, columns, lyMin, lyMax);
+
+	float layers[voxel::MAX_TERRAIN_HEIGHT + 1];
+	for (int ly = lyMin; ly <= lyMax; ++ly) {
+		float v = _values[index(lx, ly, lz)];
+		if (rx > 0) {
+			v = glm::mix(v, _values[index(lx + 1, ly, lz)], fx);
+		}
+		if (rz > 0) {
+			float v1 = _values[index(lx, ly, lz + 1)];
+			if (rx > 0) {
+				v1 = glm::mix(v1, _values[index(lx + 1, ly, lz + 1)], fx);
+			}
+			v = glm::mix(v, v1, fz);
+		}
+		layers[ly - lyMin] = v;
+	}
+	for (int y = minY; y <= maxY; ++y) {
+		const int ly = y / _step;
+		const int ry = y - ly * _step;
+		const float v = layers[ly - lyMin];
+		out[y - minY] = ry == 0 ? v : glm::mix(v, layers[ly - lyMin + 1], (float)ry / (float)_step);
+	}
+}
+
+}
@@ -0,0 +1,69 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "WorldContext.h"
+#include <glm/vec2.hpp>
+#include <vector>
+
+namespace voxelworld {
+
+/**
+ * @brief The cave noise of the world generation, sampled on a coarse lattice and trilinearly interpolated in between.
+ *
+ * The lattice points are the world positions whose coordinates are multiples of WorldContext::caveNoiseSampleStep -
+ * so every field returns the same value for a position, no matter which area it covers. This keeps the chunks
+ * consistent with their neighbours. The lattice points are evaluated lazily (and in batches) when a column is
+ * queried and are cached for the following queries.
+ *
+ * @note Not thread safe - use one field per page-in.
+ */
+class DensityField {
+private:
+	const WorldContext& _ctx;
+	const glm::vec2 _noiseOffset;
+	const int _step;
+	// the lattice coordinates of the first lattice column
+	int _latticeX = 0;
+	int _latticeZ = 0;
+	// the amount of lattice points per axis
+	int _width = 0;
+	int _height = 0;
+	int _depth = 0;
+	// NaN for lattice points that weren't evaluated yet
+	std::vector<float> _values;
+
+	int index(int lx, int ly, int lz) const;
+	/**
+	 * @brief Evaluates the missing lattice points of the given lattice columns in the height range [lyMin, lyMax]
+	 */
+	void evaluate(const int* lx, const int* lz, int columns, int lyMin, int lyMax);
+public:
+	DensityField(const WorldContext& ctx, const glm::vec2& noiseOffset);
+
+	/**
+	 * @brief Drops the cached values and covers the world columns of the given area (inclusive)
+	 */
+	void reset(int lowerX, int lowerZ, int upperX, int upperZ);
+	bool contains(int x, int z) const;
+
+	/**
+	 * @brief Interpolated cave noise in the range [0,1] of the world column at @c x and @c z
+	 * @param[out] out Receives the values of the heights @c [minY, maxY]
+	 */
+	void column(int x, int z, int minY, int maxY, float* out);
+
+	int step() const;
+};
+
+inline int DensityField::step() const {
+	return _step;
+}
+
+inline int DensityField::index(int lx, int ly, int lz) const {
+	return ((lz - _latticeZ) * _width + (lx - _latticeX)) * _height + ly;
+}
+
+}
@@ -53,15 +53,24 @@ bool FilePersister::save(const voxel::PagedVolume::ChunkPtr& chunk, unsigned int
 	if (!saveCompressed(chunk, final)) {
 		return false;
 	}
-	const core::String& filename = getWorldName(chunk->chunkPos(), seed);
+	return write(chunk->chunkPos(), seed, final.getBuffer(), final.getSize());
+}
+
+bool FilePersister::write(const glm::ivec3& chunkPos, unsigned int seed, const uint8_t *data, size_t size) {
+	core_trace_scoped(WorldPersisterWrite);
+	const core::String& filename = getWorldName(chunkPos, seed);
 	const io::FilesystemPtr& filesystem = io::filesystem();
 
-	if (!filesystem->write(filename, final.getBuffer(), final.getSize())) {
+	if (!filesystem->write(filename, data, size)) {
 		Log::error("Failed to write file %s", filename.c_str());
 		return false;
 	}
-	Log::debug("Wrote file %s (%i)", filename.c_str(), (int)final.getSize());
+	Log::debug("Wrote file %s (%i)", filename.c_str(), (int)size);
 	return true;
 }
 
+bool FilePersister::exists(const glm::ivec3& chunkPos, unsigned int seed) const {
+	return io::filesystem()->exists(getWorldName(chunkPos, seed));
+}
+
 }
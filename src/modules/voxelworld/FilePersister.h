@@ -19,6 +19,12 @@ public:
 	bool load(const voxel::PagedVolume::ChunkPtr& chunk, unsigned int seed) override;
 	bool save(const voxel::PagedVolume::ChunkPtr& chunk, unsigned int seed) override;
 	void erase(const voxel::Region& region, unsigned int seed) override;
+
+	/**
+	 * @brief Writes the already compressed chunk data (see @c saveCompressed()) for the given chunk position
+	 */
+	bool write(const glm::ivec3& chunkPos, unsigned int seed, const uint8_t *data, size_t size);
+	bool exists(const glm::ivec3& chunkPos, unsigned int seed) const;
 };
 
 }
@@ -3,6 +3,7 @@
  */
 
 #include "TreeVolumeCache.h"
+#include "BiomeManager.h"
 #include "core/App.h"
 #include "core/Log.h"
 #include "core/StringUtil.h"
@@ -52,7 +53,31 @@ void TreeVolumeCache::shutdown() {
 	_treeTypeCount.clear();
 }
 
-voxel::RawVolume* TreeVolumeCache::loadTree(const glm::ivec3& treePos, const char *treeType) {
+bool TreeVolumeCache::treePath(char *buf, size_t size, const char *treeType, int treeIndex) const {
+	if (!core::string::formatBuf(buf, size, "models/trees/%s/%i", treeType, treeIndex)) {
+		Log::error("Failed to assemble tree path");
+		return false;
+	}
+	return true;
+}
+
+void TreeVolumeCache::prefetch(const BiomeManager& biomeManager) {
+	for (const Biome* biome : biomeManager.biomes()) {
+		for (const char *treeType : biome->treeTypes()) {
+			int treeCount = 0;
+			_treeTypeCount.get(treeType, treeCount);
+			for (int treeIndex = 1; treeIndex <= treeCount; ++treeIndex) {
+				char filename[64];
+				if (!treePath(filename, sizeof(filename), treeType, treeIndex)) {
+					return;
+				}
+				_volumeCache->prefetch(filename);
+			}
+		}
+	}
+}
+
+voxelformat::CachedVolumePtr TreeVolumeCache::loadTree(const glm::ivec3& treePos, const char *treeType) {
 	int treeCount = 1;
 	if (!_treeTypeCount.get(treeType, treeCount)) {
 		Log::warn("Could not get tree type count for %s - assuming 1", treeType);
@@ -62,8 +87,7 @@ voxel::RawVolume* TreeVolumeCache::loadTree(const glm::ivec3& treePos, const cha
 	}
 	const int treeIndex = 1 + (glm::abs(treePos.x + treePos.z) % treeCount);
 	char filename[64];
-	if (!core::string::formatBuf(filename, sizeof(filename), "models/trees/%s/%i", treeType, treeIndex)) {
-		Log::error("Failed to assemble tree path");
+	if (!treePath(filename, sizeof(filename), treeType, treeIndex)) {
 		return nullptr;
 	}
 	return _volumeCache->loadVolume(filename);
@@ -10,11 +10,15 @@
 
 namespace voxelworld {
 
+class BiomeManager;
+
 class TreeVolumeCache {
 private:
 	core::StringMap<int> _treeTypeCount;
 
 	voxelformat::VolumeCachePtr _volumeCache;
+
+	bool treePath(char *buf, size_t size, const char *treeType, int treeIndex) const;
 public:
 	TreeVolumeCache(const voxelformat::VolumeCachePtr& volumeCache);
 
@@ -29,7 +33,12 @@ public:
 	 * the registered biome tree types
 	 * @return voxel::RawVolume or @c nullptr if no tree volume was found for the given tree type.
 	 */
-	voxel::RawVolume* loadTree(const glm::ivec3& treePos, const char *treeType);
+	voxelformat::CachedVolumePtr loadTree(const glm::ivec3& treePos, const char *treeType);
+
+	/**
+	 * @brief Loads all the tree volumes of the biomes in the background
+	 */
+	void prefetch(const BiomeManager& biomeManager);
 };
 
 }
\ No newline at end of file
@@ -13,7 +13,7 @@ namespace voxelworld {
 
 WorldContext::WorldContext() :
 	landscapeNoiseOctaves(1), landscapeNoiseLacunarity(0.1f), landscapeNoiseFrequency(0.005f), landscapeNoiseGain(0.6f),
-	caveNoiseOctaves(1), caveNoiseLacunarity(0.1f), caveNoiseFrequency(0.05f), caveNoiseGain(0.1f), caveDensityThreshold(0.83f),
+	caveNoiseOctaves(1), caveNoiseLacunarity(0.1f), caveNoiseFrequency(0.05f), caveNoiseGain(0.1f), caveDensityThreshold(0.83f), caveNoiseSampleStep(1),
 	mountainNoiseOctaves(2), mountainNoiseLacunarity(0.3f), mountainNoiseFrequency(0.00075f), mountainNoiseGain(0.5f) {
 }
 
@@ -36,6 +36,7 @@ bool WorldContext::load(const core::String& luaString) {
 	CTX_LUA_FLOAT(caveNoiseFrequency);
 	CTX_LUA_FLOAT(caveNoiseGain);
 	CTX_LUA_FLOAT(caveDensityThreshold);
+	CTX_LUA_INT(caveNoiseSampleStep);
 	CTX_LUA_INT(mountainNoiseOctaves);
 	CTX_LUA_FLOAT(mountainNoiseLacunarity);
 	CTX_LUA_FLOAT(mountainNoiseFrequency);
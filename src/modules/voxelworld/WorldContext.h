@@ -25,6 +25,12 @@ struct WorldContext {
 	float caveNoiseFrequency;
 	float caveNoiseGain;
 	float caveDensityThreshold;
+	/**
+	 * @brief The cave noise is evaluated every n voxels and interpolated in between - 1 evaluates every voxel
+	 * @note Other values change the caves of a seed - the chunks that were persisted before don't match their
+	 * freshly generated neighbours then. Only use them for new worlds.
+	 */
+	int caveNoiseSampleStep;
 
 	int mountainNoiseOctaves;
 	float mountainNoiseLacunarity;
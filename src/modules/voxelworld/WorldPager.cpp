@@ -7,9 +7,11 @@
 #include "voxel/PagedVolumeWrapper.h"
 #include "voxelutil/Raycast.h"
 #include "noise/Simplex.h"
+#include "noise/SimplexBatch.h"
 #include "core/Common.h"
 #include "core/StringUtil.h"
 #include "core/collection/Array.h"
+#include <vector>
 
 namespace voxelworld {
 
@@ -33,8 +35,10 @@ bool WorldPager::pageIn(voxel::PagedVolume::PagerContext& pctx) {
 	//if (pctx.region.getLowerX() == 0 && pctx.region.getLowerZ() == 0) {
 	core_trace_scoped(CreateWorld);
 	math::Random random(_seed);
-	createWorld(wrapper);
-	placeTrees(pctx);
+	DensityField densityField(_worldCtx, _noiseSeedOffset);
+	densityField.reset(pctx.region.getLowerX(), pctx.region.getLowerZ(), pctx.region.getUpperX(), pctx.region.getUpperZ());
+	createWorld(wrapper, densityField);
+	placeTrees(pctx, densityField);
 	_chunkPersister->save(pctx.chunk, _seed);
 	//}
 	return true;
@@ -66,6 +70,8 @@ bool WorldPager::init(voxel::PagedVolume *volumeData, const core::String& worldP
 	if (!_volumeCache.init()) {
 		return false;
 	}
+	// the first chunks need the trees - load them while the pager is still idle
+	_volumeCache.prefetch(_biomeManager);
 	_volumeData = volumeData;
 	return _volumeData != nullptr;
 }
@@ -82,7 +88,7 @@ void WorldPager::shutdown() {
 }
 
 // use a 2d noise to switch between different noises - to generate steep mountains
-void WorldPager::createWorld(voxel::PagedVolumeWrapper& volume) const {
+void WorldPager::createWorld(voxel::PagedVolumeWrapper& volume, DensityField& densityField) const {
 	core_trace_scoped(WorldGeneration);
 	const voxel::Region& region = volume.region();
 	Log::debug("Create new chunk at %i:%i:%i", region.getLowerX(), region.getLowerY(), region.getLowerZ());
@@ -97,61 +103,82 @@ void WorldPager::createWorld(voxel::PagedVolumeWrapper& volume) const {
 	const int size = 2;
 	core_assert(depth % size == 0);
 	core_assert(width % size == 0);
+	const int columns = width / size;
+	std::vector<float> noiseValues(columns);
 	for (int z = lowerZ; z < lowerZ + depth; z += size) {
-		for (int x = lowerX; x < lowerX + width; x += size) {
+		getNoiseValues(lowerX, z, size, columns, noiseValues.data());
+		for (int column = 0; column < columns; ++column) {
+			const int x = lowerX + column * size;
 			voxel::Voxel voxels[voxel::MAX_TERRAIN_HEIGHT];
-			const int ni = fillVoxels(x, minsY, z, voxels);
+			const int ni = fillVoxels(x, minsY, z, noiseValues[column], densityField, voxels);
 			volume.setVoxels(x, minsY, z, size, size, voxels, ni);
 		}
 	}
 }
 
-float WorldPager::getNoiseValue(float x, float z) const {
-	core_trace_scoped(NoiseValue);
-	const glm::vec2 noisePos2d(_noiseSeedOffset.x + x, _noiseSeedOffset.y + z);
-	// TODO: move the noise settings into the biome
-	const float landscapeNoise = noise::fBm(noisePos2d * _worldCtx.landscapeNoiseFrequency, _worldCtx.landscapeNoiseOctaves,
-			_worldCtx.landscapeNoiseLacunarity, _worldCtx.landscapeNoiseGain);
+static inline float mixNoiseValues(float landscapeNoise, float mountainNoise) {
 	const float noiseNormalized = noise::norm(landscapeNoise);
-	const float mountainNoise = noise::fBm(noisePos2d * _worldCtx.mountainNoiseFrequency, _worldCtx.mountainNoiseOctaves,
-			_worldCtx.mountainNoiseLacunarity, _worldCtx.mountainNoiseGain);
 	const float mountainNoiseNormalized = noise::norm(mountainNoise);
 	const float mountainMultiplier = mountainNoiseNormalized * (mountainNoiseNormalized + 0.5f);
 	const float n = glm::clamp(noiseNormalized * mountainMultiplier, 0.0f, 1.0f);
 	return n;
 }
 
-float WorldPager::getDensity(float x, float y, float z, float n) const {
-	core_trace_scoped(DensityValue);
-	const glm::vec3 noisePos3d(_noiseSeedOffset.x + x, y, _noiseSeedOffset.y + z);
+float WorldPager::getNoiseValue(float x, float z) const {
+	core_trace_scoped(NoiseValue);
+	const glm::vec2 noisePos2d(_noiseSeedOffset.x + x, _noiseSeedOffset.y + z);
 	// TODO: move the noise settings into the biome
-	const float noiseVal = noise::norm(
-			noise::fBm(noisePos3d * _worldCtx.caveNoiseFrequency, _worldCtx.caveNoiseOctaves, _worldCtx.caveNoiseLacunarity, _worldCtx.caveNoiseGain));
-	const float finalDensity = n + noiseVal;
-	return finalDensity;
+	const float landscapeNoise = noise::fBm(noisePos2d * _worldCtx.landscapeNoiseFrequency, _worldCtx.landscapeNoiseOctaves,
+			_worldCtx.landscapeNoiseLacunarity, _worldCtx.landscapeNoiseGain);
+	const float mountainNoise = noise::fBm(noisePos2d * _worldCtx.mountainNoiseFrequency, _worldCtx.mountainNoiseOctaves,
+			_worldCtx.mountainNoiseLacunarity, _worldCtx.mountainNoiseGain);
+	return mixNoiseValues(landscapeNoise, mountainNoise);
 }
 
-int WorldPager::terrainHeight(int x, int y, int z) const {
-	const float n = getNoiseValue(x, z);
-	return terrainHeight(x, y, z, n);
+void WorldPager::getNoiseValues(int x, int z, int step, int amount, float* out) const {
+	core_trace_scoped(NoiseValues);
+	std::vector<glm::vec2> landscapePositions(amount);
+	std::vector<glm::vec2> mountainPositions(amount);
+	for (int i = 0; i < amount; ++i) {
+		const float columnX = (float)(x + i * step);
+		const glm::vec2 noisePos2d(_noiseSeedOffset.x + columnX, _noiseSeedOffset.y + (float)z);
+		landscapePositions[i] = noisePos2d * _worldCtx.landscapeNoiseFrequency;
+		mountainPositions[i] = noisePos2d * _worldCtx.mountainNoiseFrequency;
+	}
+	std::vector<float> mountainNoise(amount);
+	noise::fBm(landscapePositions.data(), out, amount, _worldCtx.landscapeNoiseOctaves,
+			_worldCtx.landscapeNoiseLacunarity, _worldCtx.landscapeNoiseGain);
+	noise::fBm(mountainPositions.data(), mountainNoise.data(), amount, _worldCtx.mountainNoiseOctaves,
+			_worldCtx.mountainNoiseLacunarity, _worldCtx.mountainNoiseGain);
+	for (int i = 0; i < amount; ++i) {
+		out[i] = mixNoiseValues(out[i], mountainNoise[i]);
+	}
 }
 
-int WorldPager::terrainHeight(int x, int minsY, int z, float n) const {
-	core_trace_scoped(TerrainHeight);
+int WorldPager::surfaceHeight(int x, int z, float n) const {
 	const int maxHeight = voxel::MAX_TERRAIN_HEIGHT - 1;
 	int centerHeight;
 	// the center of a city should make the terrain more even
 	const float cityMultiplier = _biomeManager.getCityMultiplier(glm::ivec2(x, z), &centerHeight);
-	int ni;
 	if (cityMultiplier < 1.0f) {
 		const float revn = (1.0f - cityMultiplier);
-		ni = revn * centerHeight + (cityMultiplier * n * maxHeight);
-	} else {
-		ni = n * maxHeight;
+		return revn * centerHeight + (cityMultiplier * n * maxHeight);
 	}
-	for (int y = ni - 1; y >= minsY + 1; --y) {
-		const float density = getDensity(x, y, z, n);
-		if (density > _worldCtx.caveDensityThreshold) {
+	return n * maxHeight;
+}
+
+int WorldPager::terrainHeight(int x, int minsY, int z, float n, DensityField& densityField, float* densities) const {
+	core_trace_scoped(TerrainHeight);
+	const int surface = surfaceHeight(x, z, n);
+	const int minY = minsY + 1;
+	const int maxY = surface - 1;
+	densityField.column(x, z, minY, maxY, densities + minY);
+	for (int y = minY; y <= maxY; ++y) {
+		densities[y] += n;
+	}
+	int ni = surface;
+	for (int y = maxY; y >= minY; --y) {
+		if (densities[y] > _worldCtx.caveDensityThreshold) {
 			break;
 		}
 		--ni;
@@ -159,10 +186,11 @@ int WorldPager::terrainHeight(int x, int minsY, int z, float n) const {
 	return ni;
 }
 
-int WorldPager::fillVoxels(int x, int minsY, int z, voxel::Voxel* voxels) const {
+int WorldPager::fillVoxels(int x, int minsY, int z, float n, DensityField& densityField, voxel::Voxel* voxels) const {
 	core_trace_scoped(FillVoxels);
-	const float n = getNoiseValue(x, z);
-	const int ni = terrainHeight(x, minsY, z, n);
+	// the densities of the column are evaluated once - for the terrain height and for the voxels
+	float densities[voxel::MAX_TERRAIN_HEIGHT];
+	const int ni = terrainHeight(x, minsY, z, n, densityField, densities);
 	if (ni < minsY) {
 		return 0;
 	}
@@ -174,7 +202,7 @@ int WorldPager::fillVoxels(int x, int minsY, int z, voxel::Voxel* voxels) const
 	voxels[0] = dirt;
 	glm::ivec3 pos(x, 0, z);
 	for (int y = ni - 1; y >= minsY + 1; --y) {
-		const float density = getDensity(x, y, z, n);
+		const float density = densities[y];
 		if (density > _worldCtx.caveDensityThreshold) {
 			const bool cave = y < ni - 1;
 			pos.y = y;
@@ -196,7 +224,7 @@ int WorldPager::fillVoxels(int x, int minsY, int z, voxel::Voxel* voxels) const
 	return core_max(ni - minsY, voxel::MAX_WATER_HEIGHT - minsY);
 }
 
-void WorldPager::placeTrees(voxel::PagedVolume::PagerContext& pagerCtx) {
+void WorldPager::placeTrees(voxel::PagedVolume::PagerContext& pagerCtx, DensityField& densityField) {
 	// expand region to all surrounding regions by half of the region size.
 	// we do this to be able to limit the generation on the current chunk. Otherwise
 	// we would endlessly generate new chunks just because the trees overlap to
@@ -229,6 +257,9 @@ void WorldPager::placeTrees(voxel::PagedVolume::PagerContext& pagerCtx) {
 	voxel::PagedVolumeWrapper chunkWrapper(_volumeData, pagerCtx.chunk, pagerCtx.region);
 
 	const size_t regionsSize = lengthof(regions);
+	DensityField neighbourField(_worldCtx, _noiseSeedOffset);
+	DensityField columnField(_worldCtx, _noiseSeedOffset);
+	float densities[voxel::MAX_TERRAIN_HEIGHT];
 
 	for (size_t i = 0; i < regionsSize; ++i) {
 		const voxel::Region& region = regions[i];
@@ -240,6 +271,13 @@ void WorldPager::placeTrees(voxel::PagedVolume::PagerContext& pagerCtx) {
 		std::vector<glm::vec2> positions;
 		math::Random random(_seed);
 		_biomeManager.getTreePositions(region, positions, random, 0);
+		// the trees of the neighbours are placed on the terrain that the neighbour chunk generates - the lattice
+		// of the density fields is aligned to the world coordinates, so the heights match
+		DensityField* field = &densityField;
+		if (region != pagerCtx.region) {
+			neighbourField.reset(region.getLowerX(), region.getLowerZ(), region.getUpperX(), region.getUpperZ());
+			field = &neighbourField;
+		}
 		int treeTypeIndex = random.random(0, treeTypes.size() - 1);
 		const int treeTypeSize = (int)treeTypes.size();
 		const math::Axis axes[] = {math::Axis::None, math::Axis::Y, math::Axis::Y, math::Axis::None, math::Axis::Y};
@@ -248,17 +286,23 @@ void WorldPager::placeTrees(voxel::PagedVolume::PagerContext& pagerCtx) {
 		for (const glm::vec2& position : positions) {
 			++positionIndex;
 			glm::ivec3 treePos(position.x, 0, position.y);
-			treePos.y = terrainHeight(position.x, pagerCtx.region.getLowerY(), position.y);
+			DensityField* treeField = field;
+			if (!field->contains(treePos.x, treePos.z)) {
+				columnField.reset(treePos.x, treePos.z, treePos.x, treePos.z);
+				treeField = &columnField;
+			}
+			const float n = getNoiseValue(treePos.x, treePos.z);
+			treePos.y = terrainHeight(treePos.x, pagerCtx.region.getLowerY(), treePos.z, n, *treeField, densities);
 			if (treePos.y <= voxel::MAX_WATER_HEIGHT) {
 				continue;
 			}
 			const char *treeType = treeTypes[treeTypeIndex++];
 			treeTypeIndex %= treeTypeSize;
-			const voxel::RawVolume* v = _volumeCache.loadTree(treePos, treeType);
-			if (v == nullptr) {
+			const voxelformat::CachedVolumePtr& v = _volumeCache.loadTree(treePos, treeType);
+			if (!v) {
 				continue;
 			}
-			const voxelutil::RawVolumeRotateWrapper rotateWrapper(v, axes[positionIndex % axesSize]);
+			const voxelutil::RawVolumeRotateWrapper rotateWrapper(v.get(), axes[positionIndex % axesSize]);
 			addVolumeToPosition(chunkWrapper, rotateWrapper, treePos);
 		}
 	}
@@ -14,6 +14,7 @@
 #include "core/SharedPtr.h"
 #include "ChunkPersister.h"
 #include "TreeVolumeCache.h"
+#include "DensityField.h"
 #include "voxelutil/RawVolumeRotateWrapper.h"
 
 namespace voxel {
@@ -41,19 +42,36 @@ private:
 	TreeVolumeCache _volumeCache;
 	ChunkPersisterPtr _chunkPersister;
 
-	void createWorld(voxel::PagedVolumeWrapper& volume) const;
-	void placeTrees(voxel::PagedVolume::PagerContext& pagerCtx);
+	void createWorld(voxel::PagedVolumeWrapper& volume, DensityField& densityField) const;
+	/**
+	 * @param[in] densityField The density field of the chunk
+	 */
+	void placeTrees(voxel::PagedVolume::PagerContext& pagerCtx, DensityField& densityField);
 	void addVolumeToPosition(voxel::PagedVolumeWrapper& target, const voxelutil::RawVolumeRotateWrapper& source, const glm::ivec3& pos);
 
-	int terrainHeight(int x, int minsY, int z) const;
-	int terrainHeight(int x, int minsY, int z, float n) const;
-	int fillVoxels(int x, int minsY, int z, voxel::Voxel* voxels) const;
+	/**
+	 * @brief The height of the terrain after the caves were carved into the surface
+	 * @param[out] densities Receives the densities of the heights @c [minsY+1, surfaceHeight()-1] at
+	 * @c densities[y] - must have room for voxel::MAX_TERRAIN_HEIGHT values
+	 */
+	int terrainHeight(int x, int minsY, int z, float n, DensityField& densityField, float* densities) const;
+	/**
+	 * @brief The height of the terrain before the caves are carved into it
+	 */
+	int surfaceHeight(int x, int z, float n) const;
+	/**
+	 * @param[in] n The noise value of the column - see getNoiseValue()
+	 */
+	int fillVoxels(int x, int minsY, int z, float n, DensityField& densityField, voxel::Voxel* voxels) const;
 
 	/**
 	 * @return A float value between [0.0-1.0]
 	 */
 	float getNoiseValue(float x, float z) const;
-	float getDensity(float x, float y, float z, float n) const;
+	/**
+	 * @brief Batch version of getNoiseValue() for @c amount columns in a row that are @c step voxels apart
+	 */
+	void getNoiseValues(int x, int z, int step, int amount, float* out) const;
 
 public:
 	WorldPager(const voxelformat::VolumeCachePtr& volumeCache, const ChunkPersisterPtr& chunkPersister);
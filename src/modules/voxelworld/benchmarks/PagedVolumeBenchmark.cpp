@@ -0,0 +1,98 @@
+/**
+ * @file
+ */
+
+#include <benchmark/benchmark.h>
+#include "voxel/PagedVolume.h"
+#include "voxel/Constants.h"
+#include "voxelutil/FloorTrace.h"
+
+namespace {
+
+/**
+ * @brief Flat terrain pager - we only want to measure the chunk lookup here, not the world generation
+ */
+class FlatPager: public voxel::PagedVolume::Pager {
+public:
+	bool pageIn(voxel::PagedVolume::PagerContext& ctx) override {
+		const voxel::Voxel dirt = voxel::createVoxel(voxel::VoxelType::Dirt, 0);
+		const voxel::Region& region = ctx.region;
+		const int sideLength = ctx.chunk->sideLength();
+		for (int y = 0; y < sideLength; ++y) {
+			if (region.getLowerY() + y >= voxel::MAX_WATER_HEIGHT) {
+				break;
+			}
+			for (int x = 0; x < sideLength; ++x) {
+				for (int z = 0; z < sideLength; ++z) {
+					ctx.chunk->setVoxel(x, y, z, dirt);
+				}
+			}
+		}
+		return false;
+	}
+
+	void pageOut(voxel::PagedVolume::Chunk* chunk) override {
+	}
+};
+
+constexpr int ChunkSideLength = 32;
+constexpr int ChunksPerAxis = 8;
+
+FlatPager pager;
+voxel::PagedVolume* volume = nullptr;
+
+void setupVolume(const benchmark::State& state) {
+	if (state.thread_index != 0) {
+		return;
+	}
+	volume = new voxel::PagedVolume(&pager, 256 * 1024 * 1024, ChunkSideLength);
+	// warm up - the benchmarks should only measure cache hits
+	for (int x = 0; x < ChunksPerAxis; ++x) {
+		for (int y = 0; y < ChunksPerAxis; ++y) {
+			for (int z = 0; z < ChunksPerAxis; ++z) {
+				volume->voxel(x * ChunkSideLength, y * ChunkSideLength, z * ChunkSideLength);
+			}
+		}
+	}
+}
+
+void shutdownVolume(const benchmark::State& state) {
+	if (state.thread_index != 0) {
+		return;
+	}
+	delete volume;
+	volume = nullptr;
+}
+
+}
+
+static void BM_ChunkLookup(benchmark::State& state) {
+	setupVolume(state);
+	const int max = ChunksPerAxis * ChunkSideLength;
+	int i = state.thread_index * 7919;
+	for (auto _ : state) {
+		const int x = (i * 31) % max;
+		const int y = (i * 17) % max;
+		const int z = (i * 13) % max;
+		benchmark::DoNotOptimize(volume->chunk(glm::ivec3(x, y, z)));
+		++i;
+	}
+	state.SetItemsProcessed(state.iterations());
+	shutdownVolume(state);
+}
+
+static void BM_FindWalkableFloor(benchmark::State& state) {
+	setupVolume(state);
+	const int max = ChunksPerAxis * ChunkSideLength;
+	int i = state.thread_index * 7919;
+	for (auto _ : state) {
+		const glm::ivec3 pos((i * 31) % max, voxel::MAX_HEIGHT / 2, (i * 13) % max);
+		benchmark::DoNotOptimize(voxelutil::findWalkableFloor(volume, pos, voxel::MAX_HEIGHT));
+		++i;
+	}
+	state.SetItemsProcessed(state.iterations());
+	shutdownVolume(state);
+}
+
+BENCHMARK(BM_ChunkLookup)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_FindWalkableFloor)->ThreadRange(1, 16)->UseRealTime();
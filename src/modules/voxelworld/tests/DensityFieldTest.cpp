@@ -0,0 +1,84 @@
+/**
+ * @file
+ */
+
+#include "core/tests/AbstractTest.h"
+#include "voxelworld/DensityField.h"
+#include "voxel/Constants.h"
+#include "noise/Noise.h"
+#include "noise/Simplex.h"
+
+namespace voxelworld {
+
+class DensityFieldTest: public core::AbstractTest {
+protected:
+	WorldContext _ctx;
+	const glm::vec2 _noiseOffset { 12.0f, 345.0f };
+
+	float exact(int x, int y, int z) const {
+		const glm::vec3 noisePos3d(_noiseOffset.x + (float)x, (float)y, _noiseOffset.y + (float)z);
+		return noise::norm(noise::fBm(noisePos3d * _ctx.caveNoiseFrequency, _ctx.caveNoiseOctaves, _ctx.caveNoiseLacunarity, _ctx.caveNoiseGain));
+	}
+};
+
+TEST_F(DensityFieldTest, testStepOneIsExact) {
+	_ctx.caveNoiseSampleStep = 1;
+	DensityField field(_ctx, _noiseOffset);
+	field.reset(-8, -8, 7, 7);
+	float values[voxel::MAX_TERRAIN_HEIGHT];
+	for (int x = -8; x <= 7; x += 3) {
+		field.column(x, 5, 0, voxel::MAX_TERRAIN_HEIGHT - 1, values);
+		for (int y = 0; y < voxel::MAX_TERRAIN_HEIGHT; ++y) {
+			ASSERT_EQ(exact(x, y, 5), values[y]) << x << ":" << y;
+		}
+	}
+}
+
+TEST_F(DensityFieldTest, testLatticePointsAreExact) {
+	_ctx.caveNoiseSampleStep = 4;
+	DensityField field(_ctx, _noiseOffset);
+	field.reset(-16, -16, 15, 15);
+	float values[voxel::MAX_TERRAIN_HEIGHT];
+	for (int x = -16; x <= 12; x += 4) {
+		field.column(x, -4, 0, voxel::MAX_TERRAIN_HEIGHT - 1, values);
+		for (int y = 0; y < voxel::MAX_TERRAIN_HEIGHT; y += 4) {
+			ASSERT_EQ(exact(x, y, -4), values[y]) << x << ":" << y;
+		}
+	}
+}
+
+TEST_F(DensityFieldTest, testInterpolation) {
+	_ctx.caveNoiseSampleStep = 4;
+	DensityField field(_ctx, _noiseOffset);
+	field.reset(0, 0, 15, 15);
+	float values[voxel::MAX_TERRAIN_HEIGHT];
+	field.column(6, 0, 4, 8, values);
+	// between the lattice points (4,4,0) and (8,4,0) - (4,8,0) and (8,8,0)
+	const float a = glm::mix(exact(4, 4, 0), exact(8, 4, 0), 0.5f);
+	const float b = glm::mix(exact(4, 8, 0), exact(8, 8, 0), 0.5f);
+	EXPECT_FLOAT_EQ(a, values[0]);
+	EXPECT_FLOAT_EQ(glm::mix(a, b, 0.25f), values[1]);
+	EXPECT_FLOAT_EQ(glm::mix(a, b, 0.5f), values[2]);
+	EXPECT_FLOAT_EQ(b, values[4]);
+}
+
+TEST_F(DensityFieldTest, testFieldsAgree) {
+	_ctx.caveNoiseSampleStep = 4;
+	DensityField chunk(_ctx, _noiseOffset);
+	chunk.reset(-32, -32, -1, -1);
+	DensityField neighbour(_ctx, _noiseOffset);
+	neighbour.reset(-35, -7, -35, -7);
+	ASSERT_TRUE(chunk.contains(-35 + 32, -7));
+	ASSERT_FALSE(chunk.contains(-35, -7));
+	ASSERT_TRUE(neighbour.contains(-35, -7));
+	float values1[voxel::MAX_TERRAIN_HEIGHT];
+	float values2[voxel::MAX_TERRAIN_HEIGHT];
+	chunk.column(-5, -7, 3, 60, values1);
+	neighbour.reset(-5, -7, -5, -7);
+	neighbour.column(-5, -7, 3, 60, values2);
+	for (int i = 0; i <= 60 - 3; ++i) {
+		ASSERT_EQ(values1[i], values2[i]) << i;
+	}
+}
+
+}
@@ -19,4 +19,17 @@ TEST_F(WorldPersisterTest, testSaveLoad) {
 	ASSERT_EQ(voxel::VoxelType::Grass, _volData.voxel(32, 32, 32).getMaterial());
 }
 
+TEST_F(WorldPersisterTest, testSaveLoadUniform) {
+	FilePersister persister;
+	const glm::ivec3 pos(100, 0, 0);
+	voxel::PagedVolume::ChunkPtr chunk = core::make_shared<voxel::PagedVolume::Chunk>(pos, 64, &_pager);
+	chunk->setUniform(voxel::createVoxel(voxel::VoxelType::Water, 1));
+	ASSERT_TRUE(persister.save(chunk, _seed)) << "Could not save uniform chunk";
+	voxel::PagedVolume::ChunkPtr loaded = core::make_shared<voxel::PagedVolume::Chunk>(pos, 64, &_pager);
+	ASSERT_TRUE(persister.load(loaded, _seed)) << "Could not load uniform chunk";
+	ASSERT_TRUE(loaded->isUniform());
+	EXPECT_EQ(voxel::VoxelType::Water, loaded->voxel(10, 20, 30).getMaterial());
+	EXPECT_EQ(1, loaded->voxel(10, 20, 30).getColor());
+}
+
 }
@@ -58,6 +58,8 @@ void WorldRenderer::reset() {
 
 void WorldRenderer::shutdown() {
 	_cancelThreads = true;
+	// the extraction tasks access the volume and the mesh extractor
+	_threadPool.shutdown();
 	_worldShader.shutdown();
 	_waterShader.shutdown();
 	_materialBlock.shutdown();
@@ -79,7 +81,6 @@ void WorldRenderer::shutdown() {
 	_postProcessBuf.shutdown();
 	_postProcessBufId = -1;
 	_postProcessShader.shutdown();
-	_threadPool.shutdown();
 }
 
 int WorldRenderer::renderWorld(const video::Camera& camera) {
@@ -416,7 +417,6 @@ bool WorldRenderer::init(voxel::PagedVolume* volume, const glm::ivec2& position,
 
 	_worldChunkMgr.init(&_worldShader, volume);
 	_worldChunkMgr.updateViewDistance(_viewDistance);
-	_threadPool.enqueue([this] () {while (!_cancelThreads) { _worldChunkMgr.extractScheduledMesh(); } });
 
 	if (!initFrameBuffers(dimension)) {
 		return false;
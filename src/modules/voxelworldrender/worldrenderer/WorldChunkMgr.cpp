@@ -4,6 +4,8 @@
 
 #include "WorldChunkMgr.h"
 #include "core/Trace.h"
+#include "core/TimeProvider.h"
+#include "core/GameConfig.h"
 #include "video/Trace.h"
 #include "voxel/Constants.h"
 #include "voxelrender/ShaderAttribute.h"
@@ -19,6 +21,7 @@ constexpr double ScaleDuration = 1.5;
 
 WorldChunkMgr::WorldChunkMgr(core::ThreadPool& threadPool) :
 		_octree({}, 30), _threadPool(threadPool) {
+	resetChunkBuffers();
 }
 
 void WorldChunkMgr::updateViewDistance(float viewDistance) {
@@ -29,7 +32,8 @@ void WorldChunkMgr::updateViewDistance(float viewDistance) {
 
 bool WorldChunkMgr::init(shader::WorldShader* worldShader, voxel::PagedVolume* volume) {
 	_worldShader = worldShader;
-	if (!_meshExtractor.init(volume)) {
+	_meshUploadBudget = core::Var::get(cfg::ClientMeshUploadBudget, "2");
+	if (!_meshExtractor.init(volume, &_threadPool)) {
 		Log::error("Failed to initialize the mesh extractor");
 		return false;
 	}
@@ -38,82 +42,131 @@ bool WorldChunkMgr::init(shader::WorldShader* worldShader, voxel::PagedVolume* v
 
 void WorldChunkMgr::shutdown() {
 	_meshExtractor.shutdown();
+	for (ChunkBuffer& chunkBuffer : _chunkBuffers) {
+		chunkBuffer.shutdown();
+	}
+	resetChunkBuffers();
 }
 
-void WorldChunkMgr::reset() {
+void WorldChunkMgr::resetChunkBuffers() {
 	for (ChunkBuffer& chunkBuffer : _chunkBuffers) {
-		chunkBuffer.inuse = false;
+		chunkBuffer.reset();
 	}
+	_usedChunkBuffers.clear();
+	// lowest slots are handed out first
+	for (int i = 0; i < MAX_CHUNKBUFFERS; ++i) {
+		_freeChunkBuffers[i] = MAX_CHUNKBUFFERS - 1 - i;
+	}
+	_freeChunkBufferCount = MAX_CHUNKBUFFERS;
+}
+
+void WorldChunkMgr::releaseChunkBuffer(ChunkBuffer* chunkBuffer) {
+	core_assert(chunkBuffer->inuse);
+	_usedChunkBuffers.remove(chunkBuffer->aabb().mins());
+	chunkBuffer->reset();
+	core_assert(_freeChunkBufferCount < MAX_CHUNKBUFFERS);
+	_freeChunkBuffers[_freeChunkBufferCount++] = (int)(chunkBuffer - _chunkBuffers);
+}
+
+void WorldChunkMgr::reset() {
+	resetChunkBuffers();
 	_visibleBuffers.size = 0;
 	_meshExtractor.reset();
 	_octree.clear();
 }
 
-void WorldChunkMgr::handleMeshQueue() {
-	voxel::Mesh mesh;
-	if (!_meshExtractor.pop(mesh)) {
-		return;
-	}
-
-	// Now add the mesh to the list of meshes to render.
-	core_trace_scoped(WorldRendererHandleMeshQueue);
-
-	ChunkBuffer* freeChunkBuffer = nullptr;
-	for (ChunkBuffer& chunkBuffer : _chunkBuffers) {
-		if (freeChunkBuffer == nullptr && !chunkBuffer.inuse) {
-			freeChunkBuffer = &chunkBuffer;
-		}
-		// check whether we update an existing one
-		if (chunkBuffer.aabb().mins() == mesh.getOffset()) {
-			freeChunkBuffer = &chunkBuffer;
-			break;
-		}
-	}
-
-	if (freeChunkBuffer == nullptr) {
-		Log::warn("Could not find free chunk buffer slot");
-		return;
-	}
-
-	video::Buffer& buffer = freeChunkBuffer->_buffer;
-	freeChunkBuffer->_vbo = buffer.create();
-	if (freeChunkBuffer->_vbo == -1) {
+bool WorldChunkMgr::createBuffers(ChunkBuffer* chunkBuffer) {
+	video::Buffer& buffer = chunkBuffer->_buffer;
+	chunkBuffer->_vbo = buffer.create();
+	if (chunkBuffer->_vbo == -1) {
 		Log::error("Failed to create vertex buffer");
-		return;
+		return false;
 	}
+	// the buffers are reused - the storage is only reallocated if a mesh doesn't fit
+	buffer.setMode(chunkBuffer->_vbo, video::BufferMode::Dynamic);
 	const int locationPos = _worldShader->getLocationPos();
-	const video::Attribute& posAttrib = voxelrender::getPositionVertexAttribute(freeChunkBuffer->_vbo, locationPos, _worldShader->getAttributeComponents(locationPos));
+	const video::Attribute& posAttrib = voxelrender::getPositionVertexAttribute(chunkBuffer->_vbo, locationPos, _worldShader->getAttributeComponents(locationPos));
 	if (!buffer.addAttribute(posAttrib)) {
 		Log::error("Failed to add position attribute");
-		return;
+		chunkBuffer->shutdown();
+		return false;
 	}
 	const int locationInfo = _worldShader->getLocationInfo();
-	const video::Attribute& infoAttrib = voxelrender::getInfoVertexAttribute(freeChunkBuffer->_vbo, locationInfo, _worldShader->getAttributeComponents(locationInfo));
+	const video::Attribute& infoAttrib = voxelrender::getInfoVertexAttribute(chunkBuffer->_vbo, locationInfo, _worldShader->getAttributeComponents(locationInfo));
 	if (!buffer.addAttribute(infoAttrib)) {
 		Log::error("Failed to add info attribute");
-		return;
+		chunkBuffer->shutdown();
+		return false;
 	}
-	freeChunkBuffer->_ibo = buffer.create(nullptr, 0, video::BufferType::IndexBuffer);
-	if (freeChunkBuffer->_ibo == -1) {
+	chunkBuffer->_ibo = buffer.create(nullptr, 0, video::BufferType::IndexBuffer);
+	if (chunkBuffer->_ibo == -1) {
 		Log::error("Failed to create index buffer");
-		return;
+		chunkBuffer->shutdown();
+		return false;
+	}
+	buffer.setMode(chunkBuffer->_ibo, video::BufferMode::Dynamic);
+	return true;
+}
+
+bool WorldChunkMgr::uploadMesh(const voxel::Mesh& mesh) {
+	core_trace_scoped(WorldRendererUploadMesh);
+	const glm::ivec3& mins = mesh.getOffset();
+
+	// check whether we update an existing one
+	ChunkBuffer* chunkBuffer = nullptr;
+	auto i = _usedChunkBuffers.find(mins);
+	if (i != _usedChunkBuffers.end()) {
+		chunkBuffer = i->second;
+	} else if (_freeChunkBufferCount > 0) {
+		chunkBuffer = &_chunkBuffers[_freeChunkBuffers[_freeChunkBufferCount - 1]];
+	} else {
+		Log::warn("Could not find free chunk buffer slot");
+		return false;
 	}
-	freeChunkBuffer->_compressedIndexSize = mesh.compressedIndexSize();
 
+	if (!chunkBuffer->created() && !createBuffers(chunkBuffer)) {
+		return false;
+	}
+
+	chunkBuffer->_compressedIndexSize = mesh.compressedIndexSize();
+	video::Buffer& buffer = chunkBuffer->_buffer;
 	const voxel::VertexArray& vertices = mesh.getVertexVector();
 	const uint8_t* indices = mesh.compressedIndices();
-	buffer.update(freeChunkBuffer->_vbo, &vertices.front(), vertices.size() * sizeof(voxel::VertexArray::value_type));
-	buffer.update(freeChunkBuffer->_ibo, indices, mesh.getNoOfIndices() * freeChunkBuffer->_compressedIndexSize);
+	buffer.update(chunkBuffer->_vbo, &vertices.front(), vertices.size() * sizeof(voxel::VertexArray::value_type));
+	buffer.update(chunkBuffer->_ibo, indices, mesh.getNoOfIndices() * chunkBuffer->_compressedIndexSize);
+	chunkBuffer->scaleSeconds = ScaleDuration;
+	if (chunkBuffer->inuse) {
+		return true;
+	}
 
+	--_freeChunkBufferCount;
 	const glm::ivec3& size = _meshExtractor.meshSize();
-	const glm::ivec3& mins = mesh.getOffset();
 	const glm::ivec3 maxs(mins.x + size.x, mins.y + size.y, mins.z + size.z);
-	freeChunkBuffer->_aabb = {mins, maxs};
-	if (!_octree.insert(freeChunkBuffer)) {
+	chunkBuffer->_aabb = {mins, maxs};
+	if (!_octree.insert(chunkBuffer)) {
 		Log::warn("Failed to insert into octree");
 	}
-	freeChunkBuffer->inuse = true;
-	freeChunkBuffer->scaleSeconds = ScaleDuration;
+	chunkBuffer->inuse = true;
+	_usedChunkBuffers.put(mins, chunkBuffer);
+	return true;
+}
+
+void WorldChunkMgr::handleMeshQueue() {
+	core_trace_scoped(WorldRendererHandleMeshQueue);
+	const uint64_t start = core::TimeProvider::highResTime();
+	const double budgetMillis = core_max(0.0f, _meshUploadBudget->floatVal());
+	const uint64_t budget = (uint64_t)(budgetMillis * (double)core::TimeProvider::highResTimeResolution() / 1000.0);
+	int uploaded = 0;
+	voxel::Mesh mesh;
+	// at least one mesh is uploaded per frame
+	while (_meshExtractor.pop(mesh)) {
+		uploadMesh(mesh);
+		++uploaded;
+		if (core::TimeProvider::highResTime() - start >= budget) {
+			break;
+		}
+	}
+	core_trace_value_scoped(UploadedMeshes, uploaded);
 }
 
 void WorldChunkMgr::update(double deltaFrameSeconds, const video::Camera &camera, const glm::vec3& focusPos) {
@@ -131,18 +184,14 @@ void WorldChunkMgr::update(double deltaFrameSeconds, const video::Camera &camera
 			continue;
 		}
 		core_assert_always(_meshExtractor.allowReExtraction(pos));
-		chunkBuffer.reset();
 		_octree.remove(&chunkBuffer);
+		releaseChunkBuffer(&chunkBuffer);
 		Log::trace("Remove mesh from %i:%i", pos.x, pos.z);
 	}
 
 	cull(camera);
 }
 
-void WorldChunkMgr::extractScheduledMesh() {
-	_meshExtractor.extractScheduledMesh();
-}
-
 // TODO: put into background task with two states - computing and
 // next - then the indices and vertices are just swapped
 void WorldChunkMgr::cull(const video::Camera& camera) {
@@ -11,6 +11,9 @@
 #include "WorldShader.h"
 #include "voxel/Mesh.h"
 #include "video/Buffer.h"
+#include "core/collection/Map.h"
+#include "core/GLM.h"
+#include "core/Var.h"
 #include <future>
 
 namespace voxelworldrender {
@@ -28,16 +31,27 @@ protected:
 		int32_t _ibo = -1;
 
 		~ChunkBuffer() {
-			reset();
+			shutdown();
 		}
 
+		/**
+		 * @brief The vertex and index buffers are kept to be reused by the next mesh that is put into this slot
+		 */
 		void reset() {
+			inuse = false;
+		}
+
+		void shutdown() {
 			_buffer.shutdown();
 			_vbo = -1;
 			_ibo = -1;
 			inuse = false;
 		}
 
+		inline bool created() const {
+			return _vbo != -1;
+		}
+
 		/**
 		 * This is the render aabb. There might be a scale applied here. So the mins of
 		 * the AABB might not be at the position given by @c translation()
@@ -52,7 +66,13 @@ protected:
 	Tree _octree;
 	static constexpr int MAX_CHUNKBUFFERS = 2048;
 	ChunkBuffer _chunkBuffers[MAX_CHUNKBUFFERS];
+	// the slots that are not in use
+	int _freeChunkBuffers[MAX_CHUNKBUFFERS];
+	int _freeChunkBufferCount = 0;
+	// the slots that are in use - by their mesh offset
+	core::Map<glm::ivec3, ChunkBuffer*, 1031, glm::hash<glm::ivec3>> _usedChunkBuffers;
 	int _maxAllowedDistance = -1;
+	core::VarPtr _meshUploadBudget;
 
 	struct VisibleBuffers {
 		int size = 0;
@@ -68,7 +88,15 @@ protected:
 	int distance2(const glm::ivec3 &pos, const glm::ivec3 &pos2) const;
 
 	void cull(const video::Camera &camera);
+	/**
+	 * @brief Uploads the extracted meshes until the upload budget for this frame is used up
+	 * @sa cfg::ClientMeshUploadBudget
+	 */
 	void handleMeshQueue();
+	bool uploadMesh(const voxel::Mesh& mesh);
+	bool createBuffers(ChunkBuffer* chunkBuffer);
+	void releaseChunkBuffer(ChunkBuffer* chunkBuffer);
+	void resetChunkBuffers();
 public:
 	WorldChunkMgr(core::ThreadPool& threadPool);
 
@@ -76,7 +104,6 @@ public:
 
 	void extractMesh(const glm::ivec3 &pos);
 	void extractMeshes(const video::Camera &camera);
-	void extractScheduledMesh();
 
 	void update(double deltaFrameSeconds, const video::Camera &camera, const glm::vec3& focusPos);
 
@@ -13,8 +13,9 @@ namespace voxelworldrender {
 WorldMeshExtractor::WorldMeshExtractor() {
 }
 
-bool WorldMeshExtractor::init(voxel::PagedVolume *volume) {
+bool WorldMeshExtractor::init(voxel::PagedVolume *volume, core::ThreadPool *threadPool) {
 	_volume = volume;
+	_threadPool = threadPool;
 	_meshSize = core::Var::getSafe(cfg::VoxelMeshSize);
 	return true;
 }
@@ -27,6 +28,7 @@ void WorldMeshExtractor::shutdown() {
 	_positionsExtracted.clear();
 	_extracted.clear();
 	_volume = nullptr;
+	_threadPool = nullptr;
 }
 
 void WorldMeshExtractor::reset() {
@@ -84,12 +86,27 @@ bool WorldMeshExtractor::scheduleMeshExtraction(const glm::ivec3& p) {
 	Log::trace("mesh extraction for %i:%i:%i (%i:%i:%i)",
 			p.x, p.y, p.z, pos.x, pos.y, pos.z);
 	_pendingExtraction.push(pos);
+	// every task extracts the closest pending mesh - the priority only decides when it's executed
+	_threadPool->schedule([this] () { extractScheduledMesh(); }, extractionPriority(pos));
 	return true;
 }
 
+core::TaskPriority WorldMeshExtractor::extractionPriority(const glm::ivec3& pos) const {
+	const int meshSize = _meshSize->intVal();
+	const int distance = CloseToPoint(_pendingExtractionSortPosition).distanceToSortPos(pos);
+	if (distance <= 4 * meshSize * meshSize) {
+		return core::TaskPriority::High;
+	}
+	if (distance <= 64 * meshSize * meshSize) {
+		return core::TaskPriority::Normal;
+	}
+	return core::TaskPriority::Low;
+}
+
 void WorldMeshExtractor::extractScheduledMesh() {
 	decltype(_pendingExtraction)::Key pos;
-	if (!_pendingExtraction.waitAndPop(pos)) {
+	// the pending extractions might have been dropped by a reset
+	if (!_pendingExtraction.pop(pos)) {
 		return;
 	}
 	core_trace_scoped(MeshExtraction);
@@ -97,6 +114,13 @@ void WorldMeshExtractor::extractScheduledMesh() {
 	const glm::ivec3 mins(pos);
 	const glm::ivec3 maxs(pos.x + size.x - 1, pos.y + size.y - 2, pos.z + size.z - 1);
 	const voxel::Region region(mins, maxs);
+	// the extraction also looks at the neighbouring voxels - so make sure the chunks around the region are paged in, too.
+	const voxel::Region pagingRegion(mins - 1, maxs + 1);
+	// schedule all the page-ins at once - and sleep until the pager published the chunks
+	if (!_volume->prefetch(pagingRegion)) {
+		core_trace_scoped(MeshExtractionWaitForPageIn);
+		_volume->waitForPageIn(pagingRegion);
+	}
 	// these numbers are made up mostly by try-and-error - we need to revisit them from time to time to prevent extra mem allocs
 	// they also heavily depend on the size of the mesh region we extract
 	const int factor = 64;
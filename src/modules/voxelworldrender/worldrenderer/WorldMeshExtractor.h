@@ -42,12 +42,20 @@ private:
 	PositionSet _positionsExtracted;
 	core::VarPtr _meshSize;
 	voxel::PagedVolume *_volume = nullptr;
+	core::ThreadPool *_threadPool = nullptr;
+
+	/**
+	 * @brief Extracts the pending mesh that is closest to the sort position
+	 */
+	void extractScheduledMesh();
+	/**
+	 * @brief The meshes close to the sort position are extracted before any other work of the pool
+	 */
+	core::TaskPriority extractionPriority(const glm::ivec3& pos) const;
 
 public:
 	WorldMeshExtractor();
 
-	void extractScheduledMesh();
-
 	/**
 	 * @brief We need to pop the mesh extractor queue to find out if there are new and ready to use meshes for us
 	 * @return @c false if this isn't the case, @c true if the given reference was filled with valid data.
@@ -69,6 +77,8 @@ public:
 	/**
 	 * @brief Performs async mesh extraction. You need to call @c pop in order to see if some extraction is ready.
 	 *
+	 * The extraction task is scheduled with a priority that depends on the distance to the sort position.
+	 *
 	 * @param[in] pos A world vector that is automatically converted into a mesh tile vector
 	 * @note This will not allow to reschedule an extraction for the same area until @c allowReExtraction was called.
 	 */
@@ -83,7 +93,11 @@ public:
 
 	glm::ivec3 meshSize() const;
 
-	bool init(voxel::PagedVolume *volume);
+	/**
+	 * @param[in] threadPool The pool that executes the extraction tasks. It must be shut down before this
+	 * extractor is shut down.
+	 */
+	bool init(voxel::PagedVolume *volume, core::ThreadPool *threadPool);
 	void shutdown();
 };
 
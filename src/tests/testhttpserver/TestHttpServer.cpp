@@ -38,7 +38,7 @@ core::AppState TestHttpServer::onInit() {
 	}
 
 	const int16_t port = 8088;
-	if (!_server.init(port)) {
+	if (!_server.init(_loop, port)) {
 		Log::error("Failed to start the http server");
 		return core::AppState::InitFailure;
 	}
@@ -70,7 +70,6 @@ core::AppState TestHttpServer::onInit() {
 core::AppState TestHttpServer::onRunning() {
 	Super::onRunning();
 	uv_run(_loop, UV_RUN_NOWAIT);
-	_server.update();
 	if (_remainingFrames > 0) {
 		if (--_remainingFrames <= 0) {
 			requestQuit();
@@ -83,14 +82,15 @@ core::AppState TestHttpServer::onRunning() {
 
 core::AppState TestHttpServer::onCleanup() {
 	core::AppState state = Super::onCleanup();
+	Log::info("Shuttting down http server");
+	_server.shutdown();
 	if (_loop != nullptr) {
 		uv_tty_reset_mode();
+		uv_run(_loop, UV_RUN_NOWAIT);
 		uv_loop_close(_loop);
 		delete _loop;
 		_loop = nullptr;
 	}
-	Log::info("Shuttting down http server");
-	_server.shutdown();
 	return state;
 }
 
@@ -14,6 +14,8 @@
 #include "NoiseDataNodeWindow.h"
 #include "noise/PoissonDiskDistribution.h"
 #include "noise/Simplex.h"
+#include "noise/SimplexBatch.h"
+#include <vector>
 
 #define IMAGE_PREFIX "2d"
 #define GRAPH_PREFIX "graph"
@@ -88,6 +90,25 @@ void NoiseToolWindow::updateForNoiseType(NoiseType type) {
 	setActive("frequency", true);
 }
 
+bool NoiseToolWindow::getNoiseRow(int y, const NoiseData& data, float* out) {
+	const NoiseType noiseType = data.noiseType;
+	if (noiseType != NoiseType::simplexNoise && noiseType != NoiseType::ridgedNoise && noiseType != NoiseType::fbm) {
+		return false;
+	}
+	std::vector<glm::vec2> positions(_noiseWidth);
+	for (int x = 0; x < _noiseWidth; ++x) {
+		positions[x] = glm::vec2(data.offset + x * data.frequency, data.offset + y * data.frequency);
+	}
+	if (noiseType == NoiseType::simplexNoise) {
+		noise::noise(positions.data(), out, positions.size());
+	} else if (noiseType == NoiseType::ridgedNoise) {
+		noise::ridgedNoise(positions.data(), out, positions.size());
+	} else {
+		noise::fBm(positions.data(), out, positions.size(), data.octaves, data.lacunarity, data.gain);
+	}
+	return true;
+}
+
 float NoiseToolWindow::getNoise(int x, int y, const NoiseData& data) {
 	const NoiseType noiseType = data.noiseType;
 	const glm::vec2 position(data.offset + x * data.frequency, data.offset + y * data.frequency);
@@ -245,9 +266,11 @@ void NoiseToolWindow::generateImage(NoiseType type) {
 			}
 		} else {
 			const int h = _graphHeight - 1;
+			std::vector<float> row(_noiseWidth);
 			for (int y = 0; y < _noiseHeight; ++y) {
+				const bool batched = getNoiseRow(y, qd.data, row.data());
 				for (int x = 0; x < _noiseWidth; ++x) {
-					const float n = getNoise(x, y, qd.data);
+					const float n = batched ? row[x] : getNoise(x, y, qd.data);
 					const float cn = noise::norm(n);
 					const uint8_t c = cn * 255;
 					uint8_t* buf = &noiseBuffer[index(x, y)];
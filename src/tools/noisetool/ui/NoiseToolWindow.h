@@ -47,6 +47,11 @@ private:
 	 * @return the noise in the range [-1.0 - 1.0]
 	 */
 	float getNoise(int x, int y, const NoiseData& _data);
+	/**
+	 * @brief Evaluates the noise for a whole row of the image at once if the noise type supports it
+	 * @return @c false if the noise type has to be evaluated per pixel with getNoise()
+	 */
+	bool getNoiseRow(int y, const NoiseData& _data, float* out);
 	int index(int x, int y) const;
 	void generateImage();
 	void updateForNoiseType(NoiseType type);
@@ -10,13 +10,19 @@
 #include "core/metric/Metric.h"
 #include "core/EventBus.h"
 #include "core/TimeProvider.h"
+#include "core/StringUtil.h"
+#include "core/Trace.h"
+#include "core/concurrent/Concurrency.h"
+#include "core/concurrent/ThreadPool.h"
+#include "core/concurrent/Lock.h"
 #include "voxel/MaterialColor.h"
 #include "voxelformat/Loader.h"
 #include "voxelformat/VoxFileFormat.h"
 #include "voxelutil/VolumeRescaler.h"
+#include <algorithm>
 
 VoxConvert::VoxConvert(const metric::MetricPtr& metric, const io::FilesystemPtr& filesystem, const core::EventBusPtr& eventBus, const core::TimeProviderPtr& timeProvider) :
-		Super(metric, filesystem, eventBus, timeProvider) {
+		Super(metric, filesystem, eventBus, timeProvider, core::cpus()) {
 	init(ORGANISATION, "voxconvert");
 	_initialLogLevel = SDL_LOG_PRIORITY_ERROR;
 }
@@ -26,6 +32,8 @@ core::AppState VoxConvert::onConstruct() {
 	registerArg("--merge").setShort("-m").setDescription("Merge layers into one volume");
 	registerArg("--scale").setShort("-s").setDescription("Scale layer to 50% of its original size");
 	registerArg("--force").setShort("-f").setDescription("Overwrite existing files");
+	registerArg("--batch").setShort("-b").setDescription("Convert all files of the given directory, glob pattern or manifest into the given format");
+	registerArg("--output").setShort("-o").setDescription("Target directory for the batch mode - default is the directory of the input files");
 
 	_palette = core::Var::get("palette", voxel::getDefaultPaletteName());
 	_palette->setHelp("Specify the palette base name or absolute png file to use (1x256)");
@@ -56,48 +64,71 @@ core::AppState VoxConvert::onInit() {
 		return core::AppState::InitFailure;
 	}
 
+	_mergeVolumes = hasArg("--merge") || hasArg("-m");
+	_scaleVolumes = hasArg("--scale") || hasArg("-s");
+	_force = hasArg("--force") || hasArg("-f");
+
+	if (hasArg("--batch") || hasArg("-b")) {
+		const core::String& format = hasArg("--batch") ? getArgVal("--batch") : getArgVal("-b");
+		const core::String& outputDir = hasArg("--output") ? getArgVal("--output") : getArgVal("-o");
+		const core::String input = _argv[_argc - 1];
+		if (batch(input, format, outputDir) != core::AppState::Running) {
+			return core::AppState::InitFailure;
+		}
+		return state;
+	}
+
 	const core::String infile = _argv[_argc - 2];
 	const core::String outfile = _argv[_argc - 1];
 
 	Log::debug("infile: %s", infile.c_str());
 	Log::debug("outfile: %s", outfile.c_str());
 
-	const io::FilePtr inputFile = filesystem()->open(infile, io::FileMode::Read);
-	if (!inputFile->exists()) {
+	if (!filesystem()->exists(infile)) {
 		Log::error("Given input file '%s' does not exist", infile.c_str());
 		_exitCode = 127;
 		return core::AppState::InitFailure;
 	}
 
-	const io::FilePtr outputFile = filesystem()->open(outfile, io::FileMode::Write);
-	if (!outputFile->validHandle()) {
-		Log::error("Could not open target file: %s", outfile.c_str());
+	if (!convert(infile, outfile)) {
 		return core::AppState::InitFailure;
 	}
-	if (outputFile->length() > 0) {
-		if (!hasArg("--force") && !hasArg("-f")) {
-			Log::error("Given output file '%s' already exists", outfile.c_str());
-			return core::AppState::InitFailure;
-		}
+
+	return state;
+}
+
+bool VoxConvert::convert(const core::String& infile, const core::String& outfile) const {
+	core_trace_scoped(VoxConvert);
+	const io::FilePtr inputFile = filesystem()->open(infile, io::FileMode::Read);
+	if (!inputFile->exists()) {
+		Log::error("Given input file '%s' does not exist", infile.c_str());
+		return false;
+	}
+
+	// check before the file is opened for writing - this would truncate it
+	if (!_force && filesystem()->exists(outfile)) {
+		Log::error("Given output file '%s' already exists", outfile.c_str());
+		return false;
 	}
 
 	voxel::VoxelVolumes volumes;
 	if (!voxelformat::loadVolumeFormat(inputFile, volumes)) {
-		Log::error("Failed to load given input file");
-		return core::AppState::InitFailure;
+		Log::error("Failed to load given input file '%s'", infile.c_str());
+		return false;
 	}
 
-	if (hasArg("--merge") || hasArg("-m")) {
-		voxel::RawVolume* merged = volumes.merge();
+	if (_mergeVolumes) {
+		voxel::RawVolume* merged = volumes.merge(&core::App::getInstance()->threadPool());
 		if (merged == nullptr) {
-			Log::error("Failed to merge volumes");
-			return core::AppState::InitFailure;
+			Log::error("Failed to merge volumes of '%s'", infile.c_str());
+			voxelformat::clearVolumes(volumes);
+			return false;
 		}
 		voxelformat::clearVolumes(volumes);
 		volumes.push_back(voxel::VoxelVolume(merged));
 	}
 
-	if (hasArg("--scale") || hasArg("-s")) {
+	if (_scaleVolumes) {
 		for (auto& v : volumes) {
 			const voxel::Region srcRegion = v.volume->region();
 			const glm::ivec3& targetDimensionsHalf = (srcRegion.getDimensionsInVoxels() / 2) - 1;
@@ -109,16 +140,171 @@ core::AppState VoxConvert::onInit() {
 		}
 	}
 
+	const io::FilePtr outputFile = filesystem()->open(outfile, io::FileMode::Write);
+	if (!outputFile->validHandle()) {
+		Log::error("Could not open target file: %s", outfile.c_str());
+		voxelformat::clearVolumes(volumes);
+		return false;
+	}
+
 	if (!voxelformat::saveVolumeFormat(outputFile, volumes)) {
 		voxelformat::clearVolumes(volumes);
 		Log::error("Failed to write to output file '%s'", outfile.c_str());
-		return core::AppState::InitFailure;
+		return false;
 	}
 	Log::info("Wrote output file %s", outputFile->name().c_str());
 
 	voxelformat::clearVolumes(volumes);
+	return true;
+}
 
-	return state;
+bool VoxConvert::collectJobs(const core::String& input, const core::String& format, const core::String& outputDir, std::vector<Job>& jobs) const {
+	auto outfileFor = [&] (const core::String& infile) {
+		const core::String& dir = outputDir.empty() ? core::string::extractPath(infile) : outputDir + "/";
+		return dir + core::string::extractFilename(infile) + "." + format;
+	};
+	std::vector<core::String> supported;
+	core::string::splitString(voxelformat::SUPPORTED_VOXEL_FORMATS_LOAD, supported, ",");
+	auto isSupported = [&] (const core::String& file) {
+		const size_t dot = file.rfind('.');
+		if (dot == core::String::npos) {
+			return false;
+		}
+		const core::String& ext = file.substr(dot + 1).toLower();
+		for (const core::String& s : supported) {
+			if (s == ext) {
+				return true;
+			}
+		}
+		return false;
+	};
+
+	const bool glob = core::string::contains(input, "*") || core::string::contains(input, "?");
+	if (glob || io::Filesystem::isReadableDir(input)) {
+		const core::String& dir = glob ? core::string::extractPath(input) : input + "/";
+		const core::String& filter = glob ? core::string::extractFilenameWithExtension(input) : "";
+		const core::String& absDir = io::Filesystem::absolutePath(dir.empty() ? "." : dir);
+		std::vector<io::Filesystem::DirEntry> entities;
+		if (!filesystem()->list(absDir, entities, filter)) {
+			Log::error("Failed to list the files of '%s'", input.c_str());
+			return false;
+		}
+		for (const io::Filesystem::DirEntry& e : entities) {
+			if (e.type == io::Filesystem::DirEntry::Type::dir || !isSupported(e.name)) {
+				continue;
+			}
+			const core::String infile = dir + e.name;
+			jobs.push_back(Job{infile, outfileFor(infile)});
+		}
+		return true;
+	}
+
+	if (isSupported(input)) {
+		jobs.push_back(Job{input, outfileFor(input)});
+		return true;
+	}
+
+	// a manifest with one conversion per line: infile [outfile]
+	const io::FilePtr& manifest = filesystem()->open(input);
+	if (!manifest->exists()) {
+		Log::error("Given batch input '%s' does not exist", input.c_str());
+		return false;
+	}
+	std::vector<core::String> lines;
+	core::string::splitString(manifest->load(), lines, "\r\n");
+	for (const core::String& line : lines) {
+		const core::String& trimmed = core::string::trim(line);
+		if (trimmed.empty() || trimmed[0] == '#') {
+			continue;
+		}
+		std::vector<core::String> tokens;
+		core::string::splitString(trimmed, tokens);
+		if (tokens.size() > 2u) {
+			Log::error("Invalid manifest line: '%s'", trimmed.c_str());
+			return false;
+		}
+		jobs.push_back(Job{tokens[0], tokens.size() == 2u ? tokens[1] : outfileFor(tokens[0])});
+	}
+	return true;
+}
+
+bool VoxConvert::checkJobs(const std::vector<Job>& jobs) const {
+	std::vector<core::String> outfiles;
+	std::vector<core::String> infiles;
+	outfiles.reserve(jobs.size());
+	infiles.reserve(jobs.size());
+	for (const Job& job : jobs) {
+		outfiles.push_back(job.outfile);
+		infiles.push_back(job.infile);
+	}
+	std::sort(outfiles.begin(), outfiles.end());
+	std::sort(infiles.begin(), infiles.end());
+	bool success = true;
+	for (size_t i = 0u; i < outfiles.size(); ++i) {
+		if (i > 0u && outfiles[i] == outfiles[i - 1u]) {
+			Log::error("Several input files would be converted into '%s'", outfiles[i].c_str());
+			success = false;
+		}
+		if (std::binary_search(infiles.begin(), infiles.end(), outfiles[i])) {
+			Log::error("The output file '%s' is also an input file of the batch", outfiles[i].c_str());
+			success = false;
+		}
+	}
+	return success;
+}
+
+core::AppState VoxConvert::batch(const core::String& input, const core::String& format, const core::String& outputDir) {
+	if (format.empty()) {
+		Log::error("No target format given for the batch mode");
+		return core::AppState::InitFailure;
+	}
+	std::vector<Job> jobs;
+	if (!collectJobs(input, format, outputDir, jobs)) {
+		return core::AppState::InitFailure;
+	}
+	if (jobs.empty()) {
+		Log::error("No files found for '%s'", input.c_str());
+		return core::AppState::InitFailure;
+	}
+	// the jobs are executed in parallel - a collision could not be detected by the existence check of convert()
+	if (!checkJobs(jobs)) {
+		return core::AppState::InitFailure;
+	}
+	if (!outputDir.empty() && !filesystem()->createDir(outputDir)) {
+		Log::error("Failed to create the output directory '%s'", outputDir.c_str());
+		return core::AppState::InitFailure;
+	}
+
+	core::ThreadPool& pool = threadPool();
+	Log::info("Convert %i files with %i threads", (int)jobs.size(), (int)pool.size());
+	core::Lock failedMutex;
+	std::vector<core::String> failed;
+	core::TaskGroup group;
+	for (const Job& job : jobs) {
+		// every conversion has its own volumes - a failure doesn't affect the others
+		auto task = [this, &job, &failedMutex, &failed] () {
+			if (convert(job.infile, job.outfile)) {
+				return;
+			}
+			core::ScopedLock lock(failedMutex);
+			failed.push_back(job.infile);
+		};
+		if (!pool.schedule(group, task)) {
+			task();
+		}
+	}
+	pool.wait(group);
+
+	Log::info("Converted %i of %i files", (int)(jobs.size() - failed.size()), (int)jobs.size());
+	if (failed.empty()) {
+		return core::AppState::Running;
+	}
+	Log::error("Failed to convert %i of %i files:", (int)failed.size(), (int)jobs.size());
+	for (const core::String& infile : failed) {
+		Log::error(" * %s", infile.c_str());
+	}
+	_exitCode = 1;
+	return core::AppState::InitFailure;
 }
 
 int main(int argc, char *argv[]) {
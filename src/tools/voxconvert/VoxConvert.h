@@ -5,6 +5,7 @@
 #pragma once
 
 #include "core/CommandlineApp.h"
+#include <vector>
 
 /**
  * @brief This tool is able to convert voxel volumes between different formats
@@ -15,6 +16,33 @@ class VoxConvert: public core::CommandlineApp {
 private:
 	using Super = core::CommandlineApp;
 	core::VarPtr _palette;
+	bool _mergeVolumes = false;
+	bool _scaleVolumes = false;
+	bool _force = false;
+
+	struct Job {
+		core::String infile;
+		core::String outfile;
+	};
+
+	/**
+	 * @brief Loads the input file, applies the merge and scale options and writes the output file
+	 * @note Called from the threads of the thread pool in batch mode
+	 */
+	bool convert(const core::String& infile, const core::String& outfile) const;
+	/**
+	 * @param[in] input A directory, a glob pattern like @c models/\*.qb or a manifest file with one
+	 * @c infile and an optional @c outfile per line
+	 * @param[in] format The extension of the output files
+	 * @param[in] outputDir The directory of the output files - if empty, they are written next to the input files
+	 */
+	bool collectJobs(const core::String& input, const core::String& format, const core::String& outputDir, std::vector<Job>& jobs) const;
+	/**
+	 * @brief Every job must write its own output file - and none of them may overwrite the input of another job.
+	 * The outputs of e.g. @c a.vox and @c a.qb would both be @c a.<format>
+	 */
+	bool checkJobs(const std::vector<Job>& jobs) const;
+	core::AppState batch(const core::String& input, const core::String& format, const core::String& outputDir);
 public:
 	VoxConvert(const metric::MetricPtr& metric, const io::FilesystemPtr& filesystem, const core::EventBusPtr& eventBus, const core::TimeProviderPtr& timeProvider);
 
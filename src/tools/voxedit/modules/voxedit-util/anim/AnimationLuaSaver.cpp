@@ -51,7 +51,7 @@ bool saveAnimationEntityLua(const animation::AnimationSettings& settings, const
 	}
 	stream.addString("  return attributes\n", false);
 	stream.addString("end\n", false);
-	return true;
+	return stream.flush();
 }
 
 }